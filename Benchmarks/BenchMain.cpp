@@ -0,0 +1,54 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+using namespace std;
+
+/**
+ * CPU benchmarks of the engine subsystems, runnable without an OpenGL context.
+ * Usage : OpenGLTemplateBenchmarks [--filter substring] [--min-time seconds] [--json results.json]
+ * Exits with 1 when a validation run reports mismatches against its reference.
+ */
+int main(int argc, char ** argv) {
+    string filter, jsonFile;
+    double minTime = 0.5;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minTime = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonFile = argv[++i];
+        } else {
+            cout << "Usage: " << argv[0] << " [--filter substring] [--min-time seconds] [--json results.json]" << endl;
+            return -1;
+        }
+    }
+
+    int count = BenchmarkRegistry::getInstance()->run(filter, minTime);
+    if (count == 0) {
+        cout << "No benchmark matching \"" << filter << "\"" << endl;
+        return -1;
+    }
+
+    if (!jsonFile.empty() && !BenchmarkRegistry::getInstance()->writeJson(jsonFile)) {
+        cout << "Could not write " << jsonFile << endl;
+        return -1;
+    }
+
+    // Validation runs (mismatches against a reference) make the run fail
+    const vector<string>& failures = BenchmarkRegistry::getInstance()->getFailures();
+    if (!failures.empty()) {
+        cout << failures.size() << " validation(s) failed:" << endl;
+        for (size_t i = 0; i < failures.size(); i++)
+            cout << "    " << failures[i] << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include "JsonWriter.h"
+
+BenchmarkState::BenchmarkState(long long arg, double minTime) :
+	m_Arg(arg), m_MinTime(minTime), m_Iterations(0), m_Items(0), m_Mismatches(0),
+	m_Started(false), m_Paused(false), m_Elapsed(Clock::duration::zero())
+{
+}
+
+bool BenchmarkState::keepRunning()
+{
+	if (!m_Started)
+	{
+		m_Started = true;
+		m_Start = Clock::now();
+		return true;
+	}
+
+	m_Iterations++;
+	if (elapsedSeconds() < m_MinTime)
+		return true;
+
+	if (!m_Paused)
+		m_Elapsed += Clock::now() - m_Start;
+	m_Paused = true;
+	return false;
+}
+
+void BenchmarkState::pauseTiming()
+{
+	if (!m_Paused)
+	{
+		m_Elapsed += Clock::now() - m_Start;
+		m_Paused = true;
+	}
+}
+
+void BenchmarkState::resumeTiming()
+{
+	if (m_Paused)
+	{
+		m_Start = Clock::now();
+		m_Paused = false;
+	}
+}
+
+double BenchmarkState::elapsedSeconds() const
+{
+	Clock::duration d = m_Elapsed;
+	if (m_Started && !m_Paused)
+		d += Clock::now() - m_Start;
+	return std::chrono::duration<double>(d).count();
+}
+
+void BenchmarkRegistry::add(const std::string& name, BenchmarkFunction f, const std::vector<long long>& args)
+{
+	Entry e;
+	e.name = name;
+	e.function = f;
+	e.args = args;
+	if (e.args.empty())
+		e.args.push_back(0);
+	m_Entries.push_back(e);
+}
+
+int BenchmarkRegistry::run(const std::string& filter, double minTime)
+{
+	int count = 0;
+	m_Results.clear();
+	m_Failures.clear();
+	m_MinTime = minTime;
+	std::printf("%-48s %12s %14s %16s\n", "Benchmark", "Iterations", "Time/iter (ms)", "Items/s");
+	for (size_t i = 0; i < m_Entries.size(); i++)
+	{
+		const Entry& e = m_Entries[i];
+		if (e.name.find(filter) == std::string::npos)
+			continue;
+
+		for (size_t a = 0; a < e.args.size(); a++)
+		{
+			BenchmarkState state(e.args[a], minTime);
+			e.function(state);
+
+			std::string name = e.name;
+			if (e.args[a] != 0 || e.args.size() > 1)
+				name += "/" + std::to_string(e.args[a]);
+
+			double seconds = state.elapsedSeconds();
+			long long iterations = state.iterations() > 0 ? state.iterations() : 1;
+			double itemsPerSecond = seconds > 0.0 ? (double)state.itemsProcessed() / seconds : 0.0;
+
+			std::printf("%-48s %12lld %14.4f %16.4g\n", name.c_str(), iterations, 1000.0 * seconds / (double)iterations, itemsPerSecond);
+			for (std::map<std::string, double>::const_iterator it = state.counters.begin(); it != state.counters.end(); ++it)
+				std::printf("    %-44s %.6g\n", it->first.c_str(), it->second);
+			if (state.mismatches() > 0)
+			{
+				std::printf("    FAILED: %lld mismatches\n", state.mismatches());
+				m_Failures.push_back(name);
+			}
+			std::fflush(stdout);
+			count++;
+
+			Result r;
+			r.name = name;
+			r.iterations = iterations;
+			r.timePerIteration = 1000.0 * seconds / (double)iterations;
+			r.itemsPerSecond = itemsPerSecond;
+			r.counters = state.counters;
+			r.failed = state.mismatches() > 0;
+			m_Results.push_back(r);
+		}
+	}
+	return count;
+}
+
+bool BenchmarkRegistry::writeJson(const std::string& filename) const
+{
+	std::ofstream file(filename.c_str());
+	if (!file)
+		return false;
+
+	char date[32];
+	time_t now = time(NULL);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+	JsonWriter json(file);
+	json.beginObject();
+	json.value("date", date);
+	json.value("min_time_s", m_MinTime);
+	json.beginArray("benchmarks");
+	for (size_t i = 0; i < m_Results.size(); i++)
+	{
+		const Result& r = m_Results[i];
+		json.beginObject();
+		json.value("name", r.name);
+		json.value("iterations", r.iterations);
+		json.value("time_per_iteration_ms", r.timePerIteration);
+		json.value("items_per_second", r.itemsPerSecond);
+		json.value("failed", r.failed);
+		json.beginObject("counters");
+		for (std::map<std::string, double>::const_iterator it = r.counters.begin(); it != r.counters.end(); ++it)
+			json.value(it->first.c_str(), it->second);
+		json.endObject();
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	return (bool)file;
+}
@@ -0,0 +1,142 @@
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "Singleton.h"
+
+/**
+ * @brief      State of one benchmark run
+ * @details    The benchmark body calls keepRunning() in a loop: the time spent inside the loop is measured until the
+ *             minimum run time is reached. Setup code can be excluded with pauseTiming() / resumeTiming().
+ */
+class BenchmarkState
+{
+public:
+	BenchmarkState(long long arg, double minTime);
+
+	bool keepRunning();
+	void pauseTiming();
+	void resumeTiming();
+
+	/**
+	 * @brief Argument of the run (problem size), 0 when the benchmark has no argument
+	 */
+	long long arg() const { return m_Arg; }
+	long long iterations() const { return m_Iterations; }
+	double elapsedSeconds() const;
+
+	/**
+	 * @brief Report a named value along the timings (counts, rates, ...)
+	 */
+	void setCounter(const std::string& name, double value) { counters[name] = value; }
+
+	/**
+	 * @brief Number of items processed over all iterations, reported as items per second
+	 */
+	void setItemsProcessed(long long items) { m_Items = items; }
+	long long itemsProcessed() const { return m_Items; }
+
+	/**
+	 * @brief Result of a validation against a reference, reported as the "mismatches" counter: the run fails if above 0
+	 */
+	void setMismatches(long long count) { counters["mismatches"] = (double)count; m_Mismatches = count; }
+	long long mismatches() const { return m_Mismatches; }
+
+	std::map<std::string, double> counters;
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	long long m_Arg;
+	double m_MinTime;
+	long long m_Iterations;
+	long long m_Items;
+	long long m_Mismatches;
+	bool m_Started, m_Paused;
+	Clock::time_point m_Start;
+	Clock::duration m_Elapsed;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState&);
+
+class BenchmarkRegistry : public Singleton<BenchmarkRegistry>
+{
+	friend class Singleton<BenchmarkRegistry>;
+public:
+	void add(const std::string& name, BenchmarkFunction f, const std::vector<long long>& args);
+
+	/**
+	 * @brief Run every benchmark whose name contains filter and print the results
+	 * @return number of benchmarks run
+	 */
+	int run(const std::string& filter, double minTime);
+
+	/**
+	 * @brief Runs of the last run() that reported mismatches
+	 */
+	const std::vector<std::string>& getFailures() const { return m_Failures; }
+
+	/**
+	 * @brief Write the results of the last run as JSON, for tracking over time
+	 * @return false if the file could not be written
+	 */
+	bool writeJson(const std::string& filename) const;
+
+private:
+	BenchmarkRegistry() : m_MinTime(0.0) {}
+
+	struct Entry
+	{
+		std::string name;
+		BenchmarkFunction function;
+		std::vector<long long> args;
+	};
+	std::vector<Entry> m_Entries;
+
+	struct Result
+	{
+		std::string name;
+		long long iterations;
+		double timePerIteration;	// Milliseconds
+		double itemsPerSecond;
+		std::map<std::string, double> counters;
+		bool failed;
+	};
+	std::vector<Result> m_Results;
+	std::vector<std::string> m_Failures;
+	double m_MinTime;
+};
+
+struct BenchmarkRegistrar
+{
+	BenchmarkRegistrar(const char* name, BenchmarkFunction f, const std::vector<long long>& args)
+	{
+		BenchmarkRegistry::getInstance()->add(name, f, args);
+	}
+};
+
+/**
+ * Define and register a benchmark, optionally run once per argument:
+ * BENCHMARK(BM_Name, 1000, 100000) { while (state.keepRunning()) { ... } }
+ */
+#define BENCHMARK(func, ...) \
+	static void func(BenchmarkState& state); \
+	static BenchmarkRegistrar func##_registrar(#func, func, std::vector<long long>{__VA_ARGS__}); \
+	static void func(BenchmarkState& state)
+
+/**
+ * @brief Prevent the compiler from optimizing away a computed value
+ */
+template <typename T> inline void doNotOptimize(const T& value)
+{
+	volatile const T* sink = &value;
+	(void)sink;
+#if defined(__GNUC__)
+	asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+#endif
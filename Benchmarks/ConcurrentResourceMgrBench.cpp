@@ -0,0 +1,193 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "ConcurrentResource_mgr.hpp"
+#include "Resource_mgr.hpp"
+
+static const int KeyCount = 1024;
+static const int OperationsPerThread = 20000;
+
+// Live instances per key: a second live instance of the same key means a duplicate construction
+static std::atomic<int> g_Alive[KeyCount];
+static std::atomic<int> g_Constructions(0);
+static std::atomic<int> g_Duplicates(0);
+
+class StressResource
+{
+public:
+	explicit StressResource(std::string name) : m_Key(std::stoi(name.substr(3)))
+	{
+		g_Constructions++;
+		if (g_Alive[m_Key]++ != 0)
+			g_Duplicates++;
+		// Widen the construction window so that concurrent requests of the same key do happen
+		std::this_thread::yield();
+	}
+	virtual ~StressResource() { g_Alive[m_Key]--; }
+	int key() const { return m_Key; }
+private:
+	int m_Key;
+};
+
+static std::vector<std::string> keyNames()
+{
+	std::vector<std::string> names;
+	for (int i = 0; i < KeyCount; i++)
+		names.push_back("Key" + std::to_string(i));
+	return names;
+}
+
+// Each thread acquires random keys, mostly from a small hot set, checks them and releases them later
+template <typename M> static void stressThread(M& mgr, const std::vector<std::string>& names, unsigned int seed, std::atomic<int>& errors)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> hot(0, 15), cold(0, KeyCount - 1), coin(0, 9);
+	std::vector<int> held;
+	for (int i = 0; i < OperationsPerThread; i++)
+	{
+		if (held.size() < 8 && coin(rng) < 6)
+		{
+			int key = coin(rng) < 8 ? hot(rng) : cold(rng);
+			StressResource* r = mgr.get(names[key]);
+			if (r == NULL || r->key() != key)
+				errors++;
+			held.push_back(key);
+		}
+		else if (!held.empty())
+		{
+			mgr.release(names[held.back()]);
+			held.pop_back();
+		}
+	}
+	for (size_t i = 0; i < held.size(); i++)
+		mgr.release(names[held[i]]);
+}
+
+// Resource_mgr behind a single mutex, the only way to share it between threads before the concurrent variant
+class LockedResourceMgr
+{
+public:
+	StressResource* get(const std::string& a)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Mgr.get(a);
+	}
+	void release(const std::string& a)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Mgr.release(a);
+	}
+	int size()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Mgr.size();
+	}
+private:
+	std::mutex m_Mutex;
+	Resource_mgr<StressResource> m_Mgr;
+};
+
+template <typename M> static void stressBenchmark(BenchmarkState& state)
+{
+	std::vector<std::string> names = keyNames();
+	int threads = (int)state.arg();
+	std::atomic<int> errors(0);
+	g_Duplicates = 0;
+	g_Constructions = 0;
+	int leaked = 0;
+
+	while (state.keepRunning())
+	{
+		std::unique_ptr<M> mgr(new M());
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++)
+			workers.push_back(std::thread([&, t]() { stressThread(*mgr, names, 1000u * (unsigned int)state.iterations() + t, errors); }));
+		for (size_t t = 0; t < workers.size(); t++)
+			workers[t].join();
+		// Every reference has been released, so every resource must be gone
+		leaked += mgr->size();
+	}
+	int alive = 0;
+	for (int i = 0; i < KeyCount; i++)
+		alive += g_Alive[i];
+
+	state.setItemsProcessed(state.iterations() * threads * OperationsPerThread);
+	state.setCounter("threads", threads);
+	state.setCounter("constructions per iteration", (double)g_Constructions / state.iterations());
+	state.setCounter("duplicate constructions", g_Duplicates);
+	state.setCounter("errors", errors + leaked + alive);
+}
+
+BENCHMARK(BM_ConcurrentResourceMgr_Stress, 1, 4, 8)
+{
+	stressBenchmark<ConcurrentResource_mgr<StressResource> >(state);
+}
+
+BENCHMARK(BM_LockedResourceMgr_Stress, 1, 4, 8)
+{
+	stressBenchmark<LockedResourceMgr>(state);
+}
+
+// Every thread requests the same missing key at the same time: exactly one construction per round
+BENCHMARK(BM_ConcurrentResourceMgr_SameMissingKey, 4, 8)
+{
+	int threads = (int)state.arg();
+	int rounds = 0, extraConstructions = 0, mismatches = 0;
+	g_Duplicates = 0;
+
+	while (state.keepRunning())
+	{
+		ConcurrentResource_mgr<StressResource> mgr;
+		std::atomic<int> ready(0);
+		std::vector<StressResource*> results(threads);
+		int before = g_Constructions;
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++)
+		{
+			workers.push_back(std::thread([&, t]()
+			{
+				ready++;
+				while (ready < threads)
+					std::this_thread::yield();
+				results[t] = mgr.get("Key0");
+			}));
+		}
+		for (size_t t = 0; t < workers.size(); t++)
+			workers[t].join();
+		extraConstructions += g_Constructions - before - 1;
+		for (int t = 1; t < threads; t++)
+			if (results[t] != results[0])
+				mismatches++;
+		rounds++;
+	}
+	state.setItemsProcessed(rounds);
+	state.setCounter("threads", threads);
+	state.setCounter("extra constructions", extraConstructions + g_Duplicates);
+	state.setMismatches(mismatches);
+}
+
+// Uncontended lookups of existing resources, compared to the single threaded manager
+BENCHMARK(BM_ConcurrentResourceMgr_GetByName, 1000, 100000)
+{
+	std::vector<std::string> names;
+	for (long long i = 0; i < state.arg(); i++)
+		names.push_back("Key" + std::to_string(i % KeyCount) + "_" + std::to_string(i));
+	ConcurrentResource_mgr<StressResource> mgr;
+	for (size_t i = 0; i < names.size(); i++)
+		mgr.insert(names[i], NULL);
+
+	size_t i = 0;
+	while (state.keepRunning())
+	{
+		doNotOptimize(mgr.find(names[i]));
+		i = (i + 7919) % names.size();
+	}
+	state.setItemsProcessed(state.iterations());
+}
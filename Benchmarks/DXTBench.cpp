@@ -0,0 +1,169 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "DXTCompressor.h"
+#include "image_DXT.h"
+
+// Smooth gradients with some noise, closer to real textures than pure noise
+static std::vector<unsigned char> createImage(int size, int channels)
+{
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int> noise(-8, 8);
+	std::vector<unsigned char> image((size_t)size * size * channels);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				float v = 127.5f + 127.5f * std::sin(0.02f * (x * (c + 1)) + 0.03f * y);
+				int p = (int)v + noise(rng);
+				image[((size_t)y * size + x) * channels + c] = (unsigned char)(p < 0 ? 0 : (p > 255 ? 255 : p));
+			}
+		}
+	}
+	return image;
+}
+
+static void dxtBenchmark(BenchmarkState& state, bool dxt5)
+{
+	int size = (int)state.arg();
+	int channels = dxt5 ? 4 : 3;
+	std::vector<unsigned char> image = createImage(size, channels);
+
+	int outSize = 0;
+	while (state.keepRunning())
+	{
+		unsigned char* compressed = dxt5 ? convert_image_to_DXT5(&image[0], size, size, channels, &outSize)
+			: convert_image_to_DXT1(&image[0], size, size, channels, &outSize);
+		doNotOptimize(compressed[0]);
+		free(compressed);
+	}
+	state.setItemsProcessed(state.iterations() * size * size);
+	state.setCounter("compressed bytes", outSize);
+	state.setCounter("MPixels/s", (double)state.iterations() * size * size / state.elapsedSeconds() / 1e6);
+}
+
+BENCHMARK(BM_DXT1_Compress, 256, 1024, 2048)
+{
+	dxtBenchmark(state, false);
+}
+
+BENCHMARK(BM_DXT5_Compress, 256, 1024, 2048)
+{
+	dxtBenchmark(state, true);
+}
+
+static void simdBenchmark(BenchmarkState& state, int size, int threads, bool dxt5)
+{
+	int channels = dxt5 ? 4 : 3;
+	std::vector<unsigned char> image = createImage(size, channels);
+
+	int outSize = 0;
+	while (state.keepRunning())
+	{
+		unsigned char* compressed = dxt5 ? compressDXT5(&image[0], size, size, channels, &outSize, threads)
+			: compressDXT1(&image[0], size, size, channels, &outSize, threads);
+		doNotOptimize(compressed[0]);
+		free(compressed);
+	}
+	state.setItemsProcessed(state.iterations() * size * size);
+	state.setCounter("compressed bytes", outSize);
+	state.setCounter("MPixels/s", (double)state.iterations() * size * size / state.elapsedSeconds() / 1e6);
+}
+
+// SSE2 compressor on a single thread
+BENCHMARK(BM_DXT1_CompressSIMD, 256, 1024, 2048)
+{
+	simdBenchmark(state, (int)state.arg(), 1, false);
+}
+
+BENCHMARK(BM_DXT5_CompressSIMD, 256, 1024, 2048)
+{
+	simdBenchmark(state, (int)state.arg(), 1, true);
+}
+
+// 2048 x 2048 with arg threads
+BENCHMARK(BM_DXT5_CompressSIMD_Threads, 1, 2, 4, 8)
+{
+	simdBenchmark(state, 2048, (int)state.arg(), true);
+}
+
+// Peak signal to noise ratio of the decoded blocks, over the RGB (and alpha) channels of the image
+static double psnr(const std::vector<unsigned char>& image, int channels, const unsigned char* blocks, int size, bool dxt5, double& rmse)
+{
+	std::vector<unsigned char> decoded((size_t)size * size * 4);
+	if (dxt5)
+		decompressDXT5(blocks, size, size, &decoded[0]);
+	else
+		decompressDXT1(blocks, size, size, &decoded[0]);
+	double error = 0.0;
+	for (size_t p = 0; p < (size_t)size * size; p++)
+	{
+		for (int c = 0; c < channels; c++)
+		{
+			double d = (double)image[p * channels + c] - decoded[p * 4 + c];
+			error += d * d;
+		}
+	}
+	rmse = std::sqrt(error / ((double)size * size * channels));
+	return rmse > 0.0 ? 20.0 * std::log10(255.0 / rmse) : 99.0;
+}
+
+/*
+ * SSE2 and threaded blocks against image_DXT on odd sizes (partial blocks and lanes), 1 to 4 channels: RMSE / PSNR of
+ * both, each differing block being a mismatch
+ */
+BENCHMARK(BM_DXT_Quality, 509)
+{
+	int size = (int)state.arg();
+	long long mismatches = 0;
+	double scalarPSNR[2] = { 0.0, 0.0 }, simdPSNR[2] = { 0.0, 0.0 }, scalarRMSE[2] = { 0.0, 0.0 }, simdRMSE[2] = { 0.0, 0.0 };
+	while (state.keepRunning())
+	{
+		for (int channels = 1; channels <= 4; channels++)
+		{
+			std::vector<unsigned char> image = createImage(size, channels);
+			for (int dxt5 = 0; dxt5 < 2; dxt5++)
+			{
+				int scalarSize = 0, simdSize = 0;
+				unsigned char* scalar = dxt5 ? convert_image_to_DXT5(&image[0], size, size, channels, &scalarSize)
+					: convert_image_to_DXT1(&image[0], size, size, channels, &scalarSize);
+				unsigned char* simd = dxt5 ? compressDXT5(&image[0], size, size, channels, &simdSize, 3)
+					: compressDXT1(&image[0], size, size, channels, &simdSize, 3);
+				if (scalarSize != simdSize)
+					mismatches++;
+				else
+				{
+					int blockBytes = dxt5 ? 16 : 8;
+					for (int b = 0; b < scalarSize; b += blockBytes)
+					{
+						if (memcmp(scalar + b, simd + b, blockBytes) != 0)
+							mismatches++;
+					}
+				}
+				if (channels == 3 + dxt5)
+				{
+					scalarPSNR[dxt5] = psnr(image, channels, scalar, size, dxt5 != 0, scalarRMSE[dxt5]);
+					simdPSNR[dxt5] = psnr(image, channels, simd, size, dxt5 != 0, simdRMSE[dxt5]);
+				}
+				free(scalar);
+				free(simd);
+			}
+		}
+	}
+	state.setItemsProcessed(state.iterations() * 8);
+	state.setMismatches(mismatches);
+	state.setCounter("DXT1 RMSE scalar", scalarRMSE[0]);
+	state.setCounter("DXT1 RMSE SIMD", simdRMSE[0]);
+	state.setCounter("DXT1 PSNR scalar", scalarPSNR[0]);
+	state.setCounter("DXT1 PSNR SIMD", simdPSNR[0]);
+	state.setCounter("DXT5 RMSE scalar", scalarRMSE[1]);
+	state.setCounter("DXT5 RMSE SIMD", simdRMSE[1]);
+	state.setCounter("DXT5 PSNR scalar", scalarPSNR[1]);
+	state.setCounter("DXT5 PSNR SIMD", simdPSNR[1]);
+}
@@ -0,0 +1,198 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Benchmark.h"
+#include "DynamicAABBTree.hpp"
+
+// Objects are boxes of size [0.5, 2] scattered in a cube of side 1000
+static const float WorldSize = 1000.0f;
+
+struct MovingObject
+{
+	glm::vec3 position;
+	glm::vec3 velocity;
+	glm::vec3 halfSize;
+	int proxy;
+
+	AABB bounds() const { return AABB(position - halfSize, position + halfSize); }
+};
+
+static std::vector<MovingObject> createObjects(long long count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> pos(0.0f, WorldSize);
+	std::uniform_real_distribution<float> size(0.25f, 1.0f);
+	std::uniform_real_distribution<float> vel(-1.0f, 1.0f);
+
+	std::vector<MovingObject> objects((size_t)count);
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		objects[i].position = glm::vec3(pos(rng), pos(rng), pos(rng));
+		objects[i].velocity = glm::vec3(vel(rng), vel(rng), vel(rng));
+		objects[i].halfSize = glm::vec3(size(rng), size(rng), size(rng));
+		objects[i].proxy = DynamicAABBTree<int>::NullNode;
+	}
+	return objects;
+}
+
+static void buildTree(DynamicAABBTree<int>& tree, std::vector<MovingObject>& objects)
+{
+	for (size_t i = 0; i < objects.size(); i++)
+		objects[i].proxy = tree.createProxy(objects[i].bounds(), (int)i);
+}
+
+// Camera placed in the middle of the world looking along a rotating direction
+static Frustum cameraFrustum(int frame)
+{
+	float angle = 0.1f * (float)frame;
+	glm::vec3 eye(0.5f * WorldSize);
+	glm::vec3 target = eye + glm::vec3(cos(angle), 0.0f, sin(angle));
+	glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+	glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+	return Frustum(proj * view);
+}
+
+BENCHMARK(BM_DynamicAABBTree_Build, 100000, 1000000)
+{
+	std::vector<MovingObject> objects = createObjects(state.arg(), 1);
+	int height = 0;
+	while (state.keepRunning())
+	{
+		DynamicAABBTree<int> tree;
+		buildTree(tree, objects);
+		height = tree.getHeight();
+		state.pauseTiming();	// Exclude the tree destruction
+		tree.clear();
+		state.resumeTiming();
+	}
+	state.setItemsProcessed(state.iterations() * state.arg());
+	state.setCounter("tree height", height);
+}
+
+// One iteration = one frame where a fraction of the objects move by a tenth of their velocity
+static void refitBenchmark(BenchmarkState& state, int movingPercent)
+{
+	std::vector<MovingObject> objects = createObjects(state.arg(), 2);
+	DynamicAABBTree<int> tree;
+	buildTree(tree, objects);
+
+	size_t moving = objects.size() * movingPercent / 100;
+	long long reinserted = 0;
+	while (state.keepRunning())
+	{
+		for (size_t i = 0; i < moving; i++)
+		{
+			MovingObject& o = objects[i];
+			o.position += 0.1f * o.velocity;
+			if (tree.moveProxy(o.proxy, o.bounds()))
+				reinserted++;
+		}
+	}
+	long long iterations = state.iterations() > 0 ? state.iterations() : 1;
+	state.setItemsProcessed(state.iterations() * (long long)moving);
+	state.setCounter("moving objects", (double)moving);
+	state.setCounter("reinserted per frame", (double)reinserted / (double)iterations);
+	state.setCounter("tree height", tree.getHeight());
+}
+
+BENCHMARK(BM_DynamicAABBTree_Refit10Percent, 100000, 1000000)
+{
+	refitBenchmark(state, 10);
+}
+
+BENCHMARK(BM_DynamicAABBTree_RefitAll, 100000, 1000000)
+{
+	refitBenchmark(state, 100);
+}
+
+BENCHMARK(BM_DynamicAABBTree_FrustumQuery, 100000, 1000000)
+{
+	std::vector<MovingObject> objects = createObjects(state.arg(), 3);
+	DynamicAABBTree<int> tree;
+	buildTree(tree, objects);
+
+	std::vector<int> visible;
+	int frame = 0;
+	long long found = 0;
+	while (state.keepRunning())
+	{
+		visible.clear();
+		tree.query(cameraFrustum(frame++), [&visible](int i) { visible.push_back(i); });
+		found += visible.size();
+	}
+	state.setItemsProcessed(state.iterations() * state.arg());
+	state.setCounter("visible per query", (double)found / (double)(state.iterations() > 0 ? state.iterations() : 1));
+}
+
+// Reference : the flat loop the engine used before, testing every object against the frustum
+BENCHMARK(BM_FlatList_FrustumQuery, 100000, 1000000)
+{
+	std::vector<MovingObject> objects = createObjects(state.arg(), 3);
+	std::vector<int> visible;
+	int frame = 0;
+	while (state.keepRunning())
+	{
+		visible.clear();
+		Frustum f = cameraFrustum(frame++);
+		for (size_t i = 0; i < objects.size(); i++)
+			if (f.overlaps(objects[i].bounds()))
+				visible.push_back((int)i);
+		doNotOptimize(visible.size());
+	}
+	state.setItemsProcessed(state.iterations() * state.arg());
+}
+
+BENCHMARK(BM_DynamicAABBTree_SphereQuery, 100000, 1000000)
+{
+	std::vector<MovingObject> objects = createObjects(state.arg(), 4);
+	DynamicAABBTree<int> tree;
+	buildTree(tree, objects);
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> pos(0.0f, WorldSize);
+	long long found = 0;
+	while (state.keepRunning())
+	{
+		BoundingSphere s(glm::vec3(pos(rng), pos(rng), pos(rng)), 20.0f);
+		tree.query(s, [&found](int) { found++; });
+	}
+	state.setCounter("results per query", (double)found / (double)(state.iterations() > 0 ? state.iterations() : 1));
+}
+
+BENCHMARK(BM_DynamicAABBTree_BoxQuery, 100000, 1000000)
+{
+	std::vector<MovingObject> objects = createObjects(state.arg(), 6);
+	DynamicAABBTree<int> tree;
+	buildTree(tree, objects);
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> pos(0.0f, WorldSize);
+	long long found = 0;
+	while (state.keepRunning())
+	{
+		glm::vec3 c(pos(rng), pos(rng), pos(rng));
+		tree.query(AABB(c - glm::vec3(20.0f), c + glm::vec3(20.0f)), [&found](int) { found++; });
+	}
+	state.setCounter("results per query", (double)found / (double)(state.iterations() > 0 ? state.iterations() : 1));
+}
+
+BENCHMARK(BM_DynamicAABBTree_RayQuery, 100000, 1000000)
+{
+	std::vector<MovingObject> objects = createObjects(state.arg(), 8);
+	DynamicAABBTree<int> tree;
+	buildTree(tree, objects);
+
+	std::mt19937 rng(9);
+	std::uniform_real_distribution<float> pos(0.0f, WorldSize);
+	std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+	long long found = 0;
+	while (state.keepRunning())
+	{
+		Ray r(glm::vec3(pos(rng), pos(rng), pos(rng)), glm::normalize(glm::vec3(dir(rng), dir(rng), dir(rng))));
+		tree.raycast(r, WorldSize, [&found](int, float) { found++; return WorldSize; });
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("boxes hit per ray", (double)found / (double)(state.iterations() > 0 ? state.iterations() : 1));
+}
@@ -0,0 +1,374 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "FrameCapture.h"
+#include "image_DXT.h"
+#include "PNGWriter.h"
+#include "YUVConverter.h"
+#include <stb/stb_image.h>
+
+// Frame of smooth gradients and a few edges, rows bottom first as read back
+static std::vector<unsigned char> createFrame(int width, int height, int channels)
+{
+	std::vector<unsigned char> pixels((size_t)width * height * channels);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			unsigned char* p = &pixels[((size_t)y * width + x) * channels];
+			for (int c = 0; c < channels; c++)
+				p[c] = (unsigned char)((x * (c + 1) + y * 3 + ((x / 64 + y / 64) & 1) * 80) & 255);
+		}
+	}
+	return pixels;
+}
+
+static std::vector<unsigned char> readFile(const std::string& filename)
+{
+	std::ifstream in(filename, std::ios::binary);
+	return std::vector<unsigned char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static CaptureJob createJob(const std::string& filename, CaptureFormat format, int width, int height, const std::vector<unsigned char>& pixels, int slot)
+{
+	CaptureJob job;
+	job.filename = filename;
+	job.format = format;
+	job.width = width;
+	job.height = height;
+	job.pixels = &pixels[0];
+	job.slot = slot;
+	return job;
+}
+
+// Writer thread work for a 1920 x 1080 capture: row flip, encoding (PNG, raw, DDS) and file
+BENCHMARK(BM_FrameCapture_Write, CapturePNG, CaptureRaw, CaptureDDS)
+{
+	const int width = 1920, height = 1080;
+	CaptureFormat format = (CaptureFormat)state.arg();
+	std::vector<unsigned char> pixels = createFrame(width, height, 4);
+	std::string filename = std::string("FrameCaptureBench") + (format == CapturePNG ? ".png" : (format == CaptureRaw ? ".raw" : ".dds"));
+	CaptureJob job = createJob(filename, format, width, height, pixels, 0);
+	std::vector<unsigned char> scratch;
+	long long failed = 0;
+
+	while (state.keepRunning())
+		failed += !CaptureWriter::write(job, scratch);
+
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("frame MB", pixels.size() / (1024.0 * 1024.0));
+	state.setCounter("file MB", readFile(filename).size() / (1024.0 * 1024.0));
+	state.setCounter("failed", (double)failed);
+	std::remove(filename.c_str());
+}
+
+/*
+ * Render thread side of continuous captures: a 1920 x 1080 PNG handed to the writer every arg() frames, at most three in
+ * flight as with the readback buffers. Times the hand over and the recycling of the slots, not the encoding.
+ */
+BENCHMARK(BM_FrameCapture_Submit, 1, 8)
+{
+	const int width = 1920, height = 1080, slots = 3;
+	int interval = (int)state.arg();
+	std::vector<std::vector<unsigned char> > pixels(slots, createFrame(width, height, 4));
+	std::vector<bool> busy(slots, false);
+	std::vector<int> finished;
+	CaptureWriter writer;
+	writer.start();
+	long long frame = 0, submitted = 0, dropped = 0;
+
+	while (state.keepRunning())
+	{
+		finished.clear();
+		writer.popFinished(finished);
+		for (size_t i = 0; i < finished.size(); i++)
+			busy[finished[i]] = false;
+		if (frame++ % interval != 0)
+			continue;
+		int s = 0;
+		while (s < slots && busy[s])
+			s++;
+		if (s == slots)
+		{
+			dropped++;
+			continue;
+		}
+		busy[s] = true;
+		writer.submit(createJob("FrameCaptureBench_" + std::to_string(s) + ".png", CapturePNG, width, height, pixels[s], s));
+		submitted++;
+	}
+	writer.stop();
+
+	CaptureStats stats;
+	writer.getStats(stats);
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("captures", (double)submitted);
+	state.setCounter("dropped", (double)dropped);
+	state.setCounter("encode ms", stats.written > 0 ? stats.encodeTime / stats.written : 0.0);
+	for (int s = 0; s < slots; s++)
+		std::remove(("FrameCaptureBench_" + std::to_string(s) + ".png").c_str());
+}
+
+// RGBA to YUV 4:2:0 of a 1920 x 1080 frame read back: scalar (0) or SSE2 (1)
+BENCHMARK(BM_FrameCapture_YUV, 0, 1)
+{
+	const int width = 1920, height = 1080;
+	std::vector<unsigned char> pixels = createFrame(width, height, 4);
+	std::vector<unsigned char> yuv(getYUV420Size(width, height));
+	while (state.keepRunning())
+	{
+		if (state.arg())
+			convertRGBAToYUV420(&pixels[0], width, height, true, &yuv[0]);
+		else
+			convertRGBAToYUV420Scalar(&pixels[0], width, height, true, &yuv[0]);
+		doNotOptimize(yuv[0]);
+	}
+	state.setItemsProcessed(state.iterations() * width * height);
+}
+
+/*
+ * Recording of a 1280 x 720 Y4M stream, every arg() frames, by frames of 2 ms (the render thread waiting for the GPU): the
+ * readbacks go through three buffers as in FrameCapture, frames being dropped when the writer is behind. Reports the
+ * render thread time spent on the capture per frame.
+ */
+BENCHMARK(BM_FrameCapture_Record, 1, 4)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	const int width = 1280, height = 720, slots = 3;
+	int interval = (int)state.arg();
+	std::vector<std::vector<unsigned char> > pixels(slots, createFrame(width, height, 4));
+	std::vector<bool> busy(slots, false);
+	std::vector<int> finished;
+	std::shared_ptr<VideoStream> stream = std::make_shared<VideoStream>("FrameCaptureBench.y4m", VideoY4M, width, height, 60);
+	CaptureWriter writer;
+	writer.start();
+	long long frame = 0, recorded = 0, dropped = 0;
+	double overhead = 0.0, maxOverhead = 0.0;
+
+	while (state.keepRunning())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		Clock::time_point start = Clock::now();
+		finished.clear();
+		writer.popFinished(finished);
+		for (size_t i = 0; i < finished.size(); i++)
+			busy[finished[i]] = false;
+		if (frame++ % interval == 0)
+		{
+			recorded++;
+			int s = 0;
+			while (s < slots && busy[s])
+				s++;
+			if (s == slots)
+				dropped++;
+			else
+			{
+				busy[s] = true;
+				CaptureJob job = createJob("", CapturePNG, width, height, pixels[s], s);
+				job.stream = stream;
+				writer.submit(job);
+			}
+		}
+		double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		overhead += time;
+		maxOverhead = std::max(maxOverhead, time);
+	}
+	stream.reset();
+	writer.stop();
+
+	CaptureStats stats;
+	writer.getStats(stats);
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("recorded frames", (double)recorded);
+	state.setCounter("dropped %", recorded > 0 ? 100.0 * dropped / recorded : 0.0);
+	state.setCounter("capture ms per frame", overhead / frame);
+	state.setCounter("capture ms max", maxOverhead);
+	state.setCounter("encode ms per frame", stats.framesWritten > 0 ? stats.encodeTime / stats.framesWritten : 0.0);
+	std::remove("FrameCaptureBench.y4m");
+}
+
+/*
+ * PNG files decoded back by stb_image for every channel count (several stored blocks for the larger ones), captures written
+ * top row first in the three formats, DDS matching image_DXT, formats chosen from the names, and failed writes giving
+ * their slot back.
+ */
+BENCHMARK(BM_FrameCapture_Validate, 1)
+{
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		const int sizes[3][2] = { { 1, 1 }, { 37, 23 }, { 300, 200 } };
+		for (int channels = 1; channels <= 4; channels++)
+		{
+			for (int s = 0; s < 3; s++)
+			{
+				int width = sizes[s][0], height = sizes[s][1];
+				std::vector<unsigned char> pixels = createFrame(width, height, channels);
+				std::vector<unsigned char> png;
+				if (!encodePNG(width, height, channels, &pixels[0], png))
+				{
+					mismatches++;
+					continue;
+				}
+				int w, h, c;
+				unsigned char* decoded = stbi_load_from_memory(&png[0], (int)png.size(), &w, &h, &c, 0);
+				if (decoded == NULL || w != width || h != height || c != channels || memcmp(decoded, &pixels[0], pixels.size()) != 0)
+					mismatches++;
+				stbi_image_free(decoded);
+			}
+		}
+
+		const int width = 64, height = 48;
+		std::vector<unsigned char> pixels = createFrame(width, height, 4);
+		std::vector<unsigned char> flipped(pixels.size());
+		size_t row = width * 4;
+		for (int y = 0; y < height; y++)
+			memcpy(&flipped[row * y], &pixels[row * (height - 1 - y)], row);
+		std::vector<unsigned char> scratch;
+
+		CaptureJob job = createJob("FrameCaptureBench.png", CapturePNG, width, height, pixels, 0);
+		std::vector<unsigned char> file;
+		int w, h, c;
+		unsigned char* decoded = NULL;
+		if (CaptureWriter::write(job, scratch))
+		{
+			file = readFile(job.filename);
+			decoded = stbi_load_from_memory(&file[0], (int)file.size(), &w, &h, &c, 4);
+		}
+		if (decoded == NULL || w != width || h != height || memcmp(decoded, &flipped[0], flipped.size()) != 0)
+			mismatches++;
+		stbi_image_free(decoded);
+		std::remove(job.filename.c_str());
+
+		job = createJob("FrameCaptureBench.raw", CaptureRaw, width, height, pixels, 0);
+		if (!CaptureWriter::write(job, scratch) || readFile(job.filename) != flipped)
+			mismatches++;
+		std::remove(job.filename.c_str());
+
+		job = createJob("FrameCaptureBench.dds", CaptureDDS, width, height, pixels, 0);
+		int size = 0;
+		unsigned char* blocks = convert_image_to_DXT5(&flipped[0], width, height, 4, &size);
+		file.clear();
+		if (CaptureWriter::write(job, scratch))
+			file = readFile(job.filename);
+		if (file.size() != 128 + (size_t)size || memcmp(&file[0], "DDS ", 4) != 0 || memcmp(&file[128], blocks, size) != 0)
+			mismatches++;
+		free(blocks);
+		std::remove(job.filename.c_str());
+
+		if (CaptureWriter::formatFromName("a.PNG") != CapturePNG || CaptureWriter::formatFromName("a.b.dds") != CaptureDDS
+			|| CaptureWriter::formatFromName("a.raw") != CaptureRaw || CaptureWriter::formatFromName("screenshot") != CapturePNG)
+			mismatches++;
+
+		// Through the thread, a failed write among written ones
+		CaptureWriter writer;
+		writer.start();
+		writer.submit(createJob("FrameCaptureBench_0.png", CapturePNG, width, height, pixels, 0));
+		writer.submit(createJob("FrameCaptureBench_missing/1.png", CapturePNG, width, height, pixels, 1));
+		writer.submit(createJob("FrameCaptureBench_2.raw", CaptureRaw, width, height, pixels, 2));
+		writer.stop();
+		std::vector<int> finished;
+		writer.popFinished(finished);
+		CaptureStats stats;
+		writer.getStats(stats);
+		if (finished.size() != 3 || finished[0] != 0 || finished[1] != 1 || finished[2] != 2 || stats.written != 2 || stats.failed != 1
+			|| writer.getPendingCount() != 0 || readFile("FrameCaptureBench_2.raw") != flipped)
+			mismatches++;
+		std::remove("FrameCaptureBench_0.png");
+		std::remove("FrameCaptureBench_2.raw");
+
+		// SSE2 conversion identical to the scalar one, odd sizes and both row orders
+		const int yuvSizes[5][2] = { { 1, 1 }, { 7, 5 }, { 16, 2 }, { 33, 17 }, { 64, 48 } };
+		for (int s = 0; s < 5; s++)
+		{
+			int w = yuvSizes[s][0], h = yuvSizes[s][1];
+			std::vector<unsigned char> rgba = createFrame(w, h, 4);
+			for (int bottomUp = 0; bottomUp < 2; bottomUp++)
+			{
+				std::vector<unsigned char> simd(getYUV420Size(w, h), 0), scalar(getYUV420Size(w, h), 1);
+				convertRGBAToYUV420(&rgba[0], w, h, bottomUp != 0, &simd[0]);
+				convertRGBAToYUV420Scalar(&rgba[0], w, h, bottomUp != 0, &scalar[0]);
+				if (simd != scalar)
+					mismatches++;
+			}
+		}
+		// White, black and red (BT.601 limited range), over a 2 x 2 block
+		const unsigned char colors[3][4] = { { 255, 255, 255, 255 }, { 0, 0, 0, 255 }, { 255, 0, 0, 255 } };
+		const unsigned char expected[3][3] = { { 235, 128, 128 }, { 16, 128, 128 }, { 82, 90, 240 } };
+		for (int i = 0; i < 3; i++)
+		{
+			unsigned char rgba[16], yuv[6];
+			for (int p = 0; p < 4; p++)
+				memcpy(rgba + 4 * p, colors[i], 4);
+			convertRGBAToYUV420(rgba, 2, 2, false, yuv);
+			if (yuv[0] != expected[i][0] || yuv[3] != expected[i][0] || yuv[4] != expected[i][1] || yuv[5] != expected[i][2])
+				mismatches++;
+		}
+
+		// Streams through the writer: frames in order, the stream closed with its last frame
+		std::vector<std::vector<unsigned char> > frames;
+		for (int f = 0; f < 3; f++)
+		{
+			frames.push_back(createFrame(width, height, 4));
+			for (size_t i = 0; i < frames[f].size(); i += 7)
+				frames[f][i] ^= (unsigned char)(40 * f);
+		}
+		for (int format = VideoY4M; format <= VideoRGB; format++)
+		{
+			std::string target = format == VideoY4M ? "FrameCaptureBench.y4m" : "FrameCaptureBench.rgb";
+			if (VideoStream::formatFromName(target) != format || VideoStream::formatFromName("|ffmpeg -i - out.mp4") != VideoY4M)
+				mismatches++;
+			std::shared_ptr<VideoStream> stream = std::make_shared<VideoStream>(target, (VideoFormat)format, width, height, 30);
+			CaptureWriter streamWriter;
+			streamWriter.start();
+			for (int f = 0; f < 3; f++)
+			{
+				CaptureJob frameJob = createJob("", CapturePNG, width, height, frames[f], f);
+				frameJob.stream = stream;
+				streamWriter.submit(frameJob);
+			}
+			stream.reset();
+			streamWriter.stop();
+			streamWriter.getStats(stats);
+			std::vector<unsigned char> expectedFile;
+			if (format == VideoY4M)
+			{
+				std::string header = "YUV4MPEG2 W64 H48 F30:1 Ip A1:1 C420jpeg\n";
+				expectedFile.assign(header.begin(), header.end());
+			}
+			for (int f = 0; f < 3; f++)
+			{
+				std::vector<unsigned char> converted;
+				if (format == VideoY4M)
+				{
+					converted.resize(getYUV420Size(width, height));
+					convertRGBAToYUV420Scalar(&frames[f][0], width, height, true, &converted[0]);
+					const char frameTag[] = "FRAME\n";
+					expectedFile.insert(expectedFile.end(), frameTag, frameTag + 6);
+				}
+				else
+				{
+					for (int y = height - 1; y >= 0; y--)
+					{
+						for (int x = 0; x < width; x++)
+							converted.insert(converted.end(), &frames[f][(y * width + x) * 4], &frames[f][(y * width + x) * 4] + 3);
+					}
+				}
+				expectedFile.insert(expectedFile.end(), converted.begin(), converted.end());
+			}
+			if (readFile(target) != expectedFile || stats.framesWritten != 3 || stats.framesFailed != 0 || stats.written != 0)
+				mismatches++;
+			std::remove(target.c_str());
+		}
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setMismatches(mismatches);
+}
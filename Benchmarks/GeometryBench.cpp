@@ -0,0 +1,101 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <glm/gtc/constants.hpp>
+
+#include "Benchmark.h"
+#include "GeometricModel.h"
+#include "GeometricModelLoader/OBJLoader.h"
+
+// Write a UV sphere with about triangleCount triangles and texture coordinates, in the format read by OBJLoader
+static std::string writeSphereOBJ(long long triangleCount)
+{
+	int slices = (int)std::ceil(std::sqrt((double)triangleCount / 2.0));
+	int stacks = slices;
+	std::string filename = "BenchSphere" + std::to_string(triangleCount) + ".obj";
+
+	std::ofstream file(filename.c_str());
+	for (int j = 0; j <= stacks; j++)
+	{
+		float phi = glm::pi<float>() * (float)j / (float)stacks;
+		for (int i = 0; i <= slices; i++)
+		{
+			float theta = glm::two_pi<float>() * (float)i / (float)slices;
+			file << "v " << std::sin(phi) * std::cos(theta) << " " << std::cos(phi) << " " << std::sin(phi) * std::sin(theta) << "\n";
+		}
+	}
+	for (int j = 0; j <= stacks; j++)
+		for (int i = 0; i <= slices; i++)
+			file << "vt " << (float)i / slices << " " << (float)j / stacks << "\n";
+	for (int j = 0; j < stacks; j++)
+	{
+		for (int i = 0; i < slices; i++)
+		{
+			// OBJ indices start at 1, vertices and texture coordinates share the same numbering here
+			int a = j * (slices + 1) + i + 1;
+			int b = a + slices + 1;
+			file << "f " << a << "/" << a << " " << b << "/" << b << " " << a + 1 << "/" << a + 1 << "\n";
+			file << "f " << a + 1 << "/" << a + 1 << " " << b << "/" << b << " " << b + 1 << "/" << b + 1 << "\n";
+		}
+	}
+	return filename;
+}
+
+BENCHMARK(BM_OBJLoader_LoadModel, 10000, 100000, 1000000)
+{
+	std::string filename = writeSphereOBJ(state.arg());
+	OBJLoader loader;
+	int faces = 0, vertices = 0;
+	while (state.keepRunning())
+	{
+		GeometricModel model;
+		loader.loadModel(filename, &model);
+		faces = model.nb_faces;
+		vertices = model.nb_vertex;
+		state.pauseTiming();	// Exclude the destruction
+		model.listVertex.clear();
+		state.resumeTiming();
+	}
+	state.setItemsProcessed(state.iterations() * faces);
+	state.setCounter("faces", faces);
+	state.setCounter("vertices", vertices);
+	std::remove(filename.c_str());
+}
+
+// Normals and tangents are recomputed on a loaded model, the previous results being cleared outside of the timing
+BENCHMARK(BM_OBJLoader_ComputeNormals, 10000, 100000, 1000000)
+{
+	std::string filename = writeSphereOBJ(state.arg());
+	GeometricModel model;
+	OBJLoader loader;
+	loader.loadModel(filename, &model);
+	std::remove(filename.c_str());
+
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		model.listNormals.clear();
+		state.resumeTiming();
+		OBJLoader::computeNormals(&model);
+	}
+	state.setItemsProcessed(state.iterations() * model.nb_faces);
+}
+
+BENCHMARK(BM_OBJLoader_ComputeTangents, 10000, 100000, 1000000)
+{
+	std::string filename = writeSphereOBJ(state.arg());
+	GeometricModel model;
+	OBJLoader loader;
+	loader.loadModel(filename, &model);
+	std::remove(filename.c_str());
+
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		model.listTangents.clear();
+		state.resumeTiming();
+		OBJLoader::computeTangents(&model);
+	}
+	state.setItemsProcessed(state.iterations() * model.nb_faces);
+}
@@ -0,0 +1,130 @@
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Benchmark.h"
+#include "LightClusters.h"
+
+static const float ZNear = 1.0f;
+static const float ZFar = 2000.0f;
+
+// Camera of the application: 45 degrees, 16:9, looking at the origin from the +z side
+static glm::mat4 projection()
+{
+	return glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, ZNear, ZFar);
+}
+
+static glm::mat4 view()
+{
+	return glm::lookAt(glm::vec3(0.0f, 50.0f, 400.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// Lights spread in a cube around the origin, with a radius such that a point is reached by about 8 lights
+static std::vector<PointLight> createLights(long long count, unsigned int seed)
+{
+	const float extent = 600.0f;
+	float radius = extent * std::cbrt(6.0f / (3.14159265f * (float)count));
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> position(-0.5f * extent, 0.5f * extent);
+	std::vector<PointLight> lights(count);
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		float x = position(rng), y = position(rng), z = position(rng);
+		lights[i].position = glm::vec3(x, y, z);
+		lights[i].radius = radius;
+		lights[i].color = glm::vec3(1.0f);
+		lights[i].intensity = 1.0f;
+	}
+	return lights;
+}
+
+static void binBenchmark(BenchmarkState& state, int threads)
+{
+	std::vector<PointLight> lights = createLights(state.arg(), 1);
+	LightClusters clusters;
+	clusters.setup(projection(), ZNear, ZFar);
+	glm::mat4 v = view();
+
+	while (state.keepRunning())
+		clusters.bin(&lights[0], (int)lights.size(), v, threads);
+
+	state.setItemsProcessed(state.iterations() * state.arg());
+	state.setCounter("clusters", clusters.getClusterCount());
+	state.setCounter("light indices", (double)clusters.getLightIndices().size());
+	state.setCounter("max lights per cluster", clusters.getMaxLightsPerCluster());
+	state.setCounter("threads", threads > 0 ? threads : (double)std::thread::hardware_concurrency());
+}
+
+BENCHMARK(BM_LightClusters_Bin_SingleThread, 100, 1000, 10000)
+{
+	binBenchmark(state, 1);
+}
+
+BENCHMARK(BM_LightClusters_Bin_MultiThread, 100, 1000, 10000)
+{
+	binBenchmark(state, 0);
+}
+
+// Every light tested against every cluster box, the cost the column and row ranges avoid
+static void bruteForce(const LightClusters& clusters, const std::vector<PointLight>& viewLights, std::vector< std::vector<unsigned int> >& lists)
+{
+	lists.resize(clusters.getClusterCount());
+	for (int c = 0; c < clusters.getClusterCount(); c++)
+	{
+		lists[c].clear();
+		glm::vec3 bmin = clusters.getClusterMin(c), bmax = clusters.getClusterMax(c);
+		for (size_t i = 0; i < viewLights.size(); i++)
+		{
+			glm::vec3 d = glm::clamp(viewLights[i].position, bmin, bmax) - viewLights[i].position;
+			if (glm::dot(d, d) <= viewLights[i].radius * viewLights[i].radius)
+				lists[c].push_back((unsigned int)i);
+		}
+	}
+}
+
+BENCHMARK(BM_LightClusters_BruteForce, 100, 1000)
+{
+	std::vector<PointLight> lights = createLights(state.arg(), 1);
+	LightClusters clusters;
+	clusters.setup(projection(), ZNear, ZFar);
+	clusters.bin(&lights[0], (int)lights.size(), view(), 1);
+
+	std::vector< std::vector<unsigned int> > lists;
+	while (state.keepRunning())
+		bruteForce(clusters, clusters.getViewLights(), lists);
+	state.setItemsProcessed(state.iterations() * state.arg());
+}
+
+// Validates the binning against the brute force lists, and the multithreaded result against the single threaded one
+BENCHMARK(BM_LightClusters_Validate, 1000)
+{
+	std::vector<PointLight> lights = createLights(state.arg(), 2);
+	LightClusters single, multi;
+	single.setup(projection(), ZNear, ZFar);
+	multi.setup(projection(), ZNear, ZFar);
+
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		single.bin(&lights[0], (int)lights.size(), view(), 1);
+		multi.bin(&lights[0], (int)lights.size(), view(), 4);
+		std::vector< std::vector<unsigned int> > lists;
+		bruteForce(single, single.getViewLights(), lists);
+
+		for (int c = 0; c < single.getClusterCount(); c++)
+		{
+			const LightCluster& s = single.getClusters()[c];
+			const LightCluster& m = multi.getClusters()[c];
+			std::vector<unsigned int> binned(single.getLightIndices().begin() + s.offset, single.getLightIndices().begin() + s.offset + s.count);
+			if (binned != lists[c] || s.offset != m.offset || s.count != m.count)
+				mismatches++;
+		}
+		if (single.getLightIndices() != multi.getLightIndices())
+			mismatches++;
+	}
+	state.setItemsProcessed(state.iterations() * (long long)single.getClusterCount());
+	state.setMismatches(mismatches);
+	state.setCounter("lights per cluster", (double)single.getLightIndices().size() / single.getClusterCount());
+}
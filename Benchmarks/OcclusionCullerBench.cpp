@@ -0,0 +1,137 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Benchmark.h"
+#include "OcclusionCuller.h"
+
+// Unit cube [-1,1]^3 as 12 triangles
+static const glm::vec3 CubeVertices[8] = {
+	glm::vec3(-1, -1, -1), glm::vec3(1, -1, -1), glm::vec3(1, 1, -1), glm::vec3(-1, 1, -1),
+	glm::vec3(-1, -1, 1), glm::vec3(1, -1, 1), glm::vec3(1, 1, 1), glm::vec3(-1, 1, 1)
+};
+static const int CubeIndices[36] = {
+	0, 2, 1, 0, 3, 2,	4, 5, 6, 4, 6, 7,	0, 1, 5, 0, 5, 4,
+	3, 7, 6, 3, 6, 2,	0, 4, 7, 0, 7, 3,	1, 2, 6, 1, 6, 5
+};
+
+// City block layout : buildings on a grid of streets, small objects scattered on the ground between them
+static const float CitySize = 400.0f;
+
+static std::vector<glm::mat4> createBuildings(int count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> height(5.0f, 30.0f);
+	int side = (int)std::ceil(std::sqrt((double)count));
+	float spacing = CitySize / side;
+	std::vector<glm::mat4> buildings;
+	for (int i = 0; i < count; i++)
+	{
+		float h = height(rng);
+		glm::vec3 center((i % side + 0.5f) * spacing, h, (i / side + 0.5f) * spacing);
+		glm::mat4 m = glm::translate(glm::mat4(1.0f), center);
+		buildings.push_back(glm::scale(m, glm::vec3(0.35f * spacing, h, 0.35f * spacing)));
+	}
+	return buildings;
+}
+
+static std::vector<AABB> createObjects(long long count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> pos(0.0f, CitySize);
+	std::uniform_real_distribution<float> size(0.2f, 1.0f);
+	std::vector<AABB> objects;
+	for (long long i = 0; i < count; i++)
+	{
+		glm::vec3 c(pos(rng), size(rng), pos(rng));
+		glm::vec3 h(size(rng));
+		objects.push_back(AABB(c - h, c + h));
+	}
+	return objects;
+}
+
+// Street level camera at a corner of the city looking along the diagonal
+static glm::mat4 cityViewProjection()
+{
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.5f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(-5.0f, 2.0f, -5.0f), glm::vec3(CitySize, 0.0f, CitySize), glm::vec3(0.0f, 1.0f, 0.0f));
+	return proj * view;
+}
+
+static void renderCity(OcclusionCuller& culler, const std::vector<glm::mat4>& buildings)
+{
+	culler.beginFrame(cityViewProjection());
+	for (size_t i = 0; i < buildings.size(); i++)
+		culler.renderOccluder(CubeVertices, CubeIndices, 12, buildings[i]);
+	culler.finalize();
+}
+
+BENCHMARK(BM_OcclusionCuller_Rasterize, 64, 256, 1024, 4096)
+{
+	std::vector<glm::mat4> buildings = createBuildings((int)state.arg(), 1);
+	OcclusionCuller culler;
+	while (state.keepRunning())
+		renderCity(culler, buildings);
+	state.setItemsProcessed(state.iterations() * culler.getOccluderTriangles());
+	state.setCounter("occluder triangles", culler.getOccluderTriangles());
+	state.setCounter("raster ms per frame", culler.getRasterTime());
+}
+
+// One iteration = one frame : rasterize the buildings, then test the objects that pass the frustum test
+BENCHMARK(BM_OcclusionCuller_Frame, 10000, 100000)
+{
+	std::vector<glm::mat4> buildings = createBuildings(256, 1);
+	std::vector<AABB> objects = createObjects(state.arg(), 2);
+	Frustum frustum(cityViewProjection());
+	std::vector<AABB> candidates;
+	for (size_t i = 0; i < objects.size(); i++)
+		if (frustum.overlaps(objects[i]))
+			candidates.push_back(objects[i]);
+
+	OcclusionCuller culler;
+	long long visible = 0;
+	while (state.keepRunning())
+	{
+		renderCity(culler, buildings);
+		for (size_t i = 0; i < candidates.size(); i++)
+			if (culler.isVisible(candidates[i]))
+				visible++;
+	}
+	long long iterations = state.iterations() > 0 ? state.iterations() : 1;
+	state.setItemsProcessed(state.iterations() * (long long)candidates.size());
+	state.setCounter("frustum candidates", (double)candidates.size());
+	state.setCounter("occluded per frame", (double)candidates.size() - (double)visible / (double)iterations);
+	state.setCounter("raster ms per frame", culler.getRasterTime());
+}
+
+// Checks the expected answers on simple configurations : a wall facing the camera hides what is behind it only
+BENCHMARK(BM_OcclusionCuller_Validate, 1)
+{
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 wall = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)), glm::vec3(5.0f, 5.0f, 0.1f));
+
+	struct Case { AABB box; bool visible; };
+	Case cases[] = {
+		{ AABB(glm::vec3(-1.0f, -1.0f, -22.0f), glm::vec3(1.0f, 1.0f, -20.0f)), false },	// Behind the wall
+		{ AABB(glm::vec3(-1.0f, -1.0f, -6.0f), glm::vec3(1.0f, 1.0f, -4.0f)), true },		// In front of the wall
+		{ AABB(glm::vec3(4.0f, -1.0f, -22.0f), glm::vec3(14.0f, 1.0f, -20.0f)), true },		// Partly behind the wall
+		{ AABB(glm::vec3(-1.0f, -1.0f, -11.0f), glm::vec3(1.0f, 1.0f, -9.0f)), true },		// Crossing the wall
+		{ AABB(glm::vec3(-1.0f, -1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 3.0f)), true }			// Behind the camera
+	};
+	int caseCount = sizeof(cases) / sizeof(cases[0]);
+
+	OcclusionCuller culler;
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		culler.beginFrame(proj * view);
+		culler.renderOccluder(CubeVertices, CubeIndices, 12, wall);
+		culler.finalize();
+		for (int i = 0; i < caseCount; i++)
+			if (culler.isVisible(cases[i].box) != cases[i].visible)
+				mismatches++;
+	}
+	state.setMismatches(mismatches);
+}
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "RenderTargetPool.h"
+#include "Texture2D.h"
+#include "TransientPool.hpp"
+
+// Stand in for the GL textures: items are indices in a table of descriptors
+struct TargetTable
+{
+	std::vector<uint64_t> keys;
+
+	int acquire(TransientPool<int>& pool, int width, int height, GLenum format)
+	{
+		uint64_t key = RenderTargetPool::makeKey(width, height, format);
+		int item;
+		if (!pool.acquire(key, item))
+		{
+			item = (int)keys.size();
+			keys.push_back(key);
+			pool.add(key, item, Texture2D::getStorageSize(format, width, height, 1));
+		}
+		return item;
+	}
+};
+
+/*
+ * Frame of a deferred renderer at 1920 x 1080: a G-buffer (three color targets and depth) read by the lighting, then a
+ * post-processing chain of arg() passes (downsampled bloom levels and full resolution passes), each pass releasing its
+ * input once it has read it. Times the pool operations of a frame.
+ */
+BENCHMARK(BM_RenderTargetPool_Frame, 8, 32)
+{
+	const int width = 1920, height = 1080;
+	int passes = (int)state.arg();
+	TransientPool<int> pool(30);
+	TargetTable table;
+	std::vector<int> expired;
+	long long frames = 0;
+
+	while (state.keepRunning())
+	{
+		int albedo = table.acquire(pool, width, height, GL_RGBA8);
+		int normals = table.acquire(pool, width, height, GL_RGBA16F);
+		int material = table.acquire(pool, width, height, GL_RGBA8);
+		int depth = table.acquire(pool, width, height, GL_DEPTH_COMPONENT24);
+		int lit = table.acquire(pool, width, height, GL_RGBA16F);
+		pool.release(albedo);
+		pool.release(normals);
+		pool.release(material);
+
+		int input = lit;
+		for (int p = 0; p < passes; p++)
+		{
+			// Bloom down and up the mip sizes, then full resolution passes
+			int level = p < 10 ? std::min(p + 1, 10 - p) : 0;
+			int output = table.acquire(pool, std::max(1, width >> level), std::max(1, height >> level), GL_RGBA16F);
+			pool.release(input);
+			input = output;
+		}
+		pool.release(input);
+		pool.release(depth);
+		expired.clear();
+		pool.endFrame(expired);
+		frames++;
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("peak MB", pool.getPeakBytes() / (1024.0 * 1024.0));
+	state.setCounter("without aliasing MB", pool.getRequestedBytes() / (1024.0 * 1024.0));
+	state.setCounter("pooled MB", pool.getPooledBytes() / (1024.0 * 1024.0));
+	state.setCounter("targets created", (double)pool.getCreatedCount());
+}
+
+/*
+ * Window resized during arg() frames (a new size each frame) then back to its first size: a color and depth target of
+ * the window size each frame. Counts the targets created back at the first size (none while still pooled) and the
+ * pooled memory left once the old sizes expire.
+ */
+BENCHMARK(BM_RenderTargetPool_Resize, 10, 60)
+{
+	int drag = (int)state.arg();
+	long long createdAfter = 0, pooledPeak = 0, pooledEnd = 0;
+	while (state.keepRunning())
+	{
+		TransientPool<int> pool(30);
+		TargetTable table;
+		std::vector<int> expired;
+		long long createdBefore = 0;
+		for (int frame = 0; frame < drag + 60; frame++)
+		{
+			int width = 1280, height = 720;
+			if (frame >= 5 && frame < 5 + drag)
+			{
+				width += 8 * (frame - 4);
+				height += 4 * (frame - 4);
+			}
+			if (frame == 5 + drag)
+				createdBefore = pool.getCreatedCount();
+			int color = table.acquire(pool, width, height, GL_RGBA8);
+			int depth = table.acquire(pool, width, height, GL_DEPTH_COMPONENT24);
+			pool.release(color);
+			pool.release(depth);
+			expired.clear();
+			pool.endFrame(expired);
+			pooledPeak = std::max(pooledPeak, (long long)pool.getPooledBytes());
+			if (frame == 5 + drag)
+				createdAfter = pool.getCreatedCount() - createdBefore;
+		}
+		pooledEnd = pool.getPooledBytes();
+	}
+	state.setItemsProcessed(state.iterations() * (drag + 60));
+	state.setCounter("created back at first size", (double)createdAfter);
+	state.setCounter("pooled peak MB", pooledPeak / (1024.0 * 1024.0));
+	state.setCounter("pooled end MB", pooledEnd / (1024.0 * 1024.0));
+}
+
+/*
+ * Video memory of an arg() x arg() framebuffer: an RGBA8 color and 24 bits depth target with whole mip chains (textures
+ * as created before), single level attachments with depth in a renderbuffer, and a 4x MSAA G-buffer (three color
+ * targets and depth) with its resolve textures. Times the pool keys and sizes of the attachments of a framebuffer.
+ */
+BENCHMARK(BM_RenderTargetPool_Attachments, 1024, 8192)
+{
+	int side = (int)state.arg();
+	int levels = 1;
+	while ((side >> levels) > 0)
+		levels++;
+	const GLenum gbuffer[3] = { GL_RGBA8, GL_RGBA16F, GL_RGBA8 };
+	size_t mipChain = Texture2D::getStorageSize(GL_RGBA8, side, side, levels) + Texture2D::getStorageSize(GL_DEPTH_COMPONENT24, side, side, levels);
+	size_t singleLevel = 0, multisampled = 0;
+	uint64_t keys = 0;
+	while (state.keepRunning())
+	{
+		singleLevel = Texture2D::getStorageSize(GL_RGBA8, side, side, 1) + RenderTargetPool::getRenderbufferSize(side, side, GL_DEPTH_COMPONENT24, 1);
+		multisampled = RenderTargetPool::getRenderbufferSize(side, side, GL_DEPTH_COMPONENT24, 4);
+		keys ^= RenderTargetPool::makeKey(side, side, GL_DEPTH_COMPONENT24, 4);
+		for (int i = 0; i < 3; i++)
+		{
+			multisampled += RenderTargetPool::getRenderbufferSize(side, side, gbuffer[i], 4) + Texture2D::getStorageSize(gbuffer[i], side, side, 1);
+			keys ^= RenderTargetPool::makeKey(side, side, gbuffer[i], 4) ^ RenderTargetPool::makeKey(side, side, gbuffer[i]);
+		}
+		doNotOptimize(keys);
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("mip chain MB", mipChain / (1024.0 * 1024.0));
+	state.setCounter("single level MB", singleLevel / (1024.0 * 1024.0));
+	state.setCounter("4x MSAA G-buffer MB", multisampled / (1024.0 * 1024.0));
+}
+
+/*
+ * Random acquires and releases against a brute force model: an item never handed out twice at once, free items of the
+ * key reused before creating, byte counts and frame peaks, expiry of the free items only, and distinct keys.
+ */
+BENCHMARK(BM_RenderTargetPool_Validate, 300)
+{
+	int frames = (int)state.arg();
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		const int keepFrames = 5;
+		TransientPool<int> pool(keepFrames);
+		TargetTable table;
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<int> pickSize(0, 2), pickFormat(0, 1), pickAction(0, 2);
+		const int sides[3] = { 256, 512, 1024 };
+		const GLenum formats[2] = { GL_RGBA8, GL_RGBA16F };
+
+		std::vector<int> inUse;
+		std::map<int, long long> lastUsed;		// Tracked items
+		std::map<int, size_t> bytes;
+		std::vector<int> expired;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			size_t peak = 0;
+			for (size_t i = 0; i < inUse.size(); i++)
+				peak += bytes[inUse[i]];
+			for (int op = 0; op < 20; op++)
+			{
+				if (pickAction(rng) > 0 || inUse.empty())
+				{
+					int side = sides[pickSize(rng)];
+					GLenum format = formats[pickFormat(rng)];
+					uint64_t key = RenderTargetPool::makeKey(side, side, format);
+					bool freeOfKey = false;
+					for (std::map<int, long long>::iterator it = lastUsed.begin(); it != lastUsed.end(); ++it)
+					{
+						if (table.keys[it->first] == key && std::find(inUse.begin(), inUse.end(), it->first) == inUse.end())
+							freeOfKey = true;
+					}
+					long long created = pool.getCreatedCount();
+					int item = table.acquire(pool, side, side, format);
+					if (table.keys[item] != key || std::find(inUse.begin(), inUse.end(), item) != inUse.end()
+						|| freeOfKey == (pool.getCreatedCount() != created))
+						mismatches++;
+					inUse.push_back(item);
+					lastUsed[item] = frame;
+					bytes[item] = Texture2D::getStorageSize(format, side, side, 1);
+				}
+				else
+				{
+					size_t i = rng() % inUse.size();
+					pool.release(inUse[i]);
+					lastUsed[inUse[i]] = frame;
+					inUse.erase(inUse.begin() + i);
+				}
+				size_t inUseBytes = 0, pooledBytes = 0;
+				for (size_t i = 0; i < inUse.size(); i++)
+					inUseBytes += bytes[inUse[i]];
+				for (std::map<int, long long>::iterator it = lastUsed.begin(); it != lastUsed.end(); ++it)
+					pooledBytes += bytes[it->first];
+				peak = std::max(peak, inUseBytes);
+				if (inUseBytes != pool.getInUseBytes() || pooledBytes != pool.getPooledBytes() || (int)lastUsed.size() != pool.getCount())
+					mismatches++;
+			}
+
+			// Targets held over the frames are released some frames later
+			expired.clear();
+			pool.endFrame(expired);
+			if (pool.getPeakBytes() != peak)
+				mismatches++;
+			for (size_t e = 0; e < expired.size(); e++)
+			{
+				int item = expired[e];
+				if (std::find(inUse.begin(), inUse.end(), item) != inUse.end() || lastUsed[item] > frame - keepFrames)
+					mismatches++;
+				lastUsed.erase(item);
+			}
+			for (std::map<int, long long>::iterator it = lastUsed.begin(); it != lastUsed.end(); ++it)
+			{
+				bool free = std::find(inUse.begin(), inUse.end(), it->first) == inUse.end();
+				if (free && it->second <= frame - keepFrames)
+					mismatches++;
+				if (pool.isInUse(it->first) == free)
+					mismatches++;
+			}
+		}
+
+		if (RenderTargetPool::makeKey(1920, 1080, GL_RGBA8) == RenderTargetPool::makeKey(1080, 1920, GL_RGBA8)
+			|| RenderTargetPool::makeKey(1920, 1080, GL_RGBA8) == RenderTargetPool::makeKey(1920, 1080, GL_RGBA16F)
+			|| RenderTargetPool::makeKey(1920, 1080, GL_RGBA8) == RenderTargetPool::makeKey(1920, 1080, GL_RGBA8, 4)
+			|| RenderTargetPool::makeKey(8192, 8192, GL_DEPTH32F_STENCIL8, 8) == RenderTargetPool::makeKey(8192, 8192, GL_DEPTH32F_STENCIL8, 4)
+			|| RenderTargetPool::makeKey(2048, 2048, GL_DEPTH_COMPONENT24) == RenderTargetPool::makeKey(2048, 2048, GL_DEPTH_COMPONENT24, 0, RenderTargetShadowMap))
+			mismatches++;
+		if (RenderTargetPool::getRenderbufferSize(1920, 1080, GL_RGBA16F, 4) != 4 * Texture2D::getStorageSize(GL_RGBA16F, 1920, 1080, 1)
+			|| RenderTargetPool::getRenderbufferSize(1920, 1080, GL_RGBA16F, 0) != Texture2D::getStorageSize(GL_RGBA16F, 1920, 1080, 1))
+			mismatches++;
+	}
+	state.setItemsProcessed(state.iterations() * frames);
+	state.setMismatches(mismatches);
+}
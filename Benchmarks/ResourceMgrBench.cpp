@@ -0,0 +1,179 @@
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Resource_mgr.hpp"
+
+// Resources are only constructed from their name, like models and effects
+class BenchResource
+{
+public:
+	explicit BenchResource(std::string name) : m_Name(name) {}
+	virtual ~BenchResource() {}
+	const std::string& getName() const { return m_Name; }
+private:
+	std::string m_Name;
+};
+
+class DerivedBenchResource : public BenchResource
+{
+public:
+	explicit DerivedBenchResource(std::string name) : BenchResource(name) {}
+};
+
+static std::vector<std::string> resourceNames(long long count)
+{
+	std::vector<std::string> names;
+	for (long long i = 0; i < count; i++)
+		names.push_back("Models/Resource" + std::to_string(i) + ".obj");
+	return names;
+}
+
+static void fill(Resource_mgr<BenchResource>& mgr, const std::vector<std::string>& names)
+{
+	for (size_t i = 0; i < names.size(); i++)
+		mgr.insert(names[i], new DerivedBenchResource(names[i]));
+}
+
+BENCHMARK(BM_ResourceMgr_GetByName, 1000, 100000)
+{
+	std::vector<std::string> names = resourceNames(state.arg());
+	Resource_mgr<BenchResource> mgr;
+	fill(mgr, names);
+
+	size_t i = 0;
+	while (state.keepRunning())
+	{
+		doNotOptimize(mgr.get(names[i]));
+		i = (i + 7919) % names.size();
+	}
+	state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ResourceMgr_GetTypedByName, 1000, 100000)
+{
+	std::vector<std::string> names = resourceNames(state.arg());
+	Resource_mgr<BenchResource> mgr;
+	fill(mgr, names);
+
+	size_t i = 0;
+	while (state.keepRunning())
+	{
+		doNotOptimize(mgr.get<DerivedBenchResource>(names[i]));
+		i = (i + 7919) % names.size();
+	}
+	state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ResourceMgr_GetByIndex, 1000, 100000)
+{
+	std::vector<std::string> names = resourceNames(state.arg());
+	Resource_mgr<BenchResource> mgr;
+	fill(mgr, names);
+
+	int i = 0;
+	while (state.keepRunning())
+	{
+		doNotOptimize(mgr.get(i));
+		i = (i + 7919) % mgr.size();
+	}
+	state.setItemsProcessed(state.iterations());
+}
+
+// Iteration over every resource by index, as the scene interface does to list them
+BENCHMARK(BM_ResourceMgr_IterateByIndex, 1000, 100000)
+{
+	std::vector<std::string> names = resourceNames(state.arg());
+	Resource_mgr<BenchResource> mgr;
+	fill(mgr, names);
+
+	while (state.keepRunning())
+	{
+		for (int i = 0; i < mgr.size(); i++)
+			doNotOptimize(mgr.get(i));
+	}
+	state.setItemsProcessed(state.iterations() * mgr.size());
+}
+
+BENCHMARK(BM_ResourceMgr_Iterate, 1000, 100000)
+{
+	std::vector<std::string> names = resourceNames(state.arg());
+	Resource_mgr<BenchResource> mgr;
+	fill(mgr, names);
+
+	while (state.keepRunning())
+	{
+		for (Resource_mgr<BenchResource>::const_iterator it = mgr.begin(); it != mgr.end(); ++it)
+			doNotOptimize(*it);
+	}
+	state.setItemsProcessed(state.iterations() * mgr.size());
+}
+
+BENCHMARK(BM_ResourceMgr_GetByHandle, 1000, 100000)
+{
+	std::vector<std::string> names = resourceNames(state.arg());
+	Resource_mgr<BenchResource> mgr;
+	fill(mgr, names);
+	std::vector<ResourceHandle> handles;
+	for (size_t i = 0; i < names.size(); i++)
+		handles.push_back(mgr.getHandle(names[i]));
+
+	size_t i = 0;
+	while (state.keepRunning())
+	{
+		doNotOptimize(mgr.get(handles[i]));
+		i = (i + 7919) % handles.size();
+	}
+	state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ResourceMgr_GetTypedByHandle, 1000, 100000)
+{
+	std::vector<std::string> names = resourceNames(state.arg());
+	Resource_mgr<BenchResource> mgr;
+	fill(mgr, names);
+	std::vector<TypedResourceHandle<DerivedBenchResource> > handles;
+	for (size_t i = 0; i < names.size(); i++)
+		handles.push_back(mgr.getHandle<DerivedBenchResource>(names[i]));
+
+	size_t i = 0;
+	while (state.keepRunning())
+	{
+		doNotOptimize(mgr.get(handles[i]));
+		i = (i + 7919) % handles.size();
+	}
+	state.setItemsProcessed(state.iterations());
+}
+
+// Release and recreate resources: handles of the released resources must become invalid, the others must stay valid
+BENCHMARK(BM_ResourceMgr_ReleaseAndCreate, 1000, 100000)
+{
+	std::vector<std::string> names = resourceNames(state.arg());
+	Resource_mgr<BenchResource> mgr;
+	for (size_t i = 0; i < names.size(); i++)
+		mgr.get(names[i]);
+
+	std::vector<ResourceHandle> handles;
+	for (size_t i = 0; i < names.size(); i++)
+		handles.push_back(mgr.getHandle(names[i]));
+
+	size_t i = 0;
+	int errors = 0;
+	while (state.keepRunning())
+	{
+		mgr.release(names[i]);
+		if (mgr.isValid(handles[i]) || mgr.get(handles[(i + 1) % names.size()]) == NULL)
+			errors++;
+		mgr.get(names[i]);
+		handles[i] = mgr.getHandle(names[i]);
+		i = (i + 7919) % names.size();
+	}
+	for (size_t j = 0; j < names.size(); j++)
+	{
+		BenchResource* r = mgr.get(handles[j]);
+		if (r == NULL || r->getName() != names[j])
+			errors++;
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("handle errors", errors);
+}
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Benchmark.h"
+#include "Node.h"
+#include "SceneFile.h"
+
+static const int Breadth = 10;
+
+// Transformations of the node i of a text scene, as written by writeTextScene
+struct NodeTransform
+{
+	glm::vec3 translation;
+	glm::vec3 axis;
+	float degrees;
+	float scale;
+};
+
+static NodeTransform nodeTransform(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), unit(0.1f, 1.0f);
+	NodeTransform t;
+	float x = position(rng), y = position(rng), z = position(rng);
+	t.translation = glm::vec3(x, y, z);
+	float ax = unit(rng), ay = unit(rng), az = unit(rng);
+	t.axis = glm::vec3(ax, ay, az);
+	t.degrees = 360.0f * unit(rng);
+	t.scale = unit(rng);
+	return t;
+}
+
+// Text scene of count nodes: a hierarchy where each node has Breadth sons, a few shared models and materials
+static void writeTextScene(const std::string& filename, long long count, std::vector<NodeTransform>& transforms)
+{
+	std::ofstream out(filename);
+	out << "camera eye 0 50 400 target 0 0 0 up 0 1 0\n";
+	for (int i = 0; i < 16; i++)
+		out << "model Sphere" << i << " sphere triangles " << 100 + i << "\n";
+	for (int i = 0; i < 8; i++)
+		out << "material Phong" << i << " phong-clustered diffuse 0.5 0.5 " << i / 8.0f << "\n";
+
+	std::mt19937 rng(1);
+	transforms.resize(count);
+	out.precision(9);
+	for (long long i = 0; i < count; i++)
+	{
+		NodeTransform& t = transforms[i];
+		t = nodeTransform(rng);
+		out << "node Node" << i << " ";
+		if (i < Breadth)
+			out << "-";
+		else
+			out << "Node" << (i - Breadth) / Breadth;
+		out << " model Sphere" << i % 16 << " material Phong" << i % 8
+			<< " translate " << t.translation.x << " " << t.translation.y << " " << t.translation.z
+			<< " rotate " << t.axis.x << " " << t.axis.y << " " << t.axis.z << " " << t.degrees
+			<< " scale " << t.scale << " " << t.scale << " " << t.scale << "\n";
+	}
+	for (long long i = 0; i < count; i += 1000)
+		out << "light Node" << i << " color 1 0.5 0.25 radius 20\n";
+}
+
+static double fileMegabytes(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	return (double)file.tellg() / (1024.0 * 1024.0);
+}
+
+static std::string sceneName(const char* prefix, long long count)
+{
+	return std::string(prefix) + std::to_string(count);
+}
+
+BENCHMARK(BM_SceneFile_Convert, 100000, 500000)
+{
+	std::string text = sceneName("SceneFileBench", state.arg()) + ".scene";
+	std::string binary = text + ".bin";
+	std::vector<NodeTransform> transforms;
+	writeTextScene(text, state.arg(), transforms);
+
+	while (state.keepRunning())
+		SceneFile::convert(text, binary);
+
+	state.setItemsProcessed(state.iterations() * state.arg());
+	state.setCounter("text MB", fileMegabytes(text));
+	state.setCounter("binary MB", fileMegabytes(binary));
+	std::remove(text.c_str());
+	std::remove(binary.c_str());
+}
+
+// Startup of a scene: mapping, validation and creation of the nodes (models and materials need an OpenGL context)
+BENCHMARK(BM_SceneFile_Load, 10000, 100000, 500000)
+{
+	std::string text = sceneName("SceneFileBench", state.arg()) + ".scene";
+	std::string binary = text + ".bin";
+	std::vector<NodeTransform> transforms;
+	writeTextScene(text, state.arg(), transforms);
+	SceneFile::convert(text, binary);
+
+	std::vector<ModelGL*> models;
+	std::vector<MaterialGL*> materials;
+	std::vector<Node*> created;
+	double megabytes = 0.0;
+	while (state.keepRunning())
+	{
+		std::unique_ptr<Resource_mgr<Node> > nodes(new Resource_mgr<Node>());
+		Node* root = nodes->get("Scene");
+		SceneFile file;
+		if (file.open(binary))
+		{
+			file.createNodes(*nodes, root, models, materials, created);
+			megabytes = file.getSize() / (1024.0 * 1024.0);
+		}
+		state.pauseTiming();	// Exclude the destruction
+		file.close();
+		nodes.reset();
+		state.resumeTiming();
+	}
+	state.setItemsProcessed(state.iterations() * state.arg());
+	state.setCounter("nodes", (double)created.size());
+	state.setCounter("binary MB", megabytes);
+	std::remove(text.c_str());
+	std::remove(binary.c_str());
+}
+
+// Checks the loaded hierarchy, names and frames against the text scene, and the rejection of invalid files
+BENCHMARK(BM_SceneFile_Validate, 1000)
+{
+	std::string text = sceneName("SceneFileValidate", state.arg()) + ".scene";
+	std::string binary = text + ".bin";
+	std::vector<NodeTransform> transforms;
+	writeTextScene(text, state.arg(), transforms);
+
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		if (!SceneFile::convert(text, binary))
+		{
+			mismatches++;
+			continue;
+		}
+		Resource_mgr<Node> nodes;
+		Node* root = nodes.get("Scene");
+		std::vector<Node*> created;
+		SceneFile file;
+		if (!file.open(binary) || file.getModelCount() != 16 || file.getMaterialCount() != 8 || file.getLightCount() != (state.arg() + 999) / 1000)
+		{
+			mismatches++;
+			continue;
+		}
+		file.createNodes(nodes, root, std::vector<ModelGL*>(), std::vector<MaterialGL*>(), created);
+		for (long long i = 0; i < state.arg(); i++)
+		{
+			Node* n = created[i];
+			Node* father = i < Breadth ? root : created[(i - Breadth) / Breadth];
+			const NodeTransform& t = transforms[i];
+			glm::mat4 expected = glm::translate(glm::mat4(1.0f), t.translation);
+			expected = glm::rotate(expected, glm::radians(t.degrees), t.axis);
+			expected = glm::scale(expected, glm::vec3(t.scale));
+			glm::mat4 m = n->frame()->getMatrixCopy();
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+				error = std::max(error, glm::length(m[c] - expected[c]));
+			if (n->getName() != "Node" + std::to_string(i) || n->getFather() != father || error > 1e-3f)
+				mismatches++;
+		}
+		file.close();
+
+		// A name not matching its stored hash (strings come last), a truncated file, a node declared after its sons
+		// and a node named as a node of the Scene are rejected
+		std::vector<char> bytes;
+		{
+			std::ifstream in(binary, std::ios::binary);
+			bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		}
+		{
+			std::ofstream out(binary, std::ios::binary);
+			bytes.back() ^= 1;
+			out.write(&bytes[0], bytes.size());
+		}
+		if (file.open(binary))
+			mismatches++;
+		file.close();
+		{
+			std::ofstream out(binary, std::ios::binary);
+			out.write(&bytes[0], bytes.size() / 2);
+		}
+		if (file.open(binary))
+			mismatches++;
+		const char* invalidScenes[] = { "node A B\nnode B -\n", "node Scene -\n" };
+		for (int s = 0; s < 2; s++)
+		{
+			{
+				std::ofstream out(text + ".invalid");
+				out << invalidScenes[s];
+			}
+			if (SceneFile::convert(text + ".invalid", binary))
+				mismatches++;
+		}
+		std::remove((text + ".invalid").c_str());
+	}
+	state.setItemsProcessed(state.iterations() * state.arg());
+	state.setMismatches(mismatches);
+	std::remove(text.c_str());
+	std::remove(binary.c_str());
+}
@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "GeometricModel.h"
+#include "GeometricModelLoader/OBJLoader.h"
+#include "Node.h"
+#include "SceneGenerator.h"
+
+// Hierarchy of the given node count with the default breadth, the depth allowing every node
+static SceneGeneratorSettings hierarchySettings(long long count)
+{
+	SceneGeneratorSettings settings;
+	settings.nodeCount = (int)count;
+	settings.depth = 7;
+	return settings;
+}
+
+BENCHMARK(BM_SceneGenerator_Hierarchy, 10000, 100000, 1000000)
+{
+	SceneGenerator generator(hierarchySettings(state.arg()));
+	std::vector<Node*> created;
+	while (state.keepRunning())
+	{
+		std::unique_ptr<Resource_mgr<Node> > nodes(new Resource_mgr<Node>());
+		Node* root = nodes->get("Scene");
+		generator.createHierarchy(*nodes, root, created);
+		state.pauseTiming();	// Exclude the destruction
+		nodes.reset();
+		state.resumeTiming();
+	}
+	state.setItemsProcessed(state.iterations() * (long long)created.size());
+	state.setCounter("nodes", (double)created.size());
+}
+
+static void meshBenchmark(BenchmarkState& state, ProceduralMesh mesh)
+{
+	SceneGeneratorSettings settings;
+	settings.mesh = mesh;
+	settings.trianglesPerMesh = (int)state.arg();
+	SceneGenerator generator(settings);
+
+	int faces = 0;
+	while (state.keepRunning())
+	{
+		GeometricModel model;
+		generator.createMesh(&model, 0);
+		faces = model.nb_faces;
+	}
+	state.setItemsProcessed(state.iterations() * faces);
+	state.setCounter("faces", faces);
+}
+
+BENCHMARK(BM_SceneGenerator_Sphere, 10000, 1000000)
+{
+	meshBenchmark(state, ProceduralMesh::Sphere);
+}
+
+BENCHMARK(BM_SceneGenerator_Grid, 10000, 1000000)
+{
+	meshBenchmark(state, ProceduralMesh::Grid);
+}
+
+BENCHMARK(BM_SceneGenerator_Terrain, 10000, 1000000)
+{
+	meshBenchmark(state, ProceduralMesh::Terrain);
+}
+
+// Generated mesh written as OBJ and loaded back, the loaded mesh must have the same faces
+BENCHMARK(BM_SceneGenerator_WriteOBJ, 10000, 100000)
+{
+	SceneGeneratorSettings settings;
+	settings.mesh = ProceduralMesh::Terrain;
+	settings.trianglesPerMesh = (int)state.arg();
+	SceneGenerator generator(settings);
+	GeometricModel mesh;
+	generator.createMesh(&mesh, 0);
+
+	std::string filename = "BenchGenerated" + std::to_string(state.arg()) + ".obj";
+	while (state.keepRunning())
+		SceneGenerator::writeOBJ(&mesh, filename);
+	state.setItemsProcessed(state.iterations() * mesh.nb_faces);
+
+	GeometricModel loaded;
+	OBJLoader loader;
+	loader.loadModel(filename, &loaded);
+	state.setMismatches(loaded.nb_faces != mesh.nb_faces ? 1 : 0);
+	std::remove(filename.c_str());
+}
@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Frame.h"
+#include "Node.h"
+#include "NodeCollector.h"
+#include "Resource_mgr.hpp"
+#include "Scene.h"
+
+// Chain of depth frames, each translated and rotated relatively to its parent
+static std::vector<Frame*> createDeepFrames(int depth)
+{
+	std::vector<Frame*> frames;
+	for (int i = 0; i < depth; i++)
+	{
+		Frame* f = new Frame();
+		f->translate(glm::vec3(0.1f, 0.0f, 0.0f));
+		f->rotate(glm::vec3(0.0f, 1.0f, 0.0f), 0.01f);
+		if (i > 0)
+			f->attachTo(frames.back());
+		frames.push_back(f);
+	}
+	return frames;
+}
+
+// Root frame with count children
+static std::vector<Frame*> createWideFrames(int count)
+{
+	std::vector<Frame*> frames;
+	frames.push_back(new Frame());
+	for (int i = 0; i < count; i++)
+	{
+		Frame* f = new Frame();
+		f->translate(glm::vec3((float)i, 0.0f, 0.0f));
+		f->attachTo(frames[0]);
+		frames.push_back(f);
+	}
+	return frames;
+}
+
+static void deleteFrames(std::vector<Frame*>& frames)
+{
+	for (size_t i = 0; i < frames.size(); i++)
+		delete frames[i];
+	frames.clear();
+}
+
+// Model matrix of the deepest frame : one matrix product per level
+BENCHMARK(BM_Frame_GetModelMatrix_Deep, 10, 100, 1000)
+{
+	std::vector<Frame*> frames = createDeepFrames((int)state.arg());
+	while (state.keepRunning())
+		doNotOptimize(frames.back()->getModelMatrix());
+	state.setItemsProcessed(state.iterations());
+	deleteFrames(frames);
+}
+
+// Model matrices of every child of a wide tree, as done when rendering every node
+BENCHMARK(BM_Frame_GetModelMatrix_Wide, 1000, 100000)
+{
+	std::vector<Frame*> frames = createWideFrames((int)state.arg());
+	while (state.keepRunning())
+	{
+		for (size_t i = 1; i < frames.size(); i++)
+			doNotOptimize(frames[i]->getModelMatrix());
+	}
+	state.setItemsProcessed(state.iterations() * state.arg());
+	deleteFrames(frames);
+}
+
+// Point conversion from the deepest frame to the root, and back : both model matrices and an inverse
+BENCHMARK(BM_Frame_ConvertPtTo_Deep, 10, 100, 1000)
+{
+	std::vector<Frame*> frames = createDeepFrames((int)state.arg());
+	glm::vec3 p(1.0f, 2.0f, 3.0f);
+	while (state.keepRunning())
+	{
+		p = frames.back()->convertPtTo(p, frames[0]);
+		p = frames[0]->convertPtTo(p, frames.back());
+	}
+	doNotOptimize(p);
+	state.setItemsProcessed(2 * state.iterations());
+	deleteFrames(frames);
+}
+
+// Point conversion between siblings of a wide tree, as the trackball does between the camera and the manipulated node
+BENCHMARK(BM_Frame_ConvertPtTo_Wide, 1000, 100000)
+{
+	std::vector<Frame*> frames = createWideFrames((int)state.arg());
+	glm::vec3 p(1.0f, 2.0f, 3.0f);
+	size_t n = frames.size() - 1;
+	size_t i = 0;
+	while (state.keepRunning())
+	{
+		p = frames[1 + i]->convertPtTo(p, frames[1 + (i * 7919) % n]);
+		i = (i + 1) % n;
+	}
+	doNotOptimize(p);
+	state.setItemsProcessed(state.iterations());
+	deleteFrames(frames);
+}
+
+static void deleteNodes(Node* root)
+{
+	for (size_t i = 0; i < root->m_Sons.size(); i++)
+		deleteNodes(root->m_Sons[i]);
+	delete root;
+}
+
+// Tree of nodes with the given branching factor and total count (breadth first filling)
+static Node* createNodeTree(int count, int branching)
+{
+	std::vector<Node*> nodes;
+	nodes.push_back(new Node("Root"));
+	for (int i = 1; i < count; i++)
+	{
+		Node* n = new Node("Node" + std::to_string(i));
+		nodes[(i - 1) / branching]->adopt(n);
+		nodes.push_back(n);
+	}
+	return nodes[0];
+}
+
+static void collectBenchmark(BenchmarkState& state, int branching)
+{
+	Node* root = createNodeTree((int)state.arg(), branching);
+	NodeCollector collector;
+	while (state.keepRunning())
+		collector.collect(root);
+	state.setItemsProcessed(state.iterations() * (long long)collector.nodes.size());
+	deleteNodes(root);
+}
+
+BENCHMARK(BM_NodeCollector_Collect_Wide, 1000, 100000)
+{
+	collectBenchmark(state, 1000000);
+}
+
+BENCHMARK(BM_NodeCollector_Collect_Binary, 1000, 100000, 1000000)
+{
+	collectBenchmark(state, 2);
+}
+
+BENCHMARK(BM_NodeCollector_Collect_Deep, 100, 1000)
+{
+	collectBenchmark(state, 1);
+}
+
+static double millisecondsSince(std::chrono::time_point<std::chrono::high_resolution_clock> start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Creation of a tree of nodes (each one with its frame and its sons vector) and its destruction
+BENCHMARK(BM_Node_CreateDestroyTree, 100000, 1000000)
+{
+	// Names are interned by the first run, so that the string table does not weigh on the measure
+	deleteNodes(createNodeTree((int)state.arg(), 8));
+
+	double create = 0.0, destroy = 0.0;
+	while (state.keepRunning())
+	{
+		std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+		Node* root = createNodeTree((int)state.arg(), 8);
+		create += millisecondsSince(start);
+		start = std::chrono::high_resolution_clock::now();
+		deleteNodes(root);
+		destroy += millisecondsSince(start);
+	}
+	state.setItemsProcessed(state.iterations() * state.arg());
+	state.setCounter("create ms", create / state.iterations());
+	state.setCounter("destroy ms", destroy / state.iterations());
+}
+
+// Same through the nodes manager, as the scene creates and releases its nodes
+BENCHMARK(BM_ResourceMgr_CreateReleaseNodes, 100000, 1000000)
+{
+	std::vector<StringId> names;
+	for (long long i = 0; i < state.arg(); i++)
+		names.push_back(StringId("Node" + std::to_string(i)));
+
+	double create = 0.0, destroy = 0.0;
+	while (state.keepRunning())
+	{
+		Resource_mgr<Node> nodes;
+		std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < names.size(); i++)
+			nodes.get(names[i]);
+		create += millisecondsSince(start);
+		start = std::chrono::high_resolution_clock::now();
+		for (size_t i = names.size(); i-- > 0;)
+			nodes.release(names[i]);
+		destroy += millisecondsSince(start);
+	}
+	state.setItemsProcessed(state.iterations() * state.arg());
+	state.setCounter("create ms", create / state.iterations());
+	state.setCounter("release ms", destroy / state.iterations());
+}
+
+// Collection of a tree whose nodes were created among other allocations, as in a loaded scene (models, materials...)
+BENCHMARK(BM_NodeCollector_Collect_Interleaved, 100000, 1000000)
+{
+	std::vector<std::string*> others;
+	std::vector<Node*> created;
+	created.push_back(new Node("Root"));
+	for (long long i = 1; i < state.arg(); i++)
+	{
+		others.push_back(new std::string(64, 'x'));
+		Node* n = new Node("Node" + std::to_string(i));
+		created[(i - 1) / 8]->adopt(n);
+		created.push_back(n);
+	}
+
+	NodeCollector collector;
+	while (state.keepRunning())
+		collector.collect(created[0]);
+	state.setItemsProcessed(state.iterations() * (long long)collector.nodes.size());
+	deleteNodes(created[0]);
+	for (size_t i = 0; i < others.size(); i++)
+		delete others[i];
+}
+
+// Random attach and detach operations on a collected tree: a detached subtree is kept aside and attached again later
+// under a random collected node
+class AttachDetachScript
+{
+public:
+	AttachDetachScript(int count, unsigned int seed) : m_Rng(seed)
+	{
+		m_Root = createNodeTree(count, 8);
+		m_Collector.collect(m_Root);
+		Scene::getInstance()->setCollector(&m_Collector);
+	}
+
+	~AttachDetachScript()
+	{
+		Scene::getInstance()->setCollector(NULL);
+		for (size_t i = 0; i < m_Detached.size(); i++)
+			deleteNodes(m_Detached[i]);
+		deleteNodes(m_Root);
+	}
+
+	// Detach a random subtree, or attach a detached one (the pool of detached subtrees stays small)
+	void step()
+	{
+		Node* n = pickAttached();
+		if (m_Detached.size() < 16 && (m_Detached.empty() || m_Rng() % 2 == 0))
+		{
+			if (n != m_Root)
+			{
+				n->getFather()->disown(n);
+				m_Detached.push_back(n);
+			}
+		}
+		else
+		{
+			size_t i = m_Rng() % m_Detached.size();
+			n->adopt(m_Detached[i]);
+			m_Detached[i] = m_Detached.back();
+			m_Detached.pop_back();
+		}
+	}
+
+	IncrementalNodeCollector& collector() { return m_Collector; }
+	Node* root() { return m_Root; }
+
+private:
+	// Random node still under the root: the collected list also holds the nodes detached since the last applyChanges
+	Node* pickAttached()
+	{
+		const std::vector<Node*>& nodes = m_Collector.nodes;
+		std::uniform_int_distribution<size_t> pick(0, nodes.size() - 1);
+		while (true)
+		{
+			Node* n = nodes[pick(m_Rng)];
+			Node* ancestor = n;
+			while (ancestor->getFather() != NULL)
+				ancestor = ancestor->getFather();
+			if (ancestor == m_Root)
+				return n;
+		}
+	}
+
+	Node* m_Root;
+	IncrementalNodeCollector m_Collector;
+	std::vector<Node*> m_Detached;
+	std::mt19937 m_Rng;
+};
+
+// One structural change per frame, patched into the collected list
+BENCHMARK(BM_IncrementalCollector_AttachDetach, 10000, 100000, 1000000)
+{
+	AttachDetachScript script((int)state.arg(), 1);
+	while (state.keepRunning())
+	{
+		script.step();
+		Scene::getInstance()->applyChanges();
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("collected nodes", (double)script.collector().nodes.size());
+}
+
+// Same changes, the whole tree being collected again after each one as setupEngine did
+BENCHMARK(BM_NodeCollector_AttachDetach, 10000, 100000)
+{
+	AttachDetachScript script((int)state.arg(), 1);
+	NodeCollector full;
+	while (state.keepRunning())
+	{
+		script.step();
+		Scene::getInstance()->applyChanges();
+		full.collect(script.root());
+	}
+	state.setItemsProcessed(state.iterations());
+}
+
+// Validates the patched list against a full collection, and the stored positions of the nodes
+BENCHMARK(BM_IncrementalCollector_Validate, 10000)
+{
+	AttachDetachScript script((int)state.arg(), 2);
+	NodeCollector full;
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		for (int i = 0; i < 100; i++)
+			script.step();
+		Scene::getInstance()->applyChanges();
+
+		std::vector<Node*> patched = script.collector().nodes;
+		for (size_t i = 0; i < patched.size(); i++)
+			if (patched[i]->collectorIndex != (int)i)
+				mismatches++;
+		full.collect(script.root());
+		std::sort(patched.begin(), patched.end());
+		std::sort(full.nodes.begin(), full.nodes.end());
+		if (patched != full.nodes)
+			mismatches++;
+	}
+	state.setItemsProcessed(state.iterations() * 100);
+	state.setMismatches(mismatches);
+}
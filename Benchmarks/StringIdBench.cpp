@@ -0,0 +1,186 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+#include "Node.h"
+#include "Resource_mgr.hpp"
+#include "StringId.h"
+
+// Node names of the generated scenes, longer than the small string buffer of std::string
+static std::vector<std::string> nodeNames(long long count)
+{
+	std::vector<std::string> names;
+	for (long long i = 0; i < count; i++)
+		names.push_back("GeneratedNode_" + std::to_string(i));
+	return names;
+}
+
+static void setAllocationCounter(BenchmarkState& state, long long allocationsBefore, long long operations)
+{
+	state.setCounter("allocations per op", (double)(getAllocationCount() - allocationsBefore) / (double)operations);
+}
+
+BENCHMARK(BM_StringId_InternExisting, 1000, 100000)
+{
+	std::vector<std::string> names = nodeNames(state.arg());
+	for (size_t i = 0; i < names.size(); i++)
+		StringId id(names[i]);
+
+	size_t i = 0;
+	long long allocations = getAllocationCount();
+	while (state.keepRunning())
+	{
+		doNotOptimize(StringId(names[i]));
+		i = (i + 7919) % names.size();
+	}
+	setAllocationCounter(state, allocations, state.iterations());
+	state.setItemsProcessed(state.iterations());
+}
+
+// Per node lookup of the light, as PhongMaterial::animate does every frame
+BENCHMARK(BM_ResourceMgr_FindLightByString, 1000, 100000)
+{
+	std::vector<std::string> names = nodeNames(state.arg());
+	Resource_mgr<Node> nodes;
+	for (size_t i = 0; i < names.size(); i++)
+		nodes.get(names[i]);
+	nodes.get("Light");
+
+	long long allocations = getAllocationCount();
+	while (state.keepRunning())
+		doNotOptimize(nodes.find(std::string("Light")));
+	setAllocationCounter(state, allocations, state.iterations());
+	state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ResourceMgr_FindLightById, 1000, 100000)
+{
+	static const StringId LightName = "Light"_sid;
+	std::vector<std::string> names = nodeNames(state.arg());
+	Resource_mgr<Node> nodes;
+	for (size_t i = 0; i < names.size(); i++)
+		nodes.get(names[i]);
+	nodes.get("Light");
+
+	long long allocations = getAllocationCount();
+	while (state.keepRunning())
+		doNotOptimize(nodes.find(LightName));
+	setAllocationCounter(state, allocations, state.iterations());
+	state.setItemsProcessed(state.iterations());
+}
+
+// Name comparison of every node, copying the name as the former Node::getName returning by value did
+BENCHMARK(BM_Node_CompareNameCopy, 1000, 100000)
+{
+	std::vector<std::string> names = nodeNames(state.arg());
+	std::vector<Node*> nodes;
+	for (size_t i = 0; i < names.size(); i++)
+		nodes.push_back(new Node(names[i]));
+
+	int matches = 0;
+	long long allocations = getAllocationCount();
+	while (state.keepRunning())
+	{
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			std::string name = nodes[i]->getName();
+			matches += name == "Bunny";
+		}
+	}
+	setAllocationCounter(state, allocations, state.iterations() * (long long)nodes.size());
+	doNotOptimize(matches);
+	state.setItemsProcessed(state.iterations() * (long long)nodes.size());
+	for (size_t i = 0; i < nodes.size(); i++)
+		delete nodes[i];
+}
+
+BENCHMARK(BM_Node_CompareId, 1000, 100000)
+{
+	static const StringId BunnyName = "Bunny"_sid;
+	std::vector<std::string> names = nodeNames(state.arg());
+	std::vector<Node*> nodes;
+	for (size_t i = 0; i < names.size(); i++)
+		nodes.push_back(new Node(names[i]));
+
+	int matches = 0;
+	long long allocations = getAllocationCount();
+	while (state.keepRunning())
+	{
+		for (size_t i = 0; i < nodes.size(); i++)
+			matches += nodes[i]->getId() == BunnyName;
+	}
+	setAllocationCounter(state, allocations, state.iterations() * (long long)nodes.size());
+	doNotOptimize(matches);
+	state.setItemsProcessed(state.iterations() * (long long)nodes.size());
+	for (size_t i = 0; i < nodes.size(); i++)
+		delete nodes[i];
+}
+
+/*
+ * Name work of a frame over arg() nodes, per node: the light lookup of PhongMaterial::animate and the name comparison of
+ * PhongMaterial::displayInterface. First as the engine did before StringId (string keyed map of the former Resource_mgr,
+ * Node::getName returning a copy), then with the ids. Reports the heap allocations per frame. The whole renderer frame
+ * is measured by the Profiler "Allocations" counter (headless benchmark report of a PROFILE_ALLOCATIONS build).
+ */
+BENCHMARK(BM_Frame_NameAllocationsByString, 1000, 10000)
+{
+	std::vector<std::string> names = nodeNames(state.arg());
+	std::map<std::string, std::pair<Node*, int> > legacyNodes;
+	std::vector<Node*> nodes;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		nodes.push_back(new Node(names[i]));
+		legacyNodes.insert(std::make_pair(names[i], std::make_pair(nodes.back(), 1)));
+	}
+	Node light("Light");
+	legacyNodes.insert(std::make_pair(std::string("Light"), std::make_pair(&light, 1)));
+
+	int matches = 0;
+	long long allocations = getAllocationCount();
+	while (state.keepRunning())
+	{
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			// Scene::getNode(std::string) added a reference each call
+			std::map<std::string, std::pair<Node*, int> >::iterator it = legacyNodes.find(std::string("Light"));
+			it->second.second++;
+			doNotOptimize(it->second.first);
+			std::string name = nodes[i]->getName();
+			matches += name == "Bunny";
+		}
+	}
+	state.setCounter("allocations per frame", (double)(getAllocationCount() - allocations) / (double)state.iterations());
+	doNotOptimize(matches);
+	state.setItemsProcessed(state.iterations());
+	for (size_t i = 0; i < nodes.size(); i++)
+		delete nodes[i];
+}
+
+BENCHMARK(BM_Frame_NameAllocationsById, 1000, 10000)
+{
+	static const StringId LightName = "Light"_sid;
+	static const StringId BunnyName = "Bunny"_sid;
+	std::vector<std::string> names = nodeNames(state.arg());
+	Resource_mgr<Node> nodeManager;
+	std::vector<Node*> nodes;
+	for (size_t i = 0; i < names.size(); i++)
+		nodes.push_back(nodeManager.get(names[i]));
+	nodeManager.get("Light");
+
+	int matches = 0;
+	long long allocations = getAllocationCount();
+	while (state.keepRunning())
+	{
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			// Scene::findNode(StringId) adds no reference
+			doNotOptimize(nodeManager.find(LightName));
+			matches += nodes[i]->getId() == BunnyName;
+		}
+	}
+	state.setCounter("allocations per frame", (double)(getAllocationCount() - allocations) / (double)state.iterations());
+	doNotOptimize(matches);
+	state.setItemsProcessed(state.iterations());
+}
@@ -0,0 +1,448 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "DXTCompressor.h"
+#include "image_DXT.h"
+#include "TextureImporter.h"
+#include "TextureStreamer.h"
+
+// Uncompressed TGA of smooth gradients with some noise, transparent on its left half if alpha is true
+static std::string writeImage(const std::string& filename, int size, bool alpha, int seed = 1)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> noise(-8, 8);
+	unsigned char header[18] = { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		(unsigned char)(size & 255), (unsigned char)(size >> 8), (unsigned char)(size & 255), (unsigned char)(size >> 8), 32, 0x28 };
+	std::vector<unsigned char> bytes(header, header + 18);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				int p = (int)(127.5f + 127.5f * std::sin(0.02f * (x * (c + 1)) + 0.03f * y)) + noise(rng);
+				bytes.push_back((unsigned char)(p < 0 ? 0 : (p > 255 ? 255 : p)));
+			}
+			bytes.push_back(alpha && x < size / 2 ? (unsigned char)(y & 255) : 255);
+		}
+	}
+	std::ofstream out(filename, std::ios::binary);
+	out.write((const char*)&bytes[0], bytes.size());
+	return filename;
+}
+
+// Caches of every import mode
+static void removeCaches(const std::string& filename)
+{
+	for (int c = TextureUncompressed; c <= TextureAutoCompressed; c++)
+	{
+		for (int u = TextureUsageColor; u <= TextureUsageMask; u++)
+			std::remove(TextureImporter::cacheName(filename, (TextureCompression)c, (TextureUsage)u).c_str());
+	}
+}
+
+static void removeImage(const std::string& filename)
+{
+	std::remove(filename.c_str());
+	removeCaches(filename);
+}
+
+static void setMemoryCounters(BenchmarkState& state, const CompressedImage& image)
+{
+	size_t uncompressed = TextureImporter::uncompressedSize(image.width, image.height);
+	state.setCounter("levels", image.getLevelCount());
+	state.setCounter("RGBA8 KB", uncompressed / 1024.0);
+	state.setCounter("compressed KB", image.data.size() / 1024.0);
+	state.setCounter("saved KB", ((double)uncompressed - (double)image.data.size()) / 1024.0);
+}
+
+// First import: decoding, mip chain, compression of every level and writing of the cache
+BENCHMARK(BM_TextureImport_Compress, 512, 1024, 2048)
+{
+	std::string filename = writeImage("TextureImporterBench.tga", (int)state.arg(), false);
+	TextureImporter* importer = TextureImporter::getInstance();
+	CompressedImage image;
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		std::remove(TextureImporter::cacheName(filename, TextureBC1).c_str());
+		state.resumeTiming();
+		importer->import(filename, TextureBC1, image);
+	}
+	state.setItemsProcessed(state.iterations() * state.arg() * state.arg());
+	setMemoryCounters(state, image);
+	removeImage(filename);
+}
+
+// Later imports: hashing of the source and reading of the cache
+BENCHMARK(BM_TextureImport_Cached, 512, 1024, 2048)
+{
+	std::string filename = writeImage("TextureImporterBench.tga", (int)state.arg(), false);
+	TextureImporter* importer = TextureImporter::getInstance();
+	CompressedImage image;
+	importer->import(filename, TextureBC1, image);
+	while (state.keepRunning())
+		importer->import(filename, TextureBC1, image);
+	state.setItemsProcessed(state.iterations() * state.arg() * state.arg());
+	setMemoryCounters(state, image);
+	removeImage(filename);
+}
+
+// Level sizes, cache round trip and invalidation, and the automatic choice between BC1 and BC3
+BENCHMARK(BM_TextureImport_Validate, 100)
+{
+	int size = (int)state.arg();
+	std::string opaque = writeImage("TextureImporterOpaque.tga", size, false);
+	std::string transparent = writeImage("TextureImporterTransparent.tga", size, true);
+	TextureImporter* importer = TextureImporter::getInstance();
+
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		removeCaches(opaque);
+		removeCaches(transparent);
+
+		CompressedImage first, cached, alpha;
+		if (!importer->import(opaque, TextureAutoCompressed, first) || first.compression != TextureBC1)
+			mismatches++;
+		if (!importer->import(transparent, TextureAutoCompressed, alpha) || alpha.compression != TextureBC3)
+			mismatches++;
+
+		// 100, 50, 25, 12, 6, 3, 1
+		int w = size, levels = 0;
+		size_t offset = 0;
+		for (; ; w /= 2, levels++)
+		{
+			if (levels < first.getLevelCount())
+			{
+				size_t blocks = (size_t)((w + 3) / 4) * ((w + 3) / 4);
+				if (first.levelSizes[levels] != blocks * 8 || alpha.levelSizes[levels] != blocks * 16 || first.levelOffsets[levels] != offset)
+					mismatches++;
+				offset += first.levelSizes[levels];
+			}
+			if (w == 1)
+				break;
+		}
+		if (first.getLevelCount() != levels + 1 || first.data.size() != offset)
+			mismatches++;
+
+		std::vector<TextureMemoryRecord> records = importer->getRecords();
+		bool recorded = false;
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			if (records[i].filename == opaque)
+				recorded = !records[i].fromCache && records[i].compressedBytes == first.data.size();
+		}
+		if (!recorded)
+			mismatches++;
+
+		// Same blocks from the cache
+		if (!importer->import(opaque, TextureAutoCompressed, cached) || cached.data != first.data || cached.levelSizes != first.levelSizes)
+			mismatches++;
+		records = importer->getRecords();
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			if (records[i].filename == opaque && !records[i].fromCache)
+				mismatches++;
+		}
+
+		// An edited source or another compression is compressed again
+		writeImage(opaque, size, false, 2);
+		if (!importer->import(opaque, TextureAutoCompressed, cached) || cached.data == first.data)
+			mismatches++;
+		if (!importer->import(opaque, TextureBC3, cached) || cached.compression != TextureBC3)
+			mismatches++;
+		// Each mode has its cache, the BC3 import kept the automatic one
+		if (!importer->import(opaque, TextureAutoCompressed, cached) || cached.compression != TextureBC1)
+			mismatches++;
+		records = importer->getRecords();
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			if (records[i].filename == opaque && !records[i].fromCache)
+				mismatches++;
+		}
+		writeImage(opaque, size, false);
+
+		// A cache shorter than its levels is not read
+		std::string cache = TextureImporter::cacheName(transparent, TextureAutoCompressed);
+		{
+			std::ifstream in(cache, std::ios::binary);
+			std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			std::ofstream out(cache, std::ios::binary);
+			out.write(&bytes[0], bytes.size() - 1);
+		}
+		uint64_t cachedHash;
+		if (TextureImporter::loadDDS(cache, cached, cachedHash))
+			mismatches++;
+
+		if (importer->import("TextureImporterMissing.tga", TextureBC1, cached))
+			mismatches++;
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setMismatches(mismatches);
+	removeImage(opaque);
+	removeImage(transparent);
+}
+
+// Normal map of a bumpy height field, RGBA8 with the normal in RGB
+static std::vector<unsigned char> createNormalMap(int size)
+{
+	std::vector<unsigned char> image((size_t)size * size * 4);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			float dx = 1.5f * std::cos(0.09f * x) * std::cos(0.05f * y) + 0.4f * std::sin(0.31f * (x + y));
+			float dy = -0.8f * std::sin(0.09f * x) * std::sin(0.05f * y) + 0.4f * std::sin(0.23f * (x - y));
+			float n[3] = { -dx, -dy, 1.0f };
+			float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (int c = 0; c < 3; c++)
+				image[((size_t)y * size + x) * 4 + c] = (unsigned char)((n[c] / length + 1.0f) * 127.5f + 0.5f);
+			image[((size_t)y * size + x) * 4 + 3] = 255;
+		}
+	}
+	return image;
+}
+
+// Mean angle in degrees between the normals of an image and of its decoded blocks, Z being rebuilt from X and Y for BC5
+static double normalError(const std::vector<unsigned char>& image, const unsigned char* blocks, int size, bool bc5, double& maxAngle)
+{
+	std::vector<unsigned char> decoded((size_t)size * size * 4);
+	if (bc5)
+		decompressBC5(blocks, size, size, &decoded[0]);
+	else
+		decompressDXT1(blocks, size, size, &decoded[0]);
+	double sum = 0.0;
+	maxAngle = 0.0;
+	for (size_t p = 0; p < (size_t)size * size; p++)
+	{
+		double a[3], b[3], la = 0.0, lb = 0.0, dot = 0.0;
+		for (int c = 0; c < 3; c++)
+		{
+			a[c] = image[p * 4 + c] / 127.5 - 1.0;
+			b[c] = decoded[p * 4 + c] / 127.5 - 1.0;
+		}
+		if (bc5)
+			b[2] = std::sqrt(std::max(0.0, 1.0 - b[0] * b[0] - b[1] * b[1]));
+		for (int c = 0; c < 3; c++)
+		{
+			la += a[c] * a[c];
+			lb += b[c] * b[c];
+			dot += a[c] * b[c];
+		}
+		double angle = std::acos(std::min(1.0, std::max(-1.0, dot / std::sqrt(la * lb)))) * 180.0 / 3.14159265358979;
+		sum += angle;
+		maxAngle = std::max(maxAngle, angle);
+	}
+	return sum / ((double)size * size);
+}
+
+/*
+ * BC5 normal maps and BC4 masks against BC1: angular error of the normals, PSNR, memory, the choice of the formats and
+ * the cache of BC4 / BC5 images. Quality regressions count as mismatches.
+ */
+BENCHMARK(BM_TextureImport_BCn, 512)
+{
+	int size = (int)state.arg();
+	std::vector<unsigned char> normals = createNormalMap(size);
+	std::vector<unsigned char> mask((size_t)size * size * 4);
+	for (size_t p = 0; p < (size_t)size * size; p++)
+	{
+		int x = (int)(p % size), y = (int)(p / size);
+		unsigned char v = (unsigned char)(127.5f + 127.5f * std::sin(0.05f * x) * std::cos(0.03f * y));
+		mask[4 * p] = mask[4 * p + 1] = mask[4 * p + 2] = v;
+		mask[4 * p + 3] = 255;
+	}
+
+	long long mismatches = 0;
+	double bc1Angle = 0.0, bc5Angle = 0.0, bc1MaxAngle = 0.0, bc5MaxAngle = 0.0;
+	double normalPSNR[2] = { 0.0, 0.0 }, maskPSNR[2] = { 0.0, 0.0 };
+	size_t bytes[3] = { 0, 0, 0 };
+	while (state.keepRunning())
+	{
+		int bc1Size = 0, bc4Size = 0, bc5Size = 0;
+		unsigned char* bc1 = compressDXT1(&normals[0], size, size, 4, &bc1Size);
+		unsigned char* bc5 = convert_image_to_BC5(&normals[0], size, size, 4, &bc5Size);
+		bc1Angle = normalError(normals, bc1, size, false, bc1MaxAngle);
+		bc5Angle = normalError(normals, bc5, size, true, bc5MaxAngle);
+		normalPSNR[0] = TextureImporter::computePSNR(&normals[0], 3, bc1, size, size, TextureBC1);
+		normalPSNR[1] = TextureImporter::computePSNR(&normals[0], 3, bc5, size, size, TextureBC5);
+		if (bc5Angle >= bc1Angle || bc5MaxAngle >= bc1MaxAngle)
+			mismatches++;
+		free(bc1);
+		free(bc5);
+
+		unsigned char* maskBC1 = compressDXT1(&mask[0], size, size, 4, &bc1Size);
+		unsigned char* maskBC4 = convert_image_to_BC4(&mask[0], size, size, 4, &bc4Size);
+		maskPSNR[0] = TextureImporter::computePSNR(&mask[0], 1, maskBC1, size, size, TextureBC1);
+		maskPSNR[1] = TextureImporter::computePSNR(&mask[0], 1, maskBC4, size, size, TextureBC4);
+		if (maskPSNR[1] <= maskPSNR[0] || bc4Size * 2 != bc5Size || bc4Size != bc1Size)
+			mismatches++;
+		free(maskBC1);
+		free(maskBC4);
+		bytes[0] = (size_t)size * size * 4;
+		bytes[1] = bc4Size;
+		bytes[2] = bc5Size;
+
+		// Formats from the channels and usage
+		std::vector<unsigned char> transparent(mask);
+		transparent[3] = 0;
+		if (TextureImporter::chooseCompression(&normals[0], size, size, 3, TextureUsageNormalMap) != TextureBC5
+			|| TextureImporter::chooseCompression(&mask[0], size, size, 1, TextureUsageColor) != TextureBC4
+			|| TextureImporter::chooseCompression(&mask[0], size, size, 3, TextureUsageMask) != TextureBC4
+			|| TextureImporter::chooseCompression(&mask[0], size, size, 2, TextureUsageColor) != TextureBC5
+			|| TextureImporter::chooseCompression(&mask[0], size, size, 3, TextureUsageColor) != TextureBC1
+			|| TextureImporter::chooseCompression(&transparent[0], size, size, 4, TextureUsageColor) != TextureBC3)
+			mismatches++;
+
+		// BC5 normal map through the cache
+		state.pauseTiming();
+		std::string filename = "TextureImporterNormals.tga";
+		{
+			unsigned char header[18] = { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				(unsigned char)(size & 255), (unsigned char)(size >> 8), (unsigned char)(size & 255), (unsigned char)(size >> 8), 24, 0x20 };
+			std::ofstream out(filename, std::ios::binary);
+			out.write((const char*)header, 18);
+			for (size_t p = 0; p < (size_t)size * size; p++)
+			{
+				unsigned char bgr[3] = { normals[4 * p + 2], normals[4 * p + 1], normals[4 * p] };
+				out.write((const char*)bgr, 3);
+			}
+		}
+		removeCaches(filename);
+		CompressedImage first, cached;
+		TextureImporter* importer = TextureImporter::getInstance();
+		if (!importer->import(filename, TextureAutoCompressed, first, TextureUsageNormalMap) || first.compression != TextureBC5
+			|| std::fabs(first.psnr - normalPSNR[1]) > 0.01)
+			mismatches++;
+		if (!importer->import(filename, TextureAutoCompressed, cached, TextureUsageNormalMap) || cached.data != first.data
+			|| cached.compression != TextureBC5 || cached.channels != 3 || std::fabs(cached.psnr - first.psnr) > 0.01)
+			mismatches++;
+		removeImage(filename);
+		state.resumeTiming();
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setMismatches(mismatches);
+	state.setCounter("normals BC1 mean deg", bc1Angle);
+	state.setCounter("normals BC1 max deg", bc1MaxAngle);
+	state.setCounter("normals BC5 mean deg", bc5Angle);
+	state.setCounter("normals BC5 max deg", bc5MaxAngle);
+	state.setCounter("normals BC1 PSNR", normalPSNR[0]);
+	state.setCounter("normals BC5 PSNR", normalPSNR[1]);
+	state.setCounter("mask BC1 PSNR", maskPSNR[0]);
+	state.setCounter("mask BC4 PSNR", maskPSNR[1]);
+	state.setCounter("RGBA8 KB", bytes[0] / 1024.0);
+	state.setCounter("BC4 KB", bytes[1] / 1024.0);
+	state.setCounter("BC5 KB", bytes[2] / 1024.0);
+}
+
+// Next level of a 2048 x 2048 color image, gamma correct, on arg() threads
+BENCHMARK(BM_TextureImport_GenerateMip, 1, 2, 4)
+{
+	const int size = 2048;
+	std::vector<unsigned char> image((size_t)size * size * 4), next((size_t)size * size);
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = (unsigned char)((i * 2654435761u) >> 24);
+	while (state.keepRunning())
+	{
+		TextureImporter::generateMip(&image[0], size, size, &next[0], TextureUsageColor, (int)state.arg());
+		doNotOptimize(next[0]);
+	}
+	state.setItemsProcessed(state.iterations() * size * size);
+}
+
+/*
+ * Mip filter in linear space for colors only, threads giving the same pixels, RGBA8 mip chains through the cache, BC4
+ * bands matching the whole image, and the levels streamed per frame within a budget.
+ */
+BENCHMARK(BM_TextureImport_Mips, 256)
+{
+	int size = (int)state.arg();
+	// Black and white checker, alpha alternating 0 / 255 along rows
+	std::vector<unsigned char> checker((size_t)size * size * 4);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			unsigned char* p = &checker[((size_t)y * size + x) * 4];
+			p[0] = p[1] = p[2] = (x + y) % 2 ? 255 : 0;
+			p[3] = y % 2 ? 255 : 0;
+		}
+	}
+
+	long long mismatches = 0;
+	int initialLevel = 0, frames = 0;
+	while (state.keepRunning())
+	{
+		std::vector<unsigned char> color((size_t)size * size), mask((size_t)size * size), threaded((size_t)size * size);
+		TextureImporter::generateMip(&checker[0], size, size, &color[0], TextureUsageColor, 1);
+		TextureImporter::generateMip(&checker[0], size, size, &mask[0], TextureUsageMask, 1);
+		TextureImporter::generateMip(&checker[0], size, size, &threaded[0], TextureUsageColor, 4);
+		// Half the light is sRGB 188, alpha and data are averaged as stored
+		if (color[0] != 188 || color[3] != 128 || mask[0] != 128 || mask[3] != 128 || threaded != color)
+			mismatches++;
+
+		// Flat colors stay the same
+		for (int v = 0; v < 256; v++)
+		{
+			unsigned char flat[4 * 4], half[4];
+			memset(flat, v, sizeof(flat));
+			TextureImporter::generateMip(flat, 2, 2, half, TextureUsageColor, 1);
+			if (half[0] != v || half[3] != v)
+				mismatches++;
+		}
+
+		// RGBA8 chain, the first level being the source, through the cache
+		state.pauseTiming();
+		std::string filename = writeImage("TextureImporterMips.tga", size, true);
+		state.resumeTiming();
+		TextureImporter* importer = TextureImporter::getInstance();
+		CompressedImage first, cached;
+		if (!importer->import(filename, TextureUncompressed, first) || first.compression != TextureUncompressed
+			|| first.getFormat() != GL_RGBA8 || first.data.size() != TextureImporter::uncompressedSize(size, size)
+			|| first.levelSizes[1] != (size_t)size * size || first.levelSizes.back() != 4)
+			mismatches++;
+		if (!importer->import(filename, TextureUncompressed, cached) || cached.data != first.data
+			|| cached.compression != TextureUncompressed)
+			mismatches++;
+		std::vector<unsigned char> level1((size_t)size * size);
+		TextureImporter::generateMip(&first.data[0], size, size, &level1[0], TextureUsageColor);
+		if (memcmp(&level1[0], &first.data[first.levelOffsets[1]], level1.size()) != 0)
+			mismatches++;
+
+		// BC4 compressed in bands of block rows
+		CompressedImage bc4;
+		TextureImporter::compress(&first.data[0], size, size, 3, TextureBC4, TextureUsageMask, bc4);
+		int bc4Size = 0;
+		unsigned char* whole = convert_image_to_BC4(&first.data[0], size, size, 4, &bc4Size);
+		if ((size_t)bc4Size != bc4.levelSizes[0] || memcmp(whole, &bc4.data[0], bc4Size) != 0)
+			mismatches++;
+		free(whole);
+		state.pauseTiming();
+		removeImage(filename);
+		state.resumeTiming();
+
+		// 4096 x 4096 BC1 chain: resident from the levels within 64 KB, then 4 MB per frame
+		std::vector<size_t> levelSizes;
+		for (int w = 4096; w >= 1; w /= 2)
+			levelSizes.push_back((size_t)((w + 3) / 4) * ((w + 3) / 4) * 8);
+		initialLevel = TextureStreamer::firstLevelWithin(levelSizes, TextureStreamer::InitialMipBytes);
+		frames = 0;
+		for (int next = initialLevel - 1; next >= 0; frames++)
+			next -= TextureStreamer::countMipUploads(levelSizes, next, 4 << 20, true);
+		// 256 x 256 and coarser at once, 2048 x 2048 and coarser in the first frame, 4096 x 4096 alone in the second
+		if (initialLevel != 4 || frames != 2 || TextureStreamer::countMipUploads(levelSizes, 0, 1024, false) != 0)
+			mismatches++;
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setMismatches(mismatches);
+	state.setCounter("initial level", initialLevel);
+	state.setCounter("frames to level 0", frames);
+}
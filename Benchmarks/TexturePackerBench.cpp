@@ -0,0 +1,221 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "TexturePacker.h"
+
+// RGBA of texel (x, y) of test image index
+static void texel(int index, int x, int y, unsigned char rgba[4])
+{
+	rgba[0] = (unsigned char)(x * 7 + index * 31);
+	rgba[1] = (unsigned char)(y * 5 + index * 17);
+	rgba[2] = (unsigned char)((x ^ y) + index);
+	rgba[3] = 255;
+}
+
+// Uncompressed 32 bit TGA, first row at the top
+static std::string writeImage(const std::string& filename, int index, int width, int height)
+{
+	unsigned char header[18] = { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		(unsigned char)(width & 255), (unsigned char)(width >> 8), (unsigned char)(height & 255), (unsigned char)(height >> 8), 32, 0x28 };
+	std::vector<unsigned char> bytes(header, header + 18);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			unsigned char rgba[4];
+			texel(index, x, y, rgba);
+			unsigned char bgra[4] = { rgba[2], rgba[1], rgba[0], rgba[3] };
+			bytes.insert(bytes.end(), bgra, bgra + 4);
+		}
+	}
+	std::ofstream out(filename, std::ios::binary);
+	out.write((const char*)&bytes[0], bytes.size());
+	return filename;
+}
+
+static void removeImages(const std::vector<std::string>& filenames)
+{
+	for (size_t i = 0; i < filenames.size(); i++)
+	{
+		std::remove(filenames[i].c_str());
+		// Caches of every import mode
+		for (int c = TextureUncompressed; c <= TextureAutoCompressed; c++)
+		{
+			for (int u = TextureUsageColor; u <= TextureUsageMask; u++)
+				std::remove(TextureImporter::cacheName(filenames[i], (TextureCompression)c, (TextureUsage)u).c_str());
+		}
+	}
+}
+
+/*
+ * Texture heavy scene: 160 small textures (32 to 256 texels), 24 tiling textures and 8 tiling normal maps of 512 x 512,
+ * 4000 draws each sampling one of them. Times the packing (caches written by the first run) and reports the batches
+ * of draws sorted by binding before and after.
+ */
+BENCHMARK(BM_TexturePacker_Scene, 4000)
+{
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int> side(32, 256);
+	std::vector<std::string> filenames;
+	for (int i = 0; i < 192; i++)
+	{
+		int w = i < 160 ? side(rng) : 512, h = i < 160 ? side(rng) : 512;
+		filenames.push_back(writeImage("TexturePackerScene" + std::to_string(i) + ".tga", i, w, h));
+	}
+	std::uniform_int_distribution<int> pick(0, (int)filenames.size() - 1);
+	std::vector<int> draws((size_t)state.arg());
+	for (size_t d = 0; d < draws.size(); d++)
+		draws[d] = pick(rng);
+
+	int before = 0, after = 0;
+	TexturePackingStats stats = {};
+	while (state.keepRunning())
+	{
+		TexturePacker packer;
+		for (int i = 0; i < (int)filenames.size(); i++)
+			packer.add(filenames[i], TextureAutoCompressed, i < 184 ? TextureUsageColor : TextureUsageNormalMap, i >= 160);
+		packer.build();
+		before = packer.countBatches(draws, false);
+		after = packer.countBatches(draws, true);
+		stats = packer.getStats();
+	}
+	removeImages(filenames);
+	state.setItemsProcessed(state.iterations() * filenames.size());
+	state.setCounter("batches before", before);
+	state.setCounter("batches after", after);
+	state.setCounter("batches merged", before - after);
+	state.setCounter("arrays", stats.groups);
+	state.setCounter("atlas pages", stats.atlasPages);
+	state.setCounter("atlas occupancy %", stats.atlasOccupancy * 100.0);
+	state.setCounter("packed KB", stats.memorySize / 1024.0);
+}
+
+/*
+ * Atlas texels and gutters against the sources, entries aligned and not overlapping, whole textures in arrays of their
+ * size, remapped coordinates and batch counts.
+ */
+BENCHMARK(BM_TexturePacker_Validate, 40)
+{
+	int count = (int)state.arg();
+	const int atlasSize = 256, pad = 8;
+	std::mt19937 rng(2);
+	std::uniform_int_distribution<int> side(1, 100);
+	std::vector<std::string> filenames;
+	std::vector<int> widths, heights;
+	for (int i = 0; i < count; i++)
+	{
+		// The last four are too large for the atlas, two of them with the same size
+		int w = i < count - 4 ? side(rng) : 128 + (i % 2) * 64, h = i < count - 4 ? side(rng) : 128;
+		widths.push_back(w);
+		heights.push_back(h);
+		filenames.push_back(writeImage("TexturePackerValidate" + std::to_string(i) + ".tga", i, w, h));
+	}
+
+	long long mismatches = 0;
+	int pages = 0;
+	while (state.keepRunning())
+	{
+		TexturePacker packer(atlasSize, 100, pad);
+		for (int i = 0; i < count; i++)
+			packer.add(filenames[i], TextureUncompressed);
+		if (!packer.build())
+			mismatches++;
+		const std::vector<TextureArrayGroup>& groups = packer.getGroups();
+		pages = packer.getStats().atlasPages;
+		if (packer.getStats().atlasEntries != count - 4 || packer.getStats().arrayLayers != 4 || pages < 2)
+			mismatches++;
+
+		std::vector<std::vector<int> > owner;
+		for (size_t g = 0; g < groups.size(); g++)
+		{
+			if (groups[g].atlas && (groups[g].levels != 3 || groups[g].layers[0].getLevelCount() != 3))
+				mismatches++;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			const PackedTexture& t = packer.getTexture(i);
+			const TextureArrayGroup& group = groups[t.group];
+			const CompressedImage& layer = group.layers[t.layer];
+			if (t.width != widths[i] || t.height != heights[i] || t.atlased != (i < count - 4) || group.atlas != t.atlased)
+				mismatches++;
+			if (!t.atlased)
+			{
+				// Whole first level
+				for (int y = 0; y < t.height; y++)
+					for (int x = 0; x < t.width; x++)
+					{
+						unsigned char rgba[4];
+						texel(i, x, y, rgba);
+						if (memcmp(rgba, &layer.data[((size_t)y * t.width + x) * 4], 4) != 0)
+							mismatches++;
+					}
+				if (group.width != t.width || group.levels != layer.getLevelCount())
+					mismatches++;
+				continue;
+			}
+
+			int x0 = (int)(t.uvTransform.z * atlasSize + 0.5f), y0 = (int)(t.uvTransform.w * atlasSize + 0.5f);
+			if (x0 % pad != 0 || y0 % pad != 0 || x0 < pad || y0 < pad || x0 + t.width + pad > atlasSize || y0 + t.height + pad > atlasSize)
+				mismatches++;
+			// Entry and gutter
+			if ((size_t)t.layer >= owner.size())
+				owner.resize(t.layer + 1, std::vector<int>(atlasSize * atlasSize, -1));
+			for (int y = -pad; y < t.height + pad; y++)
+			{
+				for (int x = -pad; x < t.width + pad; x++)
+				{
+					int px = x0 + x, py = y0 + y;
+					if (px < 0 || py < 0 || px >= atlasSize || py >= atlasSize)
+					{
+						mismatches++;
+						continue;
+					}
+					int& o = owner[t.layer][py * atlasSize + px];
+					if (o != -1)
+						mismatches++;
+					o = i;
+					unsigned char rgba[4];
+					texel(i, std::min(std::max(x, 0), t.width - 1), std::min(std::max(y, 0), t.height - 1), rgba);
+					if (memcmp(rgba, &layer.data[((size_t)py * atlasSize + px) * 4], 4) != 0)
+						mismatches++;
+				}
+			}
+
+			std::vector<glm::vec3> coords(2);
+			coords[0] = glm::vec3(0.0f, 0.0f, 0.0f);
+			coords[1] = glm::vec3(1.0f, 1.0f, 0.0f);
+			TexturePacker::remapCoords(t, coords);
+			if (std::abs(coords[0].x * atlasSize - x0) > 0.01f || std::abs(coords[1].y * atlasSize - (y0 + t.height)) > 0.01f
+				|| coords[1].z != (float)t.layer)
+				mismatches++;
+		}
+		// Two arrays of 128 x 128 and 192 x 128 textures, one atlas array
+		if (groups.size() != 3 || packer.getTexture(count - 4).group != packer.getTexture(count - 2).group
+			|| packer.getTexture(count - 4).group == packer.getTexture(count - 3).group)
+			mismatches++;
+
+		std::vector<int> draws;
+		for (int i = 0; i < count; i++)
+			draws.push_back(i);
+		draws.push_back(0);
+		if (packer.countBatches(draws, false) != count || packer.countBatches(draws, true) != 3)
+			mismatches++;
+
+		// Block compressed pages stop at a gutter of one block (levels 0 and 1 for a gutter of 8)
+		TexturePacker compressed(atlasSize, 100, pad);
+		for (int i = 0; i < 4; i++)
+			compressed.add(filenames[i], TextureBC1);
+		if (!compressed.build() || compressed.getGroups().empty() || !compressed.getGroups()[0].atlas
+			|| compressed.getGroups()[0].levels != 2 || compressed.getGroups()[0].layers[0].getLevelCount() != 2)
+			mismatches++;
+	}
+	removeImages(filenames);
+	state.setItemsProcessed(state.iterations());
+	state.setMismatches(mismatches);
+	state.setCounter("atlas pages", pages);
+}
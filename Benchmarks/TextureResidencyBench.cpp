@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "ResidencyLRU.hpp"
+#include "Texture2D.h"
+#include "TextureResidency.h"
+
+// Textures of 128 x 128 to 2048 x 2048, BC1 or RGBA8 with their mip chain
+static std::vector<size_t> createTextureSizes(int count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> side(7, 11), format(0, 3);
+	std::vector<size_t> sizes(count);
+	for (int i = 0; i < count; i++)
+	{
+		int levels = side(rng) + 1;
+		int s = 1 << (levels - 1);
+		sizes[i] = Texture2D::getStorageSize(format(rng) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8, s, s, levels);
+	}
+	return sizes;
+}
+
+static size_t sum(const std::vector<size_t>& sizes)
+{
+	size_t total = 0;
+	for (size_t i = 0; i < sizes.size(); i++)
+		total += sizes[i];
+	return total;
+}
+
+/*
+ * Camera walk through arg() textures: each frame uses a window of 1/8 of them that slides by one texture, under a budget
+ * of a quarter of their memory. Times the uses and the eviction of a frame.
+ */
+BENCHMARK(BM_TextureResidency_Frame, 1000, 10000)
+{
+	int count = (int)state.arg();
+	std::vector<size_t> sizes = createTextureSizes(count, 1);
+	size_t total = sum(sizes);
+	ResidencyLRU<int> lru(total / 4, TextureResidency::FramesInFlight);
+	for (int i = 0; i < count; i++)
+		lru.add(i, sizes[i], 0);
+
+	int window = std::max(1, count / 8);
+	long long frame = 0, restores = 0, evictions = 0;
+	std::vector<int> evicted;
+	while (state.keepRunning())
+	{
+		frame++;
+		evicted.clear();
+		lru.evict(frame, evicted);
+		evictions += evicted.size();
+		int first = (int)(frame % count);
+		for (int i = 0; i < window; i++)
+			restores += lru.use((first + i) % count, frame);
+	}
+	state.setItemsProcessed(state.iterations() * window);
+	state.setCounter("total MB", total / (1024.0 * 1024.0));
+	state.setCounter("budget MB", lru.getBudget() / (1024.0 * 1024.0));
+	state.setCounter("resident MB", lru.getResidentBytes() / (1024.0 * 1024.0));
+	state.setCounter("evictions per frame", (double)evictions / frame);
+	state.setCounter("restores per frame", (double)restores / frame);
+}
+
+/*
+ * Byte counts against a brute force recount, the budget met whenever possible, no eviction of textures of the frames in
+ * flight, evicted textures restored on use, and the storage sizes of the formats.
+ */
+BENCHMARK(BM_TextureResidency_Validate, 500)
+{
+	int count = (int)state.arg();
+	std::vector<size_t> sizes = createTextureSizes(count, 2);
+	long long mismatches = 0;
+	int overBudgetFrames = 0;
+	while (state.keepRunning())
+	{
+		size_t budget = sum(sizes) / 3;
+		ResidencyLRU<int> lru(budget, TextureResidency::FramesInFlight);
+		std::vector<long long> lastUsed(count, 0);
+		std::vector<bool> resident(count, true);
+		for (int i = 0; i < count; i++)
+			lru.add(i, sizes[i], 0);
+
+		std::mt19937 rng(3);
+		std::uniform_int_distribution<int> pick(0, count - 1);
+		std::vector<int> evicted;
+		overBudgetFrames = 0;
+		for (long long frame = 1; frame <= 200; frame++)
+		{
+			evicted.clear();
+			lru.evict(frame, evicted);
+			for (size_t e = 0; e < evicted.size(); e++)
+			{
+				int i = evicted[e];
+				if (!resident[i] || lastUsed[i] > frame - TextureResidency::FramesInFlight)
+					mismatches++;
+				resident[i] = false;
+			}
+			// Still over budget only when the remaining textures are in flight
+			if (lru.getResidentBytes() > budget)
+			{
+				overBudgetFrames++;
+				for (int i = 0; i < count; i++)
+				{
+					if (resident[i] && lastUsed[i] <= frame - TextureResidency::FramesInFlight)
+						mismatches++;
+				}
+			}
+
+			// Texture 0 every frame, a hot set of 20 and random ones
+			int uses = 1 + (int)(frame % 40);
+			for (int u = 0; u < uses; u++)
+			{
+				int i = u == 0 ? 0 : (u < 20 ? u : pick(rng));
+				if (lru.use(i, frame) == resident[i])
+					mismatches++;
+				resident[i] = true;
+				lastUsed[i] = frame;
+			}
+			if (frame == 100)
+			{
+				// A texture destroyed, another one created
+				lru.remove(count - 1);
+				lru.add(count - 1, 4096, frame);
+				sizes[count - 1] = 4096;
+				resident[count - 1] = true;
+				lastUsed[count - 1] = frame;
+			}
+
+			size_t residentBytes = 0;
+			int residentCount = 0;
+			for (int i = 0; i < count; i++)
+			{
+				if (resident[i] != lru.isResident(i))
+					mismatches++;
+				if (resident[i])
+				{
+					residentBytes += sizes[i];
+					residentCount++;
+				}
+			}
+			if (residentBytes != lru.getResidentBytes() || residentCount != lru.getResidentCount() || sum(sizes) != lru.getTotalBytes())
+				mismatches++;
+		}
+		if (!lru.isResident(0))
+			mismatches++;
+
+		if (Texture2D::getStorageSize(GL_RGBA8, 256, 256, 9) != 349524
+			|| Texture2D::getStorageSize(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 4, 4, 3) != 24
+			|| Texture2D::getStorageSize(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 8, 4, 1) != 32
+			|| Texture2D::getStorageSize(GL_RGBA16F, 100, 50, 1) != 40000)
+			mismatches++;
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setMismatches(mismatches);
+	state.setCounter("over budget frames", overBudgetFrames);
+}
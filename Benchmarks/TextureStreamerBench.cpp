@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stb/stb_image.h>
+
+#include "Benchmark.h"
+#include "TextureStreamer.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static const int ImageCount = 8;
+
+static unsigned char expectedChannel(int image, int x, int y, int c)
+{
+	switch (c)
+	{
+	case 0: return (unsigned char)x;
+	case 1: return (unsigned char)y;
+	case 2: return (unsigned char)((x ^ y) + image);
+	default: return 255;
+	}
+}
+
+// RLE compressed TGA (raw packets), decoded by stb_image like the PNG and JPEG files of the engine
+static std::string writeImage(int image, int size)
+{
+	std::string filename = "TextureStreamerBench" + std::to_string(image) + ".tga";
+	unsigned char header[18] = { 0, 0, 10, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		(unsigned char)(size & 255), (unsigned char)(size >> 8), (unsigned char)(size & 255), (unsigned char)(size >> 8), 32, 0x28 };
+	std::vector<unsigned char> bytes(header, header + 18);
+	bytes.reserve(18 + (size_t)size * size * 4 + (size_t)size * size / 128 + size);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x += 128)
+		{
+			int count = std::min(128, size - x);
+			bytes.push_back((unsigned char)(count - 1));
+			for (int i = x; i < x + count; i++)
+			{
+				bytes.push_back(expectedChannel(image, i, y, 2));		// BGRA
+				bytes.push_back(expectedChannel(image, i, y, 1));
+				bytes.push_back(expectedChannel(image, i, y, 0));
+				bytes.push_back(expectedChannel(image, i, y, 3));
+			}
+		}
+	}
+	std::ofstream out(filename, std::ios::binary);
+	out.write((const char*)&bytes[0], bytes.size());
+	return filename;
+}
+
+static std::vector<std::string> writeImages(int size)
+{
+	std::vector<std::string> files;
+	for (int i = 0; i < ImageCount; i++)
+		files.push_back(writeImage(i, size));
+	return files;
+}
+
+static void removeImages(const std::vector<std::string>& files)
+{
+	for (size_t i = 0; i < files.size(); i++)
+		std::remove(files[i].c_str());
+}
+
+static double millisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Decoding on the calling thread, as the synchronous Texture2D constructor does
+BENCHMARK(BM_TextureDecode_Sync, 1024, 2048)
+{
+	int size = (int)state.arg();
+	std::vector<std::string> files = writeImages(size);
+
+	while (state.keepRunning())
+	{
+		for (int i = 0; i < ImageCount; i++)
+		{
+			int width, height, channels;
+			unsigned char* pixels = stbi_load(files[i].c_str(), &width, &height, &channels, 4);
+			doNotOptimize(pixels[0]);
+			stbi_image_free(pixels);
+		}
+	}
+	double megabytes = (double)state.iterations() * ImageCount * size * size * 4 / (1024.0 * 1024.0);
+	state.setItemsProcessed(state.iterations() * ImageCount);
+	state.setCounter("MB/s", megabytes / state.elapsedSeconds());
+	state.setCounter("calling thread ms/image", state.elapsedSeconds() * 1000.0 / (state.iterations() * ImageCount));
+	removeImages(files);
+}
+
+/*
+ * ImageCount 2048 x 2048 images through the streamer with arg workers, a 32 MB ring in plain memory standing for the
+ * mapped buffer. The calling thread time is the one of the requests and of the ring copies it consumes, the GL thread
+ * adding the submission of glTextureSubImage2D from the buffer.
+ */
+BENCHMARK(BM_TextureStreamer_Decode, 1, 2, 4)
+{
+	const int size = 2048;
+	std::vector<std::string> files = writeImages(size);
+	std::vector<unsigned char> ring(32 << 20);
+	TextureStreamer* streamer = TextureStreamer::getInstance();
+	streamer->start(&ring[0], ring.size(), (int)state.arg());
+
+	double callingTime = 0.0;
+	while (state.keepRunning())
+	{
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < ImageCount; i++)
+			streamer->request(files[i], NULL);
+		callingTime += millisecondsSince(start);
+
+		int received = 0;
+		while (received < ImageCount)
+		{
+			start = Clock::now();
+			DecodedImage image;
+			if (!streamer->popDecoded(image))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			doNotOptimize(ring[image.offset]);
+			streamer->release(image);
+			callingTime += millisecondsSince(start);
+			received++;
+		}
+	}
+	streamer->stop();
+
+	double megabytes = (double)state.iterations() * ImageCount * size * size * 4 / (1024.0 * 1024.0);
+	state.setItemsProcessed(state.iterations() * ImageCount);
+	state.setCounter("MB/s", megabytes / state.elapsedSeconds());
+	state.setCounter("calling thread ms/image", callingTime / (state.iterations() * ImageCount));
+	removeImages(files);
+}
+
+// Decoded pixels found in the ring, images larger than the ring, missing files, and random ring traffic checked for overlaps
+BENCHMARK(BM_TextureStreamer_Validate, 256)
+{
+	int size = (int)state.arg();
+	std::vector<std::string> files = writeImages(size);
+	std::vector<unsigned char> ring((size_t)size * size * 4 * 3);
+	TextureStreamer* streamer = TextureStreamer::getInstance();
+
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		streamer->start(&ring[0], ring.size(), 2);
+		for (int i = 0; i < ImageCount; i++)
+			streamer->request(files[i], NULL);
+		streamer->request("TextureStreamerBenchMissing.tga", NULL);
+		for (int received = 0; received < ImageCount + 1; )
+		{
+			DecodedImage image;
+			if (!streamer->popDecoded(image))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			received++;
+			if (image.failed)
+			{
+				if (image.filename != "TextureStreamerBenchMissing.tga")
+					mismatches++;
+				continue;
+			}
+			int index = image.filename[std::string("TextureStreamerBench").size()] - '0';
+			const unsigned char* pixels = image.pixels != NULL ? image.pixels : &ring[image.offset];
+			if (image.width != size || image.height != size || image.offset == UploadRing::NoOffset)
+				mismatches++;
+			for (int y = 0; y < size; y += 7)
+			{
+				for (int x = 0; x < size; x += 5)
+				{
+					for (int c = 0; c < 4; c++)
+					{
+						if (pixels[((size_t)y * size + x) * 4 + c] != expectedChannel(index, x, y, c))
+							mismatches++;
+					}
+				}
+			}
+			streamer->release(image);
+		}
+		streamer->stop();
+
+		// A ring smaller than the image leaves the pixels in client memory
+		streamer->start(&ring[0], (size_t)size * size * 2, 1);
+		streamer->request(files[0], NULL);
+		DecodedImage large;
+		while (!streamer->popDecoded(large))
+			std::this_thread::yield();
+		if (large.pixels == NULL || large.offset != UploadRing::NoOffset || large.pixels[4 * 3 + 1] != expectedChannel(0, 3, 0, 1))
+			mismatches++;
+		streamer->release(large);
+		streamer->stop();
+
+		// Live ranges never overlap and fit in the ring
+		std::mt19937 rng(1);
+		std::uniform_int_distribution<int> length(1, 300000);
+		UploadRing r(1 << 20);
+		std::vector<std::pair<size_t, size_t> > live;
+		for (int step = 0; step < 10000; step++)
+		{
+			if (!live.empty() && (rng() % 2 == 0 || live.size() > 8))
+			{
+				size_t i = rng() % live.size();
+				r.release(live[i].first);
+				live.erase(live.begin() + i);
+				continue;
+			}
+			size_t n = length(rng);
+			size_t offset = r.allocate(n);
+			if (offset == UploadRing::NoOffset)
+				continue;
+			if (offset + n > r.getCapacity())
+				mismatches++;
+			for (size_t i = 0; i < live.size(); i++)
+			{
+				if (offset < live[i].first + live[i].second && live[i].first < offset + n)
+					mismatches++;
+			}
+			live.push_back(std::make_pair(offset, n));
+		}
+		for (size_t i = 0; i < live.size(); i++)
+			r.release(live[i].first);
+		if (r.getUsed() != 0 || r.getLiveCount() != 0 || r.allocate(r.getCapacity()) != 0)
+			mismatches++;
+	}
+	state.setItemsProcessed(state.iterations() * ImageCount);
+	state.setMismatches(mismatches);
+	removeImages(files);
+}
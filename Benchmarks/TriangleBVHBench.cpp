@@ -0,0 +1,195 @@
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/gtc/constants.hpp>
+
+#include "Benchmark.h"
+#include "TriangleBVH.h"
+
+struct Mesh
+{
+	std::vector<glm::vec3> vertices;
+	std::vector<int> indices;
+
+	int triangleCount() const { return (int)indices.size() / 3; }
+};
+
+// UV sphere of radius 1 with at least triangleCount triangles, slightly perturbed to avoid a perfectly regular layout
+static Mesh createSphere(long long triangleCount)
+{
+	int slices = (int)std::ceil(std::sqrt((double)triangleCount / 2.0));
+	int stacks = slices;
+
+	Mesh m;
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> noise(-0.002f, 0.002f);
+	for (int j = 0; j <= stacks; j++)
+	{
+		float phi = glm::pi<float>() * (float)j / (float)stacks;
+		for (int i = 0; i <= slices; i++)
+		{
+			float theta = glm::two_pi<float>() * (float)i / (float)slices;
+			float r = 1.0f + noise(rng);
+			m.vertices.push_back(r * glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)));
+		}
+	}
+	for (int j = 0; j < stacks; j++)
+	{
+		for (int i = 0; i < slices; i++)
+		{
+			int a = j * (slices + 1) + i;
+			int b = a + slices + 1;
+			int quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+			m.indices.insert(m.indices.end(), quad, quad + 6);
+		}
+	}
+	return m;
+}
+
+// Rays starting outside the sphere aimed at random points around it : a bit more than half of them hit
+static std::vector<Ray> createRays(int count, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::normal_distribution<float> gauss(0.0f, 1.0f);
+	std::uniform_real_distribution<float> target(-1.2f, 1.2f);
+	std::vector<Ray> rays;
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 origin = 5.0f * glm::normalize(glm::vec3(gauss(rng), gauss(rng), gauss(rng)));
+		glm::vec3 t(target(rng), target(rng), target(rng));
+		rays.push_back(Ray(origin, glm::normalize(t - origin)));
+	}
+	return rays;
+}
+
+static void buildBenchmark(BenchmarkState& state, int threads)
+{
+	Mesh m = createSphere(state.arg());
+	int nodes = 0;
+	while (state.keepRunning())
+	{
+		TriangleBVH bvh;
+		bvh.build(&m.vertices[0], &m.indices[0], m.triangleCount(), threads);
+		nodes = bvh.getNodeCount();
+		state.pauseTiming();	// Exclude the destruction
+		bvh = TriangleBVH();
+		state.resumeTiming();
+	}
+	state.setItemsProcessed(state.iterations() * m.triangleCount());
+	state.setCounter("triangles", m.triangleCount());
+	state.setCounter("nodes", nodes);
+	state.setCounter("threads", threads > 0 ? threads : (double)std::thread::hardware_concurrency());
+}
+
+BENCHMARK(BM_TriangleBVH_Build_SingleThread, 100000, 1000000, 4000000)
+{
+	buildBenchmark(state, 1);
+}
+
+BENCHMARK(BM_TriangleBVH_Build_MultiThread, 100000, 1000000, 4000000)
+{
+	buildBenchmark(state, 0);
+}
+
+BENCHMARK(BM_TriangleBVH_Ray, 100000, 1000000, 4000000)
+{
+	Mesh m = createSphere(state.arg());
+	TriangleBVH bvh;
+	bvh.build(&m.vertices[0], &m.indices[0], m.triangleCount());
+	std::vector<Ray> rays = createRays(4096, 2);
+
+	size_t next = 0;
+	long long hits = 0;
+	while (state.keepRunning())
+	{
+		RayHit hit;
+		if (bvh.intersect(rays[next], hit))
+			hits++;
+		next = (next + 1) % rays.size();
+	}
+	state.setItemsProcessed(state.iterations());
+	state.setCounter("triangles", m.triangleCount());
+	state.setCounter("hit ratio", (double)hits / (double)(state.iterations() > 0 ? state.iterations() : 1));
+}
+
+// Reference : testing every triangle of the mesh, what picking without the hierarchy would cost
+BENCHMARK(BM_BruteForce_Ray, 100000, 1000000)
+{
+	Mesh m = createSphere(state.arg());
+	std::vector<Ray> rays = createRays(4096, 2);
+
+	size_t next = 0;
+	while (state.keepRunning())
+	{
+		const Ray& r = rays[next];
+		float closest = FLT_MAX;
+		for (size_t i = 0; i < m.indices.size(); i += 3)
+		{
+			glm::vec3 v0 = m.vertices[m.indices[i]];
+			glm::vec3 e1 = m.vertices[m.indices[i + 1]] - v0;
+			glm::vec3 e2 = m.vertices[m.indices[i + 2]] - v0;
+			glm::vec3 p = glm::cross(r.direction, e2);
+			float det = glm::dot(e1, p);
+			if (std::fabs(det) < 1e-12f)
+				continue;
+			float invDet = 1.0f / det;
+			glm::vec3 s = r.origin - v0;
+			float u = glm::dot(s, p) * invDet;
+			if (u < 0.0f || u > 1.0f)
+				continue;
+			glm::vec3 q = glm::cross(s, e1);
+			float v = glm::dot(r.direction, q) * invDet;
+			if (v < 0.0f || u + v > 1.0f)
+				continue;
+			float t = glm::dot(e2, q) * invDet;
+			if (t > 0.0f && t < closest)
+				closest = t;
+		}
+		doNotOptimize(closest);
+		next = (next + 1) % rays.size();
+	}
+	state.setItemsProcessed(state.iterations());
+}
+
+// Validates the hierarchy against the brute force closest hit on a small mesh
+BENCHMARK(BM_TriangleBVH_Validate, 20000)
+{
+	Mesh m = createSphere(state.arg());
+	TriangleBVH bvh;
+	bvh.build(&m.vertices[0], &m.indices[0], m.triangleCount());
+	std::vector<Ray> rays = createRays(256, 3);
+
+	long long mismatches = 0;
+	while (state.keepRunning())
+	{
+		for (size_t k = 0; k < rays.size(); k++)
+		{
+			const Ray& r = rays[k];
+			float closest = FLT_MAX;
+			for (size_t i = 0; i < m.indices.size(); i += 3)
+			{
+				glm::vec3 v0 = m.vertices[m.indices[i]];
+				glm::vec3 e1 = m.vertices[m.indices[i + 1]] - v0;
+				glm::vec3 e2 = m.vertices[m.indices[i + 2]] - v0;
+				glm::vec3 p = glm::cross(r.direction, e2);
+				float det = glm::dot(e1, p);
+				if (std::fabs(det) < 1e-12f)
+					continue;
+				glm::vec3 s = r.origin - v0;
+				float u = glm::dot(s, p) / det;
+				glm::vec3 q = glm::cross(s, e1);
+				float v = glm::dot(r.direction, q) / det;
+				float t = glm::dot(e2, q) / det;
+				if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < closest)
+					closest = t;
+			}
+			RayHit hit;
+			bool found = bvh.intersect(r, hit);
+			if (found != (closest < FLT_MAX) || (found && std::fabs(hit.t - closest) > 1e-4f))
+				mismatches++;
+		}
+	}
+	state.setItemsProcessed(state.iterations() * (long long)rays.size());
+	state.setMismatches(mismatches);
+}
@@ -1,6 +1,7 @@
 
 #include "Display.h"
 #include "Node.h"
+#include "Profiler.h"
 #include <glm/gtc/type_ptr.hpp>
 
 
@@ -28,6 +29,7 @@ Display::~Display()
 
 void Display::apply(FrameBufferObject* src, FrameBufferObject* target)
 {
+	PROFILE_GPU_ZONE(m_Name.c_str());
 
 	
 	// note the most efficient but here for usability purposes (could be set up in the constructor if src is constant)
@@ -11,12 +11,36 @@
 #include "imgui/imgui.h"
 #include "Logger/ImGuiLogger.h"
 
+// Parameters of the headless benchmark mode (see Application::runBenchmark)
+struct BenchmarkSettings
+{
+    int frames = 600;                       // Measured frames
+    int warmup = 30;                        // Frames rendered before the measure
+    float timestep = 1000.0f / 60.0f;       // Fixed animation step in milliseconds
+    std::string output = "benchmark.json";  // JSON report path
+};
+
 class Application
 {
     public:
-        explicit Application(int width = 1024, int height=1024, std::string name="My OpenGL Engine");
+        /**
+         * @param hidden create an invisible window, for the benchmark mode
+         * @param egl create the context with EGL instead of the native API (e.g. Mesa llvmpipe on a machine without GPU)
+         * @param generatedScene procedural scene loaded instead of the default one (NULL for the default scene)
+         * @param sceneFile binary or text scene loaded instead of the default one (empty for the default scene)
+         */
+        explicit Application(int width = 1024, int height=1024, std::string name="My OpenGL Engine", bool hidden = false, bool egl = false,
+                             const SceneGeneratorSettings* generatedScene = nullptr, const std::string& sceneFile = "");
         ~Application();
         void mainLoop();
+
+        /**
+         * @brief Render a scripted camera orbit for a fixed number of frames at a fixed timestep into an offscreen
+         *        framebuffer, and write a JSON report (frame time percentiles, per phase CPU times, draw calls,
+         *        triangles, peak resident memory and a hash of the final frame)
+         * @return 0 on success, -1 if the report could not be produced
+         */
+        int runBenchmark(const BenchmarkSettings& settings);
         
         // Display Imgui Overlay
         void displayOverlay(bool display, float milli, float fps);
@@ -40,6 +64,7 @@ class Application
     private:
         static glm::vec3 projectOnSphere(glm::vec2 pos);
         glm::vec2 getNormalizedMouseCoord(glm::vec2 m) const;
+        void pickNode(glm::vec2 m);
 
         void trackballFrame();
         void translateFrameTrackball(glm::vec2 v, glm::vec2 o);
@@ -65,6 +90,7 @@ class Application
         float angleYaw{}, anglePitch{};
         glm::vec3 camPos{}, camDir{};
         glm::vec2 oMouse{}, nMouse{};
+        glm::vec2 pressMouse{};
         glm::vec2 middle{};
 };
 
@@ -0,0 +1,191 @@
+#ifndef _BOUNDING_VOLUMES_H
+#define _BOUNDING_VOLUMES_H
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cfloat>
+
+/**
+ * @brief      Axis aligned bounding box
+ * @details    An empty box has min > max, so that the first call to expand() initializes it.
+ */
+struct AABB
+{
+	glm::vec3 min;
+	glm::vec3 max;
+
+	AABB() : min(FLT_MAX), max(-FLT_MAX) {}
+	AABB(const glm::vec3& _min, const glm::vec3& _max) : min(_min), max(_max) {}
+
+	bool isEmpty() const
+	{
+		return min.x > max.x || min.y > max.y || min.z > max.z;
+	}
+
+	void expand(const glm::vec3& p)
+	{
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+
+	void expand(const AABB& b)
+	{
+		min = glm::min(min, b.min);
+		max = glm::max(max, b.max);
+	}
+
+	glm::vec3 center() const { return 0.5f * (min + max); }
+	glm::vec3 extent() const { return max - min; }
+
+	/**
+	 * @brief Half surface area of the box, used as the insertion cost heuristic
+	 */
+	float area() const
+	{
+		glm::vec3 d = max - min;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	bool contains(const AABB& b) const
+	{
+		return min.x <= b.min.x && min.y <= b.min.y && min.z <= b.min.z &&
+			max.x >= b.max.x && max.y >= b.max.y && max.z >= b.max.z;
+	}
+
+	bool overlaps(const AABB& b) const
+	{
+		return min.x <= b.max.x && max.x >= b.min.x &&
+			min.y <= b.max.y && max.y >= b.min.y &&
+			min.z <= b.max.z && max.z >= b.min.z;
+	}
+
+	/**
+	 * @brief Box enclosing this box transformed by matrix m (Arvo's method)
+	 * @param m affine transformation
+	 */
+	AABB transform(const glm::mat4& m) const
+	{
+		AABB r;
+		if (isEmpty())
+			return r;
+		glm::vec3 t(m[3]);
+		r.min = t;
+		r.max = t;
+		for (int c = 0; c < 3; c++)
+		{
+			glm::vec3 col(m[c]);
+			glm::vec3 a = col * min[c];
+			glm::vec3 b = col * max[c];
+			r.min += glm::min(a, b);
+			r.max += glm::max(a, b);
+		}
+		return r;
+	}
+
+	static AABB merge(const AABB& a, const AABB& b)
+	{
+		return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+	}
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center;
+	float radius;
+
+	BoundingSphere(const glm::vec3& c = glm::vec3(0.0f), float r = 0.0f) : center(c), radius(r) {}
+
+	bool overlaps(const AABB& b) const
+	{
+		glm::vec3 d = glm::clamp(center, b.min, b.max) - center;
+		return glm::dot(d, d) <= radius * radius;
+	}
+};
+
+struct Ray
+{
+	glm::vec3 origin;
+	glm::vec3 direction;
+	glm::vec3 invDirection;
+
+	Ray(const glm::vec3& o = glm::vec3(0.0f), const glm::vec3& d = glm::vec3(0.0f, 0.0f, -1.0f)) :
+		origin(o), direction(d), invDirection(1.0f / d) {}
+
+	/**
+	 * @brief Slab test against box b
+	 * @param tMax farthest accepted distance
+	 * @param tHit entry distance along the ray when the box is hit
+	 * @return true if the ray hits the box within [0, tMax]
+	 */
+	bool intersect(const AABB& b, float tMax, float& tHit) const
+	{
+		glm::vec3 t0 = (b.min - origin) * invDirection;
+		glm::vec3 t1 = (b.max - origin) * invDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+		float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+		tHit = tEnter;
+		return tEnter <= tExit;
+	}
+};
+
+/**
+ * @brief      View frustum defined by 6 planes extracted from a view-projection matrix
+ * @details    Planes point inward: a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane.
+ */
+struct Frustum
+{
+	enum Containment { Outside, Intersect, Inside };
+
+	glm::vec4 planes[6];
+
+	Frustum() {}
+
+	/**
+	 * @brief Extract frustum planes (Gribb-Hartmann) from a matrix
+	 * @param m view-projection matrix (or Proj * View * Model to work in model space)
+	 */
+	explicit Frustum(const glm::mat4& m)
+	{
+		glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+		planes[0] = row3 + row0;	// Left
+		planes[1] = row3 - row0;	// Right
+		planes[2] = row3 + row1;	// Bottom
+		planes[3] = row3 - row1;	// Top
+		planes[4] = row3 + row2;	// Near
+		planes[5] = row3 - row2;	// Far
+
+		for (int i = 0; i < 6; i++)
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+
+	Containment classify(const AABB& b) const
+	{
+		glm::vec3 c = b.center();
+		glm::vec3 e = 0.5f * b.extent();
+		Containment result = Inside;
+		for (int i = 0; i < 6; i++)
+		{
+			glm::vec3 n(planes[i]);
+			float d = glm::dot(n, c) + planes[i].w;
+			float r = glm::dot(e, glm::abs(n));
+			if (d < -r)
+				return Outside;
+			if (d < r)
+				result = Intersect;
+		}
+		return result;
+	}
+
+	bool overlaps(const AABB& b) const
+	{
+		return classify(b) != Outside;
+	}
+};
+
+#endif
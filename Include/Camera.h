@@ -2,6 +2,7 @@
 #define CAMERA_
 
 #include "Frame.h"
+#include "BoundingVolumes.h"
 #include <cmath>
 #include <string>
 
@@ -17,7 +18,7 @@ struct CameraMatrices {
  * @brief           Class to manage a camera in your virtual scene
  * @details         Verbose description of class details.
  */
-class Camera {
+class Camera : public PooledObject<Camera> {
 	public:
 		explicit Camera(std::string name= "");  // Creates a new Camera
 		~Camera();  // Destroy a Camera
@@ -150,6 +151,19 @@ class Camera {
 		 **/
 		glm::mat4 getViewMatrix();
 
+		/**
+		 * @brief           Return the view frustum in world space
+		 * @return          Frustum planes extracted from Proj * View
+		 **/
+		Frustum getFrustum();
+
+		/**
+		 * @brief           Return the world space ray going through a point of the screen
+		 * @param ndc       Point in normalized device coordinates ([-1,1] on both axes, y pointing up)
+		 * @return          Ray starting on the near plane, with a normalized direction
+		 **/
+		Ray getRay(glm::vec2 ndc);
+
 		/**
 		 * @brief           Set up camera position and orientation from matrix m
 		 **/
@@ -170,7 +184,7 @@ class Camera {
 		/**
 		* @brief            Return camera name
 		 **/
-		std::string getName();
+		const std::string& getName() const;
 
 		void updateBuffer();
 		Frame* frame() { return this->m_Frame; };
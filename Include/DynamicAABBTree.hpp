@@ -0,0 +1,527 @@
+#ifndef _DYNAMIC_AABB_TREE
+#define _DYNAMIC_AABB_TREE
+
+#include <vector>
+#include <cassert>
+#include "BoundingVolumes.h"
+
+/**
+ * @brief      Dynamic bounding volume hierarchy of axis aligned boxes
+ * @details    Each proxy is a leaf storing a fattened box and a user data. Leaves are inserted next to the sibling
+ *             minimizing the increase of surface area, and the ancestors are rebalanced by tree rotations on the way up
+ *             (as in Box2D's b2DynamicTree). Moving a proxy only touches the tree when its new box leaves the fat box,
+ *             so small per-frame movements cost a containment test.
+ */
+template <typename T> class DynamicAABBTree
+{
+public:
+	static const int NullNode = -1;
+
+	/**
+	 * @param margin relative enlargement of the stored boxes (fraction of the box extent)
+	 */
+	explicit DynamicAABBTree(float margin = 0.1f);
+
+	/**
+	 * @brief Create a proxy (leaf) for box b
+	 * @return proxy id, stable until destroyProxy
+	 */
+	int createProxy(const AABB& b, T data);
+	void destroyProxy(int proxy);
+
+	/**
+	 * @brief Refit a proxy to its new box b
+	 * @return true if the leaf had to be reinserted
+	 */
+	bool moveProxy(int proxy, const AABB& b);
+
+	T getUserData(int proxy) const { return m_Nodes[proxy].data; }
+	const AABB& getFatAABB(int proxy) const { return m_Nodes[proxy].box; }
+
+	int getProxyCount() const { return m_ProxyCount; }
+	int getHeight() const { return m_Root == NullNode ? 0 : m_Nodes[m_Root].height; }
+	// Fat box enclosing every proxy, empty if the tree is empty
+	AABB getBounds() const { return m_Root == NullNode ? AABB() : m_Nodes[m_Root].box; }
+	void clear();
+
+	/**
+	 * @brief Call callback(data) for each proxy whose fat box overlaps the volume
+	 */
+	template <typename F> void query(const AABB& b, F callback) const;
+	template <typename F> void query(const BoundingSphere& s, F callback) const;
+	template <typename F> void query(const Frustum& f, F callback) const;
+
+	/**
+	 * @brief Call callback(data, tEnter) for each proxy hit by the ray, closest boxes are not guaranteed to come first.
+	 * @details The callback returns the new maximum distance, allowing to prune the traversal once a hit is found.
+	 */
+	template <typename F> void raycast(const Ray& r, float tMax, F callback) const;
+
+private:
+	struct TreeNode
+	{
+		AABB box;
+		T data;
+		int parent;		// Next free node when in the free list
+		int child1;
+		int child2;
+		int height;		// Leaf = 0, free node = -1
+
+		bool isLeaf() const { return child1 == NullNode; }
+	};
+
+	int allocateNode();
+	void freeNode(int node);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int a);
+	void refitAncestors(int node);
+	AABB fatten(const AABB& b) const;
+	template <typename F> void collectLeaves(int node, F& callback) const;
+
+	std::vector<TreeNode> m_Nodes;
+	int m_Root;
+	int m_FreeList;
+	int m_ProxyCount;
+	float m_Margin;
+	mutable std::vector<int> m_Stack;
+};
+
+template <typename T>
+DynamicAABBTree<T>::DynamicAABBTree(float margin) :
+	m_Root(NullNode), m_FreeList(NullNode), m_ProxyCount(0), m_Margin(margin)
+{
+}
+
+template <typename T>
+void DynamicAABBTree<T>::clear()
+{
+	m_Nodes.clear();
+	m_Root = NullNode;
+	m_FreeList = NullNode;
+	m_ProxyCount = 0;
+}
+
+template <typename T>
+int DynamicAABBTree<T>::allocateNode()
+{
+	int id;
+	if (m_FreeList != NullNode)
+	{
+		id = m_FreeList;
+		m_FreeList = m_Nodes[id].parent;
+	}
+	else
+	{
+		id = (int)m_Nodes.size();
+		m_Nodes.push_back(TreeNode());
+	}
+	TreeNode& n = m_Nodes[id];
+	n.parent = NullNode;
+	n.child1 = NullNode;
+	n.child2 = NullNode;
+	n.height = 0;
+	return id;
+}
+
+template <typename T>
+void DynamicAABBTree<T>::freeNode(int node)
+{
+	m_Nodes[node].parent = m_FreeList;
+	m_Nodes[node].height = -1;
+	m_FreeList = node;
+}
+
+template <typename T>
+AABB DynamicAABBTree<T>::fatten(const AABB& b) const
+{
+	glm::vec3 r = m_Margin * b.extent() + glm::vec3(1e-4f);
+	return AABB(b.min - r, b.max + r);
+}
+
+template <typename T>
+int DynamicAABBTree<T>::createProxy(const AABB& b, T data)
+{
+	int proxy = allocateNode();
+	m_Nodes[proxy].box = fatten(b);
+	m_Nodes[proxy].data = data;
+	insertLeaf(proxy);
+	m_ProxyCount++;
+	return proxy;
+}
+
+template <typename T>
+void DynamicAABBTree<T>::destroyProxy(int proxy)
+{
+	assert(0 <= proxy && proxy < (int)m_Nodes.size() && m_Nodes[proxy].isLeaf());
+	removeLeaf(proxy);
+	freeNode(proxy);
+	m_ProxyCount--;
+}
+
+template <typename T>
+bool DynamicAABBTree<T>::moveProxy(int proxy, const AABB& b)
+{
+	assert(0 <= proxy && proxy < (int)m_Nodes.size() && m_Nodes[proxy].isLeaf());
+	if (m_Nodes[proxy].box.contains(b))
+		return false;
+
+	removeLeaf(proxy);
+	m_Nodes[proxy].box = fatten(b);
+	insertLeaf(proxy);
+	return true;
+}
+
+template <typename T>
+void DynamicAABBTree<T>::insertLeaf(int leaf)
+{
+	if (m_Root == NullNode)
+	{
+		m_Root = leaf;
+		m_Nodes[leaf].parent = NullNode;
+		return;
+	}
+
+	// Find the best sibling by descending along the cheapest surface area increase
+	AABB leafBox = m_Nodes[leaf].box;
+	int index = m_Root;
+	while (!m_Nodes[index].isLeaf())
+	{
+		int child1 = m_Nodes[index].child1;
+		int child2 = m_Nodes[index].child2;
+
+		float area = m_Nodes[index].box.area();
+		float combinedArea = AABB::merge(m_Nodes[index].box, leafBox).area();
+
+		// Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+		// Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float cost1 = AABB::merge(leafBox, m_Nodes[child1].box).area() + inheritanceCost;
+		if (!m_Nodes[child1].isLeaf())
+			cost1 -= m_Nodes[child1].box.area();
+		float cost2 = AABB::merge(leafBox, m_Nodes[child2].box).area() + inheritanceCost;
+		if (!m_Nodes[child2].isLeaf())
+			cost2 -= m_Nodes[child2].box.area();
+
+		if (cost < cost1 && cost < cost2)
+			break;
+
+		index = (cost1 < cost2) ? child1 : child2;
+	}
+	int sibling = index;
+
+	// Create a new parent
+	int oldParent = m_Nodes[sibling].parent;
+	int newParent = allocateNode();
+	m_Nodes[newParent].parent = oldParent;
+	m_Nodes[newParent].box = AABB::merge(leafBox, m_Nodes[sibling].box);
+	m_Nodes[newParent].height = m_Nodes[sibling].height + 1;
+	m_Nodes[newParent].child1 = sibling;
+	m_Nodes[newParent].child2 = leaf;
+	m_Nodes[sibling].parent = newParent;
+	m_Nodes[leaf].parent = newParent;
+
+	if (oldParent != NullNode)
+	{
+		if (m_Nodes[oldParent].child1 == sibling)
+			m_Nodes[oldParent].child1 = newParent;
+		else
+			m_Nodes[oldParent].child2 = newParent;
+	}
+	else
+		m_Root = newParent;
+
+	refitAncestors(m_Nodes[leaf].parent);
+}
+
+template <typename T>
+void DynamicAABBTree<T>::removeLeaf(int leaf)
+{
+	if (leaf == m_Root)
+	{
+		m_Root = NullNode;
+		return;
+	}
+
+	int parent = m_Nodes[leaf].parent;
+	int grandParent = m_Nodes[parent].parent;
+	int sibling = (m_Nodes[parent].child1 == leaf) ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+	if (grandParent != NullNode)
+	{
+		// Replace the parent by the sibling
+		if (m_Nodes[grandParent].child1 == parent)
+			m_Nodes[grandParent].child1 = sibling;
+		else
+			m_Nodes[grandParent].child2 = sibling;
+		m_Nodes[sibling].parent = grandParent;
+		freeNode(parent);
+		refitAncestors(grandParent);
+	}
+	else
+	{
+		m_Root = sibling;
+		m_Nodes[sibling].parent = NullNode;
+		freeNode(parent);
+	}
+}
+
+template <typename T>
+void DynamicAABBTree<T>::refitAncestors(int index)
+{
+	while (index != NullNode)
+	{
+		index = balance(index);
+
+		int child1 = m_Nodes[index].child1;
+		int child2 = m_Nodes[index].child2;
+		m_Nodes[index].height = 1 + std::max(m_Nodes[child1].height, m_Nodes[child2].height);
+		m_Nodes[index].box = AABB::merge(m_Nodes[child1].box, m_Nodes[child2].box);
+
+		index = m_Nodes[index].parent;
+	}
+}
+
+/**
+ * Perform a left or right rotation if node a is imbalanced.
+ * Returns the new root index of the rotated subtree.
+ */
+template <typename T>
+int DynamicAABBTree<T>::balance(int iA)
+{
+	TreeNode* A = &m_Nodes[iA];
+	if (A->isLeaf() || A->height < 2)
+		return iA;
+
+	int iB = A->child1;
+	int iC = A->child2;
+	TreeNode* B = &m_Nodes[iB];
+	TreeNode* C = &m_Nodes[iC];
+
+	int balanceFactor = C->height - B->height;
+
+	// Rotate C up
+	if (balanceFactor > 1)
+	{
+		int iF = C->child1;
+		int iG = C->child2;
+		TreeNode* F = &m_Nodes[iF];
+		TreeNode* G = &m_Nodes[iG];
+
+		// Swap A and C
+		C->child1 = iA;
+		C->parent = A->parent;
+		A->parent = iC;
+
+		// A's old parent should point to C
+		if (C->parent != NullNode)
+		{
+			if (m_Nodes[C->parent].child1 == iA)
+				m_Nodes[C->parent].child1 = iC;
+			else
+				m_Nodes[C->parent].child2 = iC;
+		}
+		else
+			m_Root = iC;
+
+		// Rotate
+		if (F->height > G->height)
+		{
+			C->child2 = iF;
+			A->child2 = iG;
+			G->parent = iA;
+			A->box = AABB::merge(B->box, G->box);
+			C->box = AABB::merge(A->box, F->box);
+			A->height = 1 + std::max(B->height, G->height);
+			C->height = 1 + std::max(A->height, F->height);
+		}
+		else
+		{
+			C->child2 = iG;
+			A->child2 = iF;
+			F->parent = iA;
+			A->box = AABB::merge(B->box, F->box);
+			C->box = AABB::merge(A->box, G->box);
+			A->height = 1 + std::max(B->height, F->height);
+			C->height = 1 + std::max(A->height, G->height);
+		}
+		return iC;
+	}
+
+	// Rotate B up
+	if (balanceFactor < -1)
+	{
+		int iD = B->child1;
+		int iE = B->child2;
+		TreeNode* D = &m_Nodes[iD];
+		TreeNode* E = &m_Nodes[iE];
+
+		// Swap A and B
+		B->child1 = iA;
+		B->parent = A->parent;
+		A->parent = iB;
+
+		// A's old parent should point to B
+		if (B->parent != NullNode)
+		{
+			if (m_Nodes[B->parent].child1 == iA)
+				m_Nodes[B->parent].child1 = iB;
+			else
+				m_Nodes[B->parent].child2 = iB;
+		}
+		else
+			m_Root = iB;
+
+		// Rotate
+		if (D->height > E->height)
+		{
+			B->child2 = iD;
+			A->child1 = iE;
+			E->parent = iA;
+			A->box = AABB::merge(C->box, E->box);
+			B->box = AABB::merge(A->box, D->box);
+			A->height = 1 + std::max(C->height, E->height);
+			B->height = 1 + std::max(A->height, D->height);
+		}
+		else
+		{
+			B->child2 = iE;
+			A->child1 = iD;
+			D->parent = iA;
+			A->box = AABB::merge(C->box, D->box);
+			B->box = AABB::merge(A->box, E->box);
+			A->height = 1 + std::max(C->height, D->height);
+			B->height = 1 + std::max(A->height, E->height);
+		}
+		return iB;
+	}
+
+	return iA;
+}
+
+template <typename T>
+template <typename F>
+void DynamicAABBTree<T>::collectLeaves(int node, F& callback) const
+{
+	size_t base = m_Stack.size();
+	m_Stack.push_back(node);
+	while (m_Stack.size() > base)
+	{
+		int id = m_Stack.back();
+		m_Stack.pop_back();
+		const TreeNode& n = m_Nodes[id];
+		if (n.isLeaf())
+			callback(n.data);
+		else
+		{
+			m_Stack.push_back(n.child1);
+			m_Stack.push_back(n.child2);
+		}
+	}
+}
+
+template <typename T>
+template <typename F>
+void DynamicAABBTree<T>::query(const AABB& b, F callback) const
+{
+	if (m_Root == NullNode)
+		return;
+	m_Stack.clear();
+	m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		int id = m_Stack.back();
+		m_Stack.pop_back();
+		const TreeNode& n = m_Nodes[id];
+		if (!n.box.overlaps(b))
+			continue;
+		if (n.isLeaf())
+			callback(n.data);
+		else
+		{
+			m_Stack.push_back(n.child1);
+			m_Stack.push_back(n.child2);
+		}
+	}
+}
+
+template <typename T>
+template <typename F>
+void DynamicAABBTree<T>::query(const BoundingSphere& s, F callback) const
+{
+	if (m_Root == NullNode)
+		return;
+	m_Stack.clear();
+	m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		int id = m_Stack.back();
+		m_Stack.pop_back();
+		const TreeNode& n = m_Nodes[id];
+		if (!s.overlaps(n.box))
+			continue;
+		if (n.isLeaf())
+			callback(n.data);
+		else
+		{
+			m_Stack.push_back(n.child1);
+			m_Stack.push_back(n.child2);
+		}
+	}
+}
+
+template <typename T>
+template <typename F>
+void DynamicAABBTree<T>::query(const Frustum& f, F callback) const
+{
+	if (m_Root == NullNode)
+		return;
+	m_Stack.clear();
+	m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		int id = m_Stack.back();
+		m_Stack.pop_back();
+		const TreeNode& n = m_Nodes[id];
+		Frustum::Containment c = f.classify(n.box);
+		if (c == Frustum::Outside)
+			continue;
+		if (c == Frustum::Inside || n.isLeaf())
+			collectLeaves(id, callback);	// No more plane tests for fully visible subtrees
+		else
+		{
+			m_Stack.push_back(n.child1);
+			m_Stack.push_back(n.child2);
+		}
+	}
+}
+
+template <typename T>
+template <typename F>
+void DynamicAABBTree<T>::raycast(const Ray& r, float tMax, F callback) const
+{
+	if (m_Root == NullNode)
+		return;
+	m_Stack.clear();
+	m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		int id = m_Stack.back();
+		m_Stack.pop_back();
+		const TreeNode& n = m_Nodes[id];
+		float tEnter;
+		if (!r.intersect(n.box, tMax, tEnter))
+			continue;
+		if (n.isLeaf())
+			tMax = callback(n.data, tEnter);
+		else
+		{
+			m_Stack.push_back(n.child1);
+			m_Stack.push_back(n.child2);
+		}
+	}
+}
+
+#endif
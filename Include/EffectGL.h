@@ -37,7 +37,7 @@ public :
     virtual void animate( const float elapsedTime);
 
 
-    string getName() { return m_Name; };
+    const string& getName() const { return m_Name; };
 
 
 
@@ -13,6 +13,9 @@
 
 #include "FrameBufferObject.h"
 #include "Display.h"
+#include "OcclusionCuller.h"
+#include "LightClusters.h"
+#include "SceneGenerator.h"
 
 class EngineGL 
 {
@@ -31,13 +34,18 @@ public:
 	~EngineGL();
 	/**
 	 * @brief	Initialize the engine
+	 * @param	generated settings of a procedural scene replacing the default one (NULL for the default scene)
+	 * @param	sceneFile scene loaded instead of the default one (see loadScene), ignored for a generated scene
 	 * @return success of the initialization
 	 */
 
-	bool init();
+	bool init(const SceneGeneratorSettings* generated = NULL, const std::string& sceneFile = "");
 	/**
 	 * @brief	Load a Scene according to the provided filename
-	 * @param	filename of a target scene in a known format (.DAE,.3DS,.OBJ)
+	 * @details	The scene is added under the scene node: models, materials, nodes and lights of a binary scene (see
+	 *			SceneFile), the nodes being created in one pass over the mapped file. A text scene is converted first
+	 *			to filename + ".bin".
+	 * @param	filename of a binary or text scene
 	 * @return success of the loading operation
 	 */
 	bool loadScene(std::string filename);
@@ -97,12 +105,40 @@ public:
 	 */
 	virtual void displayInterface();
 
+	/**
+	 * @brief	Remove from visibleNodes the nodes hidden by the occluders (see Node::setOccluder)
+	 */
+	void cullOccludedNodes();
+
+	/**
+	 * @brief	Bin the lights of the scene registry in the froxels of the camera and upload the result for the
+	 *			clustered materials (lights, grid and light indices in the shader storage buffers 0, 1 and 2)
+	 * @param	targetWidth, targetHeight size of the render target the clusters tile
+	 */
+	void updateLightClusters(int targetWidth, int targetHeight);
+
 protected:
 	int m_Width;
 	int m_Height;
 
 	Scene* scene;
-	NodeCollector* allNodes{};
+	IncrementalNodeCollector* allNodes{};	// Patched from the scene changes at the beginning of animate
+	std::vector<Node*> visibleNodes;	// Nodes returned by the frustum query of the current frame
+	OcclusionCuller occlusionCuller;
+	bool occlusionCulling;
+	bool showCullingInterface;
+	LightClusters lightClusters;
+	std::vector<PointLight> frameLights;	// World space lights of the current frame
+	glm::mat4 clusterProjection;			// Projection of the current froxel bounds
+	GLuint lightBuffers[3];					// Lights, grid and light indices
+	int lightBinningThreads;
+	bool showLightingInterface;
+	bool showStreamingInterface;
+	bool showTextureMemoryInterface;
+	bool showResidencyInterface;
+	bool showCaptureInterface;
+	bool showRenderTargetInterface;
+	int captureCount;			// Screenshots of the back buffer
     FrameBufferObject* myFBO;
 	Display* display{};
 };
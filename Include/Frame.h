@@ -5,8 +5,10 @@
 #include <vector>
 #include "glm/gtc/quaternion.hpp"
 #include "glm/gtx/quaternion.hpp"
+#include "ObjectPool.hpp"
 
-class Frame
+// Allocated from a pool: frames are created with every node and camera
+class Frame : public PooledObject<Frame>
 {
 public:
 
@@ -156,6 +158,12 @@ public:
 	   **/
 	bool updateNeeded();
 
+	/**
+	   * @brief Number of changes of the frame (or of its fathers), for the users that track changes on their own without clearing the update flag
+	   * @return version of the frame transformation
+	   **/
+	unsigned int getVersion();
+
 
 	/**
 	   * @brief Return parent frame of current node
@@ -171,6 +179,7 @@ private:
 	bool isCamera;  ///< boolean flagging current frame as belonging to instance of Camera class
 	Frame *reference; ///< Father frame.
 	bool m_ToUpdate;/// set to true when the frame change
+	unsigned int m_Version;/// incremented when the frame change
 };
 
 
@@ -2,14 +2,23 @@
 
 
 #include <string>
+#include <vector>
+#include "RenderTargetPool.h"
 #include "Scene.h"
 #include "Texture2D.h"
 
 class FrameBufferObject
 {
 public:
-    FrameBufferObject(std::string name = "", int _width = 1024, int _height = 1024);
-    ~FrameBufferObject();
+    /**
+     * @brief     Framebuffer with color and depth attachments of the given formats (0 for none), taken from the RenderTargetPool
+     */
+    FrameBufferObject(std::string name = "", int _width = 1024, int _height = 1024, GLenum colorFormat = GL_RGBA8, GLenum depthFormat = GL_DEPTH_COMPONENT24);
+    /**
+     * @brief     Framebuffer with the attachments of desc: color textures (multiple render targets), depth in a texture if sampled or in a renderbuffer otherwise, multisampled renderbuffers resolved into the textures when desc.samples > 1
+     */
+    FrameBufferObject(std::string name, const RenderTargetDesc& desc);
+    virtual ~FrameBufferObject();
 
     GLuint getId()
     {
@@ -23,42 +32,77 @@ public:
     void enable();
 
     /**
-     * @brief     Release the FBO as rendering target.Bind NULL as rendering target (initial default state). Change the viewport to match the screen size (Note : Changing viewport here is not the most efficient strategy but improves usability in IMN401)
+     * @brief     Release the FBO as rendering target.Bind NULL as rendering target (initial default state). Change the viewport to match the screen size (Note : Changing viewport here is not the most efficient strategy but improves usability in IMN401). Resolves the multisampled attachments.
      */
     void disable();
 
+    /**
+     * @brief     Blit the multisampled color attachments (and the depth if sampled) into the textures. Done by disable, nothing without MSAA
+     */
+    void resolve();
+
 
     /**
-     * @brief     Destroy FBO in GPU memory but keep the C++ object intact. Usage except in the destructor mostly for changing the FBO parameters(size, attachments... without losing the c++ pointer and FBO Id)
+     * @brief     Give the attachments back to the RenderTargetPool but keep the C++ object intact. Usage except in the destructor mostly for changing the FBO parameters(size, attachments... without losing the c++ pointer and FBO Id)
      */
     void destroy();
 
     /**
-    * @brief    Create simple texture attachments (color, depth) of given size for the current FBO
+    * @brief    Take texture attachments (color, depth) of given size from the RenderTargetPool for the current FBO
     */
     void createTextureTargets(int width, int height);
 
+    // Formats of the next createTextureTargets, 0 for no attachment
+    void setAttachmentFormats(GLenum colorFormat, GLenum depthFormat);
+
     void resizeFBO(int width, int height);
 
+    /**
+     * @brief     New attachments (size, formats, samples) keeping the FBO Id, the former ones given back to the RenderTargetPool
+     */
+    void reconfigure(const RenderTargetDesc& desc);
+
+    const RenderTargetDesc& getDesc() const
+    {
+        return m_Desc;
+    }
+
 
 
     /**
      * @brief Return the color attachment as a Texture2D
      * @return The color attachment
     **/
-    Texture2D* getColorTexture();
+    Texture2D* getColorTexture(int index = 0);
+    int getColorTextureCount();
+    // NULL unless the depth is sampled
+    Texture2D* getDepthTexture();
+
+    /**
+     * @brief     Video memory of the attachments (textures, renderbuffers), in bytes
+     */
+    size_t getMemorySize();
 
     int getWidth();
     int getHeight();
 
 
-    std::string getName()
+    const std::string& getName() const
     {
         return m_Name;
     }
 
+    /**
+     * @brief     Stream every interval-th frame to a video file (.y4m, raw RGB otherwise) or to a command ("|ffmpeg ..."), the frame being taken when the FBO is released (disable) and encoded on the capture thread. Resizing the FBO stops the recording.
+     * @return    false if the target could not be opened, or if the FBO has no color attachment
+     */
+    bool startRecording(const std::string& target, int interval = 1, int fps = 60);
+    void stopRecording();
+    bool isRecording();
+
     // Interface - ImGUI
     bool show_interface;
+    // Capture of the first color attachment (none for depth only FBOs)
     void writeToFile(string filename);
     virtual void displayInterface();
 
@@ -71,13 +115,20 @@ private:
     std::string m_Name;
     std::string info_text;
     GLuint m_FBOId;
-    bool CheckFramebufferStatus();
+    GLuint m_ResolveFBOId;  // Textures of the multisampled FBO, 0 without MSAA
+    bool CheckFramebufferStatus(GLuint fbo);
+
+    // FBO holding the single sample result (read back by the captures)
+    GLuint getResolvedId();
 
 
     Scene* scene;
 
-    Texture2D* colorTexture;
+    RenderTargetDesc m_Desc;
+    std::vector<Texture2D*> colorTextures;
     Texture2D* depthTexture;
+    std::vector<GLuint> m_ColorRenderbuffers;   // Multisampled
+    GLuint m_DepthRenderbuffer;
 
 
 
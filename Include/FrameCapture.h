@@ -0,0 +1,218 @@
+#ifndef _FRAME_CAPTURE_H
+#define _FRAME_CAPTURE_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include "Singleton.h"
+
+enum CaptureFormat
+{
+	CapturePNG = 0,
+	CaptureRaw = 1,		// RGBA8 rows, top first, without header
+	CaptureDDS = 2		// DXT5 (image_DXT)
+};
+
+enum VideoFormat
+{
+	VideoY4M = 0,		// YUV 4:2:0 frames (YUV4MPEG2), read by ffmpeg and most players
+	VideoRGB = 1		// RGB24 frames without header
+};
+
+/**
+ * @brief      Output of a recording: a file, or the standard input of a command when the target starts with '|'
+ *             (e.g. "|ffmpeg -y -i - capture.mp4")
+ * @details    Opened (and the Y4M header written) on construction, closed on destruction: the last frame job to release
+ *             it closes it on the writer thread.
+ */
+class VideoStream
+{
+public:
+	VideoStream(const std::string& target, VideoFormat format, int width, int height, int fps);
+	~VideoStream();
+
+	bool isOpen() const { return m_File != NULL; }
+	/**
+	 * @brief Convert and write a frame of RGBA8 pixels, rows bottom first (writer thread)
+	 */
+	bool writeFrame(const unsigned char* pixels, std::vector<unsigned char>& scratch);
+
+	int getWidth() const { return m_Width; }
+	int getHeight() const { return m_Height; }
+	// .y4m files and commands in Y4M, raw RGB otherwise
+	static VideoFormat formatFromName(const std::string& target);
+
+private:
+	FILE* m_File;
+	bool m_Pipe;
+	VideoFormat m_Format;
+	int m_Width, m_Height;
+};
+
+/**
+ * @brief      Pixels read back from a framebuffer, to encode and write
+ */
+struct CaptureJob
+{
+	std::string filename;
+	CaptureFormat format;
+	int width, height;				// RGBA8
+	const unsigned char* pixels;	// Rows bottom first, as read by glReadPixels, kept by the caller until the job is done
+	int slot;						// Given back by popFinished
+	std::shared_ptr<VideoStream> stream;	// Frame of a recording, written to the stream instead of filename
+};
+
+struct CaptureStats
+{
+	int requested, written, failed;
+	int dropped;				// Every readback slot was in flight
+	long long bytes;			// Pixels written
+	double submitTime;			// Milliseconds of the render thread (readbacks, fences, hand over to the writer)
+	double maxSubmitTime;		// Longest single call
+	double encodeTime;			// Milliseconds of the writer thread
+	int frames;					// Recorded frames read back
+	int droppedFrames;			// Recorded frames dropped, the writer being behind
+	int framesWritten, framesFailed;
+	double recordTime;			// Milliseconds of the render thread in recordFrame
+};
+
+/**
+ * @brief      Thread encoding and writing captured pixels, in submission order
+ * @details    Does not use OpenGL: the pixels may be in a mapped buffer as well as in plain memory.
+ */
+class CaptureWriter
+{
+public:
+	CaptureWriter();
+	~CaptureWriter();
+
+	void start();
+	// Write the pending jobs and stop the thread
+	void stop();
+
+	void submit(const CaptureJob& job);
+	/**
+	 * @brief Slots of the jobs done (written or failed) since the last call
+	 */
+	void popFinished(std::vector<int>& slots);
+	int getPendingCount();
+	// Written, failed, bytes, encodeTime and frames written or failed of stats
+	void getStats(CaptureStats& stats);
+
+	/**
+	 * @brief Flip the rows of the job (into scratch), encode them and write the file
+	 */
+	static bool write(const CaptureJob& job, std::vector<unsigned char>& scratch);
+	// From the extension of filename (.png, .raw, .dds), PNG otherwise
+	static CaptureFormat formatFromName(const std::string& filename);
+
+private:
+	void work();
+
+	std::mutex m_Mutex;
+	std::condition_variable m_JobAdded;
+	std::deque<CaptureJob> m_Jobs;
+	std::vector<int> m_Finished;
+	std::thread m_Thread;
+	bool m_Stop;
+	bool m_Busy;
+	int m_Written, m_Failed;
+	int m_FramesWritten, m_FramesFailed;
+	long long m_Bytes;
+	double m_EncodeTime;
+};
+
+/**
+ * @brief      Screenshots that do not stall the pipeline
+ * @details    capture() reads the color attachment into one of a few persistently mapped pixel pack buffers and
+ *             fences it; it never waits, a capture being dropped when every buffer is in flight. update(), once per
+ *             frame, hands the readbacks whose fence is signaled to the writer thread, which encodes and writes them
+ *             straight from the mapped memory, and recycles the buffers once written. The render thread only issues
+ *             the readback and polls fences.
+ *             A recording reads back every Nth frame of a framebuffer the same way and the writer streams them, in
+ *             order, to a video file or pipe. Its frames may use all the buffers but one (kept for screenshots): when
+ *             the writer is behind, frames are dropped and counted rather than waited for, bounding the memory to the
+ *             buffers.
+ */
+class FrameCapture : public Singleton<FrameCapture>
+{
+	friend class Singleton<FrameCapture>;
+public:
+	/**
+	 * @brief Queue the readback of the first color attachment of framebuffer (0 for the back buffer), GL thread
+	 * @return false if the capture is dropped
+	 */
+	bool capture(GLuint framebuffer, int width, int height, const std::string& filename, CaptureFormat format);
+	bool capture(GLuint framebuffer, int width, int height, const std::string& filename)
+	{
+		return capture(framebuffer, width, height, filename, CaptureWriter::formatFromName(filename));
+	}
+
+	/**
+	 * @brief Hand the finished readbacks to the writer and recycle the written buffers (GL thread, once per frame)
+	 */
+	void update();
+
+	/**
+	 * @brief Record every interval-th frame of framebuffer, the frames being taken by recordFrame
+	 * @param fps frame rate written in the stream
+	 * @return false if the stream could not be opened
+	 */
+	bool startRecording(GLuint framebuffer, int width, int height, const std::string& target, int interval = 1, int fps = 60);
+	// Frames read back are still written, the stream being closed after the last one
+	void stopRecording();
+	bool isRecording(GLuint framebuffer) const { return m_Recording && m_RecordFramebuffer == framebuffer; }
+	/**
+	 * @brief Framebuffer rendered for this frame: read it back if it is recorded and the frame is due (GL thread)
+	 */
+	void recordFrame(GLuint framebuffer);
+
+	// Buffers in flight at most (taken into account while no capture is pending)
+	void setSlotCount(int count);
+	int getSlotCount() const { return (int)m_Slots.size(); }
+	// Captures not written yet
+	int getPendingCount() const;
+	const CaptureStats& getStats();
+	long long getFrame() const { return m_Frame; }
+
+private:
+	FrameCapture();
+	~FrameCapture();
+
+	enum SlotState { SlotFree, SlotReading, SlotWriting };
+
+	struct Slot
+	{
+		GLuint buffer;
+		size_t capacity;
+		unsigned char* memory;	// Persistent mapping
+		GLsync fence;
+		SlotState state;
+		long long sequence;		// Order of the readbacks, kept when handing them to the writer
+		CaptureJob job;
+	};
+
+	// Free slot of at least size bytes, NULL if none
+	Slot* acquireSlot(size_t size, bool recording);
+	void readBack(Slot& slot, GLuint framebuffer, int width, int height);
+	void addTime(double time);
+
+	std::vector<Slot> m_Slots;
+	std::vector<int> m_Finished;
+	std::vector<Slot*> m_Reading;
+	long long m_Frame, m_Sequence;
+	std::shared_ptr<VideoStream> m_Recording;
+	GLuint m_RecordFramebuffer;
+	int m_RecordInterval;
+	long long m_RecordStart, m_RecordedFrame;
+	CaptureWriter m_Writer;
+	CaptureStats m_Stats;
+};
+
+#endif
@@ -6,6 +6,9 @@
 #include <map>
 #include <string>
 #include "GeometricModelLoader/GeometricModelLoader.h"
+#include "BoundingVolumes.h"
+
+class TriangleBVH;
 
 struct Face
 {
@@ -19,7 +22,7 @@ class GeometricModel
 		GeometricModel(std::string name,bool loadnow = true);
 		~GeometricModel();
 
-		const std::string getName();
+		const std::string& getName() const;
 
 		int nb_vertex;
 		int nb_faces;
@@ -30,12 +33,22 @@ class GeometricModel
 		std::vector < glm::vec3 > listCoords;
 		std::vector < glm::vec4 > listTangents;
 
+		// Bounding box of listVertex in model space
+		AABB boundingBox;
+		void computeBoundingBox();
+
+		/**
+		 * @brief Triangle hierarchy used for ray queries in model space, built on first use and kept with the mesh
+		 */
+		TriangleBVH* getBVH();
+
 		static GeometricModelLoader* loader;
 		bool show_interface;
 		virtual void displayInterface();
 
 	protected:
 		std::string m_Name;
+		TriangleBVH* m_BVH;
 
 };
 
@@ -1,3 +1,6 @@
+#ifndef _OBJ_LOADER_H
+#define _OBJ_LOADER_H
+
 #include "GeometricModelLoader.h"
 
 using namespace std;
@@ -10,8 +13,17 @@ class OBJLoader : public GeometricModelLoader {
 		~OBJLoader();
 		bool loadModel(string name,GeometricModel *model) override;
 
-	private:
-		static void setupForTextureCoordinates(GeometricModel* model);
+		/**
+		 * @brief Compute smooth per vertex normals, averaging the normals of the adjacent faces
+		 */
 		static void computeNormals(GeometricModel* model);
+		/**
+		 * @brief Compute per vertex tangents (w holds the handedness of the bitangent), requires normals and texture coordinates
+		 */
 		static void computeTangents(GeometricModel* model);
-};
\ No newline at end of file
+
+	private:
+		static void setupForTextureCoordinates(GeometricModel* model);
+};
+
+#endif
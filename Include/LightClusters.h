@@ -0,0 +1,124 @@
+#ifndef _LIGHT_CLUSTERS_H
+#define _LIGHT_CLUSTERS_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @brief      Point light, laid out as two vec4 of a std430 shader storage buffer
+ */
+struct PointLight
+{
+	glm::vec3 position;
+	float radius;		// Distance at which the light contribution reaches 0
+	glm::vec3 color;
+	float intensity;
+};
+
+/**
+ * @brief      Range of a cluster in the light index list
+ */
+struct LightCluster
+{
+	unsigned int offset;
+	unsigned int count;
+};
+
+/**
+ * @brief      CPU light binning for clustered forward shading
+ * @details    The view frustum of a perspective camera is split in a grid of froxels: tilesX x tilesY screen tiles and
+ *             slices exponentially spaced between the near and far planes, so that every slice has about the same
+ *             depth to width ratio. The view space bounding box of each froxel is computed by setup() when the
+ *             projection changes. bin() then transforms the lights to view space and lists the lights whose sphere
+ *             overlaps each froxel box. Slices are binned in parallel: each thread fills the lists of its slices,
+ *             which are then concatenated in slice order, so the result does not depend on the thread count.
+ *             A fragment finds its cluster from gl_FragCoord and its view depth:
+ *             slice = floor(log(depth) * depthScale + depthBias).
+ */
+class LightClusters
+{
+public:
+	LightClusters(int tilesX = 16, int tilesY = 9, int slices = 24);
+	~LightClusters();
+
+	/**
+	 * @brief Compute the froxel bounds of a perspective projection
+	 * @param projection projection matrix of the camera
+	 * @param zNear distance of the near plane
+	 * @param zFar distance of the far plane
+	 */
+	void setup(const glm::mat4& projection, float zNear, float zFar);
+
+	/**
+	 * @brief Assign the lights to the froxels
+	 * @param lights world space lights
+	 * @param count number of lights
+	 * @param view view matrix of the camera
+	 * @param threads number of threads used for the binning (0 for hardware concurrency)
+	 */
+	void bin(const PointLight* lights, int count, const glm::mat4& view, int threads = 0);
+
+	int getTilesX() const { return m_TilesX; }
+	int getTilesY() const { return m_TilesY; }
+	int getSlices() const { return m_Slices; }
+	int getClusterCount() const { return m_TilesX * m_TilesY * m_Slices; }
+	float getDepthScale() const { return m_DepthScale; }
+	float getDepthBias() const { return m_DepthBias; }
+
+	/**
+	 * @brief Index of the cluster of a tile and a slice, the tiles of a slice being stored row by row
+	 */
+	int clusterIndex(int x, int y, int slice) const { return (slice * m_TilesY + y) * m_TilesX + x; }
+	/**
+	 * @brief Slice holding a view depth (positive distance along the view direction), -1 outside of [near, far]
+	 */
+	int sliceOf(float depth) const;
+
+	// Bounds of a cluster in view space
+	glm::vec3 getClusterMin(int cluster) const { return m_ClusterMin[cluster]; }
+	glm::vec3 getClusterMax(int cluster) const { return m_ClusterMax[cluster]; }
+
+	// Result of the last bin(), in the layout of the shader storage buffers
+	const std::vector<PointLight>& getViewLights() const { return m_ViewLights; }
+	const std::vector<LightCluster>& getClusters() const { return m_Clusters; }
+	const std::vector<unsigned int>& getLightIndices() const { return m_Indices; }
+
+	// Statistics of the last bin()
+	int getMaxLightsPerCluster() const { return m_MaxLightsPerCluster; }
+	// Milliseconds
+	double getBinTime() const { return m_BinTime; }
+
+private:
+	// Lights of a slice, found by the bin of the slice
+	struct SliceBin
+	{
+		std::vector<unsigned int> counts;		// Per tile of the slice
+		std::vector<unsigned int> offsets;		// Per tile, in indices
+		std::vector<unsigned int> indices;		// Light indices grouped by tile
+		std::vector<glm::uvec2> pairs;			// Tile and light of each overlap
+	};
+
+	void binSlice(int slice, SliceBin& bin);
+
+	int m_TilesX, m_TilesY, m_Slices;
+	float m_Near, m_Far;
+	float m_DepthScale, m_DepthBias;
+
+	std::vector<glm::vec3> m_ClusterMin;
+	std::vector<glm::vec3> m_ClusterMax;
+	// Extent of the columns (x) and rows (y) of each slice, to find the tiles overlapped by a light without testing all
+	std::vector<glm::vec2> m_ColumnBounds;
+	std::vector<glm::vec2> m_RowBounds;
+
+	std::vector<PointLight> m_ViewLights;
+	std::vector<glm::ivec2> m_LightSlices;		// First and last slice of each light, x > y if it is outside
+	std::vector<SliceBin> m_SliceBins;
+
+	std::vector<LightCluster> m_Clusters;
+	std::vector<unsigned int> m_Indices;
+
+	int m_MaxLightsPerCluster;
+	double m_BinTime;
+};
+
+#endif
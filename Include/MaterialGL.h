@@ -44,7 +44,7 @@ class MaterialGL
 		virtual void animate(Node* o, const float elapsedTime);
 
 
-		string getName() { return m_Name; };
+		const string& getName() { return m_Name; };
 
 		virtual void displayInterface(Node* o) {};
 
@@ -19,7 +19,7 @@ class ModelGL
 		void loadToGPU();
 
 
-		std::string getName() { return m_Name; }
+		const std::string& getName() const { return m_Name; }
 		bool show_interface;
 		void displayInterface();
 		GeometricModel* getGeometricModel() {
@@ -10,27 +10,37 @@
 #include "ModelGL.h"
 #include <vector>
 #include "Logger/ImGuiLogger.h"
+#include "StringId.h"
+#include "ObjectPool.hpp"
 
 class MaterialGL;
 
 
-class Node
+// Allocated from a pool, scenes holding up to millions of nodes created and deleted one by one
+class Node : public PooledObject<Node>
 {
 	public:
 		Node(std::string name);
-		~Node();
+		// Node named by an interned string, without interning its name again
+		explicit Node(StringId name);
+		virtual ~Node();
 
 		Node(const Node& toCopy);
 
-		const std::string getName();
+		const std::string& getName() const;
+		// Interned name, for comparisons and lookups without string operations
+		StringId getId() const;
 		void setName(std::string name);
 
 
 		// Render the Node and its sons using Node's material (or mat for overriding Node material)
 		void render(MaterialGL *mat = NULL);
 
+		// Structural changes are recorded by the scene when they concern collected nodes (see IncrementalNodeCollector)
+		// Adopting a node that has a father moves it from its former father
 		void adopt(Node* son);
 		bool disown(Node* son);
+		Node* getFather();
 
 		Frame* frame();
 
@@ -46,10 +56,27 @@ class Node
 
 		std::vector<Node*> m_Sons;
 		
-		Node* getSon(std::string name);
+		Node* getSon(StringId name);
 
 		bool isManipulated;
 
+		// World space bounding box of the node's model (empty box if the node has no model)
+		AABB getWorldBounds();
+		// Proxy of the node in the scene spatial index (-1 when not indexed)
+		int spatialProxy;
+		// Frame version of the node's bounds in the spatial index
+		unsigned int spatialVersion;
+		// Position of the node in the list of the incremental collector (-1 when not collected)
+		int collectorIndex;
+
+		/**
+		 * @brief Mark the node as an occluder for the CPU occlusion culling
+		 * @param proxy simplified mesh rasterized instead of the node's model (NULL to use the model itself)
+		 */
+		void setOccluder(bool occluder, GeometricModel* proxy = NULL);
+		// Mesh rasterized by the occlusion culling, NULL if the node is not an occluder
+		GeometricModel* getOccluder();
+
 		bool show_interface;
 		virtual void displayInterface();
 	protected:
@@ -57,7 +84,10 @@ class Node
 		MaterialGL* m_Material;
 		Frame *m_Frame;
 		std::string m_Name;
+		StringId m_Id;
 		Node* m_Father;
+		bool m_Occluder;
+		GeometricModel* m_OccluderProxy;
 		
 };
 
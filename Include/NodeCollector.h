@@ -39,4 +39,84 @@ class NodeCollector
 
 };
 
+// Structural change of the scene graph concerning a collected node
+struct SceneChange
+{
+	enum Type
+	{
+		Attached,	// The node got a father
+		Detached	// The node was disowned by its father
+	};
+
+	Type type;
+	Node* node;
+};
+
+/**
+ * @brief      Collector kept up to date from the structural changes of the scene graph, instead of a new traversal
+ * @details    collect() gathers the tree once, apply() then patches the node list with the changes recorded since:
+ *             an attached node brings its subtree when its father is collected, a detached node takes its subtree
+ *             away when it is no longer under a collected father. Each collected node knows its position in the list
+ *             (Node::collectorIndex): a removal moves the last node in the freed place, every other node keeping its
+ *             position. The cost of apply() only depends on the size of the moved subtrees.
+ */
+class IncrementalNodeCollector : public NodeCollector
+{
+	public:
+		virtual void collect(Node* rootNode)
+		{
+			for (size_t i = 0; i < nodes.size(); i++)
+				nodes[i]->collectorIndex = -1;
+			NodeCollector::collect(rootNode);
+			for (size_t i = 0; i < nodes.size(); i++)
+				nodes[i]->collectorIndex = (int)i;
+		}
+
+		/**
+		 * @brief Patch the node list with changes, in the order they were made
+		 * @param removed receives the nodes removed from the list (NULL if not needed)
+		 */
+		void apply(const std::vector<SceneChange>& changes, std::vector<Node*>* removed = NULL)
+		{
+			for (size_t i = 0; i < changes.size(); i++)
+			{
+				Node* n = changes[i].node;
+				Node* father = n->getFather();
+				bool underCollected = father != NULL && father->collectorIndex >= 0;
+				if (changes[i].type == SceneChange::Attached && n->collectorIndex < 0 && underCollected)
+					add(n);
+				else if (changes[i].type == SceneChange::Detached && n->collectorIndex >= 0 && !underCollected)
+					remove(n, removed);
+			}
+		}
+
+	private:
+		void add(Node* node)
+		{
+			if (node->collectorIndex < 0)
+			{
+				node->collectorIndex = (int)nodes.size();
+				nodes.push_back(node);
+			}
+			for (size_t i = 0; i < node->m_Sons.size(); i++)
+				add(node->m_Sons[i]);
+		}
+
+		void remove(Node* node, std::vector<Node*>* removed)
+		{
+			if (node->collectorIndex >= 0)
+			{
+				Node* last = nodes.back();
+				nodes[node->collectorIndex] = last;
+				last->collectorIndex = node->collectorIndex;
+				nodes.pop_back();
+				node->collectorIndex = -1;
+				if (removed != NULL)
+					removed->push_back(node);
+			}
+			for (size_t i = 0; i < node->m_Sons.size(); i++)
+				remove(node->m_Sons[i], removed);
+		}
+};
+
 #endif
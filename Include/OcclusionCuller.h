@@ -0,0 +1,82 @@
+#ifndef _OCCLUSION_CULLER_H
+#define _OCCLUSION_CULLER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "BoundingVolumes.h"
+
+/**
+ * @brief      Software occlusion culling on a low resolution depth buffer
+ * @details    Occluder triangles are rasterized (4 pixels at a time with SSE2) into a small depth buffer storing the
+ *             normalized depth z/w in [0,1]. finalize() then builds the maximum depth of each 8x8 tile, so that most
+ *             box tests are answered at the tile level. A box is occluded when its nearest depth is behind the depth
+ *             buffer on every pixel it covers. Triangles crossing the near plane are skipped and boxes crossing it are
+ *             reported visible, which keeps the test conservative.
+ */
+class OcclusionCuller
+{
+public:
+	static const int TileSize = 8;
+
+	OcclusionCuller(int width = 256, int height = 128);
+	~OcclusionCuller();
+
+	/**
+	 * @brief Change the depth buffer resolution (rounded up to a multiple of the tile size)
+	 */
+	void resize(int width, int height);
+
+	/**
+	 * @brief Clear the depth buffer and set the view-projection used by the next occluders and tests
+	 */
+	void beginFrame(const glm::mat4& viewProjection);
+
+	/**
+	 * @brief Rasterize an indexed triangle mesh
+	 * @param vertices vertex positions in model space
+	 * @param indices 3 vertex indices per triangle
+	 * @param triangleCount number of triangles
+	 * @param model model matrix of the mesh
+	 */
+	void renderOccluder(const glm::vec3* vertices, const int* indices, int triangleCount, const glm::mat4& model);
+
+	/**
+	 * @brief Build the tile depth hierarchy. Must be called after the last occluder and before the tests
+	 */
+	void finalize();
+
+	/**
+	 * @brief Test a world space box against the occluders
+	 * @return false if the box is hidden by the occluders
+	 */
+	bool isVisible(const AABB& box);
+
+	int getWidth() const { return m_Width; }
+	int getHeight() const { return m_Height; }
+	const float* getDepthBuffer() const { return &m_Depth[0]; }
+
+	// Statistics of the current frame
+	int getOccluderTriangles() const { return m_OccluderTriangles; }
+	int getTestedCount() const { return m_Tested; }
+	int getOccludedCount() const { return m_Occluded; }
+	/**
+	 * @brief Time spent rasterizing and building the hierarchy this frame, in milliseconds
+	 */
+	double getRasterTime() const { return m_RasterTime; }
+
+private:
+	void rasterizeTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2);
+
+	int m_Width, m_Height;
+	int m_TilesX, m_TilesY;
+	std::vector<float> m_Depth;		// Row major, m_Width * m_Height
+	std::vector<float> m_TileMax;	// Farthest depth of each tile
+	glm::mat4 m_ViewProjection;
+
+	int m_OccluderTriangles;
+	int m_Tested;
+	int m_Occluded;
+	double m_RasterTime;
+};
+
+#endif
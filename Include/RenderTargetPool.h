@@ -0,0 +1,106 @@
+#ifndef _RENDER_TARGET_POOL_H
+#define _RENDER_TARGET_POOL_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include "Singleton.h"
+#include "TransientPool.hpp"
+
+class FrameBufferObject;
+class Texture2D;
+
+// How the textures of a render target are sampled. Pooled apart, since bindless handles freeze the sampler state
+enum RenderTargetUsage
+{
+	RenderTargetSampled = 0,		// Filtered reads (color targets, SSAO depth)
+	RenderTargetShadowMap = 1		// Depth comparison (sampler2DShadow): GL_TEXTURE_COMPARE_MODE set on the depth texture
+};
+
+/**
+ * @brief      Attachments of a render target
+ */
+struct RenderTargetDesc
+{
+	RenderTargetDesc(int width = 1024, int height = 1024, GLenum colorFormat = GL_RGBA8, GLenum depthFormat = GL_DEPTH_COMPONENT24,
+		RenderTargetUsage usage = RenderTargetSampled);
+
+	int width, height;
+	std::vector<GLenum> colorFormats;	// GL_COLOR_ATTACHMENT0 + i, none for depth only targets
+	GLenum depthFormat;					// 0 for none, GL_DEPTH24_STENCIL8 for depth and stencil
+	bool sampledDepth;					// Depth in a texture (shadow maps, SSAO), in a renderbuffer otherwise
+	int samples;						// MSAA when above 1: multisampled renderbuffers, resolved into the textures
+	RenderTargetUsage usage;			// Of the textures
+};
+
+/**
+ * @brief      Render targets shared by the framebuffers and the passes of the frames
+ * @details    Attachments are pooled by (size, format, samples, usage): single level textures for the attachments that
+ *             are sampled, renderbuffers for the others (multisampled ones, unsampled depth). A framebuffer takes its
+ *             attachments from the pool and gives them back when destroyed or resized, so that returning to a former
+ *             size reuses them. Passes acquire transient framebuffers by descriptor and release them once their
+ *             output has been read: a later pass of the same frame then aliases the released attachments.
+ *             Attachments and released framebuffers unused for keepFrames frames are destroyed by update(). GL thread
+ *             only.
+ */
+class RenderTargetPool : public Singleton<RenderTargetPool>
+{
+	friend class Singleton<RenderTargetPool>;
+public:
+	/**
+	 * @brief Attachment texture: a free one of the same size, format and usage, or a new one (single level, its handle
+	 *        made resident on its first getHandle)
+	 */
+	Texture2D* acquireTexture(int width, int height, GLenum format, RenderTargetUsage usage = RenderTargetSampled);
+	void releaseTexture(Texture2D* texture);
+	/**
+	 * @brief Renderbuffer of samples samples (0 or 1 for none)
+	 */
+	GLuint acquireRenderbuffer(int width, int height, GLenum format, int samples);
+	void releaseRenderbuffer(GLuint renderbuffer);
+
+	/**
+	 * @brief Framebuffer with the attachments of desc, for the passes of this frame
+	 */
+	FrameBufferObject* acquire(const RenderTargetDesc& desc);
+	// Output of target read by its last pass: its attachments may be aliased by the next acquires
+	void release(FrameBufferObject* target);
+
+	/**
+	 * @brief End of the frame (once per frame): statistics, destruction of the attachments and framebuffers unused for
+	 *        keepFrames frames
+	 */
+	void update();
+
+	static uint64_t makeKey(int width, int height, GLenum format, int samples = 0, RenderTargetUsage usage = RenderTargetSampled);
+	// Bytes of a renderbuffer
+	static size_t getRenderbufferSize(int width, int height, GLenum format, int samples);
+
+	size_t getPooledBytes() const { return m_Textures.getPooledBytes() + m_Renderbuffers.getPooledBytes(); }
+	size_t getInUseBytes() const { return m_Textures.getInUseBytes() + m_Renderbuffers.getInUseBytes(); }
+	// Of the last frame (sums of the peaks of the textures and of the renderbuffers)
+	size_t getPeakBytes() const { return m_Textures.getPeakBytes() + m_Renderbuffers.getPeakBytes(); }
+	size_t getRequestedBytes() const { return m_Textures.getRequestedBytes() + m_Renderbuffers.getRequestedBytes(); }
+	int getTextureCount() const { return m_Textures.getCount(); }
+	int getRenderbufferCount() const { return m_Renderbuffers.getCount(); }
+	int getFreeCount() const { return m_Textures.getFreeCount() + m_Renderbuffers.getFreeCount(); }
+	long long getCreatedCount() const { return m_Textures.getCreatedCount() + m_Renderbuffers.getCreatedCount(); }
+	long long getReusedCount() const { return m_Textures.getReusedCount() + m_Renderbuffers.getReusedCount(); }
+	long long getDestroyedCount() const { return m_Textures.getDestroyedCount() + m_Renderbuffers.getDestroyedCount(); }
+	int getFreeFramebufferCount() const { return (int)m_FreeFramebuffers.size(); }
+	void setKeepFrames(int frames);
+	int getKeepFrames() const { return m_Textures.getKeepFrames(); }
+
+private:
+	RenderTargetPool();
+
+	TransientPool<Texture2D*> m_Textures;
+	TransientPool<GLuint> m_Renderbuffers;
+	// Released transient framebuffers, without attachments, with the frame of their release (oldest first)
+	std::vector<std::pair<FrameBufferObject*, long long> > m_FreeFramebuffers;
+	std::vector<Texture2D*> m_ExpiredTextures;
+	std::vector<GLuint> m_ExpiredRenderbuffers;
+};
+
+#endif
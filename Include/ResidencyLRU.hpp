@@ -0,0 +1,154 @@
+#ifndef _RESIDENCY_LRU
+#define _RESIDENCY_LRU
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief      Resident items (bindless handles) kept under a byte budget, least recently used first out
+ * @details    Items are tracked with their size and the last frame that used them. Resident items are kept in a list
+ *             ordered by last use, so that use is O(1) and eviction pops the front of the list. Items used in the
+ *             last framesInFlight frames may still be read by the GPU and are never evicted: the budget is then
+ *             exceeded until they age. The caller makes the handles (non-)resident as told by use and evict.
+ */
+template <typename T> class ResidencyLRU
+{
+public:
+	explicit ResidencyLRU(size_t budget = 0, int framesInFlight = 3);
+
+	/**
+	 * @brief Track an item that was just made resident, or refresh its size
+	 */
+	void add(T item, size_t bytes, long long frame);
+	void remove(T item);
+
+	/**
+	 * @brief Item used by frame
+	 * @return true if it was evicted and must be made resident again
+	 */
+	bool use(T item, long long frame);
+
+	/**
+	 * @brief Evict the least recently used items until the resident bytes fit the budget
+	 * @param evicted items to make non-resident (appended)
+	 */
+	void evict(long long frame, std::vector<T>& evicted);
+
+	void setBudget(size_t budget) { m_Budget = budget; }
+	size_t getBudget() const { return m_Budget; }
+	size_t getResidentBytes() const { return m_ResidentBytes; }
+	size_t getTotalBytes() const { return m_TotalBytes; }
+	int getResidentCount() const { return (int)m_Resident.size(); }
+	int getCount() const { return (int)m_Entries.size(); }
+	bool isResident(T item) const;
+
+private:
+	struct Entry
+	{
+		size_t bytes;
+		long long lastUsed;
+		bool resident;
+		typename std::list<T>::iterator position;	// In m_Resident when resident
+	};
+
+	size_t m_Budget;
+	int m_FramesInFlight;
+	size_t m_ResidentBytes, m_TotalBytes;
+	std::list<T> m_Resident;		// Least recently used first
+	std::unordered_map<T, Entry> m_Entries;
+};
+
+template <typename T>
+ResidencyLRU<T>::ResidencyLRU(size_t budget, int framesInFlight) :
+	m_Budget(budget), m_FramesInFlight(framesInFlight), m_ResidentBytes(0), m_TotalBytes(0)
+{
+}
+
+template <typename T>
+void ResidencyLRU<T>::add(T item, size_t bytes, long long frame)
+{
+	typename std::unordered_map<T, Entry>::iterator it = m_Entries.find(item);
+	if (it == m_Entries.end())
+	{
+		Entry e;
+		e.bytes = 0;
+		e.resident = false;
+		it = m_Entries.insert(std::make_pair(item, e)).first;
+	}
+	Entry& e = it->second;
+	m_TotalBytes += bytes - e.bytes;
+	if (e.resident)
+	{
+		m_ResidentBytes += bytes - e.bytes;
+		m_Resident.splice(m_Resident.end(), m_Resident, e.position);
+	}
+	else
+	{
+		m_ResidentBytes += bytes;
+		e.position = m_Resident.insert(m_Resident.end(), item);
+		e.resident = true;
+	}
+	e.bytes = bytes;
+	e.lastUsed = frame;
+}
+
+template <typename T>
+void ResidencyLRU<T>::remove(T item)
+{
+	typename std::unordered_map<T, Entry>::iterator it = m_Entries.find(item);
+	if (it == m_Entries.end())
+		return;
+	m_TotalBytes -= it->second.bytes;
+	if (it->second.resident)
+	{
+		m_ResidentBytes -= it->second.bytes;
+		m_Resident.erase(it->second.position);
+	}
+	m_Entries.erase(it);
+}
+
+template <typename T>
+bool ResidencyLRU<T>::use(T item, long long frame)
+{
+	typename std::unordered_map<T, Entry>::iterator it = m_Entries.find(item);
+	if (it == m_Entries.end())
+		return false;
+	Entry& e = it->second;
+	e.lastUsed = frame;
+	if (e.resident)
+	{
+		m_Resident.splice(m_Resident.end(), m_Resident, e.position);
+		return false;
+	}
+	e.position = m_Resident.insert(m_Resident.end(), item);
+	e.resident = true;
+	m_ResidentBytes += e.bytes;
+	return true;
+}
+
+template <typename T>
+void ResidencyLRU<T>::evict(long long frame, std::vector<T>& evicted)
+{
+	while (m_ResidentBytes > m_Budget && !m_Resident.empty())
+	{
+		Entry& e = m_Entries[m_Resident.front()];
+		// The following items were used later
+		if (e.lastUsed > frame - m_FramesInFlight)
+			return;
+		evicted.push_back(m_Resident.front());
+		m_Resident.pop_front();
+		e.resident = false;
+		m_ResidentBytes -= e.bytes;
+	}
+}
+
+template <typename T>
+bool ResidencyLRU<T>::isResident(T item) const
+{
+	typename std::unordered_map<T, Entry>::const_iterator it = m_Entries.find(item);
+	return it != m_Entries.end() && it->second.resident;
+}
+
+#endif
@@ -5,6 +5,9 @@
 #include "ModelGL.h"
 #include "Camera.h"
 #include "Resource_mgr.hpp"
+#include "DynamicAABBTree.hpp"
+#include "LightClusters.h"
+#include "NodeCollector.h"
 #include "Singleton.h"
 #include "imgui/imgui_impl_glfw_gl3.h"
 #include "Logger/ImGuiLogger.h"
@@ -16,6 +19,17 @@ const string ObjPath = "./../Objects/";
 const string MaterialPath = "./../Materials/";
 const string EffectPath = "./../Effects/";
 
+/**
+ * @brief Point light placed at the origin of the frame of a node
+ */
+struct SceneLight
+{
+    Node* node;
+    glm::vec3 color;
+    float intensity;
+    float radius;
+};
+
 class Scene : public Singleton<Scene>{
     friend class Singleton<Scene>;
 public:
@@ -26,6 +40,9 @@ public:
 
     Node* getRoot();
     Node* getNode(std::string name);
+    Node* getNode(StringId name);
+    // Existing node, NULL if there is none (unlike getNode, does not create the node nor add a reference)
+    Node* findNode(StringId name);
 
 
     template <class R>  R* getModel(string a)
@@ -41,15 +58,67 @@ public:
     {
         return m_Effects.get<R>(a);
     }
+    /**
+     * @brief Remove a reference to a node. With the last one, the node leaves the graph before being deleted: it is
+     *        disowned by its father and disowns its sons, which become roots of detached subtrees.
+     */
     void releaseNode(string a);
     void releaseNode(Node *n);
 
+    /**
+     * @brief Record a structural change of a collected node (called by Node::adopt and Node::disown)
+     */
+    void recordChange(SceneChange::Type type, Node* n);
+    /**
+     * @brief Collector patched by applyChanges, NULL to stop recording the changes
+     */
+    void setCollector(IncrementalNodeCollector* c);
+    /**
+     * @brief Apply the recorded changes to the collector, the nodes leaving it being removed from the spatial index
+     */
+    void applyChanges();
+
 
     void releaseModel(string a);
     void releaseModel(ModelGL *m);
 
+    /**
+     * @brief Insert or refit node n in the spatial index from its world bounds, and clear its frame update flag
+     */
+    void updateSpatialNode(Node* n);
+    void removeSpatialNode(Node* n);
+
+    // Spatial queries on the indexed nodes (nodes holding a model)
+    void queryFrustum(const Frustum& f, std::vector<Node*>& result);
+    void querySphere(const BoundingSphere& s, std::vector<Node*>& result);
+    void queryBox(const AABB& b, std::vector<Node*>& result);
+    /**
+     * @brief Nodes whose bounds are hit by ray r, sorted by increasing entry distance
+     */
+    void queryRay(const Ray& r, std::vector<Node*>& result, float maxDistance = FLT_MAX);
+    DynamicAABBTree<Node*>& spatialIndex() { return m_SpatialIndex; }
+
+    /**
+     * @brief Closest node whose mesh is hit by ray r (tested against the triangles, in model space)
+     * @param distance distance along the ray to the hit point, written when a node is found
+     * @return the hit node, NULL if nothing is hit
+     */
+    Node* pickNode(const Ray& r, float* distance = NULL);
+
+    /**
+     * @brief Register node n as a point light (updating its parameters if it is already one)
+     */
+    void addLight(Node* n, glm::vec3 color, float intensity, float radius);
+    void removeLight(Node* n);
+    const std::vector<SceneLight>& getLights() const { return m_Lights; }
+    /**
+     * @brief World space lights of the registry, in registration order
+     */
+    void collectLights(std::vector<PointLight>& lights);
+
     void nextManipulatedNode();
     void manipulateNode(std::string name);
+    void manipulateNode(StringId name);
 
     void displayInterface();
 
@@ -79,6 +148,13 @@ private:
     Camera* current_Camera;
     Node* current_ManipulatedNode;
 
+    DynamicAABBTree<Node*> m_SpatialIndex;
+    std::vector<SceneLight> m_Lights;
+
+    IncrementalNodeCollector* m_Collector;
+    std::vector<SceneChange> m_Changes;		// Changes since the last applyChanges
+    std::vector<Node*> m_RemovedNodes;
+
 };
 
 
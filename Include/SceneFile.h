@@ -0,0 +1,185 @@
+#ifndef _SCENE_FILE_H
+#define _SCENE_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Resource_mgr.hpp"
+#include "StringId.h"
+
+class MaterialGL;
+class ModelGL;
+class Node;
+
+/*
+ * Binary scene: a header followed by the model, material, node and light records, then the characters of all the
+ * names. Records have a fixed size and only hold 32 bit values, so the file is used in place once mapped.
+ */
+
+// Name in the string section of the file, with its hashString hash so that it is interned without being hashed
+struct SceneFileString
+{
+	uint32_t offset;
+	uint32_t length;
+	uint32_t hash;
+};
+
+struct SceneFileHeader
+{
+	char magic[4];				// "OGLS"
+	uint32_t version;
+	uint32_t modelCount;
+	uint32_t materialCount;
+	uint32_t nodeCount;
+	uint32_t lightCount;
+	uint32_t stringBytes;
+	uint32_t flags;				// SceneFileHasCamera
+	float cameraEye[3];
+	float cameraTarget[3];
+	float cameraUp[3];
+	uint32_t reserved[3];
+};
+
+enum SceneFileFlags
+{
+	SceneFileHasCamera = 1
+};
+
+enum SceneFileModelType
+{
+	SceneModelFile = 0,			// OBJ file, the name being its path relative to the Objects directory
+	SceneModelSphere = 1,		// Procedural meshes of SceneGenerator
+	SceneModelGrid = 2,
+	SceneModelTerrain = 3
+};
+
+struct SceneFileModel
+{
+	SceneFileString name;
+	uint32_t type;				// SceneFileModelType
+	uint32_t triangles;			// Procedural meshes
+	uint32_t seed;				// Terrains
+};
+
+enum SceneFileMaterialType
+{
+	SceneMaterialBase = 0,
+	SceneMaterialPhong = 1,
+	SceneMaterialPhongClustered = 2,
+	SceneMaterialRotation = 3
+};
+
+/**
+ * @brief Material and its parameters. Phong: ambient color, diffuse color, light color, ka, kd, ks and cone size.
+ *        Rotation: axis.
+ */
+struct SceneFileMaterial
+{
+	SceneFileString name;
+	uint32_t type;				// SceneFileMaterialType
+	float parameters[13];
+};
+
+enum SceneFileNodeFlags
+{
+	SceneNodeOccluder = 1
+};
+
+struct SceneFileNode
+{
+	SceneFileString name;
+	int32_t parent;				// Index of an earlier node, -1 for the scene node
+	int32_t model;				// -1 for none
+	int32_t material;			// -1 for none
+	uint32_t flags;				// SceneFileNodeFlags
+	float transform[12];		// Columns of the affine frame matrix relative to the father (last row 0 0 0 1)
+};
+
+struct SceneFileLight
+{
+	uint32_t node;
+	float color[3];
+	float intensity;
+	float radius;
+};
+
+/**
+ * @brief      Binary scene description, memory mapped and loaded in bulk
+ * @details    open() maps the file and checks every index, name range and name hash once, so that loading never
+ *             parses nor validates a node. Files are written by convert() from the text format, one statement per line, '#'
+ *             starting a comment:
+ *               camera eye x y z target x y z up x y z
+ *               model <name> file|sphere|grid|terrain [triangles N] [seed N]
+ *               material <name> base|phong|phong-clustered|rotation [ambient r g b] [diffuse r g b] [light r g b]
+ *                        [ka k] [kd k] [ks k] [cone n] [axis x y z]
+ *               node <name> <father|-> [model m] [material m] [translate x y z] [rotate x y z degrees]
+ *                    [scale x y z] [occluder]
+ *               light <node> [color r g b] [intensity i] [radius r]
+ *             Fathers, models and materials are referenced by name and must be declared before their use. Node
+ *             transformations are applied in their order of appearance, as with Frame. Node names are unique and
+ *             differ from the nodes of the Scene ("Root", "Scene").
+ */
+class SceneFile
+{
+public:
+	static const uint32_t Version = 1;
+
+	SceneFile();
+	~SceneFile();
+
+	/**
+	 * @brief Map a binary scene and validate its content
+	 * @return false if the file cannot be mapped or is not a valid scene of this version
+	 */
+	bool open(const std::string& filename);
+	void close();
+
+	/**
+	 * @brief Write the binary scene of a text scene
+	 * @return false if the text cannot be read or holds an error (reported with its line), or if the binary file
+	 *         cannot be written
+	 */
+	static bool convert(const std::string& textFile, const std::string& binaryFile);
+
+	/**
+	 * @brief True if the file starts with the magic of a binary scene
+	 */
+	static bool isBinary(const std::string& filename);
+
+	const SceneFileHeader& getHeader() const { return *m_Header; }
+	const SceneFileModel* getModels() const { return m_Models; }
+	const SceneFileMaterial* getMaterials() const { return m_Materials; }
+	const SceneFileNode* getNodes() const { return m_Nodes; }
+	const SceneFileLight* getLights() const { return m_Lights; }
+	int getModelCount() const { return m_Header != NULL ? (int)m_Header->modelCount : 0; }
+	int getMaterialCount() const { return m_Header != NULL ? (int)m_Header->materialCount : 0; }
+	int getNodeCount() const { return m_Header != NULL ? (int)m_Header->nodeCount : 0; }
+	int getLightCount() const { return m_Header != NULL ? (int)m_Header->lightCount : 0; }
+	size_t getSize() const { return m_File.size(); }
+
+	std::string getString(const SceneFileString& s) const { return std::string(m_Strings + s.offset, s.length); }
+	StringId getId(const SceneFileString& s) const { return StringId(m_Strings + s.offset, s.length, s.hash); }
+
+	/**
+	 * @brief Create the nodes of the file in one pass, in file order, under root
+	 * @param models models of the file by index (missing or NULL entries leave the nodes without model)
+	 * @param materials materials of the file by index
+	 * @param created receives the nodes, indexed as in the file
+	 */
+	void createNodes(Resource_mgr<Node>& nodes, Node* root, const std::vector<ModelGL*>& models,
+		const std::vector<MaterialGL*>& materials, std::vector<Node*>& created) const;
+
+private:
+	bool validate(const std::string& filename);
+
+	MappedFile m_File;
+	const SceneFileHeader* m_Header;
+	const SceneFileModel* m_Models;
+	const SceneFileMaterial* m_Materials;
+	const SceneFileNode* m_Nodes;
+	const SceneFileLight* m_Lights;
+	const char* m_Strings;
+};
+
+#endif
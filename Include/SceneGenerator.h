@@ -0,0 +1,94 @@
+#ifndef _SCENE_GENERATOR_H
+#define _SCENE_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include "Resource_mgr.hpp"
+
+class GeometricModel;
+class Node;
+class Scene;
+
+enum class ProceduralMesh
+{
+	Sphere,		// UV sphere of radius 1
+	Grid,		// Flat square of side 2 in the XZ plane
+	Terrain		// Grid displaced by fractal value noise
+};
+
+// Parameters of a generated scene (see SceneGenerator)
+struct SceneGeneratorSettings
+{
+	int nodeCount = 10000;					// Generated nodes, each one holding a model (up to 1M)
+	int breadth = 10;						// Maximum number of sons per node
+	int depth = 4;							// Maximum depth of the hierarchy below the scene node
+	ProceduralMesh mesh = ProceduralMesh::Sphere;
+	int trianglesPerMesh = 200;				// Approximate triangle count of each mesh
+	float instanceSharing = 0.99f;			// Fraction of the nodes reusing an already created mesh
+	float materialSharing = 0.999f;			// Fraction of the nodes reusing an already created material
+	float extent = 0.0f;					// Side of the cube holding the nodes, 0 to scale it with the node count
+	int lightCount = 0;						// Point lights with clustered Phong materials, 0 for a single "Light" node
+	unsigned int seed = 1;					// Same seed, same scene
+	std::string objDirectory;				// When set, meshes are written there as OBJ and loaded back through the model loader
+};
+
+/**
+ * @brief      Procedural scenes for scale testing
+ * @details    Nodes are laid out breadth first (every node of a level gets its sons before the next level starts) and
+ *             placed at random positions inside a cube, their frame translations being relative to their father.
+ *             Meshes and materials are shared round-robin between the nodes according to the sharing ratios.
+ *             Everything only depends on the settings, so a given scene can be reproduced as a worst case.
+ */
+class SceneGenerator
+{
+public:
+	explicit SceneGenerator(const SceneGeneratorSettings& settings);
+
+	/**
+	 * @brief Fill model with a procedural mesh (positions, faces, texture coordinates, normals and tangents)
+	 * @param triangles approximate triangle count, rounded to fill the mesh rows
+	 */
+	static void createSphere(GeometricModel* model, int triangles);
+	static void createGrid(GeometricModel* model, int triangles);
+	static void createTerrain(GeometricModel* model, int triangles, unsigned int seed);
+
+	/**
+	 * @brief Write positions, texture coordinates and faces of model in the format read by OBJLoader
+	 * @return false if the file could not be written
+	 */
+	static bool writeOBJ(GeometricModel* model, const std::string& filename);
+
+	/**
+	 * @brief Mesh name from the command line ("sphere", "grid" or "terrain")
+	 * @return false if the name is unknown
+	 */
+	static bool parseMesh(const std::string& name, ProceduralMesh& mesh);
+
+	/**
+	 * @brief Fill model with the index-th unique mesh of the settings (terrains use a different seed per mesh)
+	 */
+	void createMesh(GeometricModel* model, int index) const;
+
+	/**
+	 * @brief Create the generated nodes in the nodes manager and attach them under parent, without models
+	 * @param created receives the created nodes in breadth first order
+	 */
+	void createHierarchy(Resource_mgr<Node>& nodes, Node* parent, std::vector<Node*>& created) const;
+
+	/**
+	 * @brief Generate the whole scene under the scene node: hierarchy, models, Phong materials and lights
+	 */
+	void generate(Scene* scene);
+
+	// Number of nodes actually generated, limited by breadth and depth
+	int getNodeCount() const;
+	int getUniqueMeshCount() const;
+	int getUniqueMaterialCount() const;
+	// Side of the cube holding the nodes
+	float getExtent() const;
+
+private:
+	SceneGeneratorSettings m_Settings;
+};
+
+#endif
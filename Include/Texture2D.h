@@ -5,6 +5,7 @@
 
 #include <string>
 #include "Scene.h"
+#include "TextureImporter.h"
 
 
 class Texture2D
@@ -13,6 +14,20 @@ public:
 
 	Texture2D(const std::string& filename);
 
+	/**
+	 * @brief Load an image file, decoded and uploaded by the TextureStreamer when async is true
+	 * @details The texture gives the placeholder handle until its upload completes (see isReady).
+	 */
+	Texture2D(const std::string& filename, bool async);
+
+	/**
+	 * @brief Load an image file as a block compressed (or RGBA8) texture with its mip chain (see TextureImporter)
+	 * @details Only the coarsest levels are uploaded at once, the finer ones being streamed by the TextureStreamer
+	 *          within its mip budget: the handle changes each time the base level moves down.
+	 * @param usage content of the image, for TextureAutoCompressed and the mip filter
+	 */
+	Texture2D(const std::string& filename, TextureCompression compression, TextureUsage usage = TextureUsageColor);
+
 	//Create an empty texture
 	Texture2D(int _width = 1024, int _height = 1024);
 
@@ -24,24 +39,62 @@ public:
 
 
 	void createEmptyTexture();
+	// Storage of levels levels (0 for the whole mip chain)
+	void createStorage(int levels = 0);
 	void loadToGPU();
+	/**
+	 * @brief Storage of the mip chain of compressed, and upload of its levels from firstLevel
+	 */
+	void loadCompressedToGPU(const CompressedImage& compressed, int firstLevel = 0);
+	void uploadLevel(const CompressedImage& compressed, int level);
+	/**
+	 * @brief Sample the levels from level on: bindless handles freezing the state of their texture, the levels are
+	 *        sampled through a view with its own handle (level 0 through the texture itself)
+	 */
+	void setBaseLevel(int level);
+	int getBaseLevel() const { return baseLevel; }
+	// New handle of the sampled levels, resident and tracked by the TextureResidency
 	void makeResident();
+	// Make the current handle (non-)resident, for the TextureResidency
+	void setResident(bool resident);
+	bool isResident() const { return resident; }
+
+	// Bytes of the storage
+	size_t getMemorySize() const { return memorySize; }
+	// Bytes of a texture of format with levels levels
+	static size_t getStorageSize(GLenum format, int width, int height, int levels);
+
+	// Storage of the streamed image (size of the decoded file), its pixels being uploaded by the TextureStreamer
+	void beginStreaming(int _width, int _height);
+	// Upload completed: the handle becomes resident
+	void finishStreaming();
+	bool isReady() const { return ready; }
 
 
 	GLuint getId() {
 		return id;
 	};
-	GLuint64 getHandle()
-	{
-		return handle;
-	};
+	/**
+	 * @brief Handle for a draw of the current frame, made resident again if the TextureResidency evicted it
+	 *        (placeholder handle while the texture streams, created on the first call for render targets)
+	 */
+	GLuint64 getHandle();
 
 protected:
+	void setSamplerState(GLuint texture);
+
 	GLuint id;
+	GLuint view;		// Levels from baseLevel, 0 when all the levels are sampled
 	GLuint64 handle;
 	string name;
 	int width, height;
 	GLint format;
+	int levels, baseLevel;
+	GLint swizzle[4];
+	bool swizzled;
+	bool resident;
+	size_t memorySize;
+	bool ready;
 	
 
 	unsigned char* image;
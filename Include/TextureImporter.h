@@ -0,0 +1,145 @@
+#ifndef _TEXTURE_IMPORTER_H
+#define _TEXTURE_IMPORTER_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "Singleton.h"
+
+enum TextureCompression
+{
+	TextureUncompressed = 0,
+	TextureBC1 = 1,			// DXT1, RGB at 4 bits per pixel
+	TextureBC3 = 2,			// DXT5, RGBA at 8 bits per pixel
+	TextureBC4 = 3,			// One channel at 4 bits per pixel, sampled as red
+	TextureBC5 = 4,			// Two channels at 8 bits per pixel, sampled as red and green
+	TextureAutoCompressed = 5	// Chosen by chooseCompression
+};
+
+/*
+ * What a texture holds, for the choice of its format. Normal maps are stored in BC5 with the X and Y of the normal:
+ * shaders rebuild Z = sqrt(max(0, 1 - x * x - y * y)) after mapping x and y to [-1, 1] (unpackNormal of
+ * Materials/common/NormalMap.glsl).
+ */
+enum TextureUsage
+{
+	TextureUsageColor = 0,
+	TextureUsageNormalMap = 1,
+	TextureUsageMask = 2		// Single channel data (roughness, occlusion, masks), from the red channel
+};
+
+/**
+ * @brief      Block compressed (or RGBA8) image and its whole mip chain, down to 1 x 1
+ */
+struct CompressedImage
+{
+	int width, height;
+	TextureCompression compression;		// TextureUncompressed (RGBA8 levels) to TextureBC5
+	int channels;						// Of the source image: grey (1) and grey alpha (2) images are swizzled
+	double psnr;						// Of the first level against the source, over the stored channels
+	std::vector<size_t> levelOffsets;	// In data
+	std::vector<size_t> levelSizes;
+	std::vector<unsigned char> data;
+
+	int getLevelCount() const { return (int)levelSizes.size(); }
+	bool isCompressed() const { return compression != TextureUncompressed; }
+	GLenum getFormat() const;
+	/**
+	 * @brief Swizzle of a sampled texel (GL_TEXTURE_SWIZZLE_RGBA): BC4 grey images give (r, r, r, 1), BC5 grey alpha
+	 *        images (r, r, r, g)
+	 * @return false if the texture is sampled as stored
+	 */
+	bool getSwizzle(GLint swizzle[4]) const;
+};
+
+/**
+ * @brief      Memory of an imported texture
+ */
+struct TextureMemoryRecord
+{
+	std::string filename;
+	int width, height;
+	TextureCompression compression;
+	size_t uncompressedBytes;	// RGBA8 with its mip chain, as Texture2D allocates it
+	size_t compressedBytes;
+	double psnr;				// dB
+	bool fromCache;				// Read from the .dds cache rather than compressed
+	double importTime;			// Milliseconds
+};
+
+/**
+ * @brief      Import of image files as mip chains (BC1 to BC5 or RGBA8), through a cache of .dds files
+ * @details    The first import of a file decodes it (stb_image), builds its mip chain with a gamma correct box filter
+ *             (generateMip) and compresses every level (DXTCompressor, image_DXT). The result is written next to the source
+ *             as <source>.<compression>.<usage>.dds, one cache per import mode, the DDS header keeping the hash of the
+ *             source bytes and of the mode. Later imports hash the source again and read
+ *             the cache directly when the hash matches, so an edited image is compressed again. Every import is
+ *             recorded for the memory report.
+ */
+class TextureImporter : public Singleton<TextureImporter>
+{
+	friend class Singleton<TextureImporter>;
+public:
+	/**
+	 * @brief Mip chain of an image file, from the cache when it is up to date
+	 * @return false if the file cannot be read or decoded
+	 */
+	bool import(const std::string& filename, TextureCompression compression, CompressedImage& image,
+		TextureUsage usage = TextureUsageColor);
+
+	/**
+	 * @brief Compress RGBA8 pixels and their mip chain
+	 * @param channels channels of the source image (stbi_load), the pixels being expanded to RGBA
+	 * @param compression TextureAutoCompressed is resolved by chooseCompression, TextureUncompressed keeps RGBA8 levels
+	 */
+	static void compress(const unsigned char* rgba, int width, int height, int channels, TextureCompression compression,
+		TextureUsage usage, CompressedImage& image);
+
+	/**
+	 * @brief Next level of RGBA8 pixels (max(1, width / 2) x max(1, height / 2)), averaging 2 x 2 pixels
+	 * @details Colors are averaged in linear space (sRGB decoded, then encoded again), alpha and the other usages as
+	 *          stored. Normals are normalized again. Rows are split between threads (0 for hardware concurrency).
+	 */
+	static void generateMip(const unsigned char* src, int width, int height, unsigned char* dst, TextureUsage usage, int threads = 0);
+
+	/**
+	 * @brief Format of an image: BC5 for normal maps, BC4 for masks and grey images, BC5 for grey alpha images, BC3
+	 *        for images with transparent pixels and BC1 otherwise
+	 */
+	static TextureCompression chooseCompression(const unsigned char* rgba, int width, int height, int channels, TextureUsage usage);
+
+	/**
+	 * @brief PSNR (dB) of decoded blocks against RGBA8 pixels, over the channels stored by compression
+	 */
+	static double computePSNR(const unsigned char* rgba, int channels, const unsigned char* blocks, int width, int height,
+		TextureCompression compression);
+	static const char* getCompressionName(TextureCompression compression);
+
+	/**
+	 * @brief Write / read a DDS file holding all the levels of image, tagged with sourceHash
+	 * @details loadDDS fails if the file is shorter than the levels its header declares.
+	 */
+	static bool saveDDS(const std::string& filename, const CompressedImage& image, uint64_t sourceHash);
+	static bool loadDDS(const std::string& filename, CompressedImage& image, uint64_t& sourceHash);
+
+	// 64 bit FNV-1a hash
+	static uint64_t hashBytes(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ULL);
+	// Cache file of an image file imported with a compression and a usage
+	static std::string cacheName(const std::string& filename, TextureCompression compression, TextureUsage usage = TextureUsageColor);
+
+	// Bytes of an RGBA8 image with its mip chain
+	static size_t uncompressedSize(int width, int height);
+
+	std::vector<TextureMemoryRecord> getRecords();
+	void logReport();
+
+private:
+	TextureImporter() {}
+
+	std::mutex m_Mutex;
+	std::vector<TextureMemoryRecord> m_Records;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef _TEXTURE_PACKER_H
+#define _TEXTURE_PACKER_H
+
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "TextureImporter.h"
+
+/**
+ * @brief      Place of a texture in the texture arrays of a TexturePacker
+ */
+struct PackedTexture
+{
+	std::string filename;
+	int width, height;
+	int group;				// Texture array
+	int layer;
+	glm::vec4 uvTransform;	// Packed coordinates are uv * xy + zw: the rectangle of an atlas entry, (1, 1, 0, 0) for a whole layer
+	bool atlased;
+};
+
+/**
+ * @brief      Texture array (GL_TEXTURE_2D_ARRAY) of same size and format layers: whole textures, or atlas pages
+ */
+struct TextureArrayGroup
+{
+	int width, height, levels;
+	TextureCompression compression;
+	bool atlas;
+	std::vector<CompressedImage> layers;	// Released by createGL
+	size_t memorySize;
+	GLuint id;
+	GLuint64 handle;
+};
+
+struct TexturePackingStats
+{
+	int textures;
+	int groups;
+	int arrayLayers;		// Whole textures stored as layers
+	int atlasPages;
+	int atlasEntries;
+	double atlasOccupancy;	// Texels of the entries over the texels of the pages
+	size_t memorySize;		// Of all the arrays
+	double buildTime;		// Milliseconds
+};
+
+/**
+ * @brief      Import step grouping textures so that draws sampling different textures can share one binding
+ * @details    Small textures sampled within [0, 1] are packed into atlas pages with stb_rect_pack, each entry being
+ *             surrounded by a gutter of replicated border texels. Entries are placed on multiples of the gutter, so
+ *             that the page keeps log2(padding) levels without bleeding between entries (log2(padding) - 1 for block
+ *             compressed pages, whose gutter must stay a whole block). Other textures (larger
+ *             than maxAtlasEntry or repeated) are grouped by size, format and mip count into the layers of a texture
+ *             array. Atlas pages of the same format are the layers of an array as well, so every texture is reached
+ *             through (group, layer, uvTransform), and draws of a group can be batched into instanced or multi-draw
+ *             calls with the layer and transform as per-draw data.
+ *             build() does not use OpenGL, createGL() then creates the arrays and their resident handles.
+ */
+class TexturePacker
+{
+public:
+	/**
+	 * @param atlasSize side of the atlas pages
+	 * @param maxAtlasEntry largest side of an atlased texture
+	 * @param padding gutter around the atlas entries (power of 2, at least 4 for the blocks)
+	 */
+	explicit TexturePacker(int atlasSize = 2048, int maxAtlasEntry = 256, int padding = 8);
+	~TexturePacker();
+
+	/**
+	 * @brief Texture to pack
+	 * @param repeat sampled out of [0, 1] with GL_REPEAT: kept whole as an array layer
+	 * @return index of the texture in getTexture
+	 */
+	int add(const std::string& filename, TextureCompression compression, TextureUsage usage = TextureUsageColor, bool repeat = false);
+
+	/**
+	 * @brief Import (TextureImporter), group and pack the added textures
+	 * @return false if a texture could not be imported
+	 */
+	bool build();
+
+	/**
+	 * @brief Create the texture arrays and make their handles resident (GL thread)
+	 */
+	void createGL();
+
+	/**
+	 * @brief Texture coordinates of a mesh of texture t moved to its packed place: xy in the atlas rectangle, z set to the layer
+	 */
+	static void remapCoords(const PackedTexture& t, std::vector<glm::vec3>& coords);
+
+	/**
+	 * @brief Batches of draws sorted by binding, drawTextures giving the texture sampled by each draw: one batch per
+	 *        texture when packed is false, per group otherwise
+	 */
+	int countBatches(const std::vector<int>& drawTextures, bool packed) const;
+
+	int getTextureCount() const { return (int)m_Textures.size(); }
+	const PackedTexture& getTexture(int i) const { return m_Textures[i]; }
+	const std::vector<TextureArrayGroup>& getGroups() const { return m_Groups; }
+	const TexturePackingStats& getStats() const { return m_Stats; }
+	int getAtlasSize() const { return m_AtlasSize; }
+	int getPadding() const { return m_Padding; }
+
+private:
+	struct Source
+	{
+		TextureCompression compression;
+		TextureUsage usage;
+		bool repeat;
+	};
+
+	void packAtlases(std::vector<int>& entries, std::vector<CompressedImage>& pixels, TextureCompression compression, TextureUsage usage, int channels);
+
+	int m_AtlasSize, m_MaxAtlasEntry, m_Padding;
+	std::vector<PackedTexture> m_Textures;
+	std::vector<Source> m_Sources;
+	std::vector<TextureArrayGroup> m_Groups;
+	TexturePackingStats m_Stats;
+};
+
+#endif
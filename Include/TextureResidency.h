@@ -0,0 +1,63 @@
+#ifndef _TEXTURE_RESIDENCY_H
+#define _TEXTURE_RESIDENCY_H
+
+#include <vector>
+#include "ResidencyLRU.hpp"
+#include "Singleton.h"
+
+class Texture2D;
+
+struct TextureResidencyStats
+{
+	long long evictions;		// Handles made non-resident by the budget
+	long long restores;			// Evicted handles made resident again by a use
+	int lastEvictions;			// During the last update
+	int lastRestores;
+};
+
+/**
+ * @brief      Residency of the bindless handles of the textures, under a memory budget
+ * @details    Textures are added when their handle is made resident, with the size of their storage. A texture is
+ *             used when a draw takes its handle (Texture2D::getHandle): an evicted handle is made resident again
+ *             there, before the draw. update() starts a frame and makes the least recently used handles non-resident
+ *             while the resident bytes exceed the budget, keeping those of the frames still in flight. Handles stored
+ *             once (in a buffer) must therefore be taken through getHandle in every frame that samples them.
+ *             GL thread only.
+ */
+class TextureResidency : public Singleton<TextureResidency>
+{
+	friend class Singleton<TextureResidency>;
+public:
+	// Handle of texture made resident (creation or new base level)
+	void add(Texture2D* texture, size_t bytes);
+	// Before the destruction of texture
+	void remove(Texture2D* texture);
+	// Handle of texture referenced by the current frame
+	void use(Texture2D* texture);
+
+	/**
+	 * @brief Next frame: evict handles until the budget is met (once per frame)
+	 */
+	void update();
+
+	void setBudget(size_t bytes) { m_LRU.setBudget(bytes); }
+	size_t getBudget() const { return m_LRU.getBudget(); }
+	size_t getResidentBytes() const { return m_LRU.getResidentBytes(); }
+	size_t getTotalBytes() const { return m_LRU.getTotalBytes(); }
+	int getResidentCount() const { return m_LRU.getResidentCount(); }
+	int getTextureCount() const { return m_LRU.getCount(); }
+	const TextureResidencyStats& getStats() const { return m_Stats; }
+
+	static const int FramesInFlight = 3;
+
+private:
+	TextureResidency();
+
+	ResidencyLRU<Texture2D*> m_LRU;
+	long long m_Frame;
+	int m_Restores;		// Since the last update
+	std::vector<Texture2D*> m_Evicted;
+	TextureResidencyStats m_Stats;
+};
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef _TEXTURE_STREAMER_H
+#define _TEXTURE_STREAMER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include "Singleton.h"
+#include "TextureImporter.h"
+
+class Texture2D;
+
+/**
+ * @brief      Ranges of a ring buffer, allocated in order and released in any order
+ * @details    A range that does not fit before the end of the buffer starts at the beginning, the skipped bytes
+ *             belonging to it. Space is given back when the oldest ranges are released, so a released range waits for
+ *             the ones allocated before it. Not thread safe.
+ */
+class UploadRing
+{
+public:
+	static const size_t NoOffset = (size_t)-1;
+
+	explicit UploadRing(size_t capacity = 0, size_t alignment = 256);
+
+	void reset(size_t capacity);
+	/**
+	 * @return offset of size free bytes, NoOffset if there is not enough contiguous space
+	 */
+	size_t allocate(size_t size);
+	void release(size_t offset);
+
+	size_t getCapacity() const { return m_Capacity; }
+	// Bytes of the live ranges, skipped bytes included
+	size_t getUsed() const { return m_Used; }
+	int getLiveCount() const { return (int)m_Ranges.size(); }
+
+private:
+	struct Range
+	{
+		size_t start;		// Beginning of the skipped bytes, if any
+		size_t offset;
+		size_t length;		// From start
+		bool released;
+	};
+
+	size_t m_Capacity, m_Alignment;
+	size_t m_Head, m_Tail, m_Used;
+	std::deque<Range> m_Ranges;		// In allocation order
+};
+
+/**
+ * @brief      Image decoded by a worker of the TextureStreamer, waiting for its upload
+ */
+struct DecodedImage
+{
+	Texture2D* texture;			// NULL if the texture was destroyed meanwhile
+	std::string filename;
+	int width, height;			// RGBA8 pixels
+	size_t offset;				// Pixels in the upload ring, UploadRing::NoOffset when they are in pixels
+	unsigned char* pixels;		// Images larger than the ring (to free with stbi_image_free)
+	double decodeTime;			// Milliseconds on the worker
+	std::chrono::high_resolution_clock::time_point requestTime;
+	bool failed;
+};
+
+struct TextureStreamingStats
+{
+	int requested, submitted, completed, failed;
+	long long bytes;			// Uploaded pixels
+	double decodeTime;			// Milliseconds, summed over the workers
+	double uploadTime;			// Milliseconds spent by the GL thread to submit the uploads
+	double maxUploadTime;		// Longest submission of a single texture
+	double streamingTime;		// Milliseconds during which requests were pending
+	int mipLevels;				// Finer levels uploaded by the mip streams
+	long long mipBytes;
+	double mipUploadTime;		// Milliseconds
+};
+
+/**
+ * @brief      Asynchronous texture loading
+ * @details    Images are decoded (stb_image) by worker threads, which copy the pixels into a persistently mapped
+ *             pixel unpack buffer used as a ring. Once per frame update() submits the decoded images from the ring
+ *             (storage, glTextureSubImage2D from the buffer and mipmaps) with a fence, and completes the uploads whose
+ *             fence is signaled: the ring range is released and the texture handle made resident. Until then,
+ *             textures give the handle of a placeholder (see Texture2D::getHandle). The GL thread only waits for a
+ *             worker when the ring is full.
+ *             The decoding and the ring (start, request, popDecoded, release) do not use OpenGL, so they can run on
+ *             plain memory.
+ *             Imported mip chains (see Texture2D) are made resident from their coarsest levels: update() uploads their
+ *             finer levels from the coarse end, at most getMipBudget bytes per frame, and moves the base level of the
+ *             texture down as they arrive.
+ */
+class TextureStreamer : public Singleton<TextureStreamer>
+{
+	friend class Singleton<TextureStreamer>;
+public:
+	/**
+	 * @brief Create the pixel unpack ring (GL thread) and start the workers
+	 * @param threads number of decoding threads (0 for hardware concurrency - 1, at least 1)
+	 */
+	void initGL(size_t ringSize = 64 << 20, int threads = 0);
+
+	/**
+	 * @brief Start the workers, decoded pixels being copied to ring (ringSize bytes, kept by the caller)
+	 */
+	void start(unsigned char* ring, size_t ringSize, int threads = 0);
+	// Stop the workers, pending requests being dropped
+	void stop();
+
+	/**
+	 * @brief Queue the decoding of an image file (any thread). texture may be NULL to only decode.
+	 */
+	void request(const std::string& filename, Texture2D* texture);
+	/**
+	 * @brief Forget texture in the pending requests and uploads, before its destruction
+	 */
+	void cancel(Texture2D* texture);
+
+	/**
+	 * @brief Next decoded image, in decoding order
+	 * @return false if there is none
+	 */
+	bool popDecoded(DecodedImage& image);
+	/**
+	 * @brief Give back the ring range of a decoded image (or free its pixels)
+	 */
+	void release(const DecodedImage& image);
+
+	/**
+	 * @brief Submit the decoded images and complete the finished uploads (GL thread, once per frame)
+	 */
+	void update();
+
+	// Handle of a small checker texture shown while a texture streams (created on first use, GL thread)
+	GLuint64 getPlaceholderHandle();
+
+	/**
+	 * @brief Upload the levels of image finer than the base level of texture over the next frames (image is emptied)
+	 */
+	void streamMips(Texture2D* texture, CompressedImage& image);
+	/**
+	 * @brief Level from which an image is uploaded when its texture is created: the coarsest levels, within
+	 *        InitialMipBytes, or all of them when mip streaming is disabled
+	 */
+	int getInitialLevel(const CompressedImage& image) const;
+	/**
+	 * @brief Delete a texture or view and its handle (0 if not resident) once the frames submitted until now are done
+	 *        (GL thread)
+	 */
+	void retireTexture(GLuint texture, GLuint64 handle);
+
+	// Bytes of levels uploaded per frame, 0 to upload whole mip chains at creation
+	void setMipBudget(size_t bytes) { m_MipBudget = bytes; }
+	size_t getMipBudget() const { return m_MipBudget; }
+	int getMipStreamCount() const { return (int)m_MipStreams.size(); }
+
+	static const size_t InitialMipBytes = 64 << 10;
+
+	/**
+	 * @brief Smallest level such that the levels from it to the end of the chain take at most bytes (the last one at
+	 *        least)
+	 */
+	static int firstLevelWithin(const std::vector<size_t>& levelSizes, size_t bytes);
+	/**
+	 * @brief Number of levels uploaded from nextLevel towards level 0 within budget bytes, at least one when force is
+	 *        true so that a level larger than the budget still streams
+	 */
+	static int countMipUploads(const std::vector<size_t>& levelSizes, int nextLevel, size_t budget, bool force);
+
+	// Requests not uploaded yet
+	int getPendingCount();
+	const TextureStreamingStats& getStats() const { return m_Stats; }
+	int getThreadCount() const { return (int)m_Workers.size(); }
+	const UploadRing& getRing() const { return m_Ring; }
+
+private:
+	TextureStreamer();
+	~TextureStreamer();
+
+	struct Upload
+	{
+		GLsync fence;
+		DecodedImage image;
+	};
+
+	struct MipStream
+	{
+		Texture2D* texture;
+		CompressedImage image;
+		int nextLevel;			// Finest level left to upload
+	};
+
+	struct RetiredTexture
+	{
+		GLsync fence;
+		GLuint texture;
+		GLuint64 handle;
+	};
+
+	void work();
+	void updateMips();
+
+	std::mutex m_Mutex;
+	std::condition_variable m_RequestAdded;
+	std::condition_variable m_RingReleased;
+	std::deque<DecodedImage> m_Requests;
+	std::list<DecodedImage> m_Decoding;		// Held by the workers
+	std::deque<DecodedImage> m_Decoded;
+	std::vector<std::thread> m_Workers;
+	bool m_Stop;
+
+	UploadRing m_Ring;
+	unsigned char* m_RingMemory;
+	GLuint m_Buffer;
+	std::deque<Upload> m_Uploads;		// Submitted, in submission order
+
+	GLuint m_Placeholder;
+	GLuint64 m_PlaceholderHandle;
+
+	std::list<MipStream> m_MipStreams;		// In creation order, GL thread only
+	std::deque<RetiredTexture> m_RetiredTextures;
+	size_t m_MipBudget;
+
+	TextureStreamingStats m_Stats;
+	bool m_Busy;		// Requests are pending since m_BusyStart
+	std::chrono::high_resolution_clock::time_point m_BusyStart;
+};
+
+#endif
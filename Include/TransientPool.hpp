@@ -0,0 +1,197 @@
+#ifndef _TRANSIENT_POOL
+#define _TRANSIENT_POOL
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief      Recycling of items (render targets) by descriptor key, within and across frames
+ * @details    An item released during a frame goes back to the free list of its key at once, so that a later acquire
+ *             of the same frame reuses it: targets whose lifetimes do not overlap alias the same memory, and the
+ *             pool only holds as many targets of a key as are in use at once. Free items unused for keepFrames
+ *             frames are given back by endFrame to be destroyed. The pool does not create items: the caller creates
+ *             one when acquire finds none, and adds it.
+ *             In use and pooled bytes are tracked, with the peak of the bytes in use during a frame and the bytes of
+ *             all the items used during the frame (what the targets would take without aliasing).
+ */
+template <typename T> class TransientPool
+{
+public:
+	explicit TransientPool(int keepFrames = 60);
+
+	/**
+	 * @brief Free item of key, marked in use
+	 * @return false if there is none: the caller creates it and adds it
+	 */
+	bool acquire(uint64_t key, T& item);
+	// Item created for key, in use
+	void add(uint64_t key, T item, size_t bytes);
+	// Back to the free list of its key
+	void release(T item);
+	// Forget an item destroyed by the caller (in use or free)
+	void remove(T item);
+
+	/**
+	 * @brief End of a frame: frame statistics, and free items unused for keepFrames frames
+	 * @param expired items to destroy (appended), no longer tracked
+	 */
+	void endFrame(std::vector<T>& expired);
+
+	bool isInUse(T item) const;
+	int getCount() const { return (int)m_Entries.size(); }
+	int getFreeCount() const { return m_FreeCount; }
+	size_t getPooledBytes() const { return m_PooledBytes; }
+	size_t getInUseBytes() const { return m_InUseBytes; }
+	// Of the last ended frame
+	size_t getPeakBytes() const { return m_LastPeakBytes; }
+	size_t getRequestedBytes() const { return m_LastRequestedBytes; }
+	long long getCreatedCount() const { return m_Created; }
+	long long getReusedCount() const { return m_Reused; }
+	long long getDestroyedCount() const { return m_Destroyed; }
+	long long getFrame() const { return m_Frame; }
+	void setKeepFrames(int frames) { m_KeepFrames = frames; }
+	int getKeepFrames() const { return m_KeepFrames; }
+
+private:
+	struct Entry
+	{
+		uint64_t key;
+		size_t bytes;
+		bool inUse;
+		long long lastUsed;
+	};
+
+	void used(Entry& e);
+
+	int m_KeepFrames;
+	long long m_Frame;
+	std::unordered_map<T, Entry> m_Entries;
+	std::unordered_map<uint64_t, std::vector<T> > m_Free;	// Most recently released last
+	int m_FreeCount;
+	size_t m_PooledBytes, m_InUseBytes;
+	size_t m_PeakBytes, m_RequestedBytes;			// Current frame
+	size_t m_LastPeakBytes, m_LastRequestedBytes;
+	long long m_Created, m_Reused, m_Destroyed;
+};
+
+template <typename T>
+TransientPool<T>::TransientPool(int keepFrames) :
+	m_KeepFrames(keepFrames), m_Frame(0), m_FreeCount(0), m_PooledBytes(0), m_InUseBytes(0), m_PeakBytes(0), m_RequestedBytes(0),
+	m_LastPeakBytes(0), m_LastRequestedBytes(0), m_Created(0), m_Reused(0), m_Destroyed(0)
+{
+}
+
+template <typename T>
+void TransientPool<T>::used(Entry& e)
+{
+	e.inUse = true;
+	e.lastUsed = m_Frame;
+	m_InUseBytes += e.bytes;
+	m_RequestedBytes += e.bytes;
+	m_PeakBytes = std::max(m_PeakBytes, m_InUseBytes);
+}
+
+template <typename T>
+bool TransientPool<T>::acquire(uint64_t key, T& item)
+{
+	typename std::unordered_map<uint64_t, std::vector<T> >::iterator it = m_Free.find(key);
+	if (it == m_Free.end() || it->second.empty())
+		return false;
+	item = it->second.back();
+	it->second.pop_back();
+	m_FreeCount--;
+	used(m_Entries[item]);
+	m_Reused++;
+	return true;
+}
+
+template <typename T>
+void TransientPool<T>::add(uint64_t key, T item, size_t bytes)
+{
+	Entry e;
+	e.key = key;
+	e.bytes = bytes;
+	m_Entries[item] = e;
+	m_PooledBytes += bytes;
+	used(m_Entries[item]);
+	m_Created++;
+}
+
+template <typename T>
+void TransientPool<T>::release(T item)
+{
+	typename std::unordered_map<T, Entry>::iterator it = m_Entries.find(item);
+	if (it == m_Entries.end() || !it->second.inUse)
+		return;
+	Entry& e = it->second;
+	e.inUse = false;
+	e.lastUsed = m_Frame;
+	m_InUseBytes -= e.bytes;
+	m_Free[e.key].push_back(item);
+	m_FreeCount++;
+}
+
+template <typename T>
+void TransientPool<T>::remove(T item)
+{
+	typename std::unordered_map<T, Entry>::iterator it = m_Entries.find(item);
+	if (it == m_Entries.end())
+		return;
+	Entry& e = it->second;
+	if (e.inUse)
+		m_InUseBytes -= e.bytes;
+	else
+	{
+		std::vector<T>& free = m_Free[e.key];
+		free.erase(std::find(free.begin(), free.end(), item));
+		m_FreeCount--;
+	}
+	m_PooledBytes -= e.bytes;
+	m_Entries.erase(it);
+}
+
+template <typename T>
+void TransientPool<T>::endFrame(std::vector<T>& expired)
+{
+	for (typename std::unordered_map<uint64_t, std::vector<T> >::iterator it = m_Free.begin(); it != m_Free.end();)
+	{
+		// Least recently released first
+		std::vector<T>& free = it->second;
+		size_t count = 0;
+		while (count < free.size() && m_Entries[free[count]].lastUsed <= m_Frame - m_KeepFrames)
+			count++;
+		for (size_t i = 0; i < count; i++)
+		{
+			typename std::unordered_map<T, Entry>::iterator e = m_Entries.find(free[i]);
+			m_PooledBytes -= e->second.bytes;
+			m_Entries.erase(e);
+			expired.push_back(free[i]);
+		}
+		m_FreeCount -= (int)count;
+		m_Destroyed += count;
+		free.erase(free.begin(), free.begin() + count);
+		if (free.empty())
+			it = m_Free.erase(it);
+		else
+			++it;
+	}
+
+	m_LastPeakBytes = m_PeakBytes;
+	m_LastRequestedBytes = m_RequestedBytes;
+	// Targets kept across frames count in the next one
+	m_PeakBytes = m_InUseBytes;
+	m_RequestedBytes = m_InUseBytes;
+	m_Frame++;
+}
+
+template <typename T>
+bool TransientPool<T>::isInUse(T item) const
+{
+	typename std::unordered_map<T, Entry>::const_iterator it = m_Entries.find(item);
+	return it != m_Entries.end() && it->second.inUse;
+}
+
+#endif
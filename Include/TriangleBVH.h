@@ -0,0 +1,82 @@
+#ifndef _TRIANGLE_BVH_H
+#define _TRIANGLE_BVH_H
+
+#include <vector>
+#include <cfloat>
+#include <glm/glm.hpp>
+#include "BoundingVolumes.h"
+
+struct RayHit
+{
+	float t;		// Distance along the ray (in ray direction units)
+	int face;		// Index of the hit face in the mesh, -1 if no hit
+	float u, v;		// Barycentric coordinates of the hit point
+};
+
+/**
+ * @brief      Static bounding volume hierarchy over the triangles of a mesh, for ray queries
+ * @details    Built top-down with a binned surface area heuristic. The top levels of the tree are built in parallel,
+ *             each thread filling its own subtree which is then appended to the node array. Nodes are stored in
+ *             depth-first order: the left child of an interior node immediately follows it.
+ */
+class TriangleBVH
+{
+public:
+	TriangleBVH();
+	~TriangleBVH();
+
+	/**
+	 * @brief Build the hierarchy
+	 * @param vertices vertex positions
+	 * @param indices 3 vertex indices per triangle
+	 * @param triangleCount number of triangles
+	 * @param threads number of threads used for the build (0 for hardware concurrency)
+	 */
+	void build(const glm::vec3* vertices, const int* indices, int triangleCount, int threads = 0);
+
+	/**
+	 * @brief Find the closest triangle hit by ray r
+	 * @param hit closest hit, only written when the function returns true
+	 * @param tMax farthest accepted distance
+	 * @return true if a triangle is hit before tMax
+	 */
+	bool intersect(const Ray& r, RayHit& hit, float tMax = FLT_MAX) const;
+
+	AABB bounds() const;
+	int getNodeCount() const { return (int)m_Nodes.size(); }
+	int getTriangleCount() const { return (int)m_Triangles.size(); }
+	/**
+	 * @brief Duration of the last build in milliseconds
+	 */
+	double getBuildTime() const { return m_BuildTime; }
+
+private:
+	struct BVHNode
+	{
+		glm::vec3 min;
+		int first;		// Leaf : first triangle, interior : right child index
+		glm::vec3 max;
+		int count;		// Leaf : triangle count, interior : 0
+	};
+
+	// Triangle stored as (v0, v1 - v0, v2 - v0) for the Moller-Trumbore test
+	struct BVHTriangle
+	{
+		glm::vec3 v0, e1, e2;
+		int face;
+	};
+
+	void buildNode(int begin, int end, std::vector<BVHNode>& out, int parallelDepth, int depth);
+
+	std::vector<BVHNode> m_Nodes;
+	std::vector<BVHTriangle> m_Triangles;
+
+	// Build data
+	std::vector<int> m_Indices;
+	std::vector<AABB> m_TriangleBounds;
+	std::vector<glm::vec3> m_Centroids;
+
+	double m_BuildTime;
+};
+
+#endif
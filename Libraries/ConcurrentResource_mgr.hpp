@@ -0,0 +1,247 @@
+#ifndef _CONCURRENT_RESOURCE_MGR
+#define _CONCURRENT_RESOURCE_MGR
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include "Logger/ImGuiLogger.h"
+using namespace std;
+
+/**
+ * @brief      Named and reference counted resources, usable from several threads
+ * @details    Same string API as Resource_mgr. Names are spread over shards, each one protected by a reader-writer
+ *             lock: lookups of existing resources only take a shared lock, and reference counts are atomic.
+ *             A missing resource is constructed at most once: the first caller registers it and constructs it outside
+ *             of the lock, the callers asking for it meanwhile wait for the construction to finish.
+ *             Resources created by a thread still have to be usable from that thread (e.g. no OpenGL call in a
+ *             constructor run by a loader thread).
+ */
+template <typename T> class ConcurrentResource_mgr
+{
+public:
+	ConcurrentResource_mgr();
+	~ConcurrentResource_mgr();
+
+	// Get the resource named a, creating it (as new T(a) or new R(a)) if it does not exist, and add a reference to it
+	T* get(const string& a);
+	template <typename R> R* get(const string& a);
+	void insert(const string& a, T* elt);
+	// Remove a reference to the resource named a, deleting it when no reference is left
+	void release(const string& a);
+	// Resource named a if it exists and is constructed, NULL otherwise. Does not add a reference.
+	T* find(const string& a);
+	int size() const;
+
+	/**
+	 * @brief Call f(name, resource) for each constructed resource, the shards being read-locked one after the other
+	 */
+	template <typename F> void forEach(F f);
+
+private:
+	static const int ShardCount = 32;
+
+	struct Entry
+	{
+		shared_future<T*> object;	// Ready once the construction is over, NULL if it failed
+		atomic<int> references;
+
+		explicit Entry(int r) : references(r) {}
+	};
+
+	struct Shard
+	{
+		mutable shared_timed_mutex mutex;
+		unordered_map<string, shared_ptr<Entry> > entries;
+	};
+
+	Shard& shard(const string& a) { return m_Shards[hash<string>()(a) % ShardCount]; }
+	template <typename R> T* acquire(const string& a);
+
+	Shard m_Shards[ShardCount];
+	atomic<int> m_Size;
+};
+
+template <typename T>
+ConcurrentResource_mgr<T>::ConcurrentResource_mgr() : m_Size(0)
+{
+	// Singletons are created on first use without synchronization: the logger must exist before the worker threads
+	Logger::getInstance();
+}
+
+template <typename T>
+ConcurrentResource_mgr<T>::~ConcurrentResource_mgr()
+{
+	for (int i = 0; i < ShardCount; i++)
+	{
+		for (typename unordered_map<string, shared_ptr<Entry> >::iterator it = m_Shards[i].entries.begin(); it != m_Shards[i].entries.end(); ++it)
+			delete it->second->object.get();
+		m_Shards[i].entries.clear();
+	}
+}
+
+template <typename T>
+template <typename R>
+T* ConcurrentResource_mgr<T>::acquire(const string& a)
+{
+	Shard& s = shard(a);
+	shared_ptr<Entry> entry;
+	{
+		shared_lock<shared_timed_mutex> lock(s.mutex);
+		typename unordered_map<string, shared_ptr<Entry> >::iterator it = s.entries.find(a);
+		if (it != s.entries.end())
+		{
+			entry = it->second;
+			entry->references++;
+		}
+	}
+
+	promise<T*> constructed;
+	if (!entry)
+	{
+		unique_lock<shared_timed_mutex> lock(s.mutex);
+		// Another thread may have registered the resource between the two locks
+		typename unordered_map<string, shared_ptr<Entry> >::iterator it = s.entries.find(a);
+		if (it != s.entries.end())
+		{
+			entry = it->second;
+			entry->references++;
+		}
+		else
+		{
+			entry = make_shared<Entry>(1);
+			entry->object = constructed.get_future().share();
+			s.entries.insert(make_pair(a, entry));
+			m_Size++;
+			lock.unlock();
+
+			T* object = NULL;
+			try
+			{
+				LOG_TRACE << "Creating New " << a << std::endl;
+				object = new R(a);
+			}
+			catch (const std::exception& e)
+			{
+				LOG_WARNING << "ERROR RSCMGR : " << e.what() << std::endl;
+			}
+			if (object == NULL)
+			{
+				// The waiting callers get NULL too, a later call will try again
+				lock.lock();
+				s.entries.erase(a);
+				m_Size--;
+				lock.unlock();
+			}
+			constructed.set_value(object);
+			return object;
+		}
+	}
+
+	// Wait for the construction, possibly running in another thread
+	T* object = entry->object.get();
+	if (object == NULL)
+		entry->references--;
+	return object;
+}
+
+template <typename T>
+T* ConcurrentResource_mgr<T>::get(const string& a)
+{
+	return acquire<T>(a);
+}
+
+template <typename T>
+template <typename R>
+R* ConcurrentResource_mgr<T>::get(const string& a)
+{
+	T* object = acquire<R>(a);
+	R* to_ret = dynamic_cast<R*>(object);
+	if (object != NULL && to_ret == NULL)
+		LOG_WARNING << "ERROR RSCMGR : Type conversion " << std::endl;
+	return to_ret;
+}
+
+template <typename T>
+void ConcurrentResource_mgr<T>::insert(const string& a, T* elt)
+{
+	Shard& s = shard(a);
+	unique_lock<shared_timed_mutex> lock(s.mutex);
+	if (s.entries.find(a) == s.entries.end())
+	{
+		promise<T*> p;
+		p.set_value(elt);
+		shared_ptr<Entry> entry = make_shared<Entry>(0);
+		entry->object = p.get_future().share();
+		s.entries.insert(make_pair(a, entry));
+		m_Size++;
+	}
+}
+
+template <typename T>
+void ConcurrentResource_mgr<T>::release(const string& a)
+{
+	Shard& s = shard(a);
+	shared_ptr<Entry> entry;
+	{
+		shared_lock<shared_timed_mutex> lock(s.mutex);
+		typename unordered_map<string, shared_ptr<Entry> >::iterator it = s.entries.find(a);
+		if (it == s.entries.end())
+			return;
+		entry = it->second;
+	}
+
+	if (entry->references.fetch_sub(1) > 1)
+		return;
+
+	// Last reference: the resource is removed unless it was acquired again or already removed meanwhile
+	T* object = NULL;
+	{
+		unique_lock<shared_timed_mutex> lock(s.mutex);
+		typename unordered_map<string, shared_ptr<Entry> >::iterator it = s.entries.find(a);
+		if (it == s.entries.end() || it->second != entry || entry->references.load() > 0)
+			return;
+		s.entries.erase(it);
+		m_Size--;
+	}
+	object = entry->object.get();
+	delete object;
+}
+
+template <typename T>
+T* ConcurrentResource_mgr<T>::find(const string& a)
+{
+	Shard& s = shard(a);
+	shared_lock<shared_timed_mutex> lock(s.mutex);
+	typename unordered_map<string, shared_ptr<Entry> >::iterator it = s.entries.find(a);
+	if (it == s.entries.end() || it->second->object.wait_for(chrono::seconds(0)) != future_status::ready)
+		return NULL;
+	return it->second->object.get();
+}
+
+template <typename T>
+int ConcurrentResource_mgr<T>::size() const
+{
+	return m_Size.load();
+}
+
+template <typename T>
+template <typename F>
+void ConcurrentResource_mgr<T>::forEach(F f)
+{
+	for (int i = 0; i < ShardCount; i++)
+	{
+		shared_lock<shared_timed_mutex> lock(m_Shards[i].mutex);
+		for (typename unordered_map<string, shared_ptr<Entry> >::iterator it = m_Shards[i].entries.begin(); it != m_Shards[i].entries.end(); ++it)
+		{
+			if (it->second->object.wait_for(chrono::seconds(0)) == future_status::ready && it->second->object.get() != NULL)
+				f(it->first, it->second->object.get());
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,416 @@
+#include "DXTCompressor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <emmintrin.h>
+
+#include "ThreadPool.h"
+
+// Four blocks, one per lane, pixel by pixel
+struct BlockSet
+{
+	__m128 r[16], g[16], b[16], a[16];
+};
+
+/*
+ * RGBA pixels of the block at (x, y), read and padded as convert_image_to_DXT1/5 do: 1 and 2 channel images are grey,
+ * alpha is the last channel of 2 and 4 channel images, and the pixels outside of the image repeat the first one.
+ */
+static void readBlock(const unsigned char* pixels, int width, int height, int channels, int x, int y, unsigned char block[64])
+{
+	int step = channels < 3 ? 0 : 1;
+	bool alpha = (channels & 1) == 0;
+	int mx = std::min(4, width - x), my = std::min(4, height - y);
+	for (int j = 0; j < 4; j++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			unsigned char* out = &block[(j * 4 + i) * 4];
+			if (i >= mx || j >= my)
+			{
+				memcpy(out, block, 4);
+				continue;
+			}
+			const unsigned char* p = &pixels[((size_t)(y + j) * width + (x + i)) * channels];
+			out[0] = p[0];
+			out[1] = p[step];
+			out[2] = p[2 * step];
+			out[3] = alpha ? p[channels - 1] : 255;
+		}
+	}
+}
+
+static void loadBlocks(const unsigned char blocks[4][64], BlockSet& s)
+{
+	const __m128i zero = _mm_setzero_si128();
+	for (int p = 0; p < 16; p++)
+	{
+		__m128 v[4];
+		for (int k = 0; k < 4; k++)
+		{
+			int rgba;
+			memcpy(&rgba, &blocks[k][p * 4], 4);
+			__m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128(rgba), zero);
+			v[k] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(x, zero));
+		}
+		_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+		s.r[p] = v[0];
+		s.g[p] = v[1];
+		s.b[p] = v[2];
+		s.a[p] = v[3];
+	}
+}
+
+// convert_bit_range of image_DXT: (b + (b >> from)) >> from with b = 2^(from - 1) + c * (2^to - 1)
+static inline __m128i convertBitRange(__m128i c, int from, int to)
+{
+	__m128i b = _mm_add_epi32(_mm_set1_epi32(1 << (from - 1)), _mm_sub_epi32(_mm_slli_epi32(c, to), c));
+	return _mm_srli_epi32(_mm_add_epi32(b, _mm_srli_epi32(b, from)), from);
+}
+
+static inline __m128i rgbTo565(__m128i r, __m128i g, __m128i b)
+{
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(convertBitRange(r, 8, 5), 11), _mm_slli_epi32(convertBitRange(g, 8, 6), 5)),
+		convertBitRange(b, 8, 5));
+}
+
+static inline __m128 dot3(__m128 x0, __m128 x1, __m128 x2, __m128 y0, __m128 y1, __m128 y2)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, y0), _mm_mul_ps(x1, y1)), _mm_mul_ps(x2, y2));
+}
+
+// (int) of a float known to be in [low, high + 1) once clamped, as a clamp of the integer would give
+static inline __m128i truncateClamped(__m128 v, float low, float high)
+{
+	return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, _mm_set1_ps(low)), _mm_set1_ps(high)));
+}
+
+/*
+ * compress_DDS_color_block of image_DXT for the four blocks: writes the 8 bytes of each lane to out[k * stride]
+ */
+static void compressColorBlocks(const BlockSet& s, unsigned char* out, int stride, int lanes)
+{
+	// compute_color_line_STDEV: average and covariance matrix
+	__m128 sr = _mm_setzero_ps(), sg = sr, sb = sr, srr = sr, sgg = sr, sbb = sr, srg = sr, srb = sr, sgb = sr;
+	for (int p = 0; p < 16; p++)
+	{
+		sr = _mm_add_ps(sr, s.r[p]);
+		srr = _mm_add_ps(srr, _mm_mul_ps(s.r[p], s.r[p]));
+		sg = _mm_add_ps(sg, s.g[p]);
+		sgg = _mm_add_ps(sgg, _mm_mul_ps(s.g[p], s.g[p]));
+		sb = _mm_add_ps(sb, s.b[p]);
+		sbb = _mm_add_ps(sbb, _mm_mul_ps(s.b[p], s.b[p]));
+		srg = _mm_add_ps(srg, _mm_mul_ps(s.r[p], s.g[p]));
+		srb = _mm_add_ps(srb, _mm_mul_ps(s.r[p], s.b[p]));
+		sgb = _mm_add_ps(sgb, _mm_mul_ps(s.g[p], s.b[p]));
+	}
+	const __m128 sixteen = _mm_set1_ps(16.0f);
+	sr = _mm_mul_ps(sr, _mm_set1_ps(1.0f / 16.0f));
+	sg = _mm_mul_ps(sg, _mm_set1_ps(1.0f / 16.0f));
+	sb = _mm_mul_ps(sb, _mm_set1_ps(1.0f / 16.0f));
+	srr = _mm_sub_ps(srr, _mm_mul_ps(_mm_mul_ps(sixteen, sr), sr));
+	sgg = _mm_sub_ps(sgg, _mm_mul_ps(_mm_mul_ps(sixteen, sg), sg));
+	sbb = _mm_sub_ps(sbb, _mm_mul_ps(_mm_mul_ps(sixteen, sb), sb));
+	srg = _mm_sub_ps(srg, _mm_mul_ps(_mm_mul_ps(sixteen, sr), sg));
+	srb = _mm_sub_ps(srb, _mm_mul_ps(_mm_mul_ps(sixteen, sr), sb));
+	sgb = _mm_sub_ps(sgb, _mm_mul_ps(_mm_mul_ps(sixteen, sg), sb));
+
+	// Three iterations of the power method for the principal axis
+	__m128 d0 = _mm_set1_ps(1.0f), d1 = _mm_set1_ps(2.718281828f), d2 = _mm_set1_ps(3.141592654f);
+	for (int i = 0; i < 3; i++)
+	{
+		__m128 x = d0, y = d1, z = d2;
+		d0 = dot3(x, y, z, srr, srg, srb);
+		d1 = dot3(x, y, z, srg, sgg, sgb);
+		d2 = dot3(x, y, z, srb, sgb, sbb);
+	}
+
+	// LSE_master_colors_max_min: extreme projections on the axis
+	__m128 length = _mm_div_ps(_mm_set1_ps(1.0f),
+		_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_set1_ps(0.00001f), _mm_mul_ps(d0, d0)), _mm_mul_ps(d1, d1)), _mm_mul_ps(d2, d2)));
+	__m128 dotMax = dot3(d0, d1, d2, s.r[0], s.g[0], s.b[0]), dotMin = dotMax;
+	for (int p = 1; p < 16; p++)
+	{
+		__m128 dot = dot3(d0, d1, d2, s.r[p], s.g[p], s.b[p]);
+		dotMin = _mm_min_ps(dot, dotMin);
+		dotMax = _mm_max_ps(dot, dotMax);
+	}
+	__m128 offset = dot3(d0, d1, d2, sr, sg, sb);
+	dotMin = _mm_mul_ps(_mm_sub_ps(dotMin, offset), length);
+	dotMax = _mm_mul_ps(_mm_sub_ps(dotMax, offset), length);
+
+	const __m128 half = _mm_set1_ps(0.5f);
+	__m128i c0[3], c1[3];
+	const __m128 average[3] = { sr, sg, sb }, axis[3] = { d0, d1, d2 };
+	for (int i = 0; i < 3; i++)
+	{
+		c0[i] = truncateClamped(_mm_add_ps(_mm_add_ps(half, average[i]), _mm_mul_ps(dotMax, axis[i])), 0.0f, 255.0f);
+		c1[i] = truncateClamped(_mm_add_ps(_mm_add_ps(half, average[i]), _mm_mul_ps(dotMin, axis[i])), 0.0f, 255.0f);
+	}
+	__m128i e0 = rgbTo565(c0[0], c0[1], c0[2]), e1 = rgbTo565(c1[0], c1[1], c1[2]);
+	__m128i greater = _mm_cmpgt_epi32(e0, e1);
+	__m128i encMax = _mm_or_si128(_mm_and_si128(greater, e0), _mm_andnot_si128(greater, e1));
+	__m128i encMin = _mm_or_si128(_mm_and_si128(greater, e1), _mm_andnot_si128(greater, e0));
+
+	// compress_DDS_color_block: indices from the projection on the decoded endpoints
+	__m128i mask5 = _mm_set1_epi32(31), mask6 = _mm_set1_epi32(63);
+	__m128i m0[3] = { convertBitRange(_mm_and_si128(_mm_srli_epi32(encMax, 11), mask5), 5, 8),
+		convertBitRange(_mm_and_si128(_mm_srli_epi32(encMax, 5), mask6), 6, 8), convertBitRange(_mm_and_si128(encMax, mask5), 5, 8) };
+	__m128i m1[3] = { convertBitRange(_mm_and_si128(_mm_srli_epi32(encMin, 11), mask5), 5, 8),
+		convertBitRange(_mm_and_si128(_mm_srli_epi32(encMin, 5), mask6), 6, 8), convertBitRange(_mm_and_si128(encMin, mask5), 5, 8) };
+	__m128 line[3], f0[3];
+	for (int i = 0; i < 3; i++)
+	{
+		line[i] = _mm_cvtepi32_ps(_mm_sub_epi32(m1[i], m0[i]));
+		f0[i] = _mm_cvtepi32_ps(m0[i]);
+	}
+	__m128 lineLength = dot3(line[0], line[1], line[2], line[0], line[1], line[2]);
+	__m128 positive = _mm_cmpgt_ps(lineLength, _mm_setzero_ps());
+	lineLength = _mm_and_ps(positive, _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(lineLength, _mm_andnot_ps(positive, _mm_set1_ps(1.0f)))));
+	for (int i = 0; i < 3; i++)
+		line[i] = _mm_mul_ps(line[i], lineLength);
+	__m128 lineOffset = dot3(line[0], line[1], line[2], f0[0], f0[1], f0[2]);
+
+	static const int swizzle4[] = { 0, 2, 3, 1 };
+	const __m128 three = _mm_set1_ps(3.0f);
+	unsigned int bits[4] = { 0, 0, 0, 0 };
+	for (int p = 0; p < 16; p++)
+	{
+		__m128 dot = _mm_sub_ps(dot3(line[0], line[1], line[2], s.r[p], s.g[p], s.b[p]), lineOffset);
+		__m128i index = truncateClamped(_mm_add_ps(_mm_mul_ps(dot, three), half), 0.0f, 3.0f);
+		int indices[4];
+		_mm_storeu_si128((__m128i*)indices, index);
+		for (int k = 0; k < 4; k++)
+			bits[k] |= (unsigned int)swizzle4[indices[k]] << (2 * p);
+	}
+
+	int maxima[4], minima[4];
+	_mm_storeu_si128((__m128i*)maxima, encMax);
+	_mm_storeu_si128((__m128i*)minima, encMin);
+	for (int k = 0; k < lanes; k++)
+	{
+		unsigned char* block = out + k * stride;
+		block[0] = maxima[k] & 255;
+		block[1] = (maxima[k] >> 8) & 255;
+		block[2] = minima[k] & 255;
+		block[3] = (minima[k] >> 8) & 255;
+		for (int i = 0; i < 4; i++)
+			block[4 + i] = (bits[k] >> (8 * i)) & 255;
+	}
+}
+
+/*
+ * compress_DDS_alpha_block of image_DXT for the four blocks. Like the scalar code, a uniform alpha gives a NaN index
+ * (0 times an infinite scale) whose truncation, 0x80000000 on x86, selects a1.
+ */
+static void compressAlphaBlocks(const BlockSet& s, unsigned char* out, int stride, int lanes)
+{
+	__m128 a0 = s.a[0], a1 = s.a[0];
+	for (int p = 1; p < 16; p++)
+	{
+		a0 = _mm_max_ps(s.a[p], a0);
+		a1 = _mm_min_ps(s.a[p], a1);
+	}
+	__m128 scale = _mm_div_ps(_mm_set1_ps(7.9999f), _mm_sub_ps(a0, a1));
+
+	static const unsigned long long swizzle8[] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+	unsigned long long bits[4] = { 0, 0, 0, 0 };
+	for (int p = 0; p < 16; p++)
+	{
+		int values[4];
+		_mm_storeu_si128((__m128i*)values, _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(s.a[p], a1), scale)));
+		for (int k = 0; k < 4; k++)
+			bits[k] |= swizzle8[values[k] & 7] << (3 * p);
+	}
+
+	int maxima[4], minima[4];
+	_mm_storeu_si128((__m128i*)maxima, _mm_cvttps_epi32(a0));
+	_mm_storeu_si128((__m128i*)minima, _mm_cvttps_epi32(a1));
+	for (int k = 0; k < lanes; k++)
+	{
+		unsigned char* block = out + k * stride;
+		block[0] = (unsigned char)maxima[k];
+		block[1] = (unsigned char)minima[k];
+		for (int i = 0; i < 6; i++)
+			block[2 + i] = (bits[k] >> (8 * i)) & 255;
+	}
+}
+
+static unsigned char* compressDXT(const unsigned char* pixels, int width, int height, int channels, int* outSize, int threads, bool dxt5)
+{
+	*outSize = 0;
+	if (width < 1 || height < 1 || pixels == NULL || channels < 1 || channels > 4)
+		return NULL;
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	int blockBytes = dxt5 ? 16 : 8;
+	*outSize = blocksX * blocksY * blockBytes;
+	unsigned char* compressed = (unsigned char*)malloc(*outSize);
+
+	if (threads <= 0)
+		threads = std::max(1, (int)std::thread::hardware_concurrency());
+	threads = std::min(threads, blocksY);
+	parallelFor(blocksY, threads, [&](int begin, int end) {
+		unsigned char blocks[4][64];
+		BlockSet set;
+		for (int by = begin; by < end; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx += 4)
+			{
+				int lanes = std::min(4, blocksX - bx);
+				for (int k = 0; k < 4; k++)
+					readBlock(pixels, width, height, channels, 4 * (bx + std::min(k, lanes - 1)), 4 * by, blocks[k]);
+				loadBlocks(blocks, set);
+				unsigned char* out = compressed + ((size_t)by * blocksX + bx) * blockBytes;
+				if (dxt5)
+				{
+					compressAlphaBlocks(set, out, blockBytes, lanes);
+					compressColorBlocks(set, out + 8, blockBytes, lanes);
+				}
+				else
+					compressColorBlocks(set, out, blockBytes, lanes);
+			}
+		}
+	});
+	return compressed;
+}
+
+unsigned char* compressDXT1(const unsigned char* pixels, int width, int height, int channels, int* outSize, int threads)
+{
+	return compressDXT(pixels, width, height, channels, outSize, threads, false);
+}
+
+unsigned char* compressDXT5(const unsigned char* pixels, int width, int height, int channels, int* outSize, int threads)
+{
+	return compressDXT(pixels, width, height, channels, outSize, threads, true);
+}
+
+// The four colors of a color block, the 3 color mode (c0 <= c1) only existing in DXT1
+static void decodeColors(const unsigned char* block, bool dxt1, unsigned char colors[4][4])
+{
+	int c[2] = { block[0] | (block[1] << 8), block[2] | (block[3] << 8) };
+	for (int i = 0; i < 2; i++)
+	{
+		int r = (c[i] >> 11) & 31, g = (c[i] >> 5) & 63, b = c[i] & 31;
+		colors[i][0] = (unsigned char)((r << 3) | (r >> 2));
+		colors[i][1] = (unsigned char)((g << 2) | (g >> 4));
+		colors[i][2] = (unsigned char)((b << 3) | (b >> 2));
+		colors[i][3] = 255;
+	}
+	for (int j = 0; j < 3; j++)
+	{
+		if (c[0] > c[1] || !dxt1)
+		{
+			colors[2][j] = (unsigned char)((2 * colors[0][j] + colors[1][j]) / 3);
+			colors[3][j] = (unsigned char)((colors[0][j] + 2 * colors[1][j]) / 3);
+		}
+		else
+		{
+			colors[2][j] = (unsigned char)((colors[0][j] + colors[1][j]) / 2);
+			colors[3][j] = 0;
+		}
+	}
+	colors[2][3] = 255;
+	colors[3][3] = c[0] > c[1] || !dxt1 ? 255 : 0;
+}
+
+// The 16 values of an alpha (BC4) block
+static void decodeAlphaBlock(const unsigned char* block, unsigned char values[16])
+{
+	unsigned char palette[8];
+	palette[0] = block[0];
+	palette[1] = block[1];
+	for (int i = 2; i < 8; i++)
+	{
+		if (block[0] > block[1])
+			palette[i] = (unsigned char)(((8 - i) * block[0] + (i - 1) * block[1]) / 7);
+		else
+			palette[i] = i < 6 ? (unsigned char)(((6 - i) * block[0] + (i - 1) * block[1]) / 5) : (i == 6 ? 0 : 255);
+	}
+	unsigned long long bits = 0;
+	for (int i = 0; i < 6; i++)
+		bits |= (unsigned long long)block[2 + i] << (8 * i);
+	for (int p = 0; p < 16; p++)
+		values[p] = palette[(bits >> (3 * p)) & 7];
+}
+
+static void decompressDXT(const unsigned char* blocks, int width, int height, unsigned char* rgba, bool dxt5)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			const unsigned char* block = blocks + ((size_t)by * blocksX + bx) * (dxt5 ? 16 : 8);
+			unsigned char alphas[16];
+			if (dxt5)
+			{
+				decodeAlphaBlock(block, alphas);
+				block += 8;
+			}
+			unsigned char colors[4][4];
+			decodeColors(block, !dxt5, colors);
+			unsigned int bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+			for (int p = 0; p < 16; p++)
+			{
+				int x = 4 * bx + p % 4, y = 4 * by + p / 4;
+				if (x >= width || y >= height)
+					continue;
+				unsigned char* out = &rgba[((size_t)y * width + x) * 4];
+				memcpy(out, colors[(bits >> (2 * p)) & 3], 4);
+				if (dxt5)
+					out[3] = alphas[p];
+			}
+		}
+	}
+}
+
+void decompressDXT1(const unsigned char* blocks, int width, int height, unsigned char* rgba)
+{
+	decompressDXT(blocks, width, height, rgba, false);
+}
+
+void decompressDXT5(const unsigned char* blocks, int width, int height, unsigned char* rgba)
+{
+	decompressDXT(blocks, width, height, rgba, true);
+}
+
+// BC4 and BC5 are sampled as (r, 0, 0, 1) and (r, g, 0, 1)
+static void decompressRGTC(const unsigned char* blocks, int width, int height, unsigned char* rgba, int channels)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			const unsigned char* block = blocks + ((size_t)by * blocksX + bx) * 8 * channels;
+			unsigned char values[2][16];
+			decodeAlphaBlock(block, values[0]);
+			if (channels == 2)
+				decodeAlphaBlock(block + 8, values[1]);
+			for (int p = 0; p < 16; p++)
+			{
+				int x = 4 * bx + p % 4, y = 4 * by + p / 4;
+				if (x >= width || y >= height)
+					continue;
+				unsigned char* out = &rgba[((size_t)y * width + x) * 4];
+				out[0] = values[0][p];
+				out[1] = channels == 2 ? values[1][p] : 0;
+				out[2] = 0;
+				out[3] = 255;
+			}
+		}
+	}
+}
+
+void decompressBC4(const unsigned char* blocks, int width, int height, unsigned char* rgba)
+{
+	decompressRGTC(blocks, width, height, rgba, 1);
+}
+
+void decompressBC5(const unsigned char* blocks, int width, int height, unsigned char* rgba)
+{
+	decompressRGTC(blocks, width, height, rgba, 2);
+}
@@ -0,0 +1,25 @@
+#ifndef _DXT_COMPRESSOR_H
+#define _DXT_COMPRESSOR_H
+
+/**
+ * @brief      DXT1 / DXT5 compression of an image, four blocks at a time with SSE2 and block rows split between threads
+ * @details    Takes the pixels of convert_image_to_DXT1 / convert_image_to_DXT5 (1 to 4 channels) and gives the same
+ *             blocks: each SSE lane runs the image_DXT code of one block (covariance power method for the color line,
+ *             endpoints from the extreme projections, index selection, alpha range), with the float operations in the
+ *             same order, so that the output is bit identical to the scalar compressor.
+ * @param      threads number of threads (0 for hardware concurrency)
+ * @return     blocks allocated with malloc (to free with free), NULL if the image is invalid
+ */
+unsigned char* compressDXT1(const unsigned char* pixels, int width, int height, int channels, int* outSize, int threads = 0);
+unsigned char* compressDXT5(const unsigned char* pixels, int width, int height, int channels, int* outSize, int threads = 0);
+
+/**
+ * @brief      Decoding of DXT1 / DXT5 blocks to RGBA8 pixels (width * height * 4 bytes), as a GPU samples them
+ */
+void decompressDXT1(const unsigned char* blocks, int width, int height, unsigned char* rgba);
+void decompressDXT5(const unsigned char* blocks, int width, int height, unsigned char* rgba);
+// BC4 / BC5 (convert_image_to_BC4 / convert_image_to_BC5 of image_DXT), as (r, 0, 0, 255) and (r, g, 0, 255)
+void decompressBC4(const unsigned char* blocks, int width, int height, unsigned char* rgba);
+void decompressBC5(const unsigned char* blocks, int width, int height, unsigned char* rgba);
+
+#endif
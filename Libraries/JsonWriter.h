@@ -0,0 +1,152 @@
+#ifndef _JSON_WRITER_H
+#define _JSON_WRITER_H
+
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief      Minimal streaming JSON writer for reports
+ * @details    Values are written as they come : objects and arrays are opened and closed explicitly, keys are given
+ *             with the values inside objects and omitted (NULL) inside arrays. Non finite numbers are written as null.
+ */
+class JsonWriter
+{
+public:
+	explicit JsonWriter(std::ostream& out) : m_Out(out), m_Depth(0), m_First(true) {}
+
+	JsonWriter& beginObject(const char* key = NULL)
+	{
+		writeKey(key);
+		m_Out << "{";
+		m_Depth++;
+		m_First = true;
+		return *this;
+	}
+
+	JsonWriter& endObject()
+	{
+		close("}");
+		return *this;
+	}
+
+	JsonWriter& beginArray(const char* key = NULL)
+	{
+		writeKey(key);
+		m_Out << "[";
+		m_Depth++;
+		m_First = true;
+		return *this;
+	}
+
+	JsonWriter& endArray()
+	{
+		close("]");
+		return *this;
+	}
+
+	JsonWriter& value(const char* key, double v)
+	{
+		writeKey(key);
+		if (std::isfinite(v))
+		{
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "%.9g", v);
+			m_Out << buffer;
+		}
+		else
+			m_Out << "null";
+		return *this;
+	}
+
+	JsonWriter& value(const char* key, int v) { return value(key, (long long)v); }
+
+	JsonWriter& value(const char* key, long long v)
+	{
+		writeKey(key);
+		m_Out << v;
+		return *this;
+	}
+
+	JsonWriter& value(const char* key, bool v)
+	{
+		writeKey(key);
+		m_Out << (v ? "true" : "false");
+		return *this;
+	}
+
+	JsonWriter& value(const char* key, const char* v)
+	{
+		writeKey(key);
+		writeString(v);
+		return *this;
+	}
+
+	JsonWriter& value(const char* key, const std::string& v) { return value(key, v.c_str()); }
+
+private:
+	void newLine()
+	{
+		m_Out << "\n";
+		for (int i = 0; i < m_Depth; i++)
+			m_Out << "  ";
+	}
+
+	void writeKey(const char* key)
+	{
+		if (m_Depth > 0)
+		{
+			if (!m_First)
+				m_Out << ",";
+			newLine();
+		}
+		m_First = false;
+		if (key != NULL)
+		{
+			writeString(key);
+			m_Out << ": ";
+		}
+	}
+
+	void close(const char* bracket)
+	{
+		m_Depth--;
+		if (!m_First)
+			newLine();
+		m_Out << bracket;
+		m_First = false;
+		if (m_Depth == 0)
+			m_Out << "\n";
+	}
+
+	void writeString(const char* s)
+	{
+		m_Out << "\"";
+		for (; *s; s++)
+		{
+			unsigned char c = (unsigned char)*s;
+			if (c == '"' || c == '\\')
+				m_Out << "\\" << (char)c;
+			else if (c == '\n')
+				m_Out << "\\n";
+			else if (c == '\t')
+				m_Out << "\\t";
+			else if (c < 0x20)
+			{
+				char buffer[8];
+				snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+				m_Out << buffer;
+			}
+			else
+				m_Out << (char)c;
+		}
+		m_Out << "\"";
+	}
+
+	std::ostream& m_Out;
+	int m_Depth;
+	bool m_First;
+};
+
+#endif
@@ -7,61 +7,57 @@ Logger::Logger()
 	disp_info = true;
 	disp_trace = false;
 	show_interface = false;
-	current_type = Comm_Type::TRACE;
+	ScrollToBottom = false;
 };
 void Logger::Clear()
 {
-	Buf.clear();
+	std::lock_guard<std::mutex> lock(m_Mutex);
 	loggedMsg.clear();
 }
-Logger & Logger::operator << (const char* value)
+Logger::PendingMessage& Logger::pending()
 {
-	Buf.append("%s",value);
-
-	if (std::string(value).compare("[WARNING]") == 0)
-		current_type = Comm_Type::WARNING;
-	else if (std::string(value).compare("[INFO]")== 0)
-		current_type = Comm_Type::INFO;
-	else if (std::string(value).compare("[ERROR]")== 0)
-		current_type = Comm_Type::ERROR;
-	else if (std::string(value).compare("[TRACE]")== 0)
-		current_type = Comm_Type::TRACE;
-
-
-	if (current_type != Comm_Type::TRACE)
-		std::cout << value;
+	static thread_local PendingMessage message;
+	return message;
+}
+void Logger::append(const std::string& value)
+{
+	PendingMessage& message = pending();
+	message.text += value;
 
+	if (value.compare("[WARNING]") == 0)
+		message.type = Comm_Type::WARNING;
+	else if (value.compare("[INFO]") == 0)
+		message.type = Comm_Type::INFO;
+	else if (value.compare("[ERROR]") == 0)
+		message.type = Comm_Type::ERROR;
+	else if (value.compare("[TRACE]") == 0)
+		message.type = Comm_Type::TRACE;
+}
+Logger & Logger::operator << (const char* value)
+{
+	append(value);
 	return *this;
 }
 
 Logger &Logger::operator <<(const std::string value)
 {
-	Buf.append("%s",value.c_str());
-	if (std::string(value).compare("[WARNING]") == 0)
-		current_type = Comm_Type::WARNING;
-	else if (std::string(value).compare("[INFO]") == 0)
-		current_type = Comm_Type::INFO;
-	else if (std::string(value).compare("[ERROR]") == 0)
-		current_type = Comm_Type::ERROR;
-	else if (std::string(value).compare("[TRACE]") == 0)
-		current_type = Comm_Type::TRACE;
-
-	if (current_type != Comm_Type::TRACE)
-		std::cout << value;
-
+	append(value);
 	return *this;
 }
 
 Logger &Logger::operator <<(std::ostream& (*os)(std::ostream&))
 {
-	if (current_type != Comm_Type::TRACE)
-		std::cout << std::endl;
-	std::string c = Buf.c_str();
-	float time = ImGui::GetTime();
-	loggedMsg.push_back(_msg(current_type, c));
-	Buf.clear();
-	current_type = Comm_Type::TRACE;
-	ScrollToBottom = true;
+	// The message is complete: printed and stored at once, so that messages of different threads do not mix
+	PendingMessage& message = pending();
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (message.type != Comm_Type::TRACE)
+			std::cout << message.text << std::endl;
+		loggedMsg.push_back(_msg(message.type, message.text));
+		ScrollToBottom = true;
+	}
+	message.text.clear();
+	message.type = Comm_Type::TRACE;
 	return *this;
 }
 void Logger::Draw(const char* title)
@@ -139,6 +135,7 @@ void Logger::Draw(const char* title)
 	}
 	ImGui::Separator();
 	ImGui::BeginChild("scrolling", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+	std::unique_lock<std::mutex> lock(m_Mutex);
 	for (unsigned int i = 0; i < loggedMsg.size(); i++)
 	{
 		switch (loggedMsg[i].m_Type)
@@ -164,6 +161,7 @@ void Logger::Draw(const char* title)
 	if (ScrollToBottom)
 		ImGui::SetScrollHere(1.0);
 	ScrollToBottom = false;
+	lock.unlock();
 	ImGui::EndChild();
 	ImGui::End();
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <iostream>
 #include "imgui/imgui.h"
 #include <vector>
+#include <mutex>
 #include "Singleton.h"
 using std::chrono::system_clock;
 enum class Comm_Type { WARNING, INFO, ERROR,TRACE };
@@ -35,14 +36,22 @@ private:
 class Logger :public Singleton<Logger> {
 	friend class Singleton<Logger>; 
 private:
-	ImGuiTextBuffer     Buf;
+	// Message being written by a thread, each thread assembles its messages separately
+	struct PendingMessage
+	{
+		std::string text;
+		Comm_Type type = Comm_Type::TRACE;
+	};
+	static PendingMessage& pending();
+	void append(const std::string& value);
+
+	std::mutex m_Mutex;		// Protects loggedMsg and the console output
 	std::vector<_msg> loggedMsg;
 	bool ScrollToBottom;
 	bool disp_error;
 	bool disp_warning;
 	bool disp_info;
 	bool disp_trace;
-	Comm_Type current_type;
 private: 
 	Logger();
 public:
@@ -52,9 +61,7 @@ public:
 		template<typename T>
 		Logger &operator <<(const T value)
 		{
-			Buf.append("%s",std::to_string(value).c_str());
-			if (current_type != Comm_Type::TRACE)
-				std::cout << value;
+			pending().text += std::to_string(value);
 			return *this;
 		};
 		Logger &operator <<(const std::string value);
@@ -0,0 +1,109 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : m_Data(NULL), m_Size(0), m_File(INVALID_HANDLE_VALUE), m_Mapping(NULL)
+{
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+	m_File = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+	m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_Mapping == NULL)
+	{
+		close();
+		return false;
+	}
+	m_Data = static_cast<const unsigned char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_Data == NULL)
+	{
+		close();
+		return false;
+	}
+	m_Size = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_Data != NULL)
+		UnmapViewOfFile(m_Data);
+	if (m_Mapping != NULL)
+		CloseHandle(m_Mapping);
+	if (m_File != INVALID_HANDLE_VALUE)
+		CloseHandle(m_File);
+	m_Data = NULL;
+	m_Size = 0;
+	m_Mapping = NULL;
+	m_File = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : m_Data(NULL), m_Size(0), m_File(-1)
+{
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+	m_File = ::open(filename.c_str(), O_RDONLY);
+	if (m_File < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(m_File, &status) != 0 || status.st_size == 0)
+	{
+		close();
+		return false;
+	}
+	void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, m_File, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+	m_Data = static_cast<const unsigned char*>(data);
+	m_Size = (size_t)status.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_Data != NULL)
+		munmap(const_cast<unsigned char*>(m_Data), m_Size);
+	if (m_File >= 0)
+		::close(m_File);
+	m_Data = NULL;
+	m_Size = 0;
+	m_File = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
@@ -0,0 +1,43 @@
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief      Read-only memory mapping of a whole file
+ * @details    Pages are loaded by the system on first access (the mapping is marked as read sequentially, so the
+ *             following pages are read ahead). The data stays valid until close() or the destruction of the object.
+ */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	/**
+	 * @brief Map filename, closing the previous mapping
+	 * @return false if the file could not be opened or mapped (an empty file cannot be mapped)
+	 */
+	bool open(const std::string& filename);
+	void close();
+
+	bool isOpen() const { return m_Data != NULL; }
+	const unsigned char* data() const { return m_Data; }
+	size_t size() const { return m_Size; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const unsigned char* m_Data;
+	size_t m_Size;
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#else
+	int m_File;
+#endif
+};
+
+#endif
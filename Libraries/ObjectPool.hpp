@@ -0,0 +1,114 @@
+#ifndef _OBJECT_POOL
+#define _OBJECT_POOL
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * @brief      Fixed size allocations of objects of type T, from chunks of contiguous memory
+ * @details    Free slots are chained in a free list threaded through the slots themselves. When the list is empty a
+ *             chunk of ChunkSize slots is allocated and its slots are chained in address order, so that objects created
+ *             one after the other are contiguous. Chunks are only returned when the pool is destroyed. The pool is
+ *             protected by a mutex: objects may be created by loader threads.
+ */
+template <typename T, size_t ChunkSize = 4096> class ObjectPool
+{
+public:
+	ObjectPool() : m_Free(NULL), m_Live(0) {}
+
+	~ObjectPool()
+	{
+		for (size_t i = 0; i < m_Chunks.size(); i++)
+			::operator delete(m_Chunks[i]);
+	}
+
+	/**
+	 * @brief Uninitialized memory for one T
+	 */
+	void* allocate()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Free == NULL)
+			grow();
+		Slot* s = m_Free;
+		m_Free = s->next;
+		m_Live++;
+		return s;
+	}
+
+	/**
+	 * @brief Give back memory returned by allocate, the object being already destroyed
+	 */
+	void deallocate(void* p)
+	{
+		if (p == NULL)
+			return;
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Slot* s = static_cast<Slot*>(p);
+		s->next = m_Free;
+		m_Free = s;
+		m_Live--;
+	}
+
+	// Number of allocated objects
+	size_t getLiveCount() const { return m_Live; }
+	// Number of slots, allocated or free
+	size_t getCapacity() const { return m_Chunks.size() * ChunkSize; }
+
+private:
+	union Slot
+	{
+		Slot* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	void grow()
+	{
+		Slot* chunk = static_cast<Slot*>(::operator new(ChunkSize * sizeof(Slot)));
+		m_Chunks.push_back(chunk);
+		for (size_t i = 0; i + 1 < ChunkSize; i++)
+			chunk[i].next = &chunk[i + 1];
+		chunk[ChunkSize - 1].next = m_Free;
+		m_Free = chunk;
+	}
+
+	std::mutex m_Mutex;
+	std::vector<Slot*> m_Chunks;
+	Slot* m_Free;
+	size_t m_Live;
+};
+
+/**
+ * @brief      Base class giving T a class-specific operator new and delete drawing from an ObjectPool
+ * @details    Usage: class Node : public PooledObject<Node>. The pool of each type is created on first use and never
+ *             destroyed, since objects may still be deleted during static destruction. Objects of classes derived from
+ *             T have another size and use the global operators.
+ */
+template <typename T> class PooledObject
+{
+public:
+	static void* operator new(size_t size)
+	{
+		if (size != sizeof(T))
+			return ::operator new(size);
+		return pool().allocate();
+	}
+
+	static void operator delete(void* p, size_t size)
+	{
+		if (size != sizeof(T))
+			::operator delete(p);
+		else
+			pool().deallocate(p);
+	}
+
+	static ObjectPool<T>& pool()
+	{
+		static ObjectPool<T>* instance = new ObjectPool<T>();
+		return *instance;
+	}
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "PNGWriter.h"
+
+#include <cstdio>
+#include <cstring>
+
+struct CRCTable
+{
+	unsigned int values[256];
+
+	CRCTable()
+	{
+		for (unsigned int n = 0; n < 256; n++)
+		{
+			unsigned int c = n;
+			for (int k = 0; k < 8; k++)
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			values[n] = c;
+		}
+	}
+};
+
+static unsigned int crc(const unsigned char* data, size_t size, unsigned int c = 0xffffffffu)
+{
+	static const CRCTable table;
+	for (size_t i = 0; i < size; i++)
+		c = table.values[(c ^ data[i]) & 255] ^ (c >> 8);
+	return c;
+}
+
+static void putBigEndian(std::vector<unsigned char>& out, unsigned int v)
+{
+	unsigned char bytes[4] = { (unsigned char)(v >> 24), (unsigned char)(v >> 16), (unsigned char)(v >> 8), (unsigned char)v };
+	out.insert(out.end(), bytes, bytes + 4);
+}
+
+// Chunk of size data bytes already appended after its length and type
+static void endChunk(std::vector<unsigned char>& out, size_t start)
+{
+	size_t size = out.size() - start - 8;
+	for (int i = 0; i < 4; i++)
+		out[start + i] = (unsigned char)(size >> (24 - 8 * i));
+	putBigEndian(out, crc(&out[start + 4], size + 4) ^ 0xffffffffu);
+}
+
+static size_t beginChunk(std::vector<unsigned char>& out, const char* type)
+{
+	size_t start = out.size();
+	out.insert(out.end(), 4, 0);
+	out.insert(out.end(), type, type + 4);
+	return start;
+}
+
+bool encodePNG(int width, int height, int channels, const unsigned char* pixels, std::vector<unsigned char>& png)
+{
+	if (width < 1 || height < 1 || channels < 1 || channels > 4 || pixels == NULL)
+		return false;
+	size_t rowBytes = (size_t)width * channels;
+	size_t rawSize = (rowBytes + 1) * height;		// Each row starts with its filter type (0: none)
+	size_t blocks = (rawSize + 65534) / 65535;
+	png.clear();
+	png.reserve(rawSize + blocks * 5 + 64);
+
+	static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	png.insert(png.end(), signature, signature + 8);
+
+	size_t chunk = beginChunk(png, "IHDR");
+	putBigEndian(png, width);
+	putBigEndian(png, height);
+	static const unsigned char colorTypes[4] = { 0, 4, 2, 6 };
+	unsigned char header[5] = { 8, colorTypes[channels - 1], 0, 0, 0 };
+	png.insert(png.end(), header, header + 5);
+	endChunk(png, chunk);
+
+	chunk = beginChunk(png, "IDAT");
+	png.push_back(0x78);
+	png.push_back(0x01);
+	// Adler-32 of the raw rows, sums reduced before they can overflow
+	unsigned int a = 1, b = 0;
+	size_t left = rawSize, blockLeft = 0;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = pixels + rowBytes * y;
+		// The filter byte (0) then the row, split between stored blocks of at most 65535 bytes
+		for (size_t i = 0; i <= rowBytes;)
+		{
+			if (blockLeft == 0)
+			{
+				blockLeft = left < 65535 ? left : 65535;
+				left -= blockLeft;
+				unsigned char blockHeader[5] = { (unsigned char)(left == 0 ? 1 : 0), (unsigned char)blockLeft, (unsigned char)(blockLeft >> 8),
+					(unsigned char)~blockLeft, (unsigned char)(~blockLeft >> 8) };
+				png.insert(png.end(), blockHeader, blockHeader + 5);
+			}
+			if (i == 0)
+			{
+				png.push_back(0);
+				b = (b + a) % 65521;
+				i++;
+				blockLeft--;
+				continue;
+			}
+			size_t count = rowBytes + 1 - i < blockLeft ? rowBytes + 1 - i : blockLeft;
+			const unsigned char* data = row + i - 1;
+			png.insert(png.end(), data, data + count);
+			for (size_t k = 0; k < count;)
+			{
+				size_t end = count - k < 5552 ? count : k + 5552;
+				for (; k < end; k++)
+				{
+					a += data[k];
+					b += a;
+				}
+				a %= 65521;
+				b %= 65521;
+			}
+			i += count;
+			blockLeft -= count;
+		}
+	}
+	putBigEndian(png, (b << 16) | a);
+	endChunk(png, chunk);
+
+	chunk = beginChunk(png, "IEND");
+	endChunk(png, chunk);
+	return true;
+}
+
+bool writePNG(const char* filename, int width, int height, int channels, const unsigned char* pixels)
+{
+	std::vector<unsigned char> png;
+	if (!encodePNG(width, height, channels, pixels, png))
+		return false;
+	FILE* file = fopen(filename, "wb");
+	if (file == NULL)
+		return false;
+	bool written = fwrite(&png[0], 1, png.size(), file) == png.size();
+	return fclose(file) == 0 && written;
+}
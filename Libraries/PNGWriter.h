@@ -0,0 +1,15 @@
+#ifndef _PNG_WRITER_H
+#define _PNG_WRITER_H
+
+#include <vector>
+
+/**
+ * @brief      PNG encoding of 8 bit pixels (1 to 4 channels: grey, grey alpha, RGB, RGBA), rows top first
+ * @details    The image data is a zlib stream of stored deflate blocks: no filtering or compression, so encoding
+ *             costs about a copy and two checksums, and files are as large as the pixels.
+ * @return     false if the image is invalid (or the file cannot be written)
+ */
+bool encodePNG(int width, int height, int channels, const unsigned char* pixels, std::vector<unsigned char>& png);
+bool writePNG(const char* filename, int width, int height, int channels, const unsigned char* pixels);
+
+#endif
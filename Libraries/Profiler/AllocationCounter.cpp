@@ -0,0 +1,81 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long long> g_Allocations(0);
+
+long long getAllocationCount()
+{
+	return g_Allocations.load(std::memory_order_relaxed);
+}
+
+#ifdef PROFILE_ALLOCATIONS
+
+bool isAllocationCountEnabled()
+{
+	return true;
+}
+
+// The array and nothrow variants of the standard library forward to these
+void* operator new(std::size_t size)
+{
+	g_Allocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = std::malloc(size == 0 ? 1 : size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+#ifdef __cpp_aligned_new
+// Over-aligned types (C++17), freed by the aligned deletes only
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	g_Allocations.fetch_add(1, std::memory_order_relaxed);
+	std::size_t align = (std::size_t)alignment < sizeof(void*) ? sizeof(void*) : (std::size_t)alignment;
+#ifdef _WIN32
+	void* p = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+	void* p = NULL;
+	if (posix_memalign(&p, align, size == 0 ? 1 : size) != 0)
+		p = NULL;
+#endif
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(p, alignment);
+}
+#endif
+
+#else
+
+bool isAllocationCountEnabled()
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef _ALLOCATION_COUNTER_H
+#define _ALLOCATION_COUNTER_H
+
+/**
+ * @brief Number of calls to the global operator new since the start of the program
+ * @details Only counted in the builds defining PROFILE_ALLOCATIONS (the PROFILE_ALLOCATIONS CMake option, always on for
+ *          the benchmarks), which replace the global operator new and delete: 0 otherwise. The count is a relaxed
+ *          atomic increment. Differences between two calls give the allocations of the code in between (see the
+ *          "Allocations" counter of the Profiler).
+ */
+long long getAllocationCount();
+
+// true if the build counts the allocations
+bool isAllocationCountEnabled();
+
+#endif
@@ -0,0 +1,425 @@
+#include "Profiler.h"
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <glad/glad.h>
+#include "imgui/imgui.h"
+
+void Profiler::History::add(float v)
+{
+	if ((int)values.size() < HistorySize)
+		values.push_back(v);
+	else
+		values[next] = v;
+	next = (next + 1) % HistorySize;
+}
+
+float Profiler::History::last() const
+{
+	if (values.empty())
+		return 0.0f;
+	return values[(next + HistorySize - 1) % HistorySize];
+}
+
+void Profiler::History::stats(float& min, float& avg, float& p99) const
+{
+	min = avg = p99 = 0.0f;
+	if (values.empty())
+		return;
+	std::vector<float> sorted(values);
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0.0;
+	for (size_t i = 0; i < sorted.size(); i++)
+		sum += sorted[i];
+	min = sorted[0];
+	avg = (float)(sum / sorted.size());
+	p99 = sorted[std::min(sorted.size() - 1, (size_t)std::ceil(0.99 * sorted.size()) - 1)];
+}
+
+Profiler::Profiler()
+{
+	enabled = true;
+	show_interface = false;
+	m_Current = -1;
+	m_Open = -1;
+	m_FrameCount = 0;
+	m_FrameAllocations = 0;
+	m_MeasuredFrames = 0;
+	m_Dropped = 0;
+	m_GPUEnabled = false;
+	m_Paused = false;
+	for (int i = 0; i < QueryLatency; i++)
+	{
+		m_Frames[i].usedQueries = 0;
+		m_Frames[i].duration = 0.0;
+	}
+	m_LastFrame.usedQueries = 0;
+	m_LastFrame.duration = 0.0;
+}
+
+Profiler::~Profiler()
+{
+	for (int i = 0; i < QueryLatency; i++)
+		if (!m_Frames[i].queries.empty())
+			glDeleteQueries((GLsizei)m_Frames[i].queries.size(), &m_Frames[i].queries[0]);
+}
+
+double Profiler::now() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_FrameStart).count();
+}
+
+void Profiler::beginFrame()
+{
+	if (m_Current >= 0)
+		endFrame();
+	if (!enabled)
+		return;
+
+	m_FrameCount++;
+	m_Current = (int)(m_FrameCount % QueryLatency);
+	FrameData& frame = m_Frames[m_Current];
+
+	// The pool is reused : the queries issued QueryLatency frames ago must be read first
+	resolveQueries(frame);
+
+	frame.records.clear();
+	frame.usedQueries = 0;
+	m_Open = -1;
+	m_FrameStart = std::chrono::high_resolution_clock::now();
+	m_FrameAllocations = getAllocationCount();
+}
+
+void Profiler::endFrame()
+{
+	if (m_Current < 0)
+		return;
+
+	while (m_Open >= 0)
+		endZone(m_Open);
+
+	FrameData& frame = m_Frames[m_Current];
+	frame.duration = now();
+	m_FrameTimes.add((float)frame.duration);
+
+	for (size_t i = 0; i < m_Zones.size(); i++)
+		m_Zones[i].calls = 0;
+
+	std::vector<double> sums;
+	for (size_t i = 0; i < frame.records.size(); i++)
+	{
+		Record& r = frame.records[i];
+		int parentZone = r.parent >= 0 ? frame.records[r.parent].zone : -1;
+		r.zone = zoneIndex(parentZone, r.name, r.depth);
+		if (sums.size() < m_Zones.size())
+			sums.resize(m_Zones.size(), 0.0);
+		sums[r.zone] += r.end - r.start;
+		m_Zones[r.zone].calls++;
+	}
+	for (size_t i = 0; i < sums.size(); i++)
+	{
+		if (m_Zones[i].calls > 0)
+		{
+			m_Zones[i].cpu.add((float)sums[i]);
+			m_Zones[i].totalCpu += sums[i];
+			m_Zones[i].totalCalls += m_Zones[i].calls;
+		}
+	}
+
+	// Heap allocations of the frame, including the ones of the profiler itself (PROFILE_ALLOCATIONS builds)
+	if (isAllocationCountEnabled())
+		addCounter("Allocations", (double)(getAllocationCount() - m_FrameAllocations));
+
+	for (size_t i = 0; i < m_Counters.size(); i++)
+	{
+		m_Counters[i].history.add((float)m_Counters[i].frameValue);
+		m_Counters[i].total += m_Counters[i].frameValue;
+		m_Counters[i].frameValue = 0.0;
+	}
+	m_MeasuredFrames++;
+
+	if (!m_Paused)
+	{
+		m_LastFrame.records = frame.records;
+		m_LastFrame.duration = frame.duration;
+	}
+	m_Current = -1;
+}
+
+int Profiler::beginZone(const char* name, bool gpu)
+{
+	if (m_Current < 0)
+		return -1;
+
+	FrameData& frame = m_Frames[m_Current];
+	if ((int)frame.records.size() >= MaxRecords)
+	{
+		m_Dropped++;
+		return -1;
+	}
+
+	Record r;
+	r.name = name;
+	r.parent = m_Open;
+	r.depth = m_Open >= 0 ? frame.records[m_Open].depth + 1 : 0;
+	r.zone = -1;
+	r.query = -1;
+
+	if (gpu && m_GPUEnabled)
+	{
+		if (frame.usedQueries + 2 > (int)frame.queries.size())
+		{
+			size_t old = frame.queries.size();
+			frame.queries.resize(std::max((size_t)32, 2 * old));
+			glCreateQueries(GL_TIMESTAMP, (GLsizei)(frame.queries.size() - old), &frame.queries[old]);
+		}
+		r.query = frame.usedQueries;
+		frame.usedQueries += 2;
+		glQueryCounter(frame.queries[r.query], GL_TIMESTAMP);
+	}
+
+	r.start = now();
+	r.end = r.start;
+	frame.records.push_back(r);
+	m_Open = (int)frame.records.size() - 1;
+	return m_Open;
+}
+
+void Profiler::endZone(int record)
+{
+	if (m_Current < 0)
+		return;
+	FrameData& frame = m_Frames[m_Current];
+	if (record < 0 || record >= (int)frame.records.size())
+		return;
+
+	Record& r = frame.records[record];
+	r.end = now();
+	if (r.query >= 0)
+		glQueryCounter(frame.queries[r.query + 1], GL_TIMESTAMP);
+	m_Open = r.parent;
+}
+
+void Profiler::resolveQueries(FrameData& frame)
+{
+	if (frame.usedQueries == 0)
+		return;
+
+	// Queries complete in order : if the last one is not available yet, skip the frame rather than waiting
+	GLint available = 0;
+	glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+
+	std::vector<double> sums(m_Zones.size(), 0.0);
+	std::vector<bool> measured(m_Zones.size(), false);
+	for (size_t i = 0; i < frame.records.size(); i++)
+	{
+		const Record& r = frame.records[i];
+		if (r.query < 0 || r.zone < 0)
+			continue;
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(frame.queries[r.query], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.queries[r.query + 1], GL_QUERY_RESULT, &end);
+		sums[r.zone] += (double)(end - begin) * 1e-6;
+		measured[r.zone] = true;
+	}
+	for (size_t i = 0; i < sums.size(); i++)
+		if (measured[i])
+			m_Zones[i].gpu.add((float)sums[i]);
+}
+
+int Profiler::zoneIndex(int parent, const char* name, int depth)
+{
+	// Keyed on the interned label, not on the pointer: the same label from another pointer (an other translation
+	// unit, a copied name...) is the same zone, and a pointer reused for another label is not
+	std::pair<int, StringId> key(parent, StringId(name));
+	std::map<std::pair<int, StringId>, int>::iterator it = m_ZoneLookup.find(key);
+	if (it != m_ZoneLookup.end())
+		return it->second;
+
+	Zone z;
+	z.name = name;
+	z.parent = parent;
+	z.depth = depth;
+	z.calls = 0;
+	z.totalCpu = 0.0;
+	z.totalCalls = 0;
+	m_Zones.push_back(z);
+	int index = (int)m_Zones.size() - 1;
+	m_ZoneLookup[key] = index;
+	return index;
+}
+
+void Profiler::addCounter(const char* name, double value)
+{
+	if (m_Current < 0)
+		return;
+
+	for (size_t i = 0; i < m_Counters.size(); i++)
+	{
+		if (m_Counters[i].label == name || m_Counters[i].name.compare(name) == 0)
+		{
+			m_Counters[i].frameValue += value;
+			return;
+		}
+	}
+
+	Counter c;
+	c.name = name;
+	c.label = name;
+	c.frameValue = value;
+	c.total = 0.0;
+	m_Counters.push_back(c);
+}
+
+void Profiler::resetStatistics()
+{
+	for (size_t i = 0; i < m_Zones.size(); i++)
+	{
+		m_Zones[i].cpu = History();
+		m_Zones[i].gpu = History();
+		m_Zones[i].totalCpu = 0.0;
+		m_Zones[i].totalCalls = 0;
+	}
+	for (size_t i = 0; i < m_Counters.size(); i++)
+	{
+		m_Counters[i].history = History();
+		m_Counters[i].total = 0.0;
+	}
+	m_FrameTimes = History();
+	m_MeasuredFrames = 0;
+	m_Dropped = 0;
+}
+
+int Profiler::findZone(const std::string& name, int parent) const
+{
+	for (size_t i = 0; i < m_Zones.size(); i++)
+		if (m_Zones[i].parent == parent && m_Zones[i].name == name)
+			return (int)i;
+	return -1;
+}
+
+void Profiler::drawZoneRows(int parent)
+{
+	for (size_t i = 0; i < m_Zones.size(); i++)
+	{
+		const Zone& z = m_Zones[i];
+		if (z.parent != parent)
+			continue;
+
+		float min, avg, p99;
+		z.cpu.stats(min, avg, p99);
+		ImGui::Text("%*s%s", 2 * z.depth, "", z.name.c_str());
+		ImGui::NextColumn();
+		ImGui::Text("%d", z.calls);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f / %.3f / %.3f", min, avg, p99);
+		ImGui::NextColumn();
+		if (z.gpu.values.empty())
+			ImGui::Text("-");
+		else
+		{
+			z.gpu.stats(min, avg, p99);
+			ImGui::Text("%.3f / %.3f / %.3f", min, avg, p99);
+		}
+		ImGui::NextColumn();
+
+		drawZoneRows((int)i);
+	}
+}
+
+void Profiler::drawTimeline(const FrameData& frame)
+{
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	int maxDepth = 0;
+	for (size_t i = 0; i < frame.records.size(); i++)
+		maxDepth = std::max(maxDepth, frame.records[i].depth);
+
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = std::max(ImGui::GetContentRegionAvailWidth(), 1.0f);
+	float height = (maxDepth + 1) * rowHeight;
+	ImGui::InvisibleButton("##timeline", ImVec2(width, height));
+	if (frame.duration <= 0.0)
+		return;
+
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	float scale = width / (float)frame.duration;
+	for (size_t i = 0; i < frame.records.size(); i++)
+	{
+		const Record& r = frame.records[i];
+		ImVec2 a(origin.x + (float)r.start * scale, origin.y + r.depth * rowHeight);
+		ImVec2 b(origin.x + std::max((float)r.end * scale, (float)r.start * scale + 1.0f), a.y + rowHeight - 1.0f);
+
+		// Stable color per zone
+		float hue = (float)((r.zone * 0.618034f) - std::floor(r.zone * 0.618034f));
+		drawList->AddRectFilled(a, b, ImColor::HSV(hue, 0.5f, 0.7f));
+		if (b.x - a.x > ImGui::CalcTextSize(r.name).x + 4.0f)
+			drawList->AddText(ImVec2(a.x + 2.0f, a.y), ImColor(0.0f, 0.0f, 0.0f), r.name);
+
+		if (ImGui::IsMouseHoveringRect(a, b))
+			ImGui::SetTooltip("%s\n%.3f ms", r.name, r.end - r.start);
+	}
+}
+
+void Profiler::Draw(const char* title)
+{
+	ImGui::SetNextWindowSize(ImVec2(700, 500), ImGuiSetCond_FirstUseEver);
+	if (!ImGui::Begin(title, &show_interface))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Checkbox("Enabled", &enabled);
+	ImGui::SameLine();
+	ImGui::Checkbox("Pause timeline", &m_Paused);
+	ImGui::SameLine();
+	ImGui::Text("GPU timers : %s", m_GPUEnabled ? "on" : "off");
+	if (m_Dropped > 0)
+	{
+		ImGui::SameLine();
+		ImGui::Text("(%d zones dropped)", m_Dropped);
+	}
+
+	// Rolling frame times
+	if (!m_FrameTimes.values.empty())
+	{
+		float min, avg, p99;
+		m_FrameTimes.stats(min, avg, p99);
+		char overlay[64];
+		sprintf(overlay, "frame : min %.2f avg %.2f p99 %.2f ms", min, avg, p99);
+		int offset = (int)m_FrameTimes.values.size() < HistorySize ? 0 : m_FrameTimes.next;
+		ImGui::PlotLines("##frametimes", &m_FrameTimes.values[0], (int)m_FrameTimes.values.size(), offset, overlay, 0.0f, 2.0f * p99, ImVec2(ImGui::GetContentRegionAvailWidth(), 60.0f));
+	}
+
+	for (size_t i = 0; i < m_Counters.size(); i++)
+	{
+		float min, avg, p99;
+		m_Counters[i].history.stats(min, avg, p99);
+		ImGui::Text("%s : %.0f (avg %.1f, p99 %.0f)", m_Counters[i].name.c_str(), m_Counters[i].history.last(), avg, p99);
+	}
+
+	// Flame graph of the last completed frame
+	ImGui::Text("Last frame : %.3f ms", m_LastFrame.duration);
+	drawTimeline(m_LastFrame);
+
+	ImGui::Separator();
+	ImGui::Columns(4, "zones");
+	ImGui::Text("Zone");
+	ImGui::NextColumn();
+	ImGui::Text("Calls");
+	ImGui::NextColumn();
+	ImGui::Text("CPU min / avg / p99 (ms)");
+	ImGui::NextColumn();
+	ImGui::Text("GPU min / avg / p99 (ms)");
+	ImGui::NextColumn();
+	ImGui::Separator();
+	drawZoneRows(-1);
+	ImGui::Columns(1);
+
+	ImGui::End();
+}
@@ -0,0 +1,185 @@
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "Singleton.h"
+#include "StringId.h"
+
+/**
+ * @brief      Hierarchical CPU/GPU frame profiler
+ * @details    Zones are opened and closed in a stack (see ProfileZone and the PROFILE_ZONE macros) between
+ *             beginFrame() and endFrame(). CPU times are measured with the high resolution clock. GPU zones also
+ *             write two GL_TIMESTAMP queries, taken from a pool per frame in flight. A pool is read back QueryLatency
+ *             frames later, and only if its results are available, so the profiler never stalls the pipeline.
+ *             Zones with the same name under the same parent are merged in the statistics.
+ */
+class Profiler : public Singleton<Profiler>
+{
+	friend class Singleton<Profiler>;
+public:
+	static const int HistorySize = 300;		// Frames kept for the statistics
+	static const int QueryLatency = 4;		// Frames between a GPU zone and the read back of its queries
+	static const int MaxRecords = 8192;		// Zones recorded per frame, the following ones are dropped
+
+	// Rolling window of per frame samples
+	struct History
+	{
+		std::vector<float> values;
+		int next;
+
+		History() : next(0) {}
+		void add(float v);
+		float last() const;
+		void stats(float& min, float& avg, float& p99) const;
+	};
+
+	struct Zone
+	{
+		std::string name;
+		int parent;			// Parent zone, -1 for the top level zones
+		int depth;
+		int calls;			// Number of calls during the last completed frame
+		History cpu;		// Milliseconds per frame, summed over the calls
+		History gpu;
+		double totalCpu;	// Milliseconds since the last statistics reset
+		long long totalCalls;
+	};
+
+	// Value accumulated during each frame (draw calls, triangles...)
+	struct Counter
+	{
+		std::string name;
+		const char* label;	// Pointer given to addCounter, for a fast lookup
+		double frameValue;	// Accumulated during the current frame
+		History history;
+		double total;		// Sum since the last statistics reset
+	};
+
+	// A zone occurrence in a frame
+	struct Record
+	{
+		const char* name;
+		int parent;			// Enclosing record, -1 for the top level
+		int depth;
+		int zone;			// Set when the frame ends
+		double start, end;	// CPU milliseconds from the beginning of the frame
+		int query;			// First of the two timestamp queries, -1 for CPU only zones
+	};
+
+	/**
+	 * @brief Start recording a frame, and read back the GPU queries of the frame that used the same pool
+	 */
+	void beginFrame();
+	/**
+	 * @brief Close the frame (zones still open are closed) and update the CPU statistics
+	 */
+	void endFrame();
+
+	/**
+	 * @brief Open a zone, nested in the currently open one
+	 * @param name zone label, must stay valid until the end of the frame (a literal or a persistent object name)
+	 * @param gpu also measure the GPU time between this call and endZone
+	 * @return handle to give to endZone, -1 if nothing is recorded
+	 */
+	int beginZone(const char* name, bool gpu = false);
+	void endZone(int record);
+
+	/**
+	 * @brief Add value to a per frame counter of the current frame
+	 * @param name counter label, a literal
+	 */
+	void addCounter(const char* name, double value);
+
+	/**
+	 * @brief Clear the histories and totals (zones and counters are kept), e.g. after warm up frames
+	 */
+	void resetStatistics();
+
+	// Profiling can be switched off at runtime, the zones then cost a single test
+	bool enabled;
+	// GPU queries are only issued when an OpenGL context is available
+	void setGPUEnabled(bool gpu) { m_GPUEnabled = gpu; }
+
+	const std::vector<Zone>& getZones() const { return m_Zones; }
+	const std::vector<Counter>& getCounters() const { return m_Counters; }
+	const History& getFrameTimes() const { return m_FrameTimes; }
+	/**
+	 * @brief Zone with the given name and parent (-1 for the top level), -1 if not found
+	 */
+	int findZone(const std::string& name, int parent = -1) const;
+	long long getFrameCount() const { return m_FrameCount; }
+	/**
+	 * @brief Number of frames recorded since the last statistics reset
+	 */
+	long long getMeasuredFrames() const { return m_MeasuredFrames; }
+
+	bool show_interface;
+	void Draw(const char* title);
+
+private:
+	Profiler();
+	~Profiler();
+
+	struct FrameData
+	{
+		std::vector<Record> records;
+		std::vector<unsigned int> queries;
+		int usedQueries;
+		double duration;
+	};
+
+	double now() const;
+	int zoneIndex(int parent, const char* name, int depth);
+	void resolveQueries(FrameData& frame);
+	void drawZoneRows(int parent);
+	void drawTimeline(const FrameData& frame);
+
+	std::vector<Zone> m_Zones;
+	std::map<std::pair<int, StringId>, int> m_ZoneLookup;
+	std::vector<Counter> m_Counters;
+	History m_FrameTimes;
+	long long m_MeasuredFrames;
+
+	FrameData m_Frames[QueryLatency];
+	FrameData m_LastFrame;		// Copy of the last completed frame for the timeline
+	int m_Current;				// Index of the frame being recorded, -1 outside of a frame
+	int m_Open;					// Innermost open record
+	long long m_FrameCount;
+	long long m_FrameAllocations;	// Allocation count at the beginning of the frame
+	int m_Dropped;
+	bool m_GPUEnabled;
+	bool m_Paused;
+	std::chrono::time_point<std::chrono::high_resolution_clock> m_FrameStart;
+};
+
+/**
+ * @brief      Scoped profiling zone
+ */
+class ProfileZone
+{
+public:
+	ProfileZone(const char* name, bool gpu = false)
+	{
+		m_Record = Profiler::getInstance()->beginZone(name, gpu);
+	}
+	~ProfileZone()
+	{
+		if (m_Record >= 0)
+			Profiler::getInstance()->endZone(m_Record);
+	}
+private:
+	int m_Record;
+};
+
+#ifndef PROFILE_DEFINITION
+#define PROFILE_DEFINITION
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name, true)
+#endif
+
+#endif
@@ -1,73 +1,227 @@
 #ifndef _RESOURCE_MGR
 #define _RESOURCE_MGR
 
-#include <map>
+#include <unordered_map>
+#include <vector>
 #include <stdexcept>
 #include <iostream>
 #include "Logger/ImGuiLogger.h"
+#include "StringId.h"
 using namespace std;
 
+/**
+ * @brief      Reference to a resource of a Resource_mgr, valid until the resource is released
+ * @details    The generation of the slot changes on each release, so a handle to a released resource is detected
+ *             instead of reaching the resource created afterwards in the same slot.
+ */
+struct ResourceHandle
+{
+	unsigned int index;			// Slot of the resource
+	unsigned int generation;	// 0 for the null handle
+
+	ResourceHandle() : index(0), generation(0) {}
+	ResourceHandle(unsigned int i, unsigned int g) : index(i), generation(g) {}
+	bool isNull() const { return generation == 0; }
+	bool operator==(const ResourceHandle& h) const { return index == h.index && generation == h.generation; }
+	bool operator!=(const ResourceHandle& h) const { return !(*this == h); }
+};
+
+/**
+ * @brief      Handle whose resource type has been checked when the handle was created, accessed without dynamic_cast
+ */
+template <typename R> struct TypedResourceHandle
+{
+	ResourceHandle handle;
+	bool isNull() const { return handle.isNull(); }
+};
+
+/**
+ * @brief      Named and reference counted resources
+ * @details    Generational slot map: resources are stored densely (iteration and access by index are O(1), the order
+ *             being the insertion order until a release moves the last resource in the freed place), slots map handles
+ *             to dense positions and a hash map indexes the names. Names are interned (see StringId): the StringId
+ *             overloads avoid hashing and copying strings, the std::string ones intern their argument first.
+ */
 template <typename T> class Resource_mgr
 {
 public:
+	typedef typename vector<T*>::const_iterator const_iterator;
+
 	Resource_mgr();
 	~Resource_mgr () ;
 
-	T* get(string a);
-	void  insert(string a,T* elt);
-	void release(string a);
-	T* find(string a);
-	template <typename R> R* get(string a);
+	// Get the resource named a, creating it (as new T(a) or new R(a)) if it does not exist, and add a reference to it
+	T* get(StringId a);
+	template <typename R> R* get(StringId a);
+	// Add elt under the name a if there is no resource of that name, with the given reference count
+	void  insert(StringId a,T* elt, int references = 0);
+	// Remove a reference to the resource named a, deleting it when no reference is left
+	void release(StringId a);
+	T* find(StringId a);
+	// Reference count of the resource named a, 0 if there is none
+	int getReferences(StringId a);
 	T* get(int a);
 	int size();
-	T* nextObject(string a);
+	// Make room for count resources, before creating many of them
+	void reserve(int count);
+	T* nextObject(StringId a);
+
+	T* get(const string& a) { return get(StringId(a)); }
+	template <typename R> R* get(const string& a) { return get<R>(StringId(a)); }
+	void insert(const string& a, T* elt, int references = 0) { insert(StringId(a), elt, references); }
+	void release(const string& a) { release(StringId(a)); }
+	T* find(const string& a) { return find(StringId(a)); }
+	T* nextObject(const string& a) { return nextObject(StringId(a)); }
+
+	/**
+	 * @brief Handle of the resource named a, null handle if there is none. Does not add a reference.
+	 */
+	ResourceHandle getHandle(StringId a);
+	/**
+	 * @brief Typed handle of the resource named a, null handle if there is none or if it is not a R
+	 */
+	template <typename R> TypedResourceHandle<R> getHandle(StringId a);
+	ResourceHandle getHandle(const string& a) { return getHandle(StringId(a)); }
+	template <typename R> TypedResourceHandle<R> getHandle(const string& a) { return getHandle<R>(StringId(a)); }
+	ResourceHandle getHandle(int a);
+
+	// Resource of a handle, NULL if the resource has been released
+	T* get(ResourceHandle h);
+	template <typename R> R* get(TypedResourceHandle<R> h);
+	bool isValid(ResourceHandle h) const;
+
+	const string& getName(int a) const { return m_Names[a].str(); }
+	StringId getId(int a) const { return m_Names[a]; }
+
+	const_iterator begin() const { return m_Objects.begin(); }
+	const_iterator end() const { return m_Objects.end(); }
 
 private:
+	static const unsigned int NoSlot = 0xffffffffu;
+
+	struct Slot
+	{
+		unsigned int dense;			// Position in the dense arrays, next free slot when the slot is free
+		unsigned int generation;
+	};
 
-	map< string , pair< T* , int > > rscmap;
+	ResourceHandle add(StringId a, T* elt, int references);
+	void remove(unsigned int slot);
+
+	// Dense arrays, indexed by the resource position
+	vector<T*> m_Objects;
+	vector<StringId> m_Names;
+	vector<int> m_References;
+	vector<unsigned int> m_Slots;
+
+	vector<Slot> m_SlotTable;
+	unsigned int m_FreeSlot;
+	unordered_map<StringId, unsigned int> m_Index;	// Name to slot
 
 };
 template <typename T>
-Resource_mgr<T>::Resource_mgr() 
+Resource_mgr<T>::Resource_mgr() : m_FreeSlot(NoSlot)
 {
 
 }
 
 template <typename T>
-Resource_mgr<T>::~Resource_mgr () 
+Resource_mgr<T>::~Resource_mgr ()
 {
-	for (typename map<string, pair< T*, int > >::iterator it = rscmap.begin(); it != rscmap.end(); it++)
+	for (size_t i = 0; i < m_Objects.size(); i++)
 	{
-		if ((*it).second.first != NULL)
+		if (m_Objects[i] != NULL)
 		{
-			delete (*it).second.first;
-			(*it).second.first = NULL;
+			delete m_Objects[i];
+			m_Objects[i] = NULL;
 		}
 	}
-		
+}
+
+template <typename T>
+int Resource_mgr<T>::size()
+{
+	return (int)m_Objects.size();
+}
+
+template <typename T>
+void Resource_mgr<T>::reserve(int count)
+{
+	if (count <= 0)
+		return;
+	m_Objects.reserve(count);
+	m_Names.reserve(count);
+	m_References.reserve(count);
+	m_Slots.reserve(count);
+	m_SlotTable.reserve(count);
+	m_Index.reserve(count);
+}
+
+template <typename T>
+ResourceHandle Resource_mgr<T>::add(StringId a, T* elt, int references)
+{
+	unsigned int slot;
+	if (m_FreeSlot != NoSlot)
+	{
+		slot = m_FreeSlot;
+		m_FreeSlot = m_SlotTable[slot].dense;
+	}
+	else
+	{
+		slot = (unsigned int)m_SlotTable.size();
+		Slot s = { 0, 1 };
+		m_SlotTable.push_back(s);
+	}
+	m_SlotTable[slot].dense = (unsigned int)m_Objects.size();
 
-	rscmap.clear();
+	m_Objects.push_back(elt);
+	m_Names.push_back(a);
+	m_References.push_back(references);
+	m_Slots.push_back(slot);
+	m_Index.insert(make_pair(a, slot));
 
+	return ResourceHandle(slot, m_SlotTable[slot].generation);
 }
 
 template <typename T>
-int Resource_mgr<T>::size() 
+void Resource_mgr<T>::remove(unsigned int slot)
 {
-	return (int)rscmap.size();
+	// The last resource takes the place of the removed one
+	unsigned int dense = m_SlotTable[slot].dense;
+	unsigned int last = (unsigned int)m_Objects.size() - 1;
+	m_Index.erase(m_Names[dense]);
+	if (dense != last)
+	{
+		m_Objects[dense] = m_Objects[last];
+		m_Names[dense] = m_Names[last];
+		m_References[dense] = m_References[last];
+		m_Slots[dense] = m_Slots[last];
+		m_SlotTable[m_Slots[dense]].dense = dense;
+	}
+	m_Objects.pop_back();
+	m_Names.pop_back();
+	m_References.pop_back();
+	m_Slots.pop_back();
+
+	// Generation 0 is kept for null handles
+	Slot& s = m_SlotTable[slot];
+	s.generation = (s.generation + 1 == 0) ? 1 : s.generation + 1;
+	s.dense = m_FreeSlot;
+	m_FreeSlot = slot;
 }
 
-template <typename T> 
+template <typename T>
 template <typename R>
-R* Resource_mgr<T>::get(string a)
+R* Resource_mgr<T>::get(StringId a)
 {
 	R* to_ret = NULL;
-	typename map<string , pair< T* , int > >::iterator it = rscmap.find(a);
-	if (it == rscmap.end())
+	typename unordered_map<StringId, unsigned int>::iterator it = m_Index.find(a);
+	if (it == m_Index.end())
 	{
 		try
 		{
-			LOG_TRACE << "Creating New " << a << std::endl;
-			to_ret = new R(a);
+			LOG_TRACE << "Creating New " << a.str() << std::endl;
+			to_ret = new R(a.str());
 
 		}
 		catch(const std::exception & e )
@@ -75,14 +229,15 @@ R* Resource_mgr<T>::get(string a)
 			LOG_WARNING << "ERROR RSCMGR : " << e.what() << std::endl;
 			return NULL;
 		}
-		rscmap.insert(make_pair(a , make_pair(to_ret,1)));
+		add(a, to_ret, 1);
 	}
 	else
 	{
-		to_ret = dynamic_cast <R*> ((*it).second.first);
+		unsigned int dense = m_SlotTable[it->second].dense;
+		to_ret = dynamic_cast <R*> (m_Objects[dense]);
 		if (!to_ret)
 			LOG_WARNING << "ERROR RSCMGR : Type conversion " << std::endl;
-		(*it).second.second++;
+		m_References[dense]++;
 	}
 
 	return to_ret;
@@ -94,28 +249,29 @@ R* Resource_mgr<T>::get(string a)
 
 
 template <typename T>
-T* Resource_mgr<T>::get(string a)
+T* Resource_mgr<T>::get(StringId a)
 {
 	T* to_ret = NULL;
-	typename map<string , pair< T* , int > >::iterator it = rscmap.find(a);
-	if (it == rscmap.end())
+	typename unordered_map<StringId, unsigned int>::iterator it = m_Index.find(a);
+	if (it == m_Index.end())
 	{
 		try
 		{
-			LOG_TRACE << "Creating New " << a << std::endl;
-			to_ret = new T(a);
+			LOG_TRACE << "Creating New " << a.str() << std::endl;
+			to_ret = new T(a.str());
 		}
 		catch(const std::exception & e )
 		{
 			LOG_WARNING << "ERROR RSCMGR : " << e.what() << std::endl;
 			return NULL;
 		}
-		rscmap.insert(make_pair(a , make_pair(to_ret,1)));
+		add(a, to_ret, 1);
 	}
 	else
 	{
-		to_ret = (*it).second.first;
-		(*it).second.second++;
+		unsigned int dense = m_SlotTable[it->second].dense;
+		to_ret = m_Objects[dense];
+		m_References[dense]++;
 	}
 
 	return to_ret;
@@ -123,31 +279,23 @@ T* Resource_mgr<T>::get(string a)
 template <typename T>
 T* Resource_mgr<T>::get(int a)
 {
-	T* to_ret = NULL;
-	if (a >= (int) rscmap.size())
-		return to_ret;
-
-	typename map<string , pair< T* , int > >::iterator it =rscmap.begin();
-	for (int i = 0;i < a ;i++)
-		++it;
-	to_ret = (*it).second.first;
-
-
-	return to_ret;
+	if (a < 0 || a >= (int) m_Objects.size())
+		return NULL;
+	return m_Objects[a];
 }
 
 template <typename T>
-T* Resource_mgr<T>::nextObject(string a)
+T* Resource_mgr<T>::nextObject(StringId a)
 {
+	if (m_Objects.empty())
+		return NULL;
 
-	typename map<string , pair< T* , int > >::iterator it_elt = rscmap.find(a);
-	if (it_elt != rscmap.end())
-		it_elt = std::next(it_elt);
-	if (it_elt == rscmap.end())
-		it_elt = rscmap.begin();
-
+	unsigned int next = 0;
+	typename unordered_map<StringId, unsigned int>::iterator it = m_Index.find(a);
+	if (it != m_Index.end())
+		next = (m_SlotTable[it->second].dense + 1) % (unsigned int)m_Objects.size();
 
-	return (*it_elt).second.first;
+	return m_Objects[next];
 
 
 }
@@ -159,41 +307,104 @@ T* Resource_mgr<T>::nextObject(string a)
 
 
 template <typename T>
-void Resource_mgr<T>::insert(string a,T* elt)
+void Resource_mgr<T>::insert(StringId a,T* elt, int references)
 {
-	typename map<string , pair< T* , int > >::iterator it = rscmap.find(a);
-	if (it == rscmap.end())
-		rscmap.insert(make_pair(a , make_pair(elt,0)));
+	if (m_Index.find(a) == m_Index.end())
+		add(a, elt, references);
 }
 
 
 
 
 template <typename T>
-T* Resource_mgr<T>::find(string a)
+T* Resource_mgr<T>::find(StringId a)
 {
 	T* to_ret = NULL;
-	typename map<string , pair< T* , int > >::iterator it = rscmap.find(a);
-	if (it != rscmap.end())
-		to_ret = (*it).second.first;
+	typename unordered_map<StringId, unsigned int>::iterator it = m_Index.find(a);
+	if (it != m_Index.end())
+		to_ret = m_Objects[m_SlotTable[it->second].dense];
 
 	return to_ret;
 }
 template <typename T>
-void Resource_mgr<T>::release(string a)
+int Resource_mgr<T>::getReferences(StringId a)
 {
-	typename map<string , pair< T* , int > >::iterator it = rscmap.find(a);
-	if (it != rscmap.end())
+	typename unordered_map<StringId, unsigned int>::iterator it = m_Index.find(a);
+	if (it == m_Index.end())
+		return 0;
+	return m_References[m_SlotTable[it->second].dense];
+}
+
+template <typename T>
+void Resource_mgr<T>::release(StringId a)
+{
+	typename unordered_map<StringId, unsigned int>::iterator it = m_Index.find(a);
+	if (it != m_Index.end())
 	{
-		(*it).second.second--;
-		if ((*it).second.second <= 0)
+		unsigned int slot = it->second;
+		unsigned int dense = m_SlotTable[slot].dense;
+		m_References[dense]--;
+		if (m_References[dense] <= 0)
 		{
-			delete (*it).second.first;
-			rscmap.erase(it);
+			T* elt = m_Objects[dense];
+			// Removed before the deletion, which may release other resources of this manager
+			remove(slot);
+			delete elt;
 		}
 	}
 }
 
+template <typename T>
+ResourceHandle Resource_mgr<T>::getHandle(StringId a)
+{
+	typename unordered_map<StringId, unsigned int>::iterator it = m_Index.find(a);
+	if (it == m_Index.end())
+		return ResourceHandle();
+	return ResourceHandle(it->second, m_SlotTable[it->second].generation);
+}
+
+template <typename T>
+template <typename R>
+TypedResourceHandle<R> Resource_mgr<T>::getHandle(StringId a)
+{
+	TypedResourceHandle<R> h;
+	ResourceHandle untyped = getHandle(a);
+	if (!untyped.isNull() && dynamic_cast<R*>(get(untyped)) != NULL)
+		h.handle = untyped;
+	return h;
+}
+
+template <typename T>
+ResourceHandle Resource_mgr<T>::getHandle(int a)
+{
+	if (a < 0 || a >= (int) m_Objects.size())
+		return ResourceHandle();
+	unsigned int slot = m_Slots[a];
+	return ResourceHandle(slot, m_SlotTable[slot].generation);
+}
+
+template <typename T>
+bool Resource_mgr<T>::isValid(ResourceHandle h) const
+{
+	return h.generation != 0 && h.index < m_SlotTable.size() && m_SlotTable[h.index].generation == h.generation;
+}
+
+template <typename T>
+T* Resource_mgr<T>::get(ResourceHandle h)
+{
+	if (!isValid(h))
+		return NULL;
+	return m_Objects[m_SlotTable[h.index].dense];
+}
+
+template <typename T>
+template <typename R>
+R* Resource_mgr<T>::get(TypedResourceHandle<R> h)
+{
+	// The type was checked by getHandle<R>, and a slot only holds another resource after a generation change
+	return static_cast<R*>(get(h.handle));
+}
+
 
 
 
@@ -0,0 +1,112 @@
+#include "StringId.h"
+
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	const uint32_t NoId = 0xffffffffu;
+
+	// Strings are never removed, so the references returned by StringId::str stay valid
+	class StringTable
+	{
+	public:
+		StringTable()
+		{
+			intern("", 0, hashString("", 0));
+		}
+
+		uint32_t intern(const char* s, size_t length, uint32_t hash)
+		{
+			{
+				std::shared_lock<std::shared_timed_mutex> lock(m_Mutex);
+				uint32_t id = lookup(s, length, hash);
+				if (id != NoId)
+					return id;
+			}
+			std::unique_lock<std::shared_timed_mutex> lock(m_Mutex);
+			// Another thread may have added the string between the two locks
+			uint32_t id = lookup(s, length, hash);
+			if (id != NoId)
+				return id;
+
+			id = (uint32_t)m_Strings.size();
+			m_Strings.push_back(std::string(s, length));
+			// Strings with the same hash are chained, the most recent first
+			std::unordered_map<uint32_t, uint32_t>::iterator it = m_FirstByHash.find(hash);
+			m_Next.push_back(it == m_FirstByHash.end() ? NoId : it->second);
+			m_FirstByHash[hash] = id;
+			return id;
+		}
+
+		const std::string& get(uint32_t id)
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(m_Mutex);
+			return m_Strings[id];
+		}
+
+		int count()
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(m_Mutex);
+			return (int)m_Strings.size();
+		}
+
+	private:
+		uint32_t lookup(const char* s, size_t length, uint32_t hash) const
+		{
+			std::unordered_map<uint32_t, uint32_t>::const_iterator it = m_FirstByHash.find(hash);
+			for (uint32_t id = it == m_FirstByHash.end() ? NoId : it->second; id != NoId; id = m_Next[id])
+			{
+				if (m_Strings[id].size() == length && m_Strings[id].compare(0, length, s, length) == 0)
+					return id;
+			}
+			return NoId;
+		}
+
+		std::shared_timed_mutex m_Mutex;
+		std::deque<std::string> m_Strings;					// Indexed by identifier
+		std::vector<uint32_t> m_Next;						// Next identifier with the same hash
+		std::unordered_map<uint32_t, uint32_t> m_FirstByHash;
+	};
+
+	// Created on first use, possibly during the static initialization of constant StringIds
+	StringTable& table()
+	{
+		static StringTable t;
+		return t;
+	}
+}
+
+StringId::StringId(const std::string& s) : m_Hash(hashString(s.c_str(), s.size()))
+{
+	m_Id = table().intern(s.c_str(), s.size(), m_Hash);
+}
+
+StringId::StringId(const char* s) : m_Hash(hashString(s, strlen(s)))
+{
+	m_Id = table().intern(s, strlen(s), m_Hash);
+}
+
+StringId::StringId(const StringHash& s) : m_Hash(s.hash)
+{
+	m_Id = table().intern(s.str, s.length, m_Hash);
+}
+
+StringId::StringId(const char* s, size_t length, uint32_t hash) : m_Hash(hash)
+{
+	m_Id = table().intern(s, length, m_Hash);
+}
+
+const std::string& StringId::str() const
+{
+	return table().get(m_Id);
+}
+
+int StringId::count()
+{
+	return table().count();
+}
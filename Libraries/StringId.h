@@ -0,0 +1,81 @@
+#ifndef _STRING_ID_H
+#define _STRING_ID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * @brief 32 bit FNV-1a hash of a string, evaluated at compile time for constant strings
+ */
+constexpr uint32_t hashString(const char* s, size_t length)
+{
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		h = (h ^ (uint8_t)s[i]) * 16777619u;
+	return h;
+}
+
+/**
+ * @brief      Constant string with its hash computed at compile time, written "Light"_sid
+ */
+struct StringHash
+{
+	const char* str;
+	size_t length;
+	uint32_t hash;
+
+	constexpr StringHash(const char* s, size_t l) : str(s), length(l), hash(hashString(s, l)) {}
+};
+
+constexpr StringHash operator"" _sid(const char* s, size_t length)
+{
+	return StringHash(s, length);
+}
+
+/**
+ * @brief      Interned string: a 32 bit identifier unique to the string, and its precomputed hash
+ * @details    Every distinct string gets the next identifier of a global table, kept for the whole run, so equality
+ *             and hashing never look at the characters. Creating a StringId looks the string up in the table (under
+ *             a reader-writer lock, the table can be shared between threads): constant names should be converted once,
+ *             e.g. static const StringId LightName = "Light"_sid;
+ */
+class StringId
+{
+public:
+	// Empty string
+	StringId() : m_Id(0), m_Hash(hashString("", 0)) {}
+	explicit StringId(const std::string& s);
+	explicit StringId(const char* s);
+	StringId(const StringHash& s);
+	// Characters that are not null terminated, with their hashString hash computed beforehand (e.g. stored in a file)
+	StringId(const char* s, size_t length, uint32_t hash);
+
+	uint32_t id() const { return m_Id; }
+	uint32_t hash() const { return m_Hash; }
+	// Interned string, valid until the end of the program
+	const std::string& str() const;
+	const char* c_str() const { return str().c_str(); }
+
+	bool operator==(const StringId& s) const { return m_Id == s.m_Id; }
+	bool operator!=(const StringId& s) const { return m_Id != s.m_Id; }
+	bool operator<(const StringId& s) const { return m_Id < s.m_Id; }
+
+	// Number of interned strings
+	static int count();
+
+private:
+	uint32_t m_Id;
+	uint32_t m_Hash;
+};
+
+namespace std
+{
+	template <> struct hash<StringId>
+	{
+		size_t operator()(const StringId& s) const { return s.hash(); }
+	};
+}
+
+#endif
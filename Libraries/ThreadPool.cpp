@@ -0,0 +1,67 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool()
+{
+	// Never destroyed (as the other singletons): the workers wait for work until the process exits
+	int count = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	for (int i = 0; i < count; i++)
+		m_Workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+void ThreadPool::parallelFor(int count, int threads, const std::function<void(int, int)>& f)
+{
+	if (threads <= 1 || count <= 1)
+	{
+		f(0, count);
+		return;
+	}
+	int chunk = (count + threads - 1) / threads;
+	Batch batch;
+	batch.f = &f;
+	batch.remaining = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (int begin = chunk; begin < count; begin += chunk)
+		{
+			Task task = { &batch, begin, std::min(count, begin + chunk) };
+			m_Tasks.push_back(task);
+			batch.remaining++;
+		}
+	}
+	m_TaskQueued.notify_all();
+
+	f(0, std::min(count, chunk));
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (batch.remaining > 0)
+	{
+		if (!runTask(lock))
+			m_TaskDone.wait(lock);
+	}
+}
+
+bool ThreadPool::runTask(std::unique_lock<std::mutex>& lock)
+{
+	if (m_Tasks.empty())
+		return false;
+	Task task = m_Tasks.front();
+	m_Tasks.pop_front();
+	lock.unlock();
+	(*task.batch->f)(task.begin, task.end);
+	lock.lock();
+	if (--task.batch->remaining == 0)
+		m_TaskDone.notify_all();
+	return true;
+}
+
+void ThreadPool::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	for (;;)
+	{
+		if (!runTask(lock))
+			m_TaskQueued.wait(lock);
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Singleton.h"
+
+/**
+ * @brief      Persistent worker threads running the parallel loops of the engine (BVH builds, light binning, mip
+ *             generation, block compression)
+ * @details    Workers are created once (hardware concurrency - 1) and wait for chunks of work, so that a loop run every
+ *             frame or once per mip level does not create and join threads each time. The calling thread runs the first
+ *             chunk, then helps with the queued chunks until its own are done: loops can be run from several threads
+ *             at once, and from within a chunk, without deadlocking.
+ */
+class ThreadPool : public Singleton<ThreadPool>
+{
+	friend class Singleton<ThreadPool>;
+public:
+	/**
+	 * @brief Run f(begin, end) over [0, count) split in threads chunks, and wait for them
+	 * @param threads number of chunks (the loop runs on the calling thread only if 1 or less)
+	 */
+	void parallelFor(int count, int threads, const std::function<void(int, int)>& f);
+
+	int getWorkerCount() const { return (int)m_Workers.size(); }
+
+private:
+	ThreadPool();
+
+	struct Batch
+	{
+		const std::function<void(int, int)>* f;
+		int remaining;		// Queued chunks not done yet
+	};
+	struct Task
+	{
+		Batch* batch;
+		int begin, end;
+	};
+
+	// Run the oldest queued chunk, lock held on entry and on return. false if there was none
+	bool runTask(std::unique_lock<std::mutex>& lock);
+	void workerLoop();
+
+	std::vector<std::thread> m_Workers;
+	std::deque<Task> m_Tasks;
+	std::mutex m_Mutex;
+	std::condition_variable m_TaskQueued, m_TaskDone;
+};
+
+// Shorthand for ThreadPool::getInstance()->parallelFor
+inline void parallelFor(int count, int threads, const std::function<void(int, int)>& f)
+{
+	ThreadPool::getInstance()->parallelFor(count, threads, f);
+}
+
+#endif
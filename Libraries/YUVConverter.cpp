@@ -0,0 +1,133 @@
+#include "YUVConverter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <emmintrin.h>
+
+static inline unsigned char luma(const unsigned char* p)
+{
+	return (unsigned char)(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+}
+
+static inline unsigned char chroma(int r, int g, int b, int cr, int cg, int cb)
+{
+	return (unsigned char)(((cr * r + cg * g + cb * b + 128) >> 8) + 128);
+}
+
+// Luma of the pixels x and x + 1 (if inside) of two rows, chroma of their block
+static void convertBlock(const unsigned char* row0, const unsigned char* row1, int x, int width,
+	unsigned char* luma0, unsigned char* luma1, unsigned char* u, unsigned char* v)
+{
+	int x1 = std::min(x + 1, width - 1);
+	const unsigned char* p[4] = { row0 + 4 * x, row0 + 4 * x1, row1 + 4 * x, row1 + 4 * x1 };
+	luma0[x] = luma(p[0]);
+	luma0[x1] = luma(p[1]);
+	luma1[x] = luma(p[2]);
+	luma1[x1] = luma(p[3]);
+
+	int c[3];
+	for (int i = 0; i < 3; i++)
+		c[i] = (p[0][i] + p[1][i] + p[2][i] + p[3][i] + 2) >> 2;
+	u[x / 2] = chroma(c[0], c[1], c[2], -38, -74, 112);
+	v[x / 2] = chroma(c[0], c[1], c[2], 112, -94, -18);
+}
+
+// Channels of 8 RGBA pixels as 16 bit lanes
+static inline void splitChannels(const unsigned char* pixels, __m128i& r, __m128i& g, __m128i& b)
+{
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	__m128i p0 = _mm_loadu_si128((const __m128i*)pixels);
+	__m128i p1 = _mm_loadu_si128((const __m128i*)(pixels + 16));
+	r = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+	g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask), _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+	b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask), _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+}
+
+// At most 220 * 255 + 128: fits unsigned 16 bit lanes
+static inline __m128i luma8(__m128i r, __m128i g, __m128i b)
+{
+	__m128i y = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+		_mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(128)));
+	return _mm_add_epi16(_mm_srli_epi16(y, 8), _mm_set1_epi16(16));
+}
+
+// Within +-112 * 255 + 128: fits signed 16 bit lanes
+static inline __m128i chroma8(__m128i r, __m128i g, __m128i b, short cr, short cg, short cb)
+{
+	__m128i c = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)), _mm_mullo_epi16(g, _mm_set1_epi16(cg))),
+		_mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(cb)), _mm_set1_epi16(128)));
+	return _mm_add_epi16(_mm_srai_epi16(c, 8), _mm_set1_epi16(128));
+}
+
+// Rounded averages of the 2 x 2 blocks of a channel of two rows of 8 pixels, in the 4 low lanes
+static inline __m128i average4(__m128i row0, __m128i row1)
+{
+	__m128i sums = _mm_madd_epi16(_mm_add_epi16(row0, row1), _mm_set1_epi16(1));
+	sums = _mm_srli_epi32(_mm_add_epi32(sums, _mm_set1_epi32(2)), 2);
+	return _mm_packs_epi32(sums, sums);
+}
+
+static inline void storeBytes4(unsigned char* destination, __m128i values)
+{
+	int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(values, values));
+	memcpy(destination, &bytes, 4);
+}
+
+// Pixels x to x + 7 of two rows
+static void convertBlock8(const unsigned char* row0, const unsigned char* row1, int x,
+	unsigned char* luma0, unsigned char* luma1, unsigned char* u, unsigned char* v)
+{
+	__m128i r0, g0, b0, r1, g1, b1;
+	splitChannels(row0 + 4 * x, r0, g0, b0);
+	splitChannels(row1 + 4 * x, r1, g1, b1);
+	__m128i y0 = luma8(r0, g0, b0), y1 = luma8(r1, g1, b1);
+	_mm_storel_epi64((__m128i*)(luma0 + x), _mm_packus_epi16(y0, y0));
+	_mm_storel_epi64((__m128i*)(luma1 + x), _mm_packus_epi16(y1, y1));
+
+	__m128i r = average4(r0, r1), g = average4(g0, g1), b = average4(b0, b1);
+	storeBytes4(u + x / 2, chroma8(r, g, b, -38, -74, 112));
+	storeBytes4(v + x / 2, chroma8(r, g, b, 112, -94, -18));
+}
+
+static void convert(const unsigned char* rgba, int width, int height, bool bottomUp, unsigned char* yuv, bool simd)
+{
+	int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	unsigned char* planeU = yuv + (size_t)width * height;
+	unsigned char* planeV = planeU + (size_t)chromaWidth * chromaHeight;
+	size_t stride = (size_t)width * 4;
+	for (int cy = 0; cy < chromaHeight; cy++)
+	{
+		// The last row is repeated for odd heights
+		int y0 = 2 * cy, y1 = std::min(y0 + 1, height - 1);
+		const unsigned char* row0 = rgba + stride * (bottomUp ? height - 1 - y0 : y0);
+		const unsigned char* row1 = rgba + stride * (bottomUp ? height - 1 - y1 : y1);
+		unsigned char* luma0 = yuv + (size_t)width * y0;
+		unsigned char* luma1 = yuv + (size_t)width * y1;
+		unsigned char* u = planeU + (size_t)chromaWidth * cy;
+		unsigned char* v = planeV + (size_t)chromaWidth * cy;
+		int x = 0;
+		if (simd)
+		{
+			for (; x + 8 <= width; x += 8)
+				convertBlock8(row0, row1, x, luma0, luma1, u, v);
+		}
+		for (; x < width; x += 2)
+			convertBlock(row0, row1, x, width, luma0, luma1, u, v);
+	}
+}
+
+void convertRGBAToYUV420(const unsigned char* rgba, int width, int height, bool bottomUp, unsigned char* yuv)
+{
+	convert(rgba, width, height, bottomUp, yuv, true);
+}
+
+void convertRGBAToYUV420Scalar(const unsigned char* rgba, int width, int height, bool bottomUp, unsigned char* yuv)
+{
+	convert(rgba, width, height, bottomUp, yuv, false);
+}
+
+int getYUV420Size(int width, int height)
+{
+	return width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2);
+}
@@ -0,0 +1,18 @@
+#ifndef _YUV_CONVERTER_H
+#define _YUV_CONVERTER_H
+
+/**
+ * @brief      RGBA8 pixels to planar YUV 4:2:0 (BT.601, limited range), as read by video encoders
+ * @details    yuv receives the width * height luma plane, then the U and V planes of ((width + 1) / 2) * ((height + 1) / 2)
+ *             samples, each the chroma of the average color of a 2 x 2 block (edge pixels repeated for odd sizes).
+ *             Eight pixels of two rows at a time with SSE2, in 16 bit integers, so that the output is bit identical to
+ *             convertRGBAToYUV420Scalar.
+ * @param      bottomUp rows of rgba bottom first (glReadPixels), the planes starting with the top row
+ */
+void convertRGBAToYUV420(const unsigned char* rgba, int width, int height, bool bottomUp, unsigned char* yuv);
+void convertRGBAToYUV420Scalar(const unsigned char* rgba, int width, int height, bool bottomUp, unsigned char* yuv);
+
+// Bytes of the three planes
+int getYUV420Size(int width, int height);
+
+#endif
@@ -37,6 +37,15 @@ void compress_DDS_color_block(
 void compress_DDS_alpha_block(
 				const unsigned char *const uncompressed,
 				unsigned char compressed[8] );
+/*
+	Takes 16 values, stride bytes apart, and compresses them into
+	the 8 bytes of a BC4 block, rounding to the nearest of the 8
+	interpolated values.
+*/
+void compress_BC4_block(
+				const unsigned char *const uncompressed,
+				int stride,
+				unsigned char compressed[8] );
 
 /********* Actual Exposed Functions *********/
 int
@@ -90,6 +99,11 @@ int
 	header.sCaps.dwCaps1 = DDSCAPS_TEXTURE;
 	/*	write it out	*/
 	fout = fopen( filename, "wb");
+	if( fout == NULL )
+	{
+		free( DDS_data );
+		return 0;
+	}
 	fwrite( &header, sizeof( DDS_header ), 1, fout );
 	fwrite( DDS_data, 1, DDS_size, fout );
 	fclose( fout );
@@ -274,6 +288,98 @@ unsigned char* convert_image_to_DXT5(
 	return compressed;
 }
 
+/*
+	copies the 4x4 block at (i,j) of one channel into ublock,
+	repeating its first value outside of the image
+*/
+static void get_channel_block(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels, int channel,
+		int i, int j,
+		unsigned char ublock[16] )
+{
+	int x, y;
+	for( y = 0; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			if( (i+x < width) && (j+y < height) )
+			{
+				ublock[y*4+x] = uncompressed[((j+y)*width+(i+x))*channels+channel];
+			} else
+			{
+				ublock[y*4+x] = ublock[0];
+			}
+		}
+	}
+}
+
+unsigned char* convert_image_to_BC4(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int *out_size )
+{
+	unsigned char *compressed;
+	int i, j;
+	unsigned char ublock[16];
+	int index = 0;
+	/*	error check	*/
+	*out_size = 0;
+	if( (width < 1) || (height < 1) ||
+		(NULL == uncompressed) ||
+		(channels < 1) || (channels > 4) )
+	{
+		return NULL;
+	}
+	/*	(8 bytes per 4x4 pixel block)	*/
+	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 8;
+	compressed = (unsigned char*)malloc( *out_size );
+	for( j = 0; j < height; j += 4 )
+	{
+		for( i = 0; i < width; i += 4 )
+		{
+			get_channel_block( uncompressed, width, height, channels, 0, i, j, ublock );
+			compress_BC4_block( ublock, 1, compressed + index );
+			index += 8;
+		}
+	}
+	return compressed;
+}
+
+unsigned char* convert_image_to_BC5(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int *out_size )
+{
+	unsigned char *compressed;
+	int i, j;
+	unsigned char ublock[16];
+	int index = 0;
+	/*	error check	*/
+	*out_size = 0;
+	if( (width < 1) || (height < 1) ||
+		(NULL == uncompressed) ||
+		(channels < 1) || (channels > 4) )
+	{
+		return NULL;
+	}
+	/*	(16 bytes per 4x4 pixel block)	*/
+	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 16;
+	compressed = (unsigned char*)malloc( *out_size );
+	for( j = 0; j < height; j += 4 )
+	{
+		for( i = 0; i < width; i += 4 )
+		{
+			get_channel_block( uncompressed, width, height, channels, 0, i, j, ublock );
+			compress_BC4_block( ublock, 1, compressed + index );
+			get_channel_block( uncompressed, width, height, channels, channels > 1 ? 1 : 0, i, j, ublock );
+			compress_BC4_block( ublock, 1, compressed + index + 8 );
+			index += 16;
+		}
+	}
+	return compressed;
+}
+
 /********* Helper Functions *********/
 int convert_bit_range( int c, int from_bits, int to_bits )
 {
@@ -630,3 +736,59 @@ void
 	}
 	/*	done compressing to DXT1	*/
 }
+
+void
+	compress_BC4_block
+	(
+		const unsigned char *const uncompressed,
+		int stride,
+		unsigned char compressed[8]
+	)
+{
+	/*	variables	*/
+	int i;
+	int next_bit;
+	int a0, a1;
+	float scale_me;
+	/*	stupid order	*/
+	int swizzle8[] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+	/*	get the limits (a0 >= a1)	*/
+	a0 = a1 = uncompressed[0];
+	for( i = 1; i < 16; ++i )
+	{
+		if( uncompressed[i*stride] > a0 )
+		{
+			a0 = uncompressed[i*stride];
+		} else if( uncompressed[i*stride] < a1 )
+		{
+			a1 = uncompressed[i*stride];
+		}
+	}
+	compressed[0] = a0;
+	compressed[1] = a1;
+	for( i = 2; i < 8; ++i )
+	{
+		compressed[i] = 0;
+	}
+	/*	a uniform block only uses a0 (index 0)	*/
+	if( a0 == a1 )
+	{
+		return;
+	}
+	/*	nearest of the 7 intervals between a1 and a0	*/
+	next_bit = 8*2;
+	scale_me = 7.0f / (a0 - a1);
+	for( i = 0; i < 16; ++i )
+	{
+		int svalue;
+		int value = (int)((uncompressed[i*stride] - a1) * scale_me + 0.5f);
+		svalue = swizzle8[ value&7 ];
+		compressed[next_bit >> 3] |= svalue << (next_bit & 7);
+		if( (next_bit & 7) > 5 )
+		{
+			/*	spans 2 bytes, fill in the start of the 2nd byte	*/
+			compressed[1 + (next_bit >> 3)] |= svalue >> (8 - (next_bit & 7) );
+		}
+		next_bit += 3;
+	}
+}
@@ -45,6 +45,30 @@ convert_image_to_DXT5
     int *out_size
 );
 
+/**
+	take an image and convert its first channel to BC4 (one channel,
+	the alpha block of DXT5 with rounded indices)
+**/
+unsigned char*
+convert_image_to_BC4
+(
+    const unsigned char *const uncompressed,
+    int width, int height, int channels,
+    int *out_size
+);
+
+/**
+	take an image and convert its first two channels to BC5 (two BC4
+	blocks, red then green; 1 channel images use it for both)
+**/
+unsigned char*
+convert_image_to_BC5
+(
+    const unsigned char *const uncompressed,
+    int width, int height, int channels,
+    int *out_size
+);
+
 /**	A bunch of DirectDraw Surface structures and flags **/
 typedef struct
 {
@@ -0,0 +1,76 @@
+#version 460
+
+layout (location = 0) out vec4 Color;
+
+uniform float AmbientReflectionCoefficient;
+uniform float DiffuseReflectionCoefficient;
+uniform float SpecularReflectionCoefficient;
+uniform float ConeSize;
+
+uniform vec3 AmbientReflectionColor;
+uniform vec3 DiffuseReflectionColor;
+
+uniform bool UseNormalMap;
+uniform sampler2D NormalMap;
+
+struct PointLight {
+    vec4 PositionRadius;    // View space position, distance at which the light vanishes
+    vec4 ColorIntensity;
+};
+
+layout (std430, binding = 0) readonly buffer Lights {
+    PointLight lights[];
+};
+
+layout (std430, binding = 1) readonly buffer LightGrid {
+    uvec4 GridSize;         // Tiles along x and y, depth slices
+    vec4 GridScale;         // Tile size in pixels, scale and bias of the slice from the log of the view depth
+    uvec2 clusters[];       // Offset and count of the lights of each cluster in lightIndices
+};
+
+layout (std430, binding = 2) readonly buffer LightIndices {
+    uint lightIndices[];
+};
+
+in vectors {
+    vec3 viewPosition;
+    vec3 viewNormal;
+    vec4 viewTangent;
+    vec2 uv;
+};
+
+#include "../common/NormalMap.glsl"
+
+void main()
+{
+    vec3 N = normalize(viewNormal);
+    if (UseNormalMap)
+        N = mapNormal(N, viewTangent, texture(NormalMap, uv).xy);
+    vec3 V = normalize(-viewPosition);
+
+    float depth = -viewPosition.z;
+    uvec3 cell = uvec3(uvec2(gl_FragCoord.xy / GridScale.xy), uint(max(floor(log(depth) * GridScale.z + GridScale.w), 0.0)));
+    cell = min(cell, GridSize.xyz - uvec3(1));
+    uvec2 cluster = clusters[(cell.z * GridSize.y + cell.y) * GridSize.x + cell.x];
+
+    vec3 lighting = AmbientReflectionCoefficient * AmbientReflectionColor;
+    for (uint i = 0; i < cluster.y; i++)
+    {
+        PointLight light = lights[lightIndices[cluster.x + i]];
+        vec3 L = light.PositionRadius.xyz - viewPosition;
+        float distance = length(L);
+        if (distance >= light.PositionRadius.w)
+            continue;
+        L /= distance;
+
+        float attenuation = 1.0 - distance / light.PositionRadius.w;
+        attenuation *= attenuation;
+
+        vec3 R = reflect(-L, N);
+        float diffuseIntensity = DiffuseReflectionCoefficient * max(dot(N, L), 0.0);
+        float specularIntensity = SpecularReflectionCoefficient * pow(max(dot(R, V), 0.0), ConeSize);
+        lighting += (diffuseIntensity * DiffuseReflectionColor + vec3(specularIntensity)) * light.ColorIntensity.rgb * (light.ColorIntensity.w * attenuation);
+    }
+
+    Color = vec4(lighting, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 460
+
+uniform mat4 Model;
+uniform mat4 View;
+uniform mat4 Proj;
+uniform mat3 NormalMatrix;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+    float gl_PointSize;
+    float gl_ClipDistance[];
+};
+
+layout (location = 0) in vec3 Position;
+layout (location = 2) in vec3 Normal;
+layout (location = 3) in vec3 TexCoord;
+layout (location = 4) in vec4 Tangent;      // Handedness of the bitangent in w
+
+// Lights are binned in view space
+out vectors {
+    vec3 viewPosition;
+    vec3 viewNormal;
+    vec4 viewTangent;
+    vec2 uv;
+};
+
+void main()
+{
+    mat4 modelView = View * Model;
+    vec4 p = modelView * vec4(Position, 1.0);
+    viewPosition = p.xyz;
+    viewNormal = NormalMatrix * Normal;
+    // Tangents follow the surface, as positions do
+    viewTangent = vec4(mat3(modelView) * Tangent.xyz, Tangent.w);
+    uv = TexCoord.xy;
+
+    gl_Position = Proj * p;
+}
@@ -11,6 +11,9 @@ uniform vec3 AmbientReflectionColor;
 uniform vec3 DiffuseReflectionColor;
 uniform vec3 LightColor;
 
+uniform bool UseNormalMap;
+uniform sampler2D NormalMap;
+
 float AmbientIntensity;
 float DiffuseIntensity;
 float SpecularIntensity;
@@ -25,13 +28,19 @@ in vectors {
     vec3 L;
     vec3 V;
     vec3 fragNormal;
+    vec4 fragTangent;
+    vec2 uv;
 };
 
+#include "../common/NormalMap.glsl"
+
 void main()
 {
     normL = normalize(L);
     normV = normalize(V);
     normN = normalize(fragNormal);
+    if (UseNormalMap)
+        normN = mapNormal(normN, fragTangent, texture(NormalMap, uv).xy);
     R = normalize(reflect(-normL, normN));
 
     AmbientIntensity = AmbientReflectionCoefficient;
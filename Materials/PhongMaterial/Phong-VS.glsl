@@ -14,11 +14,15 @@ out gl_PerVertex {
 
 layout (location = 0) in vec3 Position;
 layout (location = 2) in vec3 Normal;
+layout (location = 3) in vec3 TexCoord;
+layout (location = 4) in vec4 Tangent;      // Handedness of the bitangent in w
 
 out vectors {
     vec3 L;
     vec3 V;
     vec3 fragNormal;
+    vec4 fragTangent;
+    vec2 uv;
 };
 
 void main()
@@ -27,6 +31,8 @@ void main()
     V = CameraPosition - Position;
 
     fragNormal = Normal;
+    fragTangent = Tangent;
+    uv = TexCoord.xy;
 
 	gl_Position = Proj * View * Model * vec4(Position, 1.0);
  }
\ No newline at end of file
@@ -1,14 +1,20 @@
 
 #include "PhongMaterial.h"
 #include "Node.h"
+#include "Texture2D.h"
+#include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Interned once, the lookups below only compare identifiers
+static const StringId LightName = "Light"_sid;
+static const StringId BunnyName = "Bunny"_sid;
 
-PhongMaterial::PhongMaterial(string name) :
-	MaterialGL(name)
+PhongMaterial::PhongMaterial(string name, bool clustered) :
+	MaterialGL(name), m_Clustered(clustered)
 {
-	vp = new GLProgram(MaterialPath + "PhongMaterial/Phong-VS.glsl", GL_VERTEX_SHADER);
-	fp = new GLProgram(MaterialPath + "PhongMaterial/Phong-FS.glsl", GL_FRAGMENT_SHADER);
+	string variant = clustered ? "Phong-Clustered" : "Phong";
+	vp = new GLProgram(MaterialPath + "PhongMaterial/" + variant + "-VS.glsl", GL_VERTEX_SHADER);
+	fp = new GLProgram(MaterialPath + "PhongMaterial/" + variant + "-FS.glsl", GL_FRAGMENT_SHADER);
 
 	m_ProgramPipeline->useProgramStage(vp, GL_VERTEX_SHADER_BIT);
 	m_ProgramPipeline->useProgramStage(fp, GL_FRAGMENT_SHADER_BIT);
@@ -19,6 +25,7 @@ PhongMaterial::PhongMaterial(string name) :
 
 	l_lightPosition = glGetUniformLocation(vp->getId(), "LightPosition");
 	l_cameraPosition = glGetUniformLocation(vp->getId(), "CameraPosition");
+	l_NormalMatrix = glGetUniformLocation(vp->getId(), "NormalMatrix");
 
 	l_AmbientReflectionColor = glGetUniformLocation(fp->getId(), "AmbientReflectionColor");
 	l_DiffuseReflectionColor = glGetUniformLocation(fp->getId(), "DiffuseReflectionColor");
@@ -30,6 +37,9 @@ PhongMaterial::PhongMaterial(string name) :
 
 	l_ConeSize = glGetUniformLocation(fp->getId(), "ConeSize");
 
+	l_UseNormalMap = glGetUniformLocation(fp->getId(), "UseNormalMap");
+	l_NormalMap = glGetUniformLocation(fp->getId(), "NormalMap");
+
 	ambientReflectionColor = glm::vec3(0.92, 0.77, 0.10);
 	diffuseReflectionColor = glm::vec3(0.98, 1.00, 0.00);
 	lightColor = glm::vec3(0.66, 0.63, 0.08);
@@ -39,6 +49,7 @@ PhongMaterial::PhongMaterial(string name) :
 	specularReflectionCoefficient = 0.75;
 
 	coneSize = 1;
+	normalMap = NULL;
 
 	breakdance = { 0, 1, glm::tan(glm::sin(0.5))};
 	willFlip = false;
@@ -56,24 +67,46 @@ void PhongMaterial::render(Node* o)
 {
 	m_ProgramPipeline->bind();
 
+	// The material is shared by many nodes: their uniforms are set right before their draw
+	setNodeUniforms(o);
+	// Fetched for drawn nodes only, which marks the texture used for the TextureResidency. The handle changes as the
+	// levels stream in, and is made resident again after an eviction
+	if (normalMap != NULL)
+		glProgramUniformHandleui64ARB(fp->getId(), l_NormalMap, normalMap->getHandle());
 	o->drawGeometry(GL_TRIANGLES);
 	m_ProgramPipeline->release();
 }
 
-void PhongMaterial::animate(Node* o, const float elapsedTime)
+void PhongMaterial::setNodeUniforms(Node* o)
 {
 	glProgramUniformMatrix4fv(vp->getId(), l_View, 1, GL_FALSE, glm::value_ptr(Scene::getInstance()->camera()->getViewMatrix()));
 	glProgramUniformMatrix4fv(vp->getId(), l_Proj, 1, GL_FALSE, glm::value_ptr(Scene::getInstance()->camera()->getProjectionMatrix()));
 	glProgramUniformMatrix4fv(vp->getId(), l_Model, 1, GL_FALSE, glm::value_ptr(o->frame()->getModelMatrix()));
 
-	Frame* lumiere = Scene::getInstance()->getNode("Light")->frame();
-	glm::vec3 positionLumiere = lumiere->convertPtTo(glm::vec3(0.0, 0.0, 0.0), o->frame());
-	glProgramUniform3fv(vp->getId(), l_lightPosition, 1, glm::value_ptr(positionLumiere));
-
-	Frame* camera = Scene::getInstance()->camera()->frame();
-	glm::vec3 positionCamera = camera->convertPtTo(glm::vec3(0.0, 0.0, 0.0), o->frame());
-	glProgramUniform3fv(vp->getId(), l_cameraPosition, 1, glm::value_ptr(positionCamera));
+	if (m_Clustered)
+	{
+		// Lights and clusters are uploaded by the engine, lighting is computed in view space
+		glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(Scene::getInstance()->camera()->getViewMatrix() * o->frame()->getModelMatrix()));
+		glProgramUniformMatrix3fv(vp->getId(), l_NormalMatrix, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+	}
+	else
+	{
+		// findNode does not add a reference to the light each frame, unlike getNode
+		Node* lumiere = scene->findNode(LightName);
+		if (lumiere != NULL)
+		{
+			glm::vec3 positionLumiere = lumiere->frame()->convertPtTo(glm::vec3(0.0, 0.0, 0.0), o->frame());
+			glProgramUniform3fv(vp->getId(), l_lightPosition, 1, glm::value_ptr(positionLumiere));
+		}
+
+		Frame* camera = Scene::getInstance()->camera()->frame();
+		glm::vec3 positionCamera = camera->convertPtTo(glm::vec3(0.0, 0.0, 0.0), o->frame());
+		glProgramUniform3fv(vp->getId(), l_cameraPosition, 1, glm::value_ptr(positionCamera));
+	}
+}
 
+void PhongMaterial::animate(Node* o, const float elapsedTime)
+{
 	if (willFlip) {
 		o->frame()->scale(glm::vec3(1.0, -1.0, 1.0));
 		willFlip = false;
@@ -92,6 +125,23 @@ void PhongMaterial::update() {
 	glProgramUniform1f(fp->getId(), l_DiffuseReflectionCoefficient, diffuseReflectionCoefficient);
 	glProgramUniform1f(fp->getId(), l_SpecularReflectionCoefficient, specularReflectionCoefficient);
 	glProgramUniform1f(fp->getId(), l_ConeSize, coneSize);
+	glProgramUniform1i(fp->getId(), l_UseNormalMap, normalMap != NULL);
+}
+
+void PhongMaterial::setNormalMap(Texture2D* map) {
+	normalMap = map;
+	update();
+}
+
+void PhongMaterial::setReflection(glm::vec3 ambientColor, glm::vec3 diffuseColor, glm::vec3 light, float ka, float kd, float ks, int cone) {
+	ambientReflectionColor = ambientColor;
+	diffuseReflectionColor = diffuseColor;
+	lightColor = light;
+	ambientReflectionCoefficient = ka;
+	diffuseReflectionCoefficient = kd;
+	specularReflectionCoefficient = ks;
+	coneSize = cone;
+	update();
 }
 
 void PhongMaterial::displayInterface(Node* o) {
@@ -142,7 +192,7 @@ void PhongMaterial::displayInterface(Node* o) {
 
 	ImGui::PopItemWidth();
 
-	if (o->getName() == "Bunny") {
+	if (o->getId() == BunnyName) {
 		ImGui::Spacing();
 		ImGui::Separator();
 		ImGui::Spacing();
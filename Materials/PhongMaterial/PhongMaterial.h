@@ -6,6 +6,8 @@
 
 #include "MaterialGL.h"
 
+class Texture2D;
+
 class PhongMaterial : public MaterialGL
 {
 public:
@@ -13,24 +15,47 @@ public:
 	bool willBreakdance;
 	bool willFlip;
 
-	PhongMaterial(string name = "");
+	/**
+	 * @param clustered lit by the lights of the scene registry binned by the engine (see LightClusters) instead of the
+	 *                  single node named "Light"
+	 */
+	PhongMaterial(string name = "", bool clustered = false);
 	~PhongMaterial();
 	virtual void render(Node* o);
 	virtual void animate(Node* o, const float elapsedTime);
 	void displayInterface(Node* o);
 	void update();
 
+	/**
+	 * @brief Colors and coefficients of the Phong model (e.g. read from a scene file), uploaded to the shaders
+	 */
+	void setReflection(glm::vec3 ambientColor, glm::vec3 diffuseColor, glm::vec3 light, float ka, float kd, float ks, int cone);
+
+	/**
+	 * @brief Tangent space normals perturbing the normals of the models (NULL for none), not owned
+	 * @details Imported with TextureUsageNormalMap: BC5 keeps X and Y, the shaders rebuild Z. Models need texture
+	 *          coordinates and tangents.
+	 */
+	void setNormalMap(Texture2D* map);
+
 protected:
+	// Transform, light and camera of o, written into the programs shared by the nodes of the material
+	void setNodeUniforms(Node* o);
+
 	GLProgram* vp;
 	GLProgram* fp;
 
-	GLuint l_View, l_Proj, l_Model, l_Time, l_lightPosition, l_cameraPosition;
+	bool m_Clustered;
+	GLuint l_View, l_Proj, l_Model, l_Time, l_lightPosition, l_cameraPosition, l_NormalMatrix;
 
 	glm::vec3 ambientReflectionColor, diffuseReflectionColor, lightColor;
     GLfloat ambientReflectionCoefficient, diffuseReflectionCoefficient, specularReflectionCoefficient;
     GLuint l_AmbientReflectionColor, l_DiffuseReflectionColor, l_LightColor, l_AmbientReflectionCoefficient,
 		l_DiffuseReflectionCoefficient, l_SpecularReflectionCoefficient, l_ConeSize;
 	GLint coneSize;
+
+	Texture2D* normalMap;
+	GLuint l_UseNormalMap, l_NormalMap;
 };
 
 #endif
\ No newline at end of file
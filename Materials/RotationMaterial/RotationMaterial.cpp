@@ -23,6 +23,11 @@ void RotationMaterial::animate(Node* o, const float elapsedTime)
 	}
 }
 
+void RotationMaterial::setRotation(glm::vec3 axis)
+{
+	rotation = axis;
+}
+
 void RotationMaterial::displayInterface(Node* o) {
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -13,6 +13,8 @@ public:
 	~RotationMaterial();
 	virtual void animate(Node* o, const float elapsedTime);
 	void displayInterface(Node* o);
+	// Axis of the rotation applied to the frame of the nodes, one radian per second
+	void setRotation(glm::vec3 axis);
 
 protected:
 	glm::vec3 rotation;
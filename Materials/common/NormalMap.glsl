@@ -0,0 +1,16 @@
+// Included by the materials sampling normal maps (see GLProgram)
+
+// Tangent space normal of a BC5 normal map, which stores X and Y only (see TextureUsageNormalMap)
+vec3 unpackNormal(vec2 xy)
+{
+    xy = xy * 2.0 - 1.0;
+    return vec3(xy, sqrt(max(0.0, 1.0 - dot(xy, xy))));
+}
+
+// N perturbed by the X and Y of a normal map texel, tangent being in the space of N with the bitangent handedness in w
+vec3 mapNormal(vec3 N, vec4 tangent, vec2 xy)
+{
+    vec3 T = normalize(tangent.xyz - dot(tangent.xyz, N) * N);
+    vec3 B = cross(N, T) * tangent.w;
+    return normalize(mat3(T, B, N) * unpackNormal(xy));
+}
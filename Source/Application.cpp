@@ -1,11 +1,26 @@
 #include <iostream>
 #include <chrono>
+#include <fstream>
 #include <utility>
+#include <vector>
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
 
 #include "Application.h"
 #include <glad/glad.h>
 #include "Frame.h"
 #include "PhongMaterial.h"
+#include "Profiler.h"
+#include "JsonWriter.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #define M_PI 3.1415926535
@@ -22,7 +37,7 @@ static void error_callback(int error, const char* description) {
     LOG_TRACE << "Error :" << error << "\nDescription: " << description << std::endl;
 }
 
-Application::Application(int width,int height, std::string name) : m_width(width), m_height(height), m_title(std::move(name)) {
+Application::Application(int width,int height, std::string name, bool hidden, bool egl, const SceneGeneratorSettings* generatedScene, const std::string& sceneFile) : m_width(width), m_height(height), m_title(std::move(name)) {
 	srand((unsigned int) time(nullptr));
 
 	if (!glfwInit()) {
@@ -34,8 +49,19 @@ Application::Application(int width,int height, std::string name) : m_width(width
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (hidden) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+	if (egl) {
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+	}
 
 	m_window = glfwCreateWindow(m_width, m_height, m_title.c_str(), nullptr, nullptr);
+	if (m_window == nullptr) {
+		std::cerr << "Failed to create the GLFW window" << std::endl;
+		glfwTerminate();
+		exit(-1);
+	}
 
 	glfwMakeContextCurrent(m_window);
 	glfwSetWindowUserPointer(m_window, this);
@@ -46,6 +72,7 @@ Application::Application(int width,int height, std::string name) : m_width(width
 		glfwTerminate();
 		exit(-1);
 	}
+	Profiler::getInstance()->setGPUEnabled(true);
 
 	try {
 		ImGui_ImplGlfwGL3_Init(m_window, false);
@@ -65,7 +92,7 @@ Application::Application(int width,int height, std::string name) : m_width(width
 		// Direct engine
 		m_engine = new EngineGL(m_width, m_height);
 		m_scene = Scene::getInstance();
-		m_engine->init();
+		m_engine->init(generatedScene, sceneFile);
 	} catch (const std::exception & e) {
 		LOG_ERROR << "Error Engine Initialization: "<< e.what() <<endl;
 		Logger::getInstance()->show_interface = true;
@@ -87,9 +114,10 @@ Application::Application(int width,int height, std::string name) : m_width(width
 
 Application::~Application() {
     ImGui_ImplGlfwGL3_Shutdown();
-    glfwTerminate();
+    // GL objects of the engine and the scene are deleted while the context still exists
     delete m_engine;
 	Scene::kill();
+    glfwTerminate();
 }
 
 void Application::displayOverlay(bool display, float milli, float seconds) {
@@ -148,6 +176,11 @@ void Application::displayOverlay(bool display, float milli, float seconds) {
 			ImGui::MenuItem("Show Console", nullptr, &Logger::getInstance()->show_interface);
 			ImGui::EndMenu();
 		}
+
+        if (ImGui::BeginMenu("Profiler")) {
+			ImGui::MenuItem("Show Profiler", nullptr, &Profiler::getInstance()->show_interface);
+			ImGui::EndMenu();
+		}
 		
 		ImGui::EndMainMenuBar();
 	}
@@ -158,6 +191,10 @@ void Application::displayOverlay(bool display, float milli, float seconds) {
 	if (Logger::getInstance()->show_interface) {
         Logger::getInstance()->Draw("Console");
     }
+
+	if (Profiler::getInstance()->show_interface) {
+        Profiler::getInstance()->Draw("Profiler");
+    }
 }
 
 void Application::mousePos_callback_glfw(GLFWwindow* window, double mouseX, double mouseY) {
@@ -283,6 +320,13 @@ void Application::mouse_event(int button, int action, int mods) {
 		nMouse.x = ImGui::GetIO().MousePos.x;
 		nMouse.y = ImGui::GetIO().MousePos.y;
 
+		// A left click without drag selects the node under the cursor
+		if (action == GLFW_PRESS && button == 0) {
+			pressMouse = nMouse;
+		} else if (action == GLFW_RELEASE && button == 0 && glm::length(nMouse - pressMouse) < 3.0f) {
+			pickNode(nMouse);
+		}
+
 		if (m_trackball) {
 			oMouse = nMouse;
 
@@ -313,6 +357,15 @@ void Application::mouse_wheel_event(double yOffset) {
 	}
 }
 
+void Application::pickNode(glm::vec2 m) {
+	float distance;
+	Node* n = m_scene->pickNode(m_scene->camera()->getRay(getNormalizedMouseCoord(m)), &distance);
+	if (n != NULL) {
+		m_scene->manipulateNode(n->getId());
+		LOG_INFO << "Picked node " << n->getName() << " at distance " << distance << std::endl;
+	}
+}
+
 glm::vec2 Application::getNormalizedMouseCoord(glm::vec2 m) const {
 	glm::vec2 v = glm::vec2((float)m.x / (float)m_width,1.0f - (float)m.y / (float)m_height);
 	v = glm::vec2(2.0f) * v - glm::vec2(1.0f);
@@ -397,10 +450,14 @@ void Application::animate(const float elapsedTime) {
 }
 
 void Application::mainLoop() {
-    std::chrono::time_point<std::chrono::high_resolution_clock> last_time, now_time;
+    // The first frame measures the time elapsed since the loop started
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_time, now_time = std::chrono::high_resolution_clock::now();
+	Profiler* profiler = Profiler::getInstance();
 	LOG_INFO << "Beginning Main Loop" << std::endl;
 
     while(!glfwWindowShouldClose(m_window)) {
+		profiler->beginFrame();
+
 		// Time calculation
         last_time = now_time;	
 		now_time = std::chrono::high_resolution_clock::now();
@@ -409,22 +466,225 @@ void Application::mainLoop() {
 		auto elapsed_second = (float) chrono::duration <double, ratio<1,1> > (elapsed_Time).count();
         
         // Enlivenment handling and interface rendering
-        glfwPollEvents();
-        ImGui_ImplGlfwGL3_NewFrame();
-        displayOverlay(m_display_interface, elapsed_milli, elapsed_second);
+        {
+			PROFILE_ZONE("Events");
+			glfwPollEvents();
+		}
+        {
+			PROFILE_ZONE("Interface");
+			ImGui_ImplGlfwGL3_NewFrame();
+			displayOverlay(m_display_interface, elapsed_milli, elapsed_second);
+		}
 				
         // Rendering
 		m_engine->render();
 
 		// update		
-        animate(elapsed_milli);	
+        {
+			PROFILE_ZONE("Animate");
+			animate(elapsed_milli);
+		}
 
 		if(m_display_interface) {
+			PROFILE_GPU_ZONE("ImGui::Render");
             ImGui::Render();
         }
 
-		glfwSwapBuffers(m_window);
+		{
+			PROFILE_ZONE("Swap buffers");
+			glfwSwapBuffers(m_window);
+		}
+		profiler->endFrame();
     }
 
     LOG_INFO << "Ending Main Loop" << std::endl;
-}
\ No newline at end of file
+}
+
+// Peak resident memory of the process in bytes
+static long long peakResidentMemory() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return (long long) counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return (long long) usage.ru_maxrss;
+#else
+	return (long long) usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+	if (sorted.empty()) {
+		return 0.0;
+	}
+	size_t rank = (size_t) std::ceil(p * sorted.size());
+	return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+static void writeZones(JsonWriter& json, const std::vector<Profiler::Zone>& zones, int parent, const std::string& prefix, long long frames) {
+	for (size_t i = 0; i < zones.size(); i++) {
+		const Profiler::Zone& z = zones[i];
+		if (z.parent != parent) {
+			continue;
+		}
+		std::string path = prefix.empty() ? z.name : prefix + "/" + z.name;
+		float min, avg, p99;
+		json.beginObject();
+		json.value("name", path);
+		json.value("cpu_avg_ms", frames > 0 ? z.totalCpu / frames : 0.0);
+		json.value("calls_per_frame", frames > 0 ? (double) z.totalCalls / frames : 0.0);
+		z.cpu.stats(min, avg, p99);
+		json.value("cpu_p99_ms", p99);
+		if (!z.gpu.values.empty()) {
+			z.gpu.stats(min, avg, p99);
+			json.value("gpu_avg_ms", avg);
+			json.value("gpu_p99_ms", p99);
+		}
+		json.endObject();
+		writeZones(json, zones, (int) i, path, frames);
+	}
+}
+
+int Application::runBenchmark(const BenchmarkSettings& settings) {
+	LOG_INFO << "Benchmark : " << settings.frames << " frames after " << settings.warmup << " warm up frames" << std::endl;
+
+	// Offscreen target, the framebuffer of an invisible window may not be rendered at all
+	GLuint fbo, renderbuffers[2];
+	glCreateFramebuffers(1, &fbo);
+	glCreateRenderbuffers(2, renderbuffers);
+	glNamedRenderbufferStorage(renderbuffers[0], GL_RGBA8, m_width, m_height);
+	glNamedRenderbufferStorage(renderbuffers[1], GL_DEPTH_COMPONENT24, m_width, m_height);
+	glNamedFramebufferRenderbuffer(fbo, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	glNamedFramebufferRenderbuffer(fbo, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+	if (glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_ERROR << "Benchmark : incomplete offscreen framebuffer" << std::endl;
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteRenderbuffers(2, renderbuffers);
+		return -1;
+	}
+
+	Profiler* profiler = Profiler::getInstance();
+	Camera* camera = m_scene->camera();
+
+	// The orbit encloses the indexed nodes, generated scenes being much larger than the default one
+	float radius = 15.0f, height = 8.0f;
+	AABB bounds = m_scene->spatialIndex().getBounds();
+	if (!bounds.isEmpty()) {
+		float size = glm::length(bounds.extent());
+		radius = std::max(radius, 0.75f * size);
+		height = std::max(height, 0.4f * size);
+	}
+	std::vector<double> frameTimes;
+	int total = settings.warmup + settings.frames;
+
+	for (int f = 0; f < total; f++) {
+		if (f == settings.warmup) {
+			profiler->resetStatistics();
+		}
+		std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+		profiler->beginFrame();
+
+		{
+			// One turn around the scene over the whole run
+			PROFILE_ZONE("Camera path");
+			float angle = glm::two_pi<float>() * (float) f / (float) total;
+			camera->lookAt(glm::vec3(0.0f), glm::vec3(radius * sin(angle), height, radius * cos(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glViewport(0, 0, m_width, m_height);
+		m_engine->render();
+
+		{
+			PROFILE_ZONE("Animate");
+			animate(settings.timestep);
+		}
+		{
+			// Include the GPU work in the frame time
+			PROFILE_GPU_ZONE("Finish");
+			glFinish();
+		}
+
+		profiler->endFrame();
+		if (f >= settings.warmup) {
+			frameTimes.push_back(chrono::duration<double, milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+	}
+
+	// Hash of the final frame (FNV-1a)
+	std::vector<unsigned char> pixels((size_t) m_width * m_height * 4);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < pixels.size(); i++) {
+		hash = (hash ^ pixels[i]) * 1099511628211ULL;
+	}
+	char hashText[32];
+	snprintf(hashText, sizeof(hashText), "%016llx", hash);
+
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteRenderbuffers(2, renderbuffers);
+
+	std::ofstream file(settings.output.c_str());
+	if (!file) {
+		LOG_ERROR << "Benchmark : cannot write " << settings.output << std::endl;
+		return -1;
+	}
+
+	std::vector<double> sorted(frameTimes);
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0.0;
+	for (size_t i = 0; i < sorted.size(); i++) {
+		sum += sorted[i];
+	}
+	long long frames = profiler->getMeasuredFrames();
+
+	JsonWriter json(file);
+	json.beginObject();
+
+	json.beginObject("settings");
+	json.value("frames", settings.frames);
+	json.value("warmup", settings.warmup);
+	json.value("timestep_ms", settings.timestep);
+	json.value("width", m_width);
+	json.value("height", m_height);
+	json.value("renderer", (const char*) glGetString(GL_RENDERER));
+	json.value("gl_version", (const char*) glGetString(GL_VERSION));
+	json.endObject();
+
+	json.beginObject("frame_time_ms");
+	json.value("min", sorted.empty() ? 0.0 : sorted.front());
+	json.value("avg", sorted.empty() ? 0.0 : sum / sorted.size());
+	json.value("p50", percentile(sorted, 0.50));
+	json.value("p90", percentile(sorted, 0.90));
+	json.value("p95", percentile(sorted, 0.95));
+	json.value("p99", percentile(sorted, 0.99));
+	json.value("max", sorted.empty() ? 0.0 : sorted.back());
+	json.endObject();
+
+	json.beginArray("phases");
+	writeZones(json, profiler->getZones(), -1, "", frames);
+	json.endArray();
+
+	json.beginObject("counters_per_frame");
+	for (size_t i = 0; i < profiler->getCounters().size(); i++) {
+		const Profiler::Counter& c = profiler->getCounters()[i];
+		json.value(c.name.c_str(), frames > 0 ? c.total / frames : 0.0);
+	}
+	json.endObject();
+
+	json.value("peak_rss_bytes", peakResidentMemory());
+	json.value("final_frame_hash", hashText);
+	json.endObject();
+
+	LOG_INFO << "Benchmark : average frame " << (sorted.empty() ? 0.0 : sum / sorted.size()) << " ms, report written to " << settings.output << std::endl;
+	return 0;
+}
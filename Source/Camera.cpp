@@ -17,7 +17,7 @@ Camera::Camera(std::string name) {
 	needUpdate = true;
 }
 
-std::string Camera::getName() {
+const std::string& Camera::getName() const {
 	return m_Name;
 }
 
@@ -122,6 +122,19 @@ glm::mat4 Camera::getViewMatrix() {
 	return viewMatrix;
 }
 
+Frustum Camera::getFrustum() {
+	return Frustum(getProjectionMatrix() * getViewMatrix());
+}
+
+Ray Camera::getRay(glm::vec2 ndc) {
+	glm::mat4 inv = glm::inverse(getProjectionMatrix() * getViewMatrix());
+	glm::vec4 nearPoint = inv * glm::vec4(ndc, -1.0f, 1.0f);
+	glm::vec4 farPoint = inv * glm::vec4(ndc, 1.0f, 1.0f);
+	glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 target = glm::vec3(farPoint) / farPoint.w;
+	return Ray(origin, glm::normalize(target - origin));
+}
+
 bool Camera::updateNeeded() {
 	return(m_Frame->updateNeeded() || projection_frame->updateNeeded());
 }
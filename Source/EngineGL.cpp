@@ -3,6 +3,15 @@
 #include "BaseMaterial.h"
 #include "PhongMaterial.h"
 #include "RotationMaterial.h"
+#include "Profiler.h"
+#include "SceneFile.h"
+#include "FrameCapture.h"
+#include "RenderTargetPool.h"
+#include "TextureImporter.h"
+#include "TextureResidency.h"
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <chrono>
 
 void message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const* message, void const* user_param)
 {
@@ -53,6 +62,18 @@ EngineGL::EngineGL(int width, int height)
     m_Height = height;
 
     myFBO = NULL;
+    occlusionCulling = true;
+    showCullingInterface = false;
+    lightBuffers[0] = lightBuffers[1] = lightBuffers[2] = 0;
+    clusterProjection = glm::mat4(0.0f);
+    lightBinningThreads = 0;
+    showLightingInterface = false;
+    showStreamingInterface = false;
+    showTextureMemoryInterface = false;
+    showResidencyInterface = false;
+    showCaptureInterface = false;
+    showRenderTargetInterface = false;
+    captureCount = 0;
 
     scene = Scene::getInstance();
     scene->resizeViewport(m_Width, m_Height);
@@ -61,6 +82,8 @@ EngineGL::EngineGL(int width, int height)
 
 EngineGL::~EngineGL()
 {
+    if (lightBuffers[0] != 0)
+        glDeleteBuffers(3, lightBuffers);
 }
 
 
@@ -70,9 +93,15 @@ void EngineGL::setupEngine()
     glViewport(0, 0, m_Width, m_Height);
     setClearColor(glm::vec4(0.5,0.5,0.5,1.0));
 
-    this->allNodes = new NodeCollector();
+    this->allNodes = new IncrementalNodeCollector();
 
     allNodes->collect(scene->getRoot());
+    scene->setCollector(allNodes);
+    for (unsigned int i = 0; i < allNodes->nodes.size(); i++)
+        scene->updateSpatialNode(allNodes->nodes[i]);
+
+    glCreateBuffers(3, lightBuffers);
+    TextureStreamer::getInstance()->initGL();
 
     glEnable(GL_DEBUG_OUTPUT);
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
@@ -82,10 +111,33 @@ void EngineGL::setupEngine()
     LOG_INFO << "initialisation complete" << std::endl;
 }
 
-bool EngineGL::init()
+bool EngineGL::init(const SceneGeneratorSettings* generated, const std::string& sceneFile)
 {
     LOG_INFO << "Initializing Scene" << std::endl;
 
+    bool loaded = true;
+    if (generated == NULL && !sceneFile.empty())
+    {
+        loaded = loadScene(sceneFile);
+        if (loaded)
+        {
+            setupEngine();
+            return(true);
+        }
+        // loadScene fails before creating anything
+        LOG_ERROR << "Could not load " << sceneFile << ", showing the default scene" << std::endl;
+    }
+
+    if (generated != NULL)
+    {
+        SceneGenerator generator(*generated);
+        generator.generate(scene);
+        float extent = generator.getExtent();
+        scene->camera()->lookAt(glm::vec3(0.0), glm::vec3(0.0, 0.5 * extent, extent), glm::vec3(0.0, 1.0, 0.0));
+        setupEngine();
+        return(true);
+    }
+
     BaseMaterial* sphereMaterial = new BaseMaterial("Sphere");
     RotationMaterial* rotationMaterial = new RotationMaterial("Rotation");
     PhongMaterial* phongMaterial = new PhongMaterial("Phong");
@@ -101,6 +153,7 @@ bool EngineGL::init()
     sol->setModel(scene->m_Models.get<ModelGL>(ObjPath + "Wall.obj"));
     sol->setMaterial(phongMaterialWall);
     sol->frame()->translate(glm::vec3(0.0, -2.3, 0.0));
+    sol->setOccluder(true);
     scene->getSceneNode()->adopt(sol);
 
     Node* A = scene->getNode("A");
@@ -114,26 +167,240 @@ bool EngineGL::init()
 
     A->adopt(lumiere);
     A->setMaterial(rotationMaterial);
+    scene->addLight(lumiere, glm::vec3(1.0), 1.0f, 10.0f);
 
     setupEngine();
-    return(true);
+    return(loaded);
 }
 
 
+bool EngineGL::loadScene(std::string filename)
+{
+    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+    if (!SceneFile::isBinary(filename))
+    {
+        std::string binary = filename + ".bin";
+        if (!SceneFile::convert(filename, binary))
+            return(false);
+        filename = binary;
+    }
+    SceneFile file;
+    if (!file.open(filename))
+        return(false);
+
+    std::vector<ModelGL*> models(file.getModelCount(), NULL);
+    for (int i = 0; i < file.getModelCount(); i++)
+    {
+        const SceneFileModel& m = file.getModels()[i];
+        std::string name = file.getString(m.name);
+        if (m.type == SceneModelFile)
+        {
+            models[i] = scene->m_Models.get<ModelGL>(ObjPath + name);
+            continue;
+        }
+        // Procedural meshes of the same name are shared with the models already in the scene
+        models[i] = scene->m_Models.find(file.getId(m.name));
+        if (models[i] != NULL)
+            continue;
+        ModelGL* model = new ModelGL(name, false);
+        if (m.type == SceneModelSphere)
+            SceneGenerator::createSphere(model->getGeometricModel(), (int)m.triangles);
+        else if (m.type == SceneModelGrid)
+            SceneGenerator::createGrid(model->getGeometricModel(), (int)m.triangles);
+        else
+            SceneGenerator::createTerrain(model->getGeometricModel(), (int)m.triangles, m.seed);
+        model->loadToGPU();
+        scene->m_Models.insert(name, model);
+        models[i] = model;
+    }
+
+    std::vector<MaterialGL*> materials(file.getMaterialCount(), NULL);
+    for (int i = 0; i < file.getMaterialCount(); i++)
+    {
+        const SceneFileMaterial& m = file.getMaterials()[i];
+        const float* p = m.parameters;
+        std::string name = file.getString(m.name);
+        if (m.type == SceneMaterialPhong || m.type == SceneMaterialPhongClustered)
+        {
+            PhongMaterial* phong = new PhongMaterial(name, m.type == SceneMaterialPhongClustered);
+            phong->setReflection(glm::vec3(p[0], p[1], p[2]), glm::vec3(p[3], p[4], p[5]), glm::vec3(p[6], p[7], p[8]), p[9], p[10], p[11], (int)p[12]);
+            materials[i] = phong;
+        }
+        else if (m.type == SceneMaterialRotation)
+        {
+            RotationMaterial* rotation = new RotationMaterial(name);
+            rotation->setRotation(glm::vec3(p[0], p[1], p[2]));
+            materials[i] = rotation;
+        }
+        else
+            materials[i] = new BaseMaterial(name);
+    }
+
+    std::vector<Node*> nodes;
+    file.createNodes(scene->m_Nodes, scene->getSceneNode(), models, materials, nodes);
+
+    for (int i = 0; i < file.getLightCount(); i++)
+    {
+        const SceneFileLight& l = file.getLights()[i];
+        scene->addLight(nodes[l.node], glm::vec3(l.color[0], l.color[1], l.color[2]), l.intensity, l.radius);
+    }
+
+    const SceneFileHeader& h = file.getHeader();
+    if (h.flags & SceneFileHasCamera)
+        scene->camera()->lookAt(glm::vec3(h.cameraTarget[0], h.cameraTarget[1], h.cameraTarget[2]),
+            glm::vec3(h.cameraEye[0], h.cameraEye[1], h.cameraEye[2]), glm::vec3(h.cameraUp[0], h.cameraUp[1], h.cameraUp[2]));
+
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    LOG_INFO << "Loaded " << filename << " (" << file.getNodeCount() << " nodes, " << file.getModelCount() << " models, "
+        << file.getMaterialCount() << " materials, " << file.getLightCount() << " lights) in " << elapsed << " ms" << std::endl;
+    return(true);
+}
+
 void EngineGL::render ()
 {
+    PROFILE_GPU_ZONE("EngineGL::render");
+
     glEnable(GL_DEPTH_TEST);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    for (unsigned int i = 0; i < allNodes->nodes.size(); i++)
-        allNodes->nodes[i]->render();
+
+    {
+        PROFILE_ZONE("Texture streaming");
+        TextureStreamer::getInstance()->update();
+        TextureResidency::getInstance()->update();
+    }
+    {
+        PROFILE_ZONE("Frame capture");
+        FrameCapture::getInstance()->update();
+    }
+    {
+        PROFILE_ZONE("Render targets");
+        RenderTargetPool::getInstance()->update();
+    }
+
+    visibleNodes.clear();
+    {
+        PROFILE_ZONE("Frustum culling");
+        scene->queryFrustum(scene->camera()->getFrustum(), visibleNodes);
+    }
+    if (occlusionCulling)
+    {
+        PROFILE_ZONE("Occlusion culling");
+        cullOccludedNodes();
+    }
+
+    {
+        PROFILE_ZONE("Light binning");
+        // The clusters tile the target being drawn (the window or an enabled FBO), which the viewport follows
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        updateLightClusters(viewport[2], viewport[3]);
+    }
+
+    PROFILE_GPU_ZONE("Draw");
+    // One zone per material: the nodes are grouped by material, which also saves program and state changes
+    std::sort(visibleNodes.begin(), visibleNodes.end(), [](Node* a, Node* b) { return a->getMaterial() < b->getMaterial(); });
+    for (size_t i = 0; i < visibleNodes.size();)
+    {
+        MaterialGL* material = visibleNodes[i]->getMaterial();
+        PROFILE_ZONE(material != NULL ? material->getName().c_str() : "No material");
+        for (; i < visibleNodes.size() && visibleNodes[i]->getMaterial() == material; i++)
+            visibleNodes[i]->render();
+    }
+}
+
+void EngineGL::cullOccludedNodes()
+{
+    Camera* camera = scene->camera();
+    occlusionCuller.beginFrame(camera->getProjectionMatrix() * camera->getViewMatrix());
+
+    // Only the occluders inside the frustum can hide something
+    for (unsigned int i = 0; i < visibleNodes.size(); i++)
+    {
+        GeometricModel* occluder = visibleNodes[i]->getOccluder();
+        if (occluder != NULL && !occluder->listFaces.empty())
+            occlusionCuller.renderOccluder(&occluder->listVertex[0], &occluder->listFaces[0].s1, (int)occluder->listFaces.size(), visibleNodes[i]->frame()->getModelMatrix());
+    }
+    occlusionCuller.finalize();
+
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < visibleNodes.size(); i++)
+    {
+        Node* n = visibleNodes[i];
+        if (n->getOccluder() != NULL || occlusionCuller.isVisible(n->getWorldBounds()))
+            visibleNodes[kept++] = n;
+    }
+    visibleNodes.resize(kept);
+}
+
+// Storage buffers are never empty, so that they can always be bound
+static void uploadStorage(GLuint buffer, GLsizeiptr size, const void* data)
+{
+    if (size > 0)
+        glNamedBufferData(buffer, size, data, GL_STREAM_DRAW);
+    else
+        glNamedBufferData(buffer, 16, NULL, GL_STREAM_DRAW);
+}
+
+void EngineGL::updateLightClusters(int targetWidth, int targetHeight)
+{
+    Camera* camera = scene->camera();
+    glm::mat4 projection = camera->getProjectionMatrix();
+    if (projection != clusterProjection)
+    {
+        lightClusters.setup(projection, camera->getZnear(), camera->getZfar());
+        clusterProjection = projection;
+    }
+
+    scene->collectLights(frameLights);
+    lightClusters.bin(frameLights.empty() ? NULL : &frameLights[0], (int)frameLights.size(), camera->getViewMatrix(), lightBinningThreads);
+
+    const std::vector<PointLight>& lights = lightClusters.getViewLights();
+    const std::vector<LightCluster>& clusters = lightClusters.getClusters();
+    const std::vector<unsigned int>& indices = lightClusters.getLightIndices();
+
+    uploadStorage(lightBuffers[0], lights.size() * sizeof(PointLight), lights.empty() ? NULL : &lights[0]);
+    uploadStorage(lightBuffers[2], indices.size() * sizeof(unsigned int), indices.empty() ? NULL : &indices[0]);
+
+    // Grid header (std430 uvec4 and vec4) followed by the clusters
+    GLuint gridSize[4] = { (GLuint)lightClusters.getTilesX(), (GLuint)lightClusters.getTilesY(), (GLuint)lightClusters.getSlices(), 0 };
+    GLfloat gridScale[4] = { (float)targetWidth / lightClusters.getTilesX(), (float)targetHeight / lightClusters.getTilesY(),
+        lightClusters.getDepthScale(), lightClusters.getDepthBias() };
+    GLsizeiptr header = sizeof(gridSize) + sizeof(gridScale);
+    glNamedBufferData(lightBuffers[1], header + clusters.size() * sizeof(LightCluster), NULL, GL_STREAM_DRAW);
+    glNamedBufferSubData(lightBuffers[1], 0, sizeof(gridSize), gridSize);
+    glNamedBufferSubData(lightBuffers[1], sizeof(gridSize), sizeof(gridScale), gridScale);
+    glNamedBufferSubData(lightBuffers[1], header, clusters.size() * sizeof(LightCluster), &clusters[0]);
+
+    for (GLuint i = 0; i < 3; i++)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, lightBuffers[i]);
 }
 
 void EngineGL::animate (const float elapsedTime)
 {
+    PROFILE_ZONE("EngineGL::animate");
+
+    {
+        PROFILE_ZONE("Scene changes");
+        scene->applyChanges();
+    }
+
     // Animate each node
+    {
+        PROFILE_ZONE("Materials animate");
+        for (unsigned int i = 0; i < allNodes->nodes.size(); i++)
+        {
+            allNodes->nodes[i]->animate(elapsedTime);
+        }
+    }
+
+    // Refit the spatial index for the nodes that moved
+    PROFILE_ZONE("Spatial index refit");
     for (unsigned int i = 0; i < allNodes->nodes.size(); i++)
     {
-        allNodes->nodes[i]->animate(elapsedTime);
+        Node* n = allNodes->nodes[i];
+        if (n->spatialProxy == DynamicAABBTree<Node*>::NullNode || n->frame()->getVersion() != n->spatialVersion)
+            scene->updateSpatialNode(n);
     }
 
     // Update Camera Buffer
@@ -150,6 +417,10 @@ void EngineGL::onWindowResize(int w, int h)
     scene->resizeViewport(w,h);
     scene->camera()->setPerspectiveProjection(glm::radians(45.0f), ratio, 1.0f, 2000.0f);
 
+    // Attachments of the former size go back to the pool (minimized windows have no size)
+    if (myFBO != NULL && w > 0 && h > 0)
+        myFBO->resizeFBO(w, h);
+
 }
 
 void EngineGL::setClearColor(glm::vec4 color)
@@ -158,6 +429,164 @@ void EngineGL::setClearColor(glm::vec4 color)
 }
 void EngineGL::displayInterface()
 {
+    if (ImGui::BeginMainMenuBar())
+    {
+        if (ImGui::BeginMenu("Engine"))
+        {
+            ImGui::MenuItem("Occlusion Culling", NULL, &showCullingInterface);
+            ImGui::MenuItem("Clustered Lighting", NULL, &showLightingInterface);
+            ImGui::MenuItem("Texture Streaming", NULL, &showStreamingInterface);
+            ImGui::MenuItem("Texture Memory", NULL, &showTextureMemoryInterface);
+            ImGui::MenuItem("Texture Residency", NULL, &showResidencyInterface);
+            ImGui::MenuItem("Frame Capture", NULL, &showCaptureInterface);
+            ImGui::MenuItem("Render Targets", NULL, &showRenderTargetInterface);
+            ImGui::EndMenu();
+        }
+        ImGui::EndMainMenuBar();
+    }
+
+    if (showCullingInterface)
+    {
+        if (ImGui::Begin("Occlusion Culling", &showCullingInterface))
+        {
+            ImGui::Checkbox("Enabled", &occlusionCulling);
+            ImGui::Text("Depth buffer : %d x %d", occlusionCuller.getWidth(), occlusionCuller.getHeight());
+            ImGui::Text("Occluder triangles : %d", occlusionCuller.getOccluderTriangles());
+            ImGui::Text("Occluded : %d / %d tested", occlusionCuller.getOccludedCount(), occlusionCuller.getTestedCount());
+            ImGui::Text("Rendered nodes : %lu", visibleNodes.size());
+            ImGui::Text("Rasterization : %.3f ms", occlusionCuller.getRasterTime());
+        }
+        ImGui::End();
+    }
+
+    if (showLightingInterface)
+    {
+        if (ImGui::Begin("Clustered Lighting", &showLightingInterface))
+        {
+            ImGui::Text("Lights : %lu", frameLights.size());
+            ImGui::Text("Clusters : %d x %d x %d", lightClusters.getTilesX(), lightClusters.getTilesY(), lightClusters.getSlices());
+            ImGui::Text("Light indices : %lu", lightClusters.getLightIndices().size());
+            ImGui::Text("Max lights per cluster : %d", lightClusters.getMaxLightsPerCluster());
+            ImGui::Text("Binning : %.3f ms", lightClusters.getBinTime());
+            ImGui::SliderInt("Threads (0: all)", &lightBinningThreads, 0, 16);
+        }
+        ImGui::End();
+    }
+
+    if (showStreamingInterface)
+    {
+        if (ImGui::Begin("Texture Streaming", &showStreamingInterface))
+        {
+            TextureStreamer* streamer = TextureStreamer::getInstance();
+            const TextureStreamingStats& stats = streamer->getStats();
+            double megabytes = stats.bytes / (1024.0 * 1024.0);
+            int submitted = std::max(1, stats.submitted);
+            ImGui::Text("Textures : %d completed, %d failed / %d requested", stats.completed, stats.failed, stats.requested);
+            ImGui::Text("Pending : %d", streamer->getPendingCount());
+            ImGui::Text("Uploaded : %.1f MB (%.1f MB/s)", megabytes, stats.streamingTime > 0.0 ? megabytes * 1000.0 / stats.streamingTime : 0.0);
+            ImGui::Text("Main thread per upload : %.3f ms (max %.3f ms)", stats.uploadTime / submitted, stats.maxUploadTime);
+            ImGui::Text("Decoding per image : %.3f ms", stats.decodeTime / submitted);
+            ImGui::Text("Decoding threads : %d", streamer->getThreadCount());
+            ImGui::Text("Upload ring : %.1f / %.1f MB", streamer->getRing().getUsed() / (1024.0 * 1024.0), streamer->getRing().getCapacity() / (1024.0 * 1024.0));
+            ImGui::Separator();
+            ImGui::Text("Mip streams : %d pending", streamer->getMipStreamCount());
+            ImGui::Text("Mip levels : %d uploaded, %.1f MB in %.1f ms", stats.mipLevels, stats.mipBytes / (1024.0 * 1024.0), stats.mipUploadTime);
+            int budget = (int)(streamer->getMipBudget() >> 10);
+            if (ImGui::SliderInt("Mip budget per frame (KB, 0: off)", &budget, 0, 16384))
+                streamer->setMipBudget((size_t)budget << 10);
+        }
+        ImGui::End();
+    }
+
+    if (showTextureMemoryInterface)
+    {
+        if (ImGui::Begin("Texture Memory", &showTextureMemoryInterface))
+        {
+            std::vector<TextureMemoryRecord> records = TextureImporter::getInstance()->getRecords();
+            size_t uncompressed = 0, compressed = 0;
+            ImGui::Columns(6);
+            ImGui::Text("Texture"); ImGui::NextColumn();
+            ImGui::Text("Format"); ImGui::NextColumn();
+            ImGui::Text("PSNR dB"); ImGui::NextColumn();
+            ImGui::Text("KB"); ImGui::NextColumn();
+            ImGui::Text("RGBA8 KB"); ImGui::NextColumn();
+            ImGui::Text("Saved KB"); ImGui::NextColumn();
+            for (unsigned int i = 0; i < records.size(); i++)
+            {
+                const TextureMemoryRecord& r = records[i];
+                ImGui::Text("%s", r.filename.c_str()); ImGui::NextColumn();
+                ImGui::Text("%dx%d %s%s", r.width, r.height, TextureImporter::getCompressionName(r.compression), r.fromCache ? " (cache)" : ""); ImGui::NextColumn();
+                ImGui::Text("%.2f", r.psnr); ImGui::NextColumn();
+                ImGui::Text("%lu", r.compressedBytes / 1024); ImGui::NextColumn();
+                ImGui::Text("%lu", r.uncompressedBytes / 1024); ImGui::NextColumn();
+                // Tiny images take more room in blocks than in RGBA8
+                ImGui::Text("%lld", ((long long)r.uncompressedBytes - (long long)r.compressedBytes) / 1024); ImGui::NextColumn();
+                uncompressed += r.uncompressedBytes;
+                compressed += r.compressedBytes;
+            }
+            ImGui::Columns(1);
+            ImGui::Separator();
+            ImGui::Text("Total : %.1f MB instead of %.1f MB", compressed / (1024.0 * 1024.0), uncompressed / (1024.0 * 1024.0));
+        }
+        ImGui::End();
+    }
+
+    if (showResidencyInterface)
+    {
+        if (ImGui::Begin("Texture Residency", &showResidencyInterface))
+        {
+            TextureResidency* residency = TextureResidency::getInstance();
+            const TextureResidencyStats& stats = residency->getStats();
+            ImGui::Text("Resident : %.1f MB / %.1f MB (%d / %d textures)", residency->getResidentBytes() / (1024.0 * 1024.0),
+                residency->getTotalBytes() / (1024.0 * 1024.0), residency->getResidentCount(), residency->getTextureCount());
+            ImGui::Text("Evictions : %lld (%d last frame)", stats.evictions, stats.lastEvictions);
+            ImGui::Text("Restores : %lld (%d last frame)", stats.restores, stats.lastRestores);
+            int budget = (int)(residency->getBudget() >> 20);
+            if (ImGui::SliderInt("Budget (MB)", &budget, 0, 4096))
+                residency->setBudget((size_t)budget << 20);
+            if (residency->getResidentBytes() > residency->getBudget())
+                ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "Over budget : textures of the last %d frames are kept", TextureResidency::FramesInFlight);
+        }
+        ImGui::End();
+    }
+
+    if (showCaptureInterface)
+    {
+        if (ImGui::Begin("Frame Capture", &showCaptureInterface))
+        {
+            FrameCapture* capture = FrameCapture::getInstance();
+            if (ImGui::Button("Screenshot"))
+                capture->capture(0, m_Width, m_Height, "Screenshot_" + std::to_string(captureCount++) + ".png");
+            const CaptureStats& stats = capture->getStats();
+            ImGui::Text("Written : %d (%.1f MB), %d failed, %d dropped, %d pending", stats.written, stats.bytes / (1024.0 * 1024.0),
+                stats.failed, stats.dropped, capture->getPendingCount());
+            ImGui::Text("Recorded frames : %d written, %d failed, %d dropped of %d", stats.framesWritten, stats.framesFailed,
+                stats.droppedFrames, stats.frames);
+            long long frames = std::max(1LL, capture->getFrame());
+            ImGui::Text("Render thread : %.4f ms per frame (%.3f ms max)", stats.submitTime / frames, stats.maxSubmitTime);
+            int done = stats.written + stats.failed + stats.framesWritten + stats.framesFailed;
+            ImGui::Text("Writer thread : %.1f ms per capture", done > 0 ? stats.encodeTime / done : 0.0);
+        }
+        ImGui::End();
+    }
+
+    if (showRenderTargetInterface)
+    {
+        if (ImGui::Begin("Render Targets", &showRenderTargetInterface))
+        {
+            RenderTargetPool* pool = RenderTargetPool::getInstance();
+            ImGui::Text("Pooled : %.1f MB (%d textures, %d renderbuffers, %d free)", pool->getPooledBytes() / (1024.0 * 1024.0), pool->getTextureCount(),
+                pool->getRenderbufferCount(), pool->getFreeCount());
+            ImGui::Text("Last frame : %.1f MB peak, %.1f MB without aliasing", pool->getPeakBytes() / (1024.0 * 1024.0), pool->getRequestedBytes() / (1024.0 * 1024.0));
+            ImGui::Text("Attachments : %lld created, %lld reused, %lld destroyed", pool->getCreatedCount(), pool->getReusedCount(), pool->getDestroyedCount());
+            ImGui::Text("Free framebuffers : %d", pool->getFreeFramebufferCount());
+            int keepFrames = pool->getKeepFrames();
+            if (ImGui::SliderInt("Kept frames", &keepFrames, 1, 300))
+                pool->setKeepFrames(keepFrames);
+        }
+        ImGui::End();
+    }
+
     if (myFBO)
     {
         if (ImGui::BeginMainMenuBar())
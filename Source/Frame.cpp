@@ -9,6 +9,8 @@ Frame::Frame()
 	reference = NULL;
 	matrix = glm::mat4(1.0f);
 	isCamera = false;
+	m_ToUpdate = true;
+	m_Version = 0;
 }
 
 void Frame::attachTo(Frame *f)
@@ -117,6 +119,8 @@ glm::vec3 Frame::convertDirTo(glm::vec3 dir,Frame *to)
 void Frame::setUpdate(bool t)
 {
 	m_ToUpdate = t;
+	if (t)
+		m_Version++;
 	
 	if (t && !isCameraFrame())
 	{
@@ -130,14 +134,20 @@ bool Frame::updateNeeded()
 	return(m_ToUpdate);
 }
 
+unsigned int Frame::getVersion()
+{
+	return(m_Version);
+}
+
 bool Frame::detach(Frame* f)
 {
 	bool isInLeaves = false;
-	for (int i = 0; i < f->m_Sons.size() && !isInLeaves; i++)
+	for (size_t i = 0; i < m_Sons.size() && !isInLeaves; i++)
 	{
 		if (m_Sons[i] == f)
 		{
 			m_Sons.erase(m_Sons.begin() + i);
+			f->reference = NULL;
 			return true;
 		}
 		else
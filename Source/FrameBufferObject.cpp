@@ -3,15 +3,18 @@
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <stb/stb_image.h>
-#include <image_DXT.h>
+#include "FrameCapture.h"
+#include "RenderTargetPool.h"
 
-FrameBufferObject::FrameBufferObject(std::string name,int _width,int _height) : m_Name(name), m_Width(_width),m_Height(_height) {
+FrameBufferObject::FrameBufferObject(std::string name,int _width,int _height,GLenum colorFormat,GLenum depthFormat) :
+	m_Name(name), m_Width(_width),m_Height(_height),m_Desc(_width,_height,colorFormat,depthFormat) {
     /**
      *
      */
 
-	colorTexture = NULL;
 	depthTexture = NULL;
+	m_DepthRenderbuffer = 0;
+	m_ResolveFBOId = 0;
 	show_interface = false;
 	scene = Scene::getInstance();
 
@@ -19,31 +22,98 @@ FrameBufferObject::FrameBufferObject(std::string name,int _width,int _height) :
 	createTextureTargets(m_Width, m_Height);	
 }
 
+FrameBufferObject::FrameBufferObject(std::string name,const RenderTargetDesc& desc) :
+	m_Name(name), m_Width(desc.width),m_Height(desc.height),m_Desc(desc) {
+	depthTexture = NULL;
+	m_DepthRenderbuffer = 0;
+	m_ResolveFBOId = 0;
+	show_interface = false;
+	scene = Scene::getInstance();
+
+	glCreateFramebuffers(1, &m_FBOId);
+	createTextureTargets(m_Width, m_Height);
+}
+
 FrameBufferObject::~FrameBufferObject() {
+	stopRecording();
 	destroy();
 	glDeleteFramebuffers(1,&m_FBOId);
+	if (m_ResolveFBOId != 0)
+		glDeleteFramebuffers(1, &m_ResolveFBOId);
+}
+
+static GLenum getDepthAttachment(GLenum format) {
+	return (format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
 }
 
 void FrameBufferObject::createTextureTargets(int width,int height) {
 	m_Width = width;
 	m_Height = height;
+	m_Desc.width = width;
+	m_Desc.height = height;
+
+	// Attachments of this size and format released by other targets are reused. Textures only for what is sampled:
+	// the color targets, and the depth if asked. With MSAA the FBO renders into multisampled renderbuffers resolved
+	// into the textures of m_ResolveFBOId.
+	RenderTargetPool* pool = RenderTargetPool::getInstance();
+	bool multisampled = m_Desc.samples > 1;
+	if (multisampled && m_ResolveFBOId == 0)
+		glCreateFramebuffers(1, &m_ResolveFBOId);
+	GLuint textureFBO = multisampled ? m_ResolveFBOId : m_FBOId;
+
+	std::vector<GLenum> drawBuffers;
+	for (size_t i = 0; i < m_Desc.colorFormats.size(); i++) {
+		GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)i;
+		Texture2D* texture = pool->acquireTexture(m_Width, m_Height, m_Desc.colorFormats[i], m_Desc.usage);
+		colorTextures.push_back(texture);
+		glNamedFramebufferTexture(textureFBO, attachment, texture->getId(), 0);
+		if (multisampled) {
+			GLuint renderbuffer = pool->acquireRenderbuffer(m_Width, m_Height, m_Desc.colorFormats[i], m_Desc.samples);
+			m_ColorRenderbuffers.push_back(renderbuffer);
+			glNamedFramebufferRenderbuffer(m_FBOId, attachment, GL_RENDERBUFFER, renderbuffer);
+		}
+		drawBuffers.push_back(attachment);
+	}
+
+	if (m_Desc.depthFormat != 0) {
+		GLenum attachment = getDepthAttachment(m_Desc.depthFormat);
+		if (m_Desc.sampledDepth) {
+			depthTexture = pool->acquireTexture(m_Width, m_Height, m_Desc.depthFormat, m_Desc.usage);
+			glNamedFramebufferTexture(textureFBO, attachment, depthTexture->getId(), 0);
+		}
+		if (multisampled || !m_Desc.sampledDepth) {
+			m_DepthRenderbuffer = pool->acquireRenderbuffer(m_Width, m_Height, m_Desc.depthFormat, m_Desc.samples);
+			glNamedFramebufferRenderbuffer(m_FBOId, attachment, GL_RENDERBUFFER, m_DepthRenderbuffer);
+		}
+	}
 
-	//Texture Creation
-	colorTexture = new Texture2D(m_Width, m_Height, GL_RGBA8);
-	depthTexture = new Texture2D(m_Width, m_Height, GL_DEPTH_COMPONENT24);	
-	glNamedFramebufferTexture(m_FBOId, GL_COLOR_ATTACHMENT0, colorTexture->getId(), 0);
-	glNamedFramebufferTexture(m_FBOId, GL_DEPTH_ATTACHMENT, depthTexture->getId(), 0);
+	if (drawBuffers.empty()) {
+		glNamedFramebufferDrawBuffer(m_FBOId, GL_NONE);
+		glNamedFramebufferReadBuffer(m_FBOId, GL_NONE);
+	}
+	else {
+		glNamedFramebufferDrawBuffers(m_FBOId, (GLsizei)drawBuffers.size(), &drawBuffers[0]);
+		glNamedFramebufferReadBuffer(m_FBOId, GL_COLOR_ATTACHMENT0);
+	}
 
-	if (!CheckFramebufferStatus()) {
+	if (!CheckFramebufferStatus(m_FBOId) || (multisampled && !CheckFramebufferStatus(m_ResolveFBOId))) {
         std::cout << "Error in FBO :  " << info_text << endl;
     }
 }
 
 void FrameBufferObject::resizeFBO(int width, int height) {
+	stopRecording();
 	destroy();
 	createTextureTargets(width, height);
 }
 
+void FrameBufferObject::reconfigure(const RenderTargetDesc& desc) {
+	stopRecording();
+	destroy();
+	m_Desc = desc;
+	createTextureTargets(desc.width, desc.height);
+}
+
 int FrameBufferObject::getWidth() {
 	return m_Width;
 }
@@ -51,14 +121,44 @@ int FrameBufferObject::getHeight() {
 	return m_Height;
 }
 
+// Color attachments 0 to colorCount - 1, depth and stencil (a zero texture detaches renderbuffers as well)
+static void detachAttachments(GLuint fbo, size_t colorCount) {
+	for (size_t i = 0; i < colorCount; i++)
+		glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0 + (GLenum)i, 0, 0);
+	glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, 0, 0);
+	glNamedFramebufferTexture(fbo, GL_DEPTH_STENCIL_ATTACHMENT, 0, 0);
+}
+
 void FrameBufferObject::destroy() {
-	delete colorTexture;
-	delete depthTexture;
+	// Released attachments are aliased by other targets, and the pool deletes the expired ones: the framebuffers must
+	// not keep rendering into them, nor keep their storage alive
+	detachAttachments(m_FBOId, colorTextures.size());
+	if (m_ResolveFBOId != 0)
+		detachAttachments(m_ResolveFBOId, colorTextures.size());
+
+	RenderTargetPool* pool = RenderTargetPool::getInstance();
+	for (size_t i = 0; i < colorTextures.size(); i++)
+		pool->releaseTexture(colorTextures[i]);
+	for (size_t i = 0; i < m_ColorRenderbuffers.size(); i++)
+		pool->releaseRenderbuffer(m_ColorRenderbuffers[i]);
+	pool->releaseTexture(depthTexture);
+	pool->releaseRenderbuffer(m_DepthRenderbuffer);
+	colorTextures.clear();
+	m_ColorRenderbuffers.clear();
+	depthTexture = NULL;
+	m_DepthRenderbuffer = 0;
 }
 
-bool FrameBufferObject::CheckFramebufferStatus() {
+void FrameBufferObject::setAttachmentFormats(GLenum colorFormat, GLenum depthFormat) {
+	m_Desc.colorFormats.clear();
+	if (colorFormat != 0)
+		m_Desc.colorFormats.push_back(colorFormat);
+	m_Desc.depthFormat = depthFormat;
+}
+
+bool FrameBufferObject::CheckFramebufferStatus(GLuint fbo) {
 	GLenum status;
-	status = (GLenum)glCheckNamedFramebufferStatus(m_FBOId, GL_FRAMEBUFFER);
+	status = (GLenum)glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
 	bool evryok = false;
 
     switch (status) {
@@ -103,28 +203,89 @@ void FrameBufferObject::enable() {
 }
 
 void FrameBufferObject::disable() {
+	resolve();
+	FrameCapture::getInstance()->recordFrame(getResolvedId());
 	glViewport(0, 0, scene->getViewportWidth(), scene->getViewportHeight());
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-Texture2D* FrameBufferObject::getColorTexture() {
-	return colorTexture;
+void FrameBufferObject::resolve() {
+	if (m_Desc.samples <= 1)
+		return;
+	// One blit per color attachment: a blit writes the read buffer to every draw buffer
+	for (size_t i = 0; i < colorTextures.size(); i++) {
+		GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)i;
+		glNamedFramebufferReadBuffer(m_FBOId, attachment);
+		glNamedFramebufferDrawBuffer(m_ResolveFBOId, attachment);
+		glBlitNamedFramebuffer(m_FBOId, m_ResolveFBOId, 0, 0, m_Width, m_Height, 0, 0, m_Width, m_Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	if (depthTexture != NULL) {
+		GLbitfield mask = GL_DEPTH_BUFFER_BIT;
+		if (getDepthAttachment(m_Desc.depthFormat) == GL_DEPTH_STENCIL_ATTACHMENT)
+			mask |= GL_STENCIL_BUFFER_BIT;
+		glBlitNamedFramebuffer(m_FBOId, m_ResolveFBOId, 0, 0, m_Width, m_Height, 0, 0, m_Width, m_Height, mask, GL_NEAREST);
+	}
+	if (!colorTextures.empty()) {
+		glNamedFramebufferReadBuffer(m_FBOId, GL_COLOR_ATTACHMENT0);
+		glNamedFramebufferReadBuffer(m_ResolveFBOId, GL_COLOR_ATTACHMENT0);
+	}
+}
+
+GLuint FrameBufferObject::getResolvedId() {
+	return m_Desc.samples > 1 ? m_ResolveFBOId : m_FBOId;
+}
+
+Texture2D* FrameBufferObject::getColorTexture(int index) {
+	return index >= 0 && index < (int)colorTextures.size() ? colorTextures[index] : NULL;
+}
+
+int FrameBufferObject::getColorTextureCount() {
+	return (int)colorTextures.size();
+}
+
+Texture2D* FrameBufferObject::getDepthTexture() {
+	return depthTexture;
+}
+
+size_t FrameBufferObject::getMemorySize() {
+	size_t size = 0;
+	for (size_t i = 0; i < colorTextures.size(); i++)
+		size += colorTextures[i]->getMemorySize();
+	if (depthTexture != NULL)
+		size += depthTexture->getMemorySize();
+	for (size_t i = 0; i < m_Desc.colorFormats.size() && i < m_ColorRenderbuffers.size(); i++)
+		size += RenderTargetPool::getRenderbufferSize(m_Width, m_Height, m_Desc.colorFormats[i], m_Desc.samples);
+	if (m_DepthRenderbuffer != 0)
+		size += RenderTargetPool::getRenderbufferSize(m_Width, m_Height, m_Desc.depthFormat, m_Desc.samples);
+	return size;
 }
 
 void FrameBufferObject::writeToFile(string filename) {
-	LOG_INFO << " Writing file" << filename << std::endl;
-	int height = this->getHeight();
-	int width = this->getWidth();
-	int tt = height * width * 4;
-	unsigned char* toto = new unsigned char[tt];
-	this->enable();
-	glReadBuffer(GL_COLOR_ATTACHMENT0);
-	glReadPixels(0, 0, height, width, GL_RGBA, GL_UNSIGNED_BYTE, toto);
-	this->disable();
-	save_image_as_DDS(filename.c_str(), width, height, 4, toto);
-	FILE* ff = fopen(filename.c_str(), "ab");
-	fwrite(toto, sizeof(unsigned char) * tt, 1, ff);
-	LOG_INFO << " File exported" << std::endl;
+	// Depth only targets read from GL_NONE
+	if (colorTextures.empty()) {
+		LOG_WARNING << "FrameBufferObject : " << m_Name << " has no color attachment to capture" << std::endl;
+		return;
+	}
+	// Read back without waiting, encoded and written on the capture thread
+	if (FrameCapture::getInstance()->capture(getResolvedId(), getWidth(), getHeight(), filename))
+		LOG_INFO << " Capturing " << filename << std::endl;
+}
+
+bool FrameBufferObject::startRecording(const std::string& target, int interval, int fps) {
+	if (colorTextures.empty()) {
+		LOG_WARNING << "FrameBufferObject : " << m_Name << " has no color attachment to record" << std::endl;
+		return false;
+	}
+	return FrameCapture::getInstance()->startRecording(getResolvedId(), m_Width, m_Height, target, interval, fps);
+}
+
+void FrameBufferObject::stopRecording() {
+	if (isRecording())
+		FrameCapture::getInstance()->stopRecording();
+}
+
+bool FrameBufferObject::isRecording() {
+	return FrameCapture::getInstance()->isRecording(getResolvedId());
 }
 
 void FrameBufferObject::displayInterface() {
@@ -180,9 +341,52 @@ void FrameBufferObject::displayInterface() {
 
 		if (to_save)
 			writeToFile(std::string(buf));
+
+		static char recordTarget[128] = "Recording.y4m";
+		static int recordInterval = 1;
+		bool recording = isRecording();
+		if (ImGui::Button(recording ? "Stop" : "Record")) {
+			if (recording)
+				stopRecording();
+			else
+				startRecording(std::string(recordTarget), recordInterval);
+		}
+		ImGui::SameLine();
+		ImGui::Text("%s", recordTarget);
+		if (ImGui::BeginPopupContextItem("Select Recording")) {
+			ImGui::InputText("", recordTarget, 128);
+			ImGui::SliderInt("Every N frames", &recordInterval, 1, 10);
+			if (ImGui::Button("Close"))
+				ImGui::CloseCurrentPopup();
+			ImGui::EndPopup();
+		}
+		if (recording) {
+			const CaptureStats& stats = FrameCapture::getInstance()->getStats();
+			ImGui::Text("%d frames, %d written, %d dropped, %.3f ms per frame", stats.frames, stats.framesWritten, stats.droppedFrames,
+				stats.frames > 0 ? stats.recordTime / stats.frames : 0.0);
+		}
+		ImGui::Text("VRAM : %.1f MB (%d color, depth %s)", getMemorySize() / (1024.0 * 1024.0), getColorTextureCount(),
+			m_Desc.depthFormat == 0 ? "none" : (m_Desc.sampledDepth ? "texture" : "renderbuffer"));
+		RenderTargetDesc desc = m_Desc;
+		const char* sampleCounts[] = { "1", "2", "4", "8" };
+		int samplesIndex = desc.samples >= 8 ? 3 : (desc.samples >= 4 ? 2 : (desc.samples >= 2 ? 1 : 0));
+		bool reconfigured = false;
+		if (ImGui::Combo("MSAA", &samplesIndex, sampleCounts, 4)) {
+			desc.samples = 1 << samplesIndex;
+			reconfigured = true;
+		}
+		if (desc.depthFormat != 0 && ImGui::Checkbox("Sampled depth", &desc.sampledDepth))
+			reconfigured = true;
+
 		if(newResolution.x != 0)
 			resizeFBO(newResolution.x, newResolution.y);
+		else if (reconfigured)
+			reconfigure(desc);
 
+		if (colorTextures.empty()) {
+			ImGui::End();
+			return;
+		}
 		int max_width = min(128, m_Width);
 		int max_height = min(128, m_Height);
 		ImTextureID tex = (void*)((uintptr_t)getColorTexture()->getId());
@@ -0,0 +1,445 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <image_DXT.h>
+
+#include "Logger/ImGuiLogger.h"
+#include "PNGWriter.h"
+#include "YUVConverter.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+static const char* PipeMode = "wb";
+#else
+static const char* PipeMode = "w";
+#endif
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+VideoStream::VideoStream(const std::string& target, VideoFormat format, int width, int height, int fps) :
+	m_File(NULL), m_Pipe(!target.empty() && target[0] == '|'), m_Format(format), m_Width(width), m_Height(height)
+{
+	if (m_Pipe)
+		m_File = popen(target.c_str() + 1, PipeMode);
+	else
+		m_File = fopen(target.c_str(), "wb");
+	if (m_File == NULL)
+		return;
+	// Colors of the frames are BT.601, limited range
+	if (m_Format == VideoY4M)
+		fprintf(m_File, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+}
+
+VideoStream::~VideoStream()
+{
+	if (m_File == NULL)
+		return;
+	if (m_Pipe)
+		pclose(m_File);
+	else
+		fclose(m_File);
+}
+
+VideoFormat VideoStream::formatFromName(const std::string& target)
+{
+	if (!target.empty() && target[0] == '|')
+		return VideoY4M;
+	size_t dot = target.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : target.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return extension == "y4m" ? VideoY4M : VideoRGB;
+}
+
+bool VideoStream::writeFrame(const unsigned char* pixels, std::vector<unsigned char>& scratch)
+{
+	if (m_File == NULL)
+		return false;
+	if (m_Format == VideoY4M)
+	{
+		scratch.resize(getYUV420Size(m_Width, m_Height));
+		convertRGBAToYUV420(pixels, m_Width, m_Height, true, &scratch[0]);
+		if (fwrite("FRAME\n", 1, 6, m_File) != 6)
+			return false;
+	}
+	else
+	{
+		scratch.resize((size_t)m_Width * m_Height * 3);
+		unsigned char* rgb = &scratch[0];
+		for (int y = m_Height - 1; y >= 0; y--)
+		{
+			const unsigned char* row = pixels + (size_t)m_Width * 4 * y;
+			for (int x = 0; x < m_Width; x++, rgb += 3)
+			{
+				rgb[0] = row[4 * x];
+				rgb[1] = row[4 * x + 1];
+				rgb[2] = row[4 * x + 2];
+			}
+		}
+	}
+	return fwrite(&scratch[0], 1, scratch.size(), m_File) == scratch.size();
+}
+
+CaptureWriter::CaptureWriter() :
+	m_Stop(false), m_Busy(false), m_Written(0), m_Failed(0), m_FramesWritten(0), m_FramesFailed(0), m_Bytes(0), m_EncodeTime(0.0)
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+	stop();
+}
+
+void CaptureWriter::start()
+{
+	if (!m_Thread.joinable())
+		m_Thread = std::thread(&CaptureWriter::work, this);
+}
+
+void CaptureWriter::stop()
+{
+	if (!m_Thread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_JobAdded.notify_all();
+	m_Thread.join();
+	m_Stop = false;
+}
+
+void CaptureWriter::submit(const CaptureJob& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back(job);
+	}
+	m_JobAdded.notify_one();
+}
+
+void CaptureWriter::popFinished(std::vector<int>& slots)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	slots.insert(slots.end(), m_Finished.begin(), m_Finished.end());
+	m_Finished.clear();
+}
+
+int CaptureWriter::getPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return (int)m_Jobs.size() + (m_Busy ? 1 : 0);
+}
+
+void CaptureWriter::getStats(CaptureStats& stats)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	stats.written = m_Written;
+	stats.failed = m_Failed;
+	stats.bytes = m_Bytes;
+	stats.encodeTime = m_EncodeTime;
+	stats.framesWritten = m_FramesWritten;
+	stats.framesFailed = m_FramesFailed;
+}
+
+void CaptureWriter::work()
+{
+	std::vector<unsigned char> scratch;
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	for (;;)
+	{
+		// Pending jobs are written before stopping
+		m_JobAdded.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+		if (m_Jobs.empty())
+			return;
+		CaptureJob job = m_Jobs.front();
+		m_Jobs.pop_front();
+		m_Busy = true;
+		lock.unlock();
+
+		Clock::time_point start = Clock::now();
+		bool frame = job.stream != NULL;
+		bool written = frame ? job.stream->writeFrame(job.pixels, scratch) : write(job, scratch);
+		double time = millisecondsSince(start);
+		if (!written && !frame)
+			LOG_WARNING << "CaptureWriter : could not write " << job.filename << std::endl;
+		// The last frame of a recording closes its stream
+		job.stream.reset();
+
+		lock.lock();
+		m_Busy = false;
+		m_EncodeTime += time;
+		if (written)
+			m_Bytes += (long long)job.width * job.height * 4;
+		if (frame)
+		{
+			m_FramesWritten += written;
+			m_FramesFailed += !written;
+		}
+		else
+		{
+			m_Written += written;
+			m_Failed += !written;
+		}
+		m_Finished.push_back(job.slot);
+	}
+}
+
+CaptureFormat CaptureWriter::formatFromName(const std::string& filename)
+{
+	size_t dot = filename.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : filename.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	if (extension == "dds")
+		return CaptureDDS;
+	if (extension == "raw")
+		return CaptureRaw;
+	return CapturePNG;
+}
+
+bool CaptureWriter::write(const CaptureJob& job, std::vector<unsigned char>& scratch)
+{
+	// Image files start with the top row
+	size_t row = (size_t)job.width * 4;
+	scratch.resize(row * job.height);
+	for (int y = 0; y < job.height; y++)
+		memcpy(&scratch[row * y], job.pixels + row * (job.height - 1 - y), row);
+
+	switch (job.format)
+	{
+	case CaptureDDS:
+		return save_image_as_DDS(job.filename.c_str(), job.width, job.height, 4, &scratch[0]) != 0;
+	case CaptureRaw:
+	{
+		FILE* file = fopen(job.filename.c_str(), "wb");
+		if (file == NULL)
+			return false;
+		bool written = fwrite(&scratch[0], 1, scratch.size(), file) == scratch.size();
+		return fclose(file) == 0 && written;
+	}
+	default:
+		return writePNG(job.filename.c_str(), job.width, job.height, 4, &scratch[0]);
+	}
+}
+
+FrameCapture::FrameCapture() :
+	m_Frame(0), m_Sequence(0), m_RecordFramebuffer(0), m_RecordInterval(1), m_RecordStart(0), m_RecordedFrame(-1)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+	setSlotCount(4);
+}
+
+FrameCapture::~FrameCapture()
+{
+	m_Writer.stop();
+}
+
+void FrameCapture::setSlotCount(int count)
+{
+	if (getPendingCount() > 0)
+		return;
+	for (size_t s = 0; s < m_Slots.size(); s++)
+	{
+		if (m_Slots[s].buffer != 0)
+			glDeleteBuffers(1, &m_Slots[s].buffer);
+	}
+	Slot slot;
+	slot.buffer = 0;
+	slot.capacity = 0;
+	slot.memory = NULL;
+	slot.fence = 0;
+	slot.state = SlotFree;
+	slot.sequence = 0;
+	m_Slots.assign(std::max(1, count), slot);
+}
+
+int FrameCapture::getPendingCount() const
+{
+	int pending = 0;
+	for (size_t s = 0; s < m_Slots.size(); s++)
+	{
+		if (m_Slots[s].state != SlotFree)
+			pending++;
+	}
+	return pending;
+}
+
+const CaptureStats& FrameCapture::getStats()
+{
+	m_Writer.getStats(m_Stats);
+	return m_Stats;
+}
+
+void FrameCapture::addTime(double time)
+{
+	m_Stats.submitTime += time;
+	m_Stats.maxSubmitTime = std::max(m_Stats.maxSubmitTime, time);
+}
+
+FrameCapture::Slot* FrameCapture::acquireSlot(size_t size, bool recording)
+{
+	// Recordings leave a buffer to the screenshots
+	if (recording && getPendingCount() >= (int)m_Slots.size() - 1)
+		return NULL;
+	size_t s = 0;
+	while (s < m_Slots.size() && m_Slots[s].state != SlotFree)
+		s++;
+	if (s == m_Slots.size())
+		return NULL;
+
+	Slot& slot = m_Slots[s];
+	if (slot.capacity < size)
+	{
+		// Mapped as long as the buffer lives, the writer reading it directly
+		GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		if (slot.buffer != 0)
+			glDeleteBuffers(1, &slot.buffer);
+		glCreateBuffers(1, &slot.buffer);
+		glNamedBufferStorage(slot.buffer, size, NULL, flags);
+		slot.memory = static_cast<unsigned char*>(glMapNamedBufferRange(slot.buffer, 0, size, flags));
+		slot.capacity = slot.memory != NULL ? size : 0;
+		if (slot.memory == NULL)
+		{
+			LOG_ERROR << "FrameCapture : could not map the readback buffer" << std::endl;
+			glDeleteBuffers(1, &slot.buffer);
+			slot.buffer = 0;
+			return NULL;
+		}
+	}
+	slot.job.slot = (int)s;
+	return &slot;
+}
+
+void FrameCapture::readBack(Slot& slot, GLuint framebuffer, int width, int height)
+{
+	GLint readFramebuffer;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glNamedFramebufferReadBuffer(framebuffer, framebuffer != 0 ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.state = SlotReading;
+	slot.sequence = m_Sequence++;
+	slot.job.width = width;
+	slot.job.height = height;
+	slot.job.pixels = slot.memory;
+	m_Writer.start();
+}
+
+bool FrameCapture::capture(GLuint framebuffer, int width, int height, const std::string& filename, CaptureFormat format)
+{
+	Clock::time_point start = Clock::now();
+	m_Stats.requested++;
+	Slot* slot = acquireSlot((size_t)width * height * 4, false);
+	if (slot == NULL)
+	{
+		LOG_WARNING << "FrameCapture : " << filename << " dropped, " << m_Slots.size() << " captures in flight" << std::endl;
+		m_Stats.dropped++;
+		return false;
+	}
+	readBack(*slot, framebuffer, width, height);
+	slot->job.filename = filename;
+	slot->job.format = format;
+	addTime(millisecondsSince(start));
+	return true;
+}
+
+bool FrameCapture::startRecording(GLuint framebuffer, int width, int height, const std::string& target, int interval, int fps)
+{
+	stopRecording();
+	std::shared_ptr<VideoStream> stream = std::make_shared<VideoStream>(target, VideoStream::formatFromName(target), width, height, fps);
+	if (!stream->isOpen())
+	{
+		LOG_ERROR << "FrameCapture : could not open " << target << std::endl;
+		return false;
+	}
+	m_Recording = stream;
+	m_RecordFramebuffer = framebuffer;
+	m_RecordInterval = std::max(1, interval);
+	m_RecordStart = m_Frame;
+	m_RecordedFrame = -1;
+	LOG_INFO << "FrameCapture : recording " << width << " x " << height << " every " << m_RecordInterval << " frames to " << target << std::endl;
+	return true;
+}
+
+void FrameCapture::stopRecording()
+{
+	if (!m_Recording)
+		return;
+	LOG_INFO << "FrameCapture : recording stopped" << std::endl;
+	m_Recording.reset();
+}
+
+void FrameCapture::recordFrame(GLuint framebuffer)
+{
+	// Once per frame, every interval-th frame
+	if (!isRecording(framebuffer) || m_RecordedFrame == m_Frame)
+		return;
+	m_RecordedFrame = m_Frame;
+	if ((m_Frame - m_RecordStart) % m_RecordInterval != 0)
+		return;
+
+	Clock::time_point start = Clock::now();
+	m_Stats.frames++;
+	int width = m_Recording->getWidth(), height = m_Recording->getHeight();
+	Slot* slot = acquireSlot((size_t)width * height * 4, true);
+	if (slot == NULL)
+		m_Stats.droppedFrames++;
+	else
+	{
+		readBack(*slot, framebuffer, width, height);
+		slot->job.filename.clear();
+		slot->job.stream = m_Recording;
+	}
+	double time = millisecondsSince(start);
+	m_Stats.recordTime += time;
+	addTime(time);
+}
+
+void FrameCapture::update()
+{
+	Clock::time_point start = Clock::now();
+	m_Frame++;
+	m_Finished.clear();
+	m_Writer.popFinished(m_Finished);
+	for (size_t i = 0; i < m_Finished.size(); i++)
+		m_Slots[m_Finished[i]].state = SlotFree;
+
+	m_Reading.clear();
+	for (size_t s = 0; s < m_Slots.size(); s++)
+	{
+		if (m_Slots[s].state == SlotReading)
+			m_Reading.push_back(&m_Slots[s]);
+	}
+	if (m_Reading.empty())
+		return;
+
+	// In the order of the readbacks, for the frames of a recording
+	std::sort(m_Reading.begin(), m_Reading.end(), [](const Slot* a, const Slot* b) { return a->sequence < b->sequence; });
+	for (size_t i = 0; i < m_Reading.size(); i++)
+	{
+		Slot& slot = *m_Reading[i];
+		GLenum status = glClientWaitSync(slot.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		glDeleteSync(slot.fence);
+		slot.fence = 0;
+		slot.state = SlotWriting;
+		m_Writer.submit(slot.job);
+		slot.job.stream.reset();
+	}
+	addTime(millisecondsSince(start));
+}
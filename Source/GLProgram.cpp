@@ -3,15 +3,40 @@
 #include "utils.hpp"
 #include <vector>
 #include<iostream>
+#include <sstream>
 
 #include "Scene.h"
 
+// Source of a shader, the lines #include "file" being replaced by file (path relative to the including file)
+static std::string readShaderSource(const std::string& filename)
+{
+	static const std::string Directive = "#include \"";
+	std::string directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+	std::istringstream lines(readFile(filename));
+	std::string source, line;
+	while (std::getline(lines, line))
+	{
+		size_t begin = line.find_first_not_of(" \t");
+		size_t end = std::string::npos;
+		if (begin != std::string::npos && line.compare(begin, Directive.size(), Directive) == 0)
+		{
+			begin += Directive.size();
+			end = line.find('"', begin);
+		}
+		if (end != std::string::npos)
+			source += readShaderSource(directory + line.substr(begin, end - begin));
+		else
+			source += line + "\n";
+	}
+	return source;
+}
+
 GLProgram::GLProgram(std::string filename,GLenum type):
     m_Type(type),m_filename(filename)
 {
 	info_text = "";
 
-	std::string str = readFile(filename);
+	std::string str = readShaderSource(filename);
 	const GLchar * srcCode = str.c_str();
 
     m_Id = glCreateShaderProgramv(type, 1, &srcCode);
@@ -5,6 +5,7 @@
  */
 #include <iostream>
 #include "GeometricModel.h"
+#include "TriangleBVH.h"
 #include "Scene.h"
 using namespace std;
 
@@ -27,16 +28,19 @@ GeometricModel::GeometricModel()
 {
     nb_vertex = 0;
     nb_faces = 0;
+    m_BVH = NULL;
 }
 GeometricModel::GeometricModel(std::string name,bool loadnow)
 {
     nb_vertex = 0;
     nb_faces = 0;
+    m_BVH = NULL;
     m_Name = name;
     show_interface = false;
     if (loadnow)
 	{
 		loader->loadModel(name,this);
+		computeBoundingBox();
     }
 		
     
@@ -44,10 +48,28 @@ GeometricModel::GeometricModel(std::string name,bool loadnow)
 }
 GeometricModel::~GeometricModel()
 {
-	
-    
+    delete m_BVH;
 }
-const std::string GeometricModel::getName()
+
+TriangleBVH* GeometricModel::getBVH()
+{
+    if (m_BVH == NULL)
+    {
+        m_BVH = new TriangleBVH();
+        if (!listFaces.empty())
+            m_BVH->build(&listVertex[0], &listFaces[0].s1, (int)listFaces.size());
+        LOG_INFO << "BVH of " << m_Name << " built in " << m_BVH->getBuildTime() << " ms (" << m_BVH->getNodeCount() << " nodes)" << std::endl;
+    }
+    return m_BVH;
+}
+void GeometricModel::computeBoundingBox()
+{
+    boundingBox = AABB();
+    for (size_t i = 0; i < listVertex.size(); i++)
+        boundingBox.expand(listVertex[i]);
+}
+
+const std::string& GeometricModel::getName() const
 {
     return m_Name;
 }
@@ -63,5 +85,7 @@ void GeometricModel::displayInterface()
         ImGui::Text("Has Texture coordinates");
     else
         ImGui::Text("No Texture coordinates found");
+    if (m_BVH != NULL)
+        ImGui::Text("Picking BVH : %d nodes, built in %.1f ms", m_BVH->getNodeCount(), m_BVH->getBuildTime());
         
 }
@@ -242,4 +242,5 @@ void OBJLoader::computeTangents(GeometricModel *model) {
 	}
 
 	delete[] tan1;
+	delete[] tan2;
 }
\ No newline at end of file
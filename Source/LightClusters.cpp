@@ -0,0 +1,209 @@
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "ThreadPool.h"
+
+static const int ParallelThreshold = 64;	// Minimum light count to bin the slices in parallel
+
+LightClusters::LightClusters(int tilesX, int tilesY, int slices) :
+	m_TilesX(tilesX), m_TilesY(tilesY), m_Slices(slices), m_Near(0.0f), m_Far(0.0f), m_DepthScale(0.0f), m_DepthBias(0.0f),
+	m_MaxLightsPerCluster(0), m_BinTime(0.0)
+{
+	m_Clusters.resize(getClusterCount());
+	for (size_t i = 0; i < m_Clusters.size(); i++)
+		m_Clusters[i].offset = m_Clusters[i].count = 0;
+}
+
+LightClusters::~LightClusters()
+{
+}
+
+void LightClusters::setup(const glm::mat4& projection, float zNear, float zFar)
+{
+	m_Near = zNear;
+	m_Far = zFar;
+	float logRatio = std::log(zFar / zNear);
+	m_DepthScale = (float)m_Slices / logRatio;
+	m_DepthBias = -(float)m_Slices * std::log(zNear) / logRatio;
+
+	// Direction of the tile corners, scaled to a unit view depth: the point at depth d is d * direction
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	std::vector<glm::vec3> corners((m_TilesX + 1) * (m_TilesY + 1));
+	for (int y = 0; y <= m_TilesY; y++)
+	{
+		for (int x = 0; x <= m_TilesX; x++)
+		{
+			glm::vec4 ndc(-1.0f + 2.0f * x / m_TilesX, -1.0f + 2.0f * y / m_TilesY, -1.0f, 1.0f);
+			glm::vec4 p = inverseProjection * ndc;
+			glm::vec3 point = glm::vec3(p) / p.w;
+			corners[y * (m_TilesX + 1) + x] = point / -point.z;
+		}
+	}
+
+	int count = getClusterCount();
+	m_ClusterMin.resize(count);
+	m_ClusterMax.resize(count);
+	m_ColumnBounds.assign(m_Slices * m_TilesX, glm::vec2(FLT_MAX, -FLT_MAX));
+	m_RowBounds.assign(m_Slices * m_TilesY, glm::vec2(FLT_MAX, -FLT_MAX));
+	for (int s = 0; s < m_Slices; s++)
+	{
+		float depth0 = zNear * std::pow(zFar / zNear, (float)s / m_Slices);
+		float depth1 = zNear * std::pow(zFar / zNear, (float)(s + 1) / m_Slices);
+		for (int y = 0; y < m_TilesY; y++)
+		{
+			for (int x = 0; x < m_TilesX; x++)
+			{
+				glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+				for (int c = 0; c < 4; c++)
+				{
+					glm::vec3 direction = corners[(y + c / 2) * (m_TilesX + 1) + x + c % 2];
+					bmin = glm::min(bmin, glm::min(direction * depth0, direction * depth1));
+					bmax = glm::max(bmax, glm::max(direction * depth0, direction * depth1));
+				}
+				int cluster = clusterIndex(x, y, s);
+				m_ClusterMin[cluster] = bmin;
+				m_ClusterMax[cluster] = bmax;
+
+				glm::vec2& column = m_ColumnBounds[s * m_TilesX + x];
+				column = glm::vec2(std::min(column.x, bmin.x), std::max(column.y, bmax.x));
+				glm::vec2& row = m_RowBounds[s * m_TilesY + y];
+				row = glm::vec2(std::min(row.x, bmin.y), std::max(row.y, bmax.y));
+			}
+		}
+	}
+}
+
+int LightClusters::sliceOf(float depth) const
+{
+	if (depth < m_Near || depth > m_Far)
+		return -1;
+	int slice = (int)std::floor(std::log(depth) * m_DepthScale + m_DepthBias);
+	return std::min(std::max(slice, 0), m_Slices - 1);
+}
+
+void LightClusters::bin(const PointLight* lights, int count, const glm::mat4& view, int threads)
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+	if (threads <= 0)
+		threads = std::max(1, (int)std::thread::hardware_concurrency());
+	if (count < ParallelThreshold)
+		threads = 1;
+	if (m_ClusterMin.empty())
+		count = 0;
+
+	// View space lights and the range of slices they overlap
+	m_ViewLights.resize(count);
+	m_LightSlices.resize(count);
+	parallelFor(count, threads, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			PointLight l = lights[i];
+			l.position = glm::vec3(view * glm::vec4(l.position, 1.0f));
+			m_ViewLights[i] = l;
+
+			float depth = -l.position.z;
+			if (depth + l.radius < m_Near || depth - l.radius > m_Far)
+				m_LightSlices[i] = glm::ivec2(1, 0);
+			else
+				m_LightSlices[i] = glm::ivec2(sliceOf(std::max(depth - l.radius, m_Near)), sliceOf(std::min(depth + l.radius, m_Far)));
+		}
+	});
+
+	m_SliceBins.resize(m_Slices);
+	parallelFor(m_Slices, threads, [this](int begin, int end) {
+		for (int s = begin; s < end; s++)
+			binSlice(s, m_SliceBins[s]);
+	});
+
+	// Concatenate the slice lists
+	int tiles = m_TilesX * m_TilesY;
+	size_t total = 0;
+	for (int s = 0; s < m_Slices; s++)
+		total += m_SliceBins[s].indices.size();
+	m_Indices.resize(total);
+	m_Clusters.resize(getClusterCount());
+	m_MaxLightsPerCluster = 0;
+
+	unsigned int base = 0;
+	for (int s = 0; s < m_Slices; s++)
+	{
+		const SliceBin& b = m_SliceBins[s];
+		for (int t = 0; t < tiles; t++)
+		{
+			LightCluster& c = m_Clusters[s * tiles + t];
+			c.offset = base + b.offsets[t];
+			c.count = b.counts[t];
+			m_MaxLightsPerCluster = std::max(m_MaxLightsPerCluster, (int)c.count);
+		}
+		if (!b.indices.empty())
+			std::copy(b.indices.begin(), b.indices.end(), m_Indices.begin() + base);
+		base += (unsigned int)b.indices.size();
+	}
+
+	m_BinTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void LightClusters::binSlice(int slice, SliceBin& b)
+{
+	int tiles = m_TilesX * m_TilesY;
+	b.counts.assign(tiles, 0);
+	b.offsets.resize(tiles);
+	b.pairs.clear();
+
+	const glm::vec2* columns = &m_ColumnBounds[slice * m_TilesX];
+	const glm::vec2* rows = &m_RowBounds[slice * m_TilesY];
+	for (size_t i = 0; i < m_ViewLights.size(); i++)
+	{
+		if (slice < m_LightSlices[i].x || slice > m_LightSlices[i].y)
+			continue;
+
+		const PointLight& l = m_ViewLights[i];
+		float r2 = l.radius * l.radius;
+
+		// Columns and rows are ordered along x and y, only the tiles of the ones overlapped by the sphere are tested
+		int x0 = 0, x1 = m_TilesX - 1, y0 = 0, y1 = m_TilesY - 1;
+		while (x0 <= x1 && columns[x0].y < l.position.x - l.radius) x0++;
+		while (x1 >= x0 && columns[x1].x > l.position.x + l.radius) x1--;
+		while (y0 <= y1 && rows[y0].y < l.position.y - l.radius) y0++;
+		while (y1 >= y0 && rows[y1].x > l.position.y + l.radius) y1--;
+
+		for (int y = y0; y <= y1; y++)
+		{
+			for (int x = x0; x <= x1; x++)
+			{
+				int cluster = clusterIndex(x, y, slice);
+				glm::vec3 closest = glm::clamp(l.position, m_ClusterMin[cluster], m_ClusterMax[cluster]);
+				glm::vec3 d = closest - l.position;
+				if (glm::dot(d, d) <= r2)
+				{
+					unsigned int tile = (unsigned int)(y * m_TilesX + x);
+					b.pairs.push_back(glm::uvec2(tile, (unsigned int)i));
+					b.counts[tile]++;
+				}
+			}
+		}
+	}
+
+	// Group the lights by tile, keeping them in increasing order
+	unsigned int offset = 0;
+	for (int t = 0; t < tiles; t++)
+	{
+		b.offsets[t] = offset;
+		offset += b.counts[t];
+	}
+	b.indices.resize(b.pairs.size());
+	std::vector<unsigned int>& cursor = b.counts;
+	for (int t = 0; t < tiles; t++)
+		cursor[t] = b.offsets[t];
+	for (size_t p = 0; p < b.pairs.size(); p++)
+		b.indices[cursor[b.pairs[p].x]++] = b.pairs[p].y;
+	// Back to counts
+	for (int t = 0; t < tiles; t++)
+		b.counts[t] -= b.offsets[t];
+}
@@ -1,12 +1,98 @@
 #include <iostream>
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
 #include "Application.h"
+#include "SceneFile.h"
 
 using namespace std;
 
+static void usage() {
+    cout << "Usage: OpenGLTemplate [--benchmark] [--frames N] [--warmup N] [--timestep ms] [--output report.json]" << endl;
+    cout << "                      [--width W] [--height H] [--egl]" << endl;
+    cout << "  --benchmark  render a scripted camera path in an invisible window and write a JSON report" << endl;
+    cout << "  --egl        create the OpenGL context with EGL (e.g. Mesa llvmpipe without a GPU)" << endl;
+    cout << "Scene files:" << endl;
+    cout << "  --scene FILE               load a binary or text scene instead of the default scene" << endl;
+    cout << "  --convert-scene TEXT BIN   write the binary scene of a text scene and exit" << endl;
+    cout << "Procedural scene (replaces the default scene when --scene-nodes is given):" << endl;
+    cout << "  --scene-nodes N            generated nodes, up to 1000000" << endl;
+    cout << "  --scene-breadth N          maximum sons per node (default 10)" << endl;
+    cout << "  --scene-depth N            maximum depth of the hierarchy (default 4)" << endl;
+    cout << "  --scene-mesh sphere|grid|terrain" << endl;
+    cout << "  --scene-triangles N        triangles per mesh (default 200)" << endl;
+    cout << "  --scene-instancing R       fraction of nodes sharing an existing mesh, in [0, 1] (default 0.99)" << endl;
+    cout << "  --scene-material-sharing R fraction of nodes sharing an existing material, in [0, 1] (default 0.999)" << endl;
+    cout << "  --scene-extent S           side of the cube holding the nodes (default scales with the node count)" << endl;
+    cout << "  --scene-lights N           point lights with clustered shading (default 0: a single light)" << endl;
+    cout << "  --scene-seed N             random seed, the same seed gives the same scene" << endl;
+    cout << "  --scene-obj DIR            write the meshes as OBJ in DIR and load them through the model loader" << endl;
+}
+
 int main(int argc, char ** argv) {
+    bool benchmark = false, egl = false;
+    int width = 1024, height = 1024;
+    BenchmarkSettings settings;
+    SceneGeneratorSettings scene;
+    bool generated = false;
+    std::string sceneFile;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--benchmark") == 0) {
+            benchmark = true;
+        } else if (strcmp(argv[i], "--egl") == 0) {
+            egl = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && hasValue) {
+            settings.frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            settings.warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timestep") == 0 && hasValue) {
+            settings.timestep = (float) atof(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+            settings.output = argv[++i];
+        } else if (strcmp(argv[i], "--width") == 0 && hasValue) {
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && hasValue) {
+            height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scene") == 0 && hasValue) {
+            sceneFile = argv[++i];
+        } else if (strcmp(argv[i], "--convert-scene") == 0 && i + 2 < argc) {
+            return SceneFile::convert(argv[i + 1], argv[i + 2]) ? 0 : -1;
+        } else if (strcmp(argv[i], "--scene-nodes") == 0 && hasValue) {
+            scene.nodeCount = atoi(argv[++i]);
+            generated = true;
+        } else if (strcmp(argv[i], "--scene-breadth") == 0 && hasValue) {
+            scene.breadth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scene-depth") == 0 && hasValue) {
+            scene.depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scene-mesh") == 0 && hasValue && SceneGenerator::parseMesh(argv[i + 1], scene.mesh)) {
+            i++;
+        } else if (strcmp(argv[i], "--scene-triangles") == 0 && hasValue) {
+            scene.trianglesPerMesh = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scene-instancing") == 0 && hasValue) {
+            scene.instanceSharing = (float) atof(argv[++i]);
+        } else if (strcmp(argv[i], "--scene-material-sharing") == 0 && hasValue) {
+            scene.materialSharing = (float) atof(argv[++i]);
+        } else if (strcmp(argv[i], "--scene-extent") == 0 && hasValue) {
+            scene.extent = (float) atof(argv[++i]);
+        } else if (strcmp(argv[i], "--scene-lights") == 0 && hasValue) {
+            scene.lightCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scene-seed") == 0 && hasValue) {
+            scene.seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--scene-obj") == 0 && hasValue) {
+            scene.objDirectory = argv[++i];
+        } else {
+            usage();
+            return -1;
+        }
+    }
+
     try {
-        Application app;
+        Application app(width, height, "My OpenGL Engine", benchmark, egl, generated ? &scene : nullptr, sceneFile);
+        if (benchmark) {
+            return app.runBenchmark(settings);
+        }
         app.mainLoop();
     } 
     catch(const std::runtime_error &e) {
@@ -1,5 +1,6 @@
 #include "ModelGL.h"
 #include <glm/glm.hpp>
+#include "Profiler.h"
 
 ModelGL::ModelGL(std::string name,bool loadnow)
 {
@@ -101,6 +102,8 @@ void ModelGL::drawGeometry(GLint type)
 		glBindVertexArray(VA_Main);
 
 		glDrawRangeElements(type,0,3*m_Model->nb_faces,3*m_Model->nb_faces, GL_UNSIGNED_INT,0);
+		Profiler::getInstance()->addCounter("Draw calls", 1.0);
+		Profiler::getInstance()->addCounter("Triangles", m_Model->nb_faces);
 
 		glBindVertexArray(0);
 	}
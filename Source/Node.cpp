@@ -7,12 +7,23 @@
 #include "MaterialGL.h"
 
 
-Node::Node(std::string name)
+Node::Node(std::string name) : Node(StringId(name))
 {
-	m_Name = name;
+}
+
+Node::Node(StringId name)
+{
+	m_Name = name.str();
+	m_Id = name;
 	m_Material = NULL;
 	m_Model = NULL;
 	isManipulated = false;
+	spatialProxy = -1;
+	spatialVersion = 0;
+	collectorIndex = -1;
+	m_Father = NULL;
+	m_Occluder = false;
+	m_OccluderProxy = NULL;
 
 	// Frame Creation
 	m_Frame = new Frame();
@@ -32,8 +43,14 @@ Node::Node(const Node& toCopy)
 	this->m_Model = (toCopy.m_Model);
 
 	this->m_Name = string(toCopy.m_Name + "-copy" );
+	this->m_Id = StringId(this->m_Name);
 
 	this->m_Sons = toCopy.m_Sons;
+	this->spatialProxy = -1;
+	this->spatialVersion = 0;
+	this->collectorIndex = -1;
+	this->m_Occluder = toCopy.m_Occluder;
+	this->m_OccluderProxy = toCopy.m_OccluderProxy;
 }
 
 Node::~Node()
@@ -43,14 +60,20 @@ Node::~Node()
 	delete m_Frame;
 }
 
-const std::string Node::getName()
+const std::string& Node::getName() const
 {
 	return(m_Name);
 }
 
+StringId Node::getId() const
+{
+	return m_Id;
+}
+
 void Node::setName(std::string name)
 {
 	m_Name = name;
+	m_Id = StringId(m_Name);
 }
 
 void Node::setModel(ModelGL *m)
@@ -80,6 +103,7 @@ MaterialGL* Node::getMaterial()
 void Node::render(MaterialGL* mat)
 {
 	
+	// Profiled per material by the caller, a zone per node would fill the profiler records of large scenes
 	if (m_Model)
 		if (mat) 
 			mat->render(this);
@@ -90,23 +114,50 @@ void Node::render(MaterialGL* mat)
 void Node::animate(const float elapsedTime)
 {
 	if (m_Material)
-	{
-		
 		m_Material->animate(this, elapsedTime);
-	}
 }
 
 void Node::adopt(Node* son)
 {
+	if (son->m_Father != NULL)
+		son->m_Father->disown(son);
 	son->m_Father = this;
 	son->frame()->attachTo(m_Frame);
 	m_Sons.push_back(son);
+	if (collectorIndex >= 0)
+		Scene::getInstance()->recordChange(SceneChange::Attached, son);
+}
+
+Node* Node::getFather()
+{
+	return m_Father;
 }
 Frame* Node::frame()
 {
 	return m_Frame;
 }
 
+AABB Node::getWorldBounds()
+{
+	if (m_Model == NULL || m_Model->getGeometricModel() == NULL)
+		return AABB();
+	return m_Model->getGeometricModel()->boundingBox.transform(m_Frame->getModelMatrix());
+}
+
+void Node::setOccluder(bool occluder, GeometricModel* proxy)
+{
+	m_Occluder = occluder;
+	m_OccluderProxy = proxy;
+}
+
+GeometricModel* Node::getOccluder()
+{
+	if (!m_Occluder)
+		return NULL;
+	if (m_OccluderProxy != NULL)
+		return m_OccluderProxy;
+	return m_Model != NULL ? m_Model->getGeometricModel() : NULL;
+}
 
 bool Node::disown(Node* son)
 {
@@ -117,6 +168,9 @@ bool Node::disown(Node* son)
 		{
 			m_Frame->detach(son->frame());
 			m_Sons.erase(m_Sons.begin() + i);
+			son->m_Father = NULL;
+			if (son->collectorIndex >= 0)
+				Scene::getInstance()->recordChange(SceneChange::Detached, son);
 			return true;
 		}
 		else
@@ -127,10 +181,10 @@ bool Node::disown(Node* son)
 	return isInLeaves;
 }
 
-Node* Node::getSon(std::string name)
+Node* Node::getSon(StringId name)
 {
-	for (int i = 0;i <= m_Sons.size();i++)
-		if (m_Sons[i]->getName() == name) return m_Sons[i];
+	for (size_t i = 0;i < m_Sons.size();i++)
+		if (m_Sons[i]->getId() == name) return m_Sons[i];
 
 	return NULL;
 }
@@ -149,6 +203,7 @@ void Node::displayInterface()
 		else
 			Scene::getInstance()->manipulateNode("Scene");
 	}
+	ImGui::Checkbox("Occluder", &m_Occluder);
 
 	ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.06f, 0.86f, 0.05f, 0.45f));
 	ImGui::PushStyleColor(ImGuiCol_HeaderHovered,ImVec4(0.38f, 0.98f, 0.33f, 0.80f));
@@ -164,10 +219,8 @@ void Node::displayInterface()
 	ImGui::PushStyleColor(ImGuiCol_HeaderActive, ImVec4(0.86f, 0.8f, 0.15f, 0.30f));
 	if (m_Model != NULL)
 	{
-		std::string name = m_Model->getName();
-		if (name.size() == 0)
-			name = "Model";
-		if (ImGui::CollapsingHeader(name.c_str()))
+		const std::string& name = m_Model->getName();
+		if (ImGui::CollapsingHeader(name.empty() ? "Model" : name.c_str()))
 			m_Model->displayInterface();
 	}
 
@@ -0,0 +1,223 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+
+// Vertices closer than this clip space w are considered behind the near plane
+static const float NearW = 1e-4f;
+
+OcclusionCuller::OcclusionCuller(int width, int height) : m_ViewProjection(1.0f)
+{
+	resize(width, height);
+	beginFrame(m_ViewProjection);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+void OcclusionCuller::resize(int width, int height)
+{
+	m_TilesX = std::max(1, (width + TileSize - 1) / TileSize);
+	m_TilesY = std::max(1, (height + TileSize - 1) / TileSize);
+	m_Width = m_TilesX * TileSize;
+	m_Height = m_TilesY * TileSize;
+	m_Depth.assign(m_Width * m_Height, 1.0f);
+	m_TileMax.assign(m_TilesX * m_TilesY, 1.0f);
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProjection)
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+	m_ViewProjection = viewProjection;
+	std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+	std::fill(m_TileMax.begin(), m_TileMax.end(), 1.0f);
+	m_OccluderTriangles = 0;
+	m_Tested = 0;
+	m_Occluded = 0;
+
+	m_RasterTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void OcclusionCuller::renderOccluder(const glm::vec3* vertices, const int* indices, int triangleCount, const glm::mat4& model)
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+	glm::mat4 mvp = m_ViewProjection * model;
+	for (int i = 0; i < triangleCount; i++)
+	{
+		glm::vec4 c0 = mvp * glm::vec4(vertices[indices[3 * i]], 1.0f);
+		glm::vec4 c1 = mvp * glm::vec4(vertices[indices[3 * i + 1]], 1.0f);
+		glm::vec4 c2 = mvp * glm::vec4(vertices[indices[3 * i + 2]], 1.0f);
+
+		// Not clipped : skipping the triangle only makes the culling less aggressive
+		if (c0.w < NearW || c1.w < NearW || c2.w < NearW)
+			continue;
+		rasterizeTriangle(c0, c1, c2);
+	}
+	m_OccluderTriangles += triangleCount;
+
+	m_RasterTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2)
+{
+	// Screen space position (pixel units) and depth in [0,1]
+	glm::vec3 p[3];
+	const glm::vec4* c[3] = { &c0, &c1, &c2 };
+	for (int k = 0; k < 3; k++)
+	{
+		float invW = 1.0f / c[k]->w;
+		p[k] = glm::vec3((c[k]->x * invW * 0.5f + 0.5f) * m_Width,
+			(c[k]->y * invW * 0.5f + 0.5f) * m_Height,
+			c[k]->z * invW * 0.5f + 0.5f);
+	}
+
+	// Occluders may be open meshes seen from both sides : rasterize both windings
+	float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+	if (std::fabs(area) < 1e-8f)
+		return;
+	if (area < 0.0f)
+	{
+		std::swap(p[1], p[2]);
+		area = -area;
+	}
+
+	int minX = std::max(0, (int)std::floor(std::min(p[0].x, std::min(p[1].x, p[2].x))));
+	int maxX = std::min(m_Width - 1, (int)std::ceil(std::max(p[0].x, std::max(p[1].x, p[2].x))));
+	int minY = std::max(0, (int)std::floor(std::min(p[0].y, std::min(p[1].y, p[2].y))));
+	int maxY = std::min(m_Height - 1, (int)std::ceil(std::max(p[0].y, std::max(p[1].y, p[2].y))));
+	if (minX > maxX || minY > maxY)
+		return;
+	minX &= ~3;	// Start on a 4 pixel boundary (m_Width is a multiple of 4)
+
+	// Edge functions e(x,y) = a * x + b * y + c, positive inside, evaluated at pixel centers
+	float a[3], b[3], e[3];
+	for (int k = 0; k < 3; k++)
+	{
+		const glm::vec3& v0 = p[k];
+		const glm::vec3& v1 = p[(k + 1) % 3];
+		a[k] = v0.y - v1.y;
+		b[k] = v1.x - v0.x;
+		e[k] = a[k] * (minX + 0.5f - v0.x) + b[k] * (minY + 0.5f - v0.y);
+	}
+
+	// Depth plane z(x,y) = z0 + dzdx * x + dzdy * y
+	float invArea = 1.0f / area;
+	float dzdx = (a[1] * p[0].z + a[2] * p[1].z + a[0] * p[2].z) * invArea;
+	float dzdy = (b[1] * p[0].z + b[2] * p[1].z + b[0] * p[2].z) * invArea;
+	float z = p[0].z + dzdx * (minX + 0.5f - p[0].x) + dzdy * (minY + 0.5f - p[0].y);
+
+	__m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	__m128 zero = _mm_setzero_ps();
+	__m128 rowE0 = _mm_add_ps(_mm_set1_ps(e[0]), _mm_mul_ps(_mm_set1_ps(a[0]), lane));
+	__m128 rowE1 = _mm_add_ps(_mm_set1_ps(e[1]), _mm_mul_ps(_mm_set1_ps(a[1]), lane));
+	__m128 rowE2 = _mm_add_ps(_mm_set1_ps(e[2]), _mm_mul_ps(_mm_set1_ps(a[2]), lane));
+	__m128 rowZ = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(_mm_set1_ps(dzdx), lane));
+	__m128 stepE0 = _mm_set1_ps(4.0f * a[0]), stepE1 = _mm_set1_ps(4.0f * a[1]), stepE2 = _mm_set1_ps(4.0f * a[2]);
+	__m128 stepZ = _mm_set1_ps(4.0f * dzdx);
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		__m128 e0 = rowE0, e1 = rowE1, e2 = rowE2, zv = rowZ;
+		float* row = &m_Depth[y * m_Width];
+		for (int x = minX; x <= maxX; x += 4)
+		{
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+			if (_mm_movemask_ps(inside))
+			{
+				__m128 depth = _mm_loadu_ps(row + x);
+				__m128 nearer = _mm_min_ps(depth, zv);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, depth)));
+			}
+			e0 = _mm_add_ps(e0, stepE0);
+			e1 = _mm_add_ps(e1, stepE1);
+			e2 = _mm_add_ps(e2, stepE2);
+			zv = _mm_add_ps(zv, stepZ);
+		}
+		rowE0 = _mm_add_ps(rowE0, _mm_set1_ps(b[0]));
+		rowE1 = _mm_add_ps(rowE1, _mm_set1_ps(b[1]));
+		rowE2 = _mm_add_ps(rowE2, _mm_set1_ps(b[2]));
+		rowZ = _mm_add_ps(rowZ, _mm_set1_ps(dzdy));
+	}
+}
+
+void OcclusionCuller::finalize()
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+	for (int ty = 0; ty < m_TilesY; ty++)
+	{
+		for (int tx = 0; tx < m_TilesX; tx++)
+		{
+			__m128 m = _mm_setzero_ps();
+			for (int y = ty * TileSize; y < (ty + 1) * TileSize; y++)
+			{
+				const float* row = &m_Depth[y * m_Width + tx * TileSize];
+				for (int x = 0; x < TileSize; x += 4)
+					m = _mm_max_ps(m, _mm_loadu_ps(row + x));
+			}
+			float lanes[4];
+			_mm_storeu_ps(lanes, m);
+			m_TileMax[ty * m_TilesX + tx] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		}
+	}
+
+	m_RasterTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool OcclusionCuller::isVisible(const AABB& box)
+{
+	m_Tested++;
+
+	// Screen rectangle and nearest depth of the box corners
+	glm::vec2 rectMin(FLT_MAX), rectMax(-FLT_MAX);
+	float nearest = FLT_MAX;
+	for (int k = 0; k < 8; k++)
+	{
+		glm::vec3 corner((k & 1) ? box.max.x : box.min.x, (k & 2) ? box.max.y : box.min.y, (k & 4) ? box.max.z : box.min.z);
+		glm::vec4 c = m_ViewProjection * glm::vec4(corner, 1.0f);
+		if (c.w < NearW)
+			return true;
+		float invW = 1.0f / c.w;
+		glm::vec2 s((c.x * invW * 0.5f + 0.5f) * m_Width, (c.y * invW * 0.5f + 0.5f) * m_Height);
+		rectMin = glm::min(rectMin, s);
+		rectMax = glm::max(rectMax, s);
+		nearest = std::min(nearest, c.z * invW * 0.5f + 0.5f);
+	}
+
+	// Outside of the screen : left to the frustum culling
+	if (rectMax.x < 0.0f || rectMax.y < 0.0f || rectMin.x >= m_Width || rectMin.y >= m_Height)
+		return true;
+
+	int minX = std::max(0, (int)std::floor(rectMin.x));
+	int maxX = std::min(m_Width - 1, (int)std::floor(rectMax.x));
+	int minY = std::max(0, (int)std::floor(rectMin.y));
+	int maxY = std::min(m_Height - 1, (int)std::floor(rectMax.y));
+
+	// Tiles first, then the pixels of the tiles that are not entirely in front of the box
+	for (int ty = minY / TileSize; ty <= maxY / TileSize; ty++)
+	{
+		for (int tx = minX / TileSize; tx <= maxX / TileSize; tx++)
+		{
+			if (nearest > m_TileMax[ty * m_TilesX + tx])
+				continue;
+
+			int y0 = std::max(minY, ty * TileSize), y1 = std::min(maxY, (ty + 1) * TileSize - 1);
+			int x0 = std::max(minX, tx * TileSize), x1 = std::min(maxX, (tx + 1) * TileSize - 1);
+			for (int y = y0; y <= y1; y++)
+			{
+				const float* row = &m_Depth[y * m_Width];
+				for (int x = x0; x <= x1; x++)
+					if (nearest <= row[x])
+						return true;
+			}
+		}
+	}
+
+	m_Occluded++;
+	return false;
+}
@@ -0,0 +1,122 @@
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+
+#include "FrameBufferObject.h"
+#include "Texture2D.h"
+
+RenderTargetDesc::RenderTargetDesc(int _width, int _height, GLenum colorFormat, GLenum _depthFormat, RenderTargetUsage _usage) :
+	width(_width), height(_height), depthFormat(_depthFormat), sampledDepth(false), samples(1), usage(_usage)
+{
+	if (colorFormat != 0)
+		colorFormats.push_back(colorFormat);
+}
+
+RenderTargetPool::RenderTargetPool() :
+	m_Textures(30), m_Renderbuffers(30)
+{
+}
+
+uint64_t RenderTargetPool::makeKey(int width, int height, GLenum format, int samples, RenderTargetUsage usage)
+{
+	// Internal formats fit 16 bits
+	return ((uint64_t)(width & 0xFFFF) << 48) | ((uint64_t)(height & 0xFFFF) << 32) | ((uint64_t)(usage & 0xFF) << 24)
+		| ((uint64_t)(samples & 0xFF) << 16) | (uint64_t)(format & 0xFFFF);
+}
+
+size_t RenderTargetPool::getRenderbufferSize(int width, int height, GLenum format, int samples)
+{
+	return Texture2D::getStorageSize(format, width, height, 1) * std::max(1, samples);
+}
+
+Texture2D* RenderTargetPool::acquireTexture(int width, int height, GLenum format, RenderTargetUsage usage)
+{
+	uint64_t key = makeKey(width, height, format, 0, usage);
+	Texture2D* texture;
+	if (!m_Textures.acquire(key, texture))
+	{
+		texture = new Texture2D(width, height, (GLint)format);
+		// Before the handle is created on the first getHandle
+		if (usage == RenderTargetShadowMap)
+		{
+			glTextureParameteri(texture->getId(), GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTextureParameteri(texture->getId(), GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		}
+		m_Textures.add(key, texture, texture->getMemorySize());
+	}
+	return texture;
+}
+
+void RenderTargetPool::releaseTexture(Texture2D* texture)
+{
+	if (texture != NULL)
+		m_Textures.release(texture);
+}
+
+GLuint RenderTargetPool::acquireRenderbuffer(int width, int height, GLenum format, int samples)
+{
+	samples = samples > 1 ? samples : 0;
+	uint64_t key = makeKey(width, height, format, samples);
+	GLuint renderbuffer;
+	if (!m_Renderbuffers.acquire(key, renderbuffer))
+	{
+		glCreateRenderbuffers(1, &renderbuffer);
+		glNamedRenderbufferStorageMultisample(renderbuffer, samples, format, width, height);
+		m_Renderbuffers.add(key, renderbuffer, getRenderbufferSize(width, height, format, samples));
+	}
+	return renderbuffer;
+}
+
+void RenderTargetPool::releaseRenderbuffer(GLuint renderbuffer)
+{
+	if (renderbuffer != 0)
+		m_Renderbuffers.release(renderbuffer);
+}
+
+FrameBufferObject* RenderTargetPool::acquire(const RenderTargetDesc& desc)
+{
+	FrameBufferObject* target;
+	if (m_FreeFramebuffers.empty())
+		target = new FrameBufferObject("Transient", desc);
+	else
+	{
+		// Framebuffer names do not depend on the attachments. The last released, so that the oldest expire
+		target = m_FreeFramebuffers.back().first;
+		m_FreeFramebuffers.pop_back();
+		target->reconfigure(desc);
+	}
+	return target;
+}
+
+void RenderTargetPool::release(FrameBufferObject* target)
+{
+	target->destroy();
+	m_FreeFramebuffers.push_back(std::make_pair(target, m_Textures.getFrame()));
+}
+
+void RenderTargetPool::setKeepFrames(int frames)
+{
+	m_Textures.setKeepFrames(frames);
+	m_Renderbuffers.setKeepFrames(frames);
+}
+
+void RenderTargetPool::update()
+{
+	long long frame = m_Textures.getFrame();
+	m_ExpiredTextures.clear();
+	m_Textures.endFrame(m_ExpiredTextures);
+	for (size_t i = 0; i < m_ExpiredTextures.size(); i++)
+		delete m_ExpiredTextures[i];
+
+	// Deleting a renderbuffer still used by submitted commands is deferred by the driver
+	m_ExpiredRenderbuffers.clear();
+	m_Renderbuffers.endFrame(m_ExpiredRenderbuffers);
+	if (!m_ExpiredRenderbuffers.empty())
+		glDeleteRenderbuffers((GLsizei)m_ExpiredRenderbuffers.size(), &m_ExpiredRenderbuffers[0]);
+
+	// More framebuffers than the passes used at once over the last keepFrames frames
+	size_t expired = 0;
+	while (expired < m_FreeFramebuffers.size() && m_FreeFramebuffers[expired].second <= frame - m_Textures.getKeepFrames())
+		delete m_FreeFramebuffers[expired++].first;
+	m_FreeFramebuffers.erase(m_FreeFramebuffers.begin(), m_FreeFramebuffers.begin() + expired);
+}
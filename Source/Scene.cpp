@@ -1,9 +1,12 @@
 #include "Scene.h"
 #include "EffectGL.h"
+#include "TriangleBVH.h"
 
 #include "imgui_internal.h"
+#include <algorithm>
 Scene::Scene()
 {
+    m_Collector = NULL;
 
     LOG_TRACE << "Creating Scene" << std::endl;
     // Get the root Node
@@ -41,17 +44,21 @@ Camera* Scene::camera()
 void Scene::nextManipulatedNode()
 {
     current_ManipulatedNode->isManipulated = false;
-    current_ManipulatedNode = m_Nodes.nextObject(current_ManipulatedNode->getName());
+    current_ManipulatedNode = m_Nodes.nextObject(current_ManipulatedNode->getId());
     if (current_ManipulatedNode == m_Root)
-        current_ManipulatedNode = m_Nodes.nextObject(current_ManipulatedNode->getName());
+        current_ManipulatedNode = m_Nodes.nextObject(current_ManipulatedNode->getId());
     current_ManipulatedNode->isManipulated = true;
     LOG_INFO << "manipulating Node " << current_ManipulatedNode->getName() << std::endl;
 }
 void Scene::manipulateNode(std::string name)
+{
+    manipulateNode(StringId(name));
+}
+void Scene::manipulateNode(StringId name)
 {
     Node* c_node =  m_Nodes.find(name);
     if (c_node == NULL)
-        LOG_WARNING << "Error : Node " << name << " does not exists." << std::endl;
+        LOG_WARNING << "Error : Node " << name.str() << " does not exists." << std::endl;
     else
     {
         if (current_ManipulatedNode != NULL)
@@ -83,14 +90,156 @@ Node* Scene::getNode(std::string name)
     return(m_Nodes.get(name));
 }
 
+Node* Scene::getNode(StringId name)
+{
+    return(m_Nodes.get(name));
+}
+
+Node* Scene::findNode(StringId name)
+{
+    return(m_Nodes.find(name));
+}
+
 
 void Scene::releaseNode(Node *n)
 {
-    m_Nodes.release(n->getName());
+    StringId id = n->getId();
+    if (m_Nodes.getReferences(id) <= 1)
+    {
+        // The collector must not keep the node nor reach the sons through it once it is deleted
+        if (n->getFather() != NULL)
+            n->getFather()->disown(n);
+        while (!n->m_Sons.empty())
+            n->disown(n->m_Sons.back());
+        applyChanges();
+        removeLight(n);
+        removeSpatialNode(n);
+    }
+    m_Nodes.release(id);
+}
+
+void Scene::recordChange(SceneChange::Type type, Node* n)
+{
+    if (m_Collector != NULL)
+    {
+        SceneChange change = { type, n };
+        m_Changes.push_back(change);
+    }
+}
+
+void Scene::setCollector(IncrementalNodeCollector* c)
+{
+    m_Collector = c;
+    m_Changes.clear();
+}
+
+void Scene::applyChanges()
+{
+    if (m_Collector == NULL || m_Changes.empty())
+        return;
+    m_RemovedNodes.clear();
+    m_Collector->apply(m_Changes, &m_RemovedNodes);
+    m_Changes.clear();
+    for (size_t i = 0; i < m_RemovedNodes.size(); i++)
+        removeSpatialNode(m_RemovedNodes[i]);
 }
 void Scene::releaseNode(std::string name)
 {
-    m_Nodes.release(name);
+    Node* n = m_Nodes.find(name);
+    if (n != NULL)
+        releaseNode(n);
+}
+
+void Scene::addLight(Node* n, glm::vec3 color, float intensity, float radius)
+{
+    SceneLight light = { n, color, intensity, radius };
+    for (size_t i = 0; i < m_Lights.size(); i++)
+    {
+        if (m_Lights[i].node == n)
+        {
+            m_Lights[i] = light;
+            return;
+        }
+    }
+    m_Lights.push_back(light);
+}
+
+void Scene::removeLight(Node* n)
+{
+    for (size_t i = 0; i < m_Lights.size(); i++)
+    {
+        if (m_Lights[i].node == n)
+        {
+            m_Lights.erase(m_Lights.begin() + i);
+            return;
+        }
+    }
+}
+
+void Scene::collectLights(std::vector<PointLight>& lights)
+{
+    lights.resize(m_Lights.size());
+    for (size_t i = 0; i < m_Lights.size(); i++)
+    {
+        const SceneLight& l = m_Lights[i];
+        lights[i].position = glm::vec3(l.node->frame()->getModelMatrix()[3]);
+        lights[i].radius = l.radius;
+        lights[i].color = l.color;
+        lights[i].intensity = l.intensity;
+    }
+}
+
+void Scene::updateSpatialNode(Node* n)
+{
+    if (n->getModel() == NULL)
+    {
+        removeSpatialNode(n);
+        return;
+    }
+
+    AABB bounds = n->getWorldBounds();
+    if (n->spatialProxy == DynamicAABBTree<Node*>::NullNode)
+        n->spatialProxy = m_SpatialIndex.createProxy(bounds, n);
+    else
+        m_SpatialIndex.moveProxy(n->spatialProxy, bounds);
+    // The update flag of the frame belongs to its other users
+    n->spatialVersion = n->frame()->getVersion();
+}
+
+void Scene::removeSpatialNode(Node* n)
+{
+    if (n->spatialProxy != DynamicAABBTree<Node*>::NullNode)
+    {
+        m_SpatialIndex.destroyProxy(n->spatialProxy);
+        n->spatialProxy = DynamicAABBTree<Node*>::NullNode;
+    }
+}
+
+void Scene::queryFrustum(const Frustum& f, std::vector<Node*>& result)
+{
+    m_SpatialIndex.query(f, [&result](Node* n) { result.push_back(n); });
+}
+
+void Scene::querySphere(const BoundingSphere& s, std::vector<Node*>& result)
+{
+    m_SpatialIndex.query(s, [&result](Node* n) { result.push_back(n); });
+}
+
+void Scene::queryBox(const AABB& b, std::vector<Node*>& result)
+{
+    m_SpatialIndex.query(b, [&result](Node* n) { result.push_back(n); });
+}
+
+void Scene::queryRay(const Ray& r, std::vector<Node*>& result, float maxDistance)
+{
+    std::vector< std::pair<float, Node*> > hits;
+    m_SpatialIndex.raycast(r, maxDistance, [&hits, maxDistance](Node* n, float t) {
+        hits.push_back(std::make_pair(t, n));
+        return maxDistance;
+    });
+    std::sort(hits.begin(), hits.end(), [](const std::pair<float, Node*>& a, const std::pair<float, Node*>& b) { return a.first < b.first; });
+    for (size_t i = 0; i < hits.size(); i++)
+        result.push_back(hits[i].second);
 }
 
 void Scene::releaseModel(string a)
@@ -102,6 +251,35 @@ void Scene::releaseModel(ModelGL *m)
     m_Models.release(m->getName());
 }
 
+Node* Scene::pickNode(const Ray& r, float* distance)
+{
+    Node* picked = NULL;
+    float closest = FLT_MAX;
+
+    // Candidates come from the spatial index, the traversal is pruned by the closest triangle hit so far
+    m_SpatialIndex.raycast(r, closest, [&picked, &closest, &r](Node* n, float tEnter) {
+        // Nodes without geometry are not pickable, nor boxes entered behind the closest hit
+        GeometricModel* model = n->getModel() != NULL ? n->getModel()->getGeometricModel() : NULL;
+        if (model == NULL || tEnter > closest)
+            return closest;
+        glm::mat4 toModel = glm::inverse(n->frame()->getModelMatrix());
+
+        // The direction is not normalized, so that distances along the model space ray match the world ones
+        Ray localRay(glm::vec3(toModel * glm::vec4(r.origin, 1.0f)), glm::vec3(toModel * glm::vec4(r.direction, 0.0f)));
+        RayHit hit;
+        if (model->getBVH()->intersect(localRay, hit, closest))
+        {
+            closest = hit.t;
+            picked = n;
+        }
+        return closest;
+    });
+
+    if (picked != NULL && distance != NULL)
+        *distance = closest;
+    return picked;
+}
+
 void Scene::resizeViewport(int w, int h)
 {
     m_width = w;
@@ -158,7 +336,7 @@ void Scene::displayInterface()
 
         if (ImGui::RadioButton(n->getName().c_str(), current_ManipulatedNode == n))
         {
-            manipulateNode(n->getName());
+            manipulateNode(n->getId());
         }
 
 
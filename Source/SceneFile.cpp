@@ -0,0 +1,520 @@
+#include "SceneFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Node.h"
+
+static const char Magic[4] = { 'O', 'G', 'L', 'S' };
+// Nodes created by the Scene itself, the loaded nodes go under them
+static const char* const ReservedNodeNames[] = { "Root", "Scene" };
+
+static bool isReservedNodeName(const char* s, size_t length)
+{
+	for (size_t i = 0; i < sizeof(ReservedNodeNames) / sizeof(ReservedNodeNames[0]); i++)
+		if (strlen(ReservedNodeNames[i]) == length && memcmp(ReservedNodeNames[i], s, length) == 0)
+			return true;
+	return false;
+}
+
+SceneFile::SceneFile() :
+	m_Header(NULL), m_Models(NULL), m_Materials(NULL), m_Nodes(NULL), m_Lights(NULL), m_Strings(NULL)
+{
+}
+
+SceneFile::~SceneFile()
+{
+}
+
+bool SceneFile::open(const std::string& filename)
+{
+	close();
+	if (!m_File.open(filename))
+	{
+		LOG_ERROR << "SceneFile : could not map " << filename << std::endl;
+		return false;
+	}
+	if (!validate(filename))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void SceneFile::close()
+{
+	m_File.close();
+	m_Header = NULL;
+	m_Models = NULL;
+	m_Materials = NULL;
+	m_Nodes = NULL;
+	m_Lights = NULL;
+	m_Strings = NULL;
+}
+
+bool SceneFile::validate(const std::string& filename)
+{
+	const unsigned char* data = m_File.data();
+	if (m_File.size() < sizeof(SceneFileHeader) || memcmp(data, Magic, sizeof(Magic)) != 0)
+	{
+		LOG_ERROR << "SceneFile : " << filename << " is not a binary scene" << std::endl;
+		return false;
+	}
+	const SceneFileHeader* h = reinterpret_cast<const SceneFileHeader*>(data);
+	if (h->version != Version)
+	{
+		LOG_ERROR << "SceneFile : " << filename << " has version " << h->version << ", expected " << Version << std::endl;
+		return false;
+	}
+
+	// Sections in file order, sizes computed on 64 bits so that huge counts cannot wrap around
+	unsigned long long modelsOffset = sizeof(SceneFileHeader);
+	unsigned long long materialsOffset = modelsOffset + (unsigned long long)h->modelCount * sizeof(SceneFileModel);
+	unsigned long long nodesOffset = materialsOffset + (unsigned long long)h->materialCount * sizeof(SceneFileMaterial);
+	unsigned long long lightsOffset = nodesOffset + (unsigned long long)h->nodeCount * sizeof(SceneFileNode);
+	unsigned long long stringsOffset = lightsOffset + (unsigned long long)h->lightCount * sizeof(SceneFileLight);
+	if (stringsOffset + h->stringBytes > m_File.size())
+	{
+		LOG_ERROR << "SceneFile : " << filename << " is truncated" << std::endl;
+		return false;
+	}
+
+	const SceneFileModel* models = reinterpret_cast<const SceneFileModel*>(data + modelsOffset);
+	const SceneFileMaterial* materials = reinterpret_cast<const SceneFileMaterial*>(data + materialsOffset);
+	const SceneFileNode* nodes = reinterpret_cast<const SceneFileNode*>(data + nodesOffset);
+	const SceneFileLight* lights = reinterpret_cast<const SceneFileLight*>(data + lightsOffset);
+
+	const char* strings = reinterpret_cast<const char*>(data + stringsOffset);
+	unsigned long long stringBytes = h->stringBytes;
+	// In range, and hashed as stored: names are interned with the stored hash, a wrong one would make another id
+	auto validString = [strings, stringBytes](const SceneFileString& s) {
+		return (unsigned long long)s.offset + s.length <= stringBytes && hashString(strings + s.offset, s.length) == s.hash;
+	};
+	bool valid = true;
+	for (uint32_t i = 0; i < h->modelCount && valid; i++)
+		valid = validString(models[i].name) && models[i].type <= SceneModelTerrain;
+	for (uint32_t i = 0; i < h->materialCount && valid; i++)
+		valid = validString(materials[i].name) && materials[i].type <= SceneMaterialRotation;
+	for (uint32_t i = 0; i < h->nodeCount && valid; i++)
+	{
+		const SceneFileNode& n = nodes[i];
+		// Fathers come first, so the hierarchy has no cycle and is built in a single pass
+		valid = validString(n.name)
+			&& n.parent >= -1 && n.parent < (int32_t)i
+			&& n.model >= -1 && n.model < (int64_t)h->modelCount
+			&& n.material >= -1 && n.material < (int64_t)h->materialCount;
+	}
+	for (uint32_t i = 0; i < h->lightCount && valid; i++)
+		valid = lights[i].node < h->nodeCount;
+	if (!valid)
+	{
+		LOG_ERROR << "SceneFile : " << filename << " holds an invalid name or index" << std::endl;
+		return false;
+	}
+
+	// Nodes are found by name when created: a name given twice, or the name of a node of the Scene, would make a node
+	// adopt itself or one of its fathers
+	std::unordered_map<uint32_t, std::vector<uint32_t> > nodesByHash;
+	nodesByHash.reserve(h->nodeCount);
+	for (uint32_t i = 0; i < h->nodeCount && valid; i++)
+	{
+		const SceneFileString& name = nodes[i].name;
+		valid = !isReservedNodeName(strings + name.offset, name.length);
+		std::vector<uint32_t>& sameHash = nodesByHash[name.hash];
+		for (size_t j = 0; j < sameHash.size() && valid; j++)
+		{
+			const SceneFileString& other = nodes[sameHash[j]].name;
+			valid = other.length != name.length || memcmp(strings + other.offset, strings + name.offset, name.length) != 0;
+		}
+		sameHash.push_back(i);
+	}
+	if (!valid)
+	{
+		LOG_ERROR << "SceneFile : " << filename << " holds a duplicate or reserved node name" << std::endl;
+		return false;
+	}
+
+	m_Header = h;
+	m_Models = models;
+	m_Materials = materials;
+	m_Nodes = nodes;
+	m_Lights = lights;
+	m_Strings = strings;
+	return true;
+}
+
+bool SceneFile::isBinary(const std::string& filename)
+{
+	char magic[4];
+	std::ifstream file(filename, std::ios::binary);
+	return file.read(magic, sizeof(magic)) && memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+void SceneFile::createNodes(Resource_mgr<Node>& nodes, Node* root, const std::vector<ModelGL*>& models,
+	const std::vector<MaterialGL*>& materials, std::vector<Node*>& created) const
+{
+	int count = getNodeCount();
+	nodes.reserve(nodes.size() + count);
+	created.resize(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		const SceneFileNode& r = m_Nodes[i];
+		StringId name = getId(r.name);
+		// Created directly rather than through get, which logs every creation
+		Node* n = nodes.find(name);
+		if (n == NULL)
+		{
+			n = new Node(name);
+			nodes.insert(name, n, 1);
+		}
+		else
+			nodes.get(name);
+		created[i] = n;
+		// A node of the manager found by name cannot adopt one of its fathers (validate rejects the file's own cases)
+		Node* father = r.parent < 0 ? root : created[r.parent];
+		bool cycle = false;
+		for (Node* f = father; f != NULL && !cycle; f = f->getFather())
+			cycle = f == n;
+		if (cycle)
+			LOG_WARNING << "SceneFile : node " << name.str() << " is a father of its new father, left in place" << std::endl;
+		else
+			father->adopt(n);
+
+		const float* t = r.transform;
+		n->frame()->setUpFromMatrix(glm::mat4(t[0], t[1], t[2], 0.0f, t[3], t[4], t[5], 0.0f, t[6], t[7], t[8], 0.0f, t[9], t[10], t[11], 1.0f));
+
+		if (r.model >= 0 && r.model < (int)models.size())
+			n->setModel(models[r.model]);
+		if (r.material >= 0 && r.material < (int)materials.size())
+			n->setMaterial(materials[r.material]);
+		if (r.flags & SceneNodeOccluder)
+			n->setOccluder(true);
+	}
+}
+
+namespace
+{
+	// Text scene being converted, the records being written as they are in the binary file
+	class SceneWriter
+	{
+	public:
+		SceneWriter(const std::string& filename) : m_Filename(filename), m_Line(0)
+		{
+			memset(&m_Header, 0, sizeof(m_Header));
+			memcpy(m_Header.magic, Magic, sizeof(Magic));
+			m_Header.version = SceneFile::Version;
+		}
+
+		bool parse(std::istream& in)
+		{
+			std::string line;
+			while (std::getline(in, line))
+			{
+				m_Line++;
+				size_t comment = line.find('#');
+				if (comment != std::string::npos)
+					line.resize(comment);
+				std::istringstream s(line);
+				std::string statement;
+				if (!(s >> statement))
+					continue;
+
+				bool ok;
+				if (statement == "camera")
+					ok = parseCamera(s);
+				else if (statement == "model")
+					ok = parseModel(s);
+				else if (statement == "material")
+					ok = parseMaterial(s);
+				else if (statement == "node")
+					ok = parseNode(s);
+				else if (statement == "light")
+					ok = parseLight(s);
+				else
+					ok = error("unknown statement " + statement);
+				if (!ok)
+					return false;
+			}
+			return true;
+		}
+
+		bool write(const std::string& filename)
+		{
+			m_Header.modelCount = (uint32_t)m_Models.size();
+			m_Header.materialCount = (uint32_t)m_Materials.size();
+			m_Header.nodeCount = (uint32_t)m_Nodes.size();
+			m_Header.lightCount = (uint32_t)m_Lights.size();
+			m_Header.stringBytes = (uint32_t)m_Strings.size();
+
+			std::ofstream out(filename, std::ios::binary);
+			out.write(reinterpret_cast<const char*>(&m_Header), sizeof(m_Header));
+			writeAll(out, m_Models);
+			writeAll(out, m_Materials);
+			writeAll(out, m_Nodes);
+			writeAll(out, m_Lights);
+			writeAll(out, m_Strings);
+			return (bool)out;
+		}
+
+		size_t getNodeCount() const { return m_Nodes.size(); }
+
+	private:
+		template <typename R> static void writeAll(std::ofstream& out, const std::vector<R>& records)
+		{
+			if (!records.empty())
+				out.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(R));
+		}
+
+		bool error(const std::string& message)
+		{
+			LOG_ERROR << m_Filename << ":" << m_Line << ": " << message << std::endl;
+			return false;
+		}
+
+		SceneFileString addString(const std::string& s)
+		{
+			SceneFileString r = { (uint32_t)m_Strings.size(), (uint32_t)s.size(), hashString(s.c_str(), s.size()) };
+			m_Strings.insert(m_Strings.end(), s.begin(), s.end());
+			return r;
+		}
+
+		// Declares a name, false if it is already declared
+		static bool declare(std::unordered_map<std::string, int>& names, const std::string& name, int index)
+		{
+			return names.insert(std::make_pair(name, index)).second;
+		}
+
+		static bool readFloats(std::istream& s, float* values, int count)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				if (!(s >> values[i]))
+					return false;
+			}
+			return true;
+		}
+
+		bool parseCamera(std::istringstream& s)
+		{
+			std::string key;
+			while (s >> key)
+			{
+				float* target = key == "eye" ? m_Header.cameraEye : key == "target" ? m_Header.cameraTarget : key == "up" ? m_Header.cameraUp : NULL;
+				if (target == NULL || !readFloats(s, target, 3))
+					return error("invalid camera parameter " + key);
+			}
+			m_Header.flags |= SceneFileHasCamera;
+			return true;
+		}
+
+		bool parseModel(std::istringstream& s)
+		{
+			std::string name, type;
+			if (!(s >> name >> type))
+				return error("model expects a name and a type");
+
+			SceneFileModel m;
+			m.triangles = 200;
+			m.seed = 1;
+			if (type == "file")
+				m.type = SceneModelFile;
+			else if (type == "sphere")
+				m.type = SceneModelSphere;
+			else if (type == "grid")
+				m.type = SceneModelGrid;
+			else if (type == "terrain")
+				m.type = SceneModelTerrain;
+			else
+				return error("unknown model type " + type);
+
+			std::string key;
+			while (s >> key)
+			{
+				if (key == "triangles" && (s >> m.triangles))
+					continue;
+				if (key == "seed" && (s >> m.seed))
+					continue;
+				return error("invalid model parameter " + key);
+			}
+			if (!declare(m_ModelNames, name, (int)m_Models.size()))
+				return error("model " + name + " is already declared");
+			m.name = addString(name);
+			m_Models.push_back(m);
+			return true;
+		}
+
+		bool parseMaterial(std::istringstream& s)
+		{
+			std::string name, type;
+			if (!(s >> name >> type))
+				return error("material expects a name and a type");
+
+			// Defaults of PhongMaterial and RotationMaterial
+			SceneFileMaterial m;
+			const float defaults[13] = { 0.92f, 0.77f, 0.10f, 0.98f, 1.00f, 0.00f, 0.66f, 0.63f, 0.08f, 0.4f, 0.25f, 0.75f, 1.0f };
+			const float axis[3] = { 0.0f, 1.0f, 0.0f };
+			memcpy(m.parameters, defaults, sizeof(defaults));
+			if (type == "base")
+				m.type = SceneMaterialBase;
+			else if (type == "phong")
+				m.type = SceneMaterialPhong;
+			else if (type == "phong-clustered")
+				m.type = SceneMaterialPhongClustered;
+			else if (type == "rotation")
+			{
+				m.type = SceneMaterialRotation;
+				memcpy(m.parameters, axis, sizeof(axis));
+			}
+			else
+				return error("unknown material type " + type);
+
+			bool phong = m.type == SceneMaterialPhong || m.type == SceneMaterialPhongClustered;
+			std::string key;
+			while (s >> key)
+			{
+				int offset = -1, count = 1;
+				if (phong && key == "ambient") { offset = 0; count = 3; }
+				else if (phong && key == "diffuse") { offset = 3; count = 3; }
+				else if (phong && key == "light") { offset = 6; count = 3; }
+				else if (phong && key == "ka") offset = 9;
+				else if (phong && key == "kd") offset = 10;
+				else if (phong && key == "ks") offset = 11;
+				else if (phong && key == "cone") offset = 12;
+				else if (m.type == SceneMaterialRotation && key == "axis") { offset = 0; count = 3; }
+				if (offset < 0 || !readFloats(s, m.parameters + offset, count))
+					return error("invalid " + type + " material parameter " + key);
+			}
+			if (!declare(m_MaterialNames, name, (int)m_Materials.size()))
+				return error("material " + name + " is already declared");
+			m.name = addString(name);
+			m_Materials.push_back(m);
+			return true;
+		}
+
+		bool parseNode(std::istringstream& s)
+		{
+			std::string name, father;
+			if (!(s >> name >> father))
+				return error("node expects a name and a father");
+
+			SceneFileNode n;
+			n.parent = n.model = n.material = -1;
+			n.flags = 0;
+			if (father != "-")
+			{
+				std::unordered_map<std::string, int>::const_iterator it = m_NodeNames.find(father);
+				if (it == m_NodeNames.end())
+					return error("father " + father + " is not declared");
+				n.parent = it->second;
+			}
+
+			glm::mat4 matrix(1.0f);
+			std::string key;
+			while (s >> key)
+			{
+				float v[4];
+				std::string reference;
+				if (key == "model" && (s >> reference))
+				{
+					std::unordered_map<std::string, int>::const_iterator it = m_ModelNames.find(reference);
+					if (it == m_ModelNames.end())
+						return error("model " + reference + " is not declared");
+					n.model = it->second;
+				}
+				else if (key == "material" && (s >> reference))
+				{
+					std::unordered_map<std::string, int>::const_iterator it = m_MaterialNames.find(reference);
+					if (it == m_MaterialNames.end())
+						return error("material " + reference + " is not declared");
+					n.material = it->second;
+				}
+				else if (key == "translate" && readFloats(s, v, 3))
+					matrix = glm::translate(matrix, glm::vec3(v[0], v[1], v[2]));
+				else if (key == "rotate" && readFloats(s, v, 4))
+					matrix = glm::rotate(matrix, glm::radians(v[3]), glm::vec3(v[0], v[1], v[2]));
+				else if (key == "scale" && readFloats(s, v, 3))
+					matrix = glm::scale(matrix, glm::vec3(v[0], v[1], v[2]));
+				else if (key == "occluder")
+					n.flags |= SceneNodeOccluder;
+				else
+					return error("invalid node parameter " + key);
+			}
+			for (int c = 0; c < 4; c++)
+			{
+				n.transform[3 * c] = matrix[c].x;
+				n.transform[3 * c + 1] = matrix[c].y;
+				n.transform[3 * c + 2] = matrix[c].z;
+			}
+
+			if (isReservedNodeName(name.c_str(), name.size()))
+				return error("node name " + name + " is reserved");
+			if (!declare(m_NodeNames, name, (int)m_Nodes.size()))
+				return error("node " + name + " is already declared");
+			n.name = addString(name);
+			m_Nodes.push_back(n);
+			return true;
+		}
+
+		bool parseLight(std::istringstream& s)
+		{
+			std::string node;
+			if (!(s >> node))
+				return error("light expects a node");
+			std::unordered_map<std::string, int>::const_iterator it = m_NodeNames.find(node);
+			if (it == m_NodeNames.end())
+				return error("node " + node + " is not declared");
+
+			SceneFileLight l = { (uint32_t)it->second, { 1.0f, 1.0f, 1.0f }, 1.0f, 10.0f };
+			std::string key;
+			while (s >> key)
+			{
+				if (key == "color" && readFloats(s, l.color, 3))
+					continue;
+				if (key == "intensity" && (s >> l.intensity))
+					continue;
+				if (key == "radius" && (s >> l.radius))
+					continue;
+				return error("invalid light parameter " + key);
+			}
+			m_Lights.push_back(l);
+			return true;
+		}
+
+		std::string m_Filename;
+		int m_Line;
+
+		SceneFileHeader m_Header;
+		std::vector<SceneFileModel> m_Models;
+		std::vector<SceneFileMaterial> m_Materials;
+		std::vector<SceneFileNode> m_Nodes;
+		std::vector<SceneFileLight> m_Lights;
+		std::vector<char> m_Strings;
+		std::unordered_map<std::string, int> m_ModelNames, m_MaterialNames, m_NodeNames;
+	};
+}
+
+bool SceneFile::convert(const std::string& textFile, const std::string& binaryFile)
+{
+	std::ifstream in(textFile);
+	if (!in.is_open())
+	{
+		LOG_ERROR << "SceneFile : could not read " << textFile << std::endl;
+		return false;
+	}
+
+	SceneWriter writer(textFile);
+	if (!writer.parse(in))
+		return false;
+	if (!writer.write(binaryFile))
+	{
+		LOG_ERROR << "SceneFile : could not write " << binaryFile << std::endl;
+		return false;
+	}
+	LOG_INFO << "Converted " << textFile << " (" << writer.getNodeCount() << " nodes) to " << binaryFile << std::endl;
+	return true;
+}
@@ -0,0 +1,349 @@
+#include "SceneGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <glm/gtc/constants.hpp>
+
+#include "GeometricModel.h"
+#include "GeometricModelLoader/OBJLoader.h"
+#include "Scene.h"
+#include "PhongMaterial.h"
+
+// Unique resources needed so that a fraction sharing of count users reuse an existing one
+static int uniqueCount(int count, float sharing)
+{
+	sharing = std::min(std::max(sharing, 0.0f), 1.0f);
+	return std::max(1, (int)std::ceil((double)count * (1.0 - sharing)));
+}
+
+// Faces, normals and tangents of a (columns + 1) x (rows + 1) vertex grid, texture coordinates already filled
+static void finishGridMesh(GeometricModel* model, int columns, int rows)
+{
+	model->listFaces.reserve((size_t)2 * columns * rows);
+	for (int j = 0; j < rows; j++)
+	{
+		for (int i = 0; i < columns; i++)
+		{
+			int a = j * (columns + 1) + i;
+			int b = a + columns + 1;
+			model->listFaces.push_back({ a, b, a + 1 });
+			model->listFaces.push_back({ a + 1, b, b + 1 });
+		}
+	}
+	model->listCoordFaces = model->listFaces;
+	model->nb_vertex = (int)model->listVertex.size();
+	model->nb_faces = (int)model->listFaces.size();
+
+	OBJLoader::computeNormals(model);
+	OBJLoader::computeTangents(model);
+	model->computeBoundingBox();
+}
+
+static void clearMesh(GeometricModel* model)
+{
+	model->listVertex.clear();
+	model->listFaces.clear();
+	model->listCoordFaces.clear();
+	model->listNormals.clear();
+	model->listCoords.clear();
+	model->listTangents.clear();
+}
+
+// Square grid of side 2 in the XZ plane, with a height function
+template <typename H> static void createHeightField(GeometricModel* model, int triangles, H height)
+{
+	clearMesh(model);
+	int n = std::max(1, (int)std::lround(std::sqrt(triangles / 2.0)));
+	model->listVertex.reserve((size_t)(n + 1) * (n + 1));
+	model->listCoords.reserve((size_t)(n + 1) * (n + 1));
+	for (int j = 0; j <= n; j++)
+	{
+		for (int i = 0; i <= n; i++)
+		{
+			float u = (float)i / n, v = (float)j / n;
+			float x = 2.0f * u - 1.0f, z = 2.0f * v - 1.0f;
+			model->listVertex.push_back(glm::vec3(x, height(x, z), z));
+			model->listCoords.push_back(glm::vec3(u, v, 0.0f));
+		}
+	}
+	finishGridMesh(model, n, n);
+}
+
+static float hashLattice(int x, int z, unsigned int seed)
+{
+	unsigned int h = (unsigned int)x * 73856093u ^ (unsigned int)z * 19349663u ^ seed * 83492791u;
+	h ^= h >> 13;
+	h *= 0x5bd1e995u;
+	h ^= h >> 15;
+	return (float)(h & 0xffffff) / (float)0xffffff;
+}
+
+// Smoothly interpolated lattice noise in [0, 1]
+static float valueNoise(float x, float z, unsigned int seed)
+{
+	int x0 = (int)std::floor(x), z0 = (int)std::floor(z);
+	float fx = x - x0, fz = z - z0;
+	fx = fx * fx * (3.0f - 2.0f * fx);
+	fz = fz * fz * (3.0f - 2.0f * fz);
+	float a = glm::mix(hashLattice(x0, z0, seed), hashLattice(x0 + 1, z0, seed), fx);
+	float b = glm::mix(hashLattice(x0, z0 + 1, seed), hashLattice(x0 + 1, z0 + 1, seed), fx);
+	return glm::mix(a, b, fz);
+}
+
+SceneGenerator::SceneGenerator(const SceneGeneratorSettings& settings) : m_Settings(settings)
+{
+	m_Settings.nodeCount = std::max(0, std::min(m_Settings.nodeCount, 1000000));
+	m_Settings.breadth = std::max(1, m_Settings.breadth);
+	m_Settings.depth = std::max(1, m_Settings.depth);
+	m_Settings.trianglesPerMesh = std::max(2, m_Settings.trianglesPerMesh);
+}
+
+void SceneGenerator::createSphere(GeometricModel* model, int triangles)
+{
+	clearMesh(model);
+	// Twice as many slices as stacks keeps the quads close to square
+	int stacks = std::max(2, (int)std::lround(std::sqrt(triangles / 4.0)));
+	int slices = 2 * stacks;
+	model->listVertex.reserve((size_t)(slices + 1) * (stacks + 1));
+	model->listCoords.reserve((size_t)(slices + 1) * (stacks + 1));
+	for (int j = 0; j <= stacks; j++)
+	{
+		float phi = glm::pi<float>() * (float)j / stacks;
+		for (int i = 0; i <= slices; i++)
+		{
+			float theta = glm::two_pi<float>() * (float)i / slices;
+			model->listVertex.push_back(glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)));
+			model->listCoords.push_back(glm::vec3((float)i / slices, (float)j / stacks, 0.0f));
+		}
+	}
+	finishGridMesh(model, slices, stacks);
+}
+
+void SceneGenerator::createGrid(GeometricModel* model, int triangles)
+{
+	createHeightField(model, triangles, [](float, float) { return 0.0f; });
+}
+
+void SceneGenerator::createTerrain(GeometricModel* model, int triangles, unsigned int seed)
+{
+	// Five octaves of value noise, the amplitude halving when the frequency doubles
+	createHeightField(model, triangles, [seed](float x, float z)
+	{
+		float h = 0.0f, amplitude = 0.25f, frequency = 2.0f;
+		for (int octave = 0; octave < 5; octave++)
+		{
+			h += amplitude * (valueNoise(x * frequency, z * frequency, seed + octave) - 0.5f);
+			amplitude *= 0.5f;
+			frequency *= 2.0f;
+		}
+		return h;
+	});
+}
+
+bool SceneGenerator::writeOBJ(GeometricModel* model, const std::string& filename)
+{
+	std::ofstream file(filename.c_str());
+	if (!file)
+	{
+		LOG_ERROR << "SceneGenerator : could not write " << filename << std::endl;
+		return false;
+	}
+	for (size_t i = 0; i < model->listVertex.size(); i++)
+		file << "v " << model->listVertex[i].x << " " << model->listVertex[i].y << " " << model->listVertex[i].z << "\n";
+	for (size_t i = 0; i < model->listCoords.size(); i++)
+		file << "vt " << model->listCoords[i].x << " " << model->listCoords[i].y << "\n";
+	// OBJ indices start at 1, positions and texture coordinates share the same numbering
+	bool coords = !model->listCoords.empty();
+	for (size_t i = 0; i < model->listFaces.size(); i++)
+	{
+		const Face& f = model->listFaces[i];
+		if (coords)
+			file << "f " << f.s1 + 1 << "/" << f.s1 + 1 << " " << f.s2 + 1 << "/" << f.s2 + 1 << " " << f.s3 + 1 << "/" << f.s3 + 1 << "\n";
+		else
+			file << "f " << f.s1 + 1 << " " << f.s2 + 1 << " " << f.s3 + 1 << "\n";
+	}
+	return (bool)file;
+}
+
+bool SceneGenerator::parseMesh(const std::string& name, ProceduralMesh& mesh)
+{
+	if (name == "sphere")
+		mesh = ProceduralMesh::Sphere;
+	else if (name == "grid")
+		mesh = ProceduralMesh::Grid;
+	else if (name == "terrain")
+		mesh = ProceduralMesh::Terrain;
+	else
+		return false;
+	return true;
+}
+
+void SceneGenerator::createMesh(GeometricModel* model, int index) const
+{
+	switch (m_Settings.mesh)
+	{
+	case ProceduralMesh::Sphere:
+		createSphere(model, m_Settings.trianglesPerMesh);
+		break;
+	case ProceduralMesh::Grid:
+		createGrid(model, m_Settings.trianglesPerMesh);
+		break;
+	case ProceduralMesh::Terrain:
+		createTerrain(model, m_Settings.trianglesPerMesh, m_Settings.seed * 7919u + (unsigned int)index);
+		break;
+	}
+}
+
+int SceneGenerator::getNodeCount() const
+{
+	// Capacity of the tree: breadth + breadth^2 + ... + breadth^depth
+	long long capacity = 0, level = 1;
+	for (int d = 0; d < m_Settings.depth && capacity < m_Settings.nodeCount; d++)
+	{
+		level = std::min(level * m_Settings.breadth, (long long)m_Settings.nodeCount);
+		capacity += level;
+	}
+	return (int)std::min(capacity, (long long)m_Settings.nodeCount);
+}
+
+int SceneGenerator::getUniqueMeshCount() const
+{
+	return std::min(getNodeCount(), uniqueCount(getNodeCount(), m_Settings.instanceSharing));
+}
+
+int SceneGenerator::getUniqueMaterialCount() const
+{
+	return std::min(getNodeCount(), uniqueCount(getNodeCount(), m_Settings.materialSharing));
+}
+
+float SceneGenerator::getExtent() const
+{
+	// About three mesh diameters between neighbouring nodes
+	if (m_Settings.extent > 0.0f)
+		return m_Settings.extent;
+	return 6.0f * std::cbrt((float)std::max(1, getNodeCount()));
+}
+
+void SceneGenerator::createHierarchy(Resource_mgr<Node>& nodes, Node* parent, std::vector<Node*>& created) const
+{
+	int count = getNodeCount();
+	if (count < m_Settings.nodeCount)
+		LOG_WARNING << "SceneGenerator : breadth " << m_Settings.breadth << " and depth " << m_Settings.depth << " limit the scene to " << count << " nodes" << std::endl;
+
+	std::mt19937 rng(m_Settings.seed);
+	float half = 0.5f * getExtent();
+	std::uniform_real_distribution<float> position(-half, half);
+
+	// World positions are kept to express each translation relatively to the father
+	std::vector<glm::vec3> positions;
+	positions.reserve(count);
+	created.clear();
+	created.reserve(count);
+
+	size_t father = 0;
+	int sons = 0;
+	for (int i = 0; i < count; i++)
+	{
+		Node* n = nodes.get("Generated" + std::to_string(i));
+		glm::vec3 p(position(rng), position(rng), position(rng));
+
+		// The first level goes under parent, then each node receives breadth sons in creation order
+		if (i < m_Settings.breadth)
+		{
+			parent->adopt(n);
+			n->frame()->translate(p);
+		}
+		else
+		{
+			if (sons == m_Settings.breadth)
+			{
+				father++;
+				sons = 0;
+			}
+			created[father]->adopt(n);
+			n->frame()->translate(p - positions[father]);
+			sons++;
+		}
+		created.push_back(n);
+		positions.push_back(p);
+	}
+}
+
+void SceneGenerator::generate(Scene* scene)
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+	std::vector<Node*> created;
+	createHierarchy(scene->m_Nodes, scene->getSceneNode(), created);
+
+	// Shared meshes, either built in memory or written as OBJ and loaded back
+	int meshCount = getUniqueMeshCount();
+	std::vector<ModelGL*> models(meshCount);
+	long long triangles = 0;
+	for (int i = 0; i < meshCount; i++)
+	{
+		if (!m_Settings.objDirectory.empty())
+		{
+			GeometricModel mesh;
+			createMesh(&mesh, i);
+			std::string filename = m_Settings.objDirectory + "/Generated" + std::to_string(i) + ".obj";
+			if (writeOBJ(&mesh, filename))
+				models[i] = scene->m_Models.get<ModelGL>(filename);
+		}
+		else
+		{
+			std::string name = "Generated" + std::to_string(i);
+			ModelGL* model = new ModelGL(name, false);
+			createMesh(model->getGeometricModel(), i);
+			model->loadToGPU();
+			scene->m_Models.insert(name, model);
+			models[i] = model;
+		}
+		if (models[i] != NULL)
+			triangles += models[i]->getGeometricModel()->nb_faces;
+	}
+
+	int materialCount = getUniqueMaterialCount();
+	std::vector<PhongMaterial*> materials(materialCount);
+	for (int i = 0; i < materialCount; i++)
+		materials[i] = new PhongMaterial("Generated" + std::to_string(i), m_Settings.lightCount > 0);
+
+	for (size_t i = 0; i < created.size(); i++)
+	{
+		created[i]->setModel(models[i % meshCount]);
+		created[i]->setMaterial(materials[i % materialCount]);
+	}
+
+	if (m_Settings.lightCount > 0)
+	{
+		// Lights of the scene registry, with a radius such that a point of the cube is reached by about 8 lights
+		float extent = getExtent();
+		float radius = extent * std::cbrt(6.0f / (3.14159265f * m_Settings.lightCount));
+		std::mt19937 rng(m_Settings.seed + 1);
+		std::uniform_real_distribution<float> position(-0.5f * extent, 0.5f * extent);
+		std::uniform_real_distribution<float> color(0.2f, 1.0f);
+		for (int i = 0; i < m_Settings.lightCount; i++)
+		{
+			Node* light = scene->getNode("GeneratedLight" + std::to_string(i));
+			float x = position(rng), y = position(rng), z = position(rng);
+			light->frame()->translate(glm::vec3(x, y, z));
+			scene->getSceneNode()->adopt(light);
+			float r = color(rng), g = color(rng), b = color(rng);
+			scene->addLight(light, glm::vec3(r, g, b), 1.0f, radius);
+		}
+	}
+	else
+	{
+		// Phong materials are lit by the "Light" node, placed above the generated nodes
+		Node* light = scene->getNode("Light");
+		light->frame()->translate(glm::vec3(0.0f, getExtent(), 0.0f));
+		scene->getSceneNode()->adopt(light);
+	}
+
+	double elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	LOG_INFO << "Generated " << created.size() << " nodes (" << meshCount << " meshes, " << triangles << " triangles, "
+		<< materialCount << " materials, " << m_Settings.lightCount << " lights) in " << elapsed << " ms" << std::endl;
+}
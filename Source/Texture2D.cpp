@@ -2,10 +2,12 @@
 
 
 #include <stb/stb_image.h>
+#include "TextureResidency.h"
+#include "TextureStreamer.h"
 
 
 Texture2D::Texture2D(const std::string& filename):
-	name(filename),id(0), handle(0),format(GL_RGBA8),image(NULL)
+	name(filename),id(0),view(0),handle(0),format(GL_RGBA8),levels(1),baseLevel(0),swizzled(false),resident(false),memorySize(0),ready(true),image(NULL)
 {
 	int channels;
 
@@ -21,8 +23,41 @@ Texture2D::Texture2D(const std::string& filename):
 	stbi_image_free(image);
 
 }
+Texture2D::Texture2D(const std::string& filename, bool async):
+	name(filename),id(0),view(0),handle(0),width(0),height(0),format(GL_RGBA8),levels(1),baseLevel(0),swizzled(false),resident(false),memorySize(0),ready(false),image(NULL)
+{
+	if (async)
+		TextureStreamer::getInstance()->request(filename, this);
+	else
+	{
+		// Same as the synchronous constructor
+		int channels;
+		image = stbi_load(filename.c_str(), &width, &height, &channels, 4);
+		if (image == nullptr)
+			std::cout << "Error Loading image file " << filename << endl;
+		else
+			loadToGPU();
+		stbi_image_free(image);
+		image = NULL;
+		ready = true;
+	}
+}
+
+Texture2D::Texture2D(const std::string& filename, TextureCompression compression, TextureUsage usage):
+	name(filename),id(0),view(0),handle(0),width(0),height(0),format(GL_RGBA8),levels(1),baseLevel(0),swizzled(false),resident(false),memorySize(0),ready(true),image(NULL)
+{
+	CompressedImage compressed;
+	if (TextureImporter::getInstance()->import(filename, compression, compressed, usage))
+	{
+		TextureStreamer* streamer = TextureStreamer::getInstance();
+		loadCompressedToGPU(compressed, streamer->getInitialLevel(compressed));
+		if (baseLevel > 0)
+			streamer->streamMips(this, compressed);
+	}
+}
+
 Texture2D::Texture2D(int _width, int _height,GLint _format):
-	width(_width),height(_height),format(_format)
+	id(0),view(0),handle(0),width(_width),height(_height),format(_format),levels(1),baseLevel(0),swizzled(false),resident(false),memorySize(0),ready(true),image(NULL)
 {
 	
 	createEmptyTexture();	
@@ -31,34 +66,166 @@ Texture2D::Texture2D(int _width, int _height,GLint _format):
 
 void Texture2D::createEmptyTexture()
 {
-	int numberOfLevel = (int)(1 + floor(log2(max(width, height))));
+	// Render targets only have their first level written, and get a handle once sampled (see getHandle)
+	createStorage(1);
+}
+
+void Texture2D::createStorage(int _levels)
+{
+	levels = _levels > 0 ? _levels : (int)(1 + floor(log2(max(width, height))));
 	glCreateTextures(GL_TEXTURE_2D, 1, &id);
 
-	glTextureStorage2D(id, numberOfLevel, format, width, height);
-	
-	glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glGenerateTextureMipmap(id);
+	glTextureStorage2D(id, levels, format, width, height);
+	memorySize = getStorageSize(format, width, height, levels);
+	setSamplerState(id);
+}
+
+size_t Texture2D::getStorageSize(GLenum format, int width, int height, int levels)
+{
+	// Bytes per 4 x 4 block for the compressed formats, per texel otherwise
+	size_t blockBytes = 0, texelBytes = 4;
+	switch (format)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RED_RGTC1:
+		blockBytes = 8;
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RG_RGTC2:
+		blockBytes = 16;
+		break;
+	case GL_R8:
+		texelBytes = 1;
+		break;
+	case GL_RG8:
+	case GL_R16F:
+	case GL_DEPTH_COMPONENT16:
+		texelBytes = 2;
+		break;
+	case GL_RGBA16F:
+	case GL_RG32F:
+	case GL_DEPTH32F_STENCIL8:
+		texelBytes = 8;
+		break;
+	case GL_RGBA32F:
+		texelBytes = 16;
+		break;
+	default:
+		// RGBA8, RGB10_A2, R11F_G11F_B10F, R32F, RG16F, 24 and 32 bit depths (RGB8 is padded)
+		break;
+	}
+	size_t size = 0;
+	for (int level = 0; level < levels; level++)
+	{
+		int w = max(1, width >> level), h = max(1, height >> level);
+		size += blockBytes ? (size_t)((w + 3) / 4) * ((h + 3) / 4) * blockBytes : (size_t)w * h * texelBytes;
+	}
+	return size;
+}
+
+void Texture2D::setSamplerState(GLuint texture)
+{
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, levels - baseLevel > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	if (swizzled)
+		glTextureParameteriv(texture, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+}
+
+void Texture2D::beginStreaming(int _width, int _height)
+{
+	width = _width;
+	height = _height;
+	createStorage();
+}
+
+void Texture2D::finishStreaming()
+{
 	makeResident();
+	ready = true;
+}
+
+GLuint64 Texture2D::getHandle()
+{
+	if (!ready)
+		return TextureStreamer::getInstance()->getPlaceholderHandle();
+	if (handle == 0)
+		makeResident();
+	TextureResidency::getInstance()->use(this);
+	return handle;
 }
 
 
 
 void Texture2D::loadToGPU()
 {
-	createEmptyTexture();
+	createStorage();
 
 	glTextureSubImage2D(id, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image);
 	glGenerateTextureMipmap(id);
+	makeResident();
+}
 
+void Texture2D::loadCompressedToGPU(const CompressedImage& compressed, int firstLevel)
+{
+	width = compressed.width;
+	height = compressed.height;
+	format = compressed.getFormat();
+	swizzled = compressed.getSwizzle(swizzle);
+	createStorage(compressed.getLevelCount());
+	// Coarse levels first, so that streamed textures are sampled as soon as possible
+	for (int level = levels - 1; level >= firstLevel; level--)
+		uploadLevel(compressed, level);
+	setBaseLevel(firstLevel);
+}
+
+void Texture2D::uploadLevel(const CompressedImage& compressed, int level)
+{
+	int w = max(1, width >> level), h = max(1, height >> level);
+	const unsigned char* data = &compressed.data[compressed.levelOffsets[level]];
+	if (compressed.isCompressed())
+		glCompressedTextureSubImage2D(id, level, 0, 0, w, h, format, (GLsizei)compressed.levelSizes[level], data);
+	else
+		glTextureSubImage2D(id, level, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, data);
+}
+
+void Texture2D::setBaseLevel(int level)
+{
+	GLuint previousView = view;
+	GLuint64 previousHandle = resident ? handle : 0;
+	baseLevel = level;
+	view = 0;
+	if (level > 0)
+	{
+		// A view needs a name that was never bound
+		glGenTextures(1, &view);
+		glTextureView(view, GL_TEXTURE_2D, id, format, level, levels - level, 0, 1);
+		setSamplerState(view);
+	}
+	makeResident();
+	if (previousView != 0)
+		TextureStreamer::getInstance()->retireTexture(previousView, previousHandle);
 }
 
 void Texture2D::makeResident()
 {
-	handle = glGetTextureHandleARB(id);
+	handle = glGetTextureHandleARB(view != 0 ? view : id);
 	glMakeTextureHandleResidentARB(handle);
+	resident = true;
+	TextureResidency::getInstance()->add(this, memorySize);
+}
+
+void Texture2D::setResident(bool _resident)
+{
+	if (_resident == resident || handle == 0)
+		return;
+	if (_resident)
+		glMakeTextureHandleResidentARB(handle);
+	else
+		glMakeTextureHandleNonResidentARB(handle);
+	resident = _resident;
 
 }
 
@@ -67,5 +234,14 @@ void Texture2D::makeResident()
 
 Texture2D::~Texture2D()
 {
-
+	TextureStreamer* streamer = TextureStreamer::getInstance();
+	// Pending loads and mip streams keep a pointer to the texture
+	if (!ready || baseLevel > 0)
+		streamer->cancel(this);
+	TextureResidency::getInstance()->remove(this);
+	// Deleted once the frames submitted until now no longer sample them
+	if (view != 0)
+		streamer->retireTexture(view, resident ? handle : 0);
+	if (id != 0)
+		streamer->retireTexture(id, view == 0 && resident ? handle : 0);
 }
@@ -0,0 +1,492 @@
+#include "TextureImporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <stb/stb_image.h>
+#include <image_DXT.h>
+
+#include "DXTCompressor.h"
+#include "Logger/ImGuiLogger.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+static const unsigned int DDSMagic = ('D' << 0) | ('D' << 8) | ('S' << 16) | (' ' << 24);
+static const unsigned int FourCCDXT1 = ('D' << 0) | ('X' << 8) | ('T' << 16) | ('1' << 24);
+static const unsigned int FourCCDXT5 = ('D' << 0) | ('X' << 8) | ('T' << 16) | ('5' << 24);
+static const unsigned int FourCCATI1 = ('A' << 0) | ('T' << 8) | ('I' << 16) | ('1' << 24);
+static const unsigned int FourCCATI2 = ('A' << 0) | ('T' << 8) | ('I' << 16) | ('2' << 24);
+// Written in the reserved words of the header, before the source hash, the source channels and the PSNR (in 1/100 dB)
+static const unsigned int CacheTag = ('O' << 0) | ('G' << 8) | ('L' << 16) | ('T' << 24);
+// Hashed with the source, so that caches written by an older mip filter or encoder are built again
+static const unsigned char CacheVersion = 2;
+
+static size_t levelSize(int width, int height, TextureCompression compression)
+{
+	if (compression == TextureUncompressed)
+		return (size_t)width * height * 4;
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * (compression == TextureBC3 || compression == TextureBC5 ? 16 : 8);
+}
+
+GLenum CompressedImage::getFormat() const
+{
+	switch (compression)
+	{
+	case TextureUncompressed: return GL_RGBA8;
+	case TextureBC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case TextureBC4: return GL_COMPRESSED_RED_RGTC1;
+	case TextureBC5: return GL_COMPRESSED_RG_RGTC2;
+	default: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+}
+
+bool CompressedImage::getSwizzle(GLint swizzle[4]) const
+{
+	if (compression == TextureBC4 && channels == 1)
+	{
+		swizzle[0] = swizzle[1] = swizzle[2] = GL_RED;
+		swizzle[3] = GL_ONE;
+		return true;
+	}
+	if (compression == TextureBC5 && channels == 2)
+	{
+		swizzle[0] = swizzle[1] = swizzle[2] = GL_RED;
+		swizzle[3] = GL_GREEN;
+		return true;
+	}
+	return false;
+}
+
+// sRGB transfer functions: 8 bit values to linear, and linear values quantized to LinearSteps to 8 bits
+static const int LinearSteps = 16384;
+
+struct GammaTables
+{
+	float toLinear[256];
+	unsigned char toSRGB[LinearSteps + 1];
+
+	GammaTables()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			float c = i / 255.0f;
+			toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int i = 0; i <= LinearSteps; i++)
+		{
+			float c = (float)i / LinearSteps;
+			c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+			toSRGB[i] = (unsigned char)std::min(255.0f, c * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const GammaTables& gammaTables()
+{
+	static const GammaTables tables;
+	return tables;
+}
+
+void TextureImporter::generateMip(const unsigned char* src, int width, int height, unsigned char* dst, TextureUsage usage, int threads)
+{
+	int w = std::max(1, width / 2), h = std::max(1, height / 2);
+	const GammaTables& gamma = gammaTables();
+	bool srgb = usage == TextureUsageColor, normals = usage == TextureUsageNormalMap;
+	if (threads <= 0)
+		threads = std::max(1, (int)std::thread::hardware_concurrency());
+	// Each thread gets at least 64 K pixels of the level
+	threads = std::max(1, std::min(threads, (int)((size_t)w * h / 65536)));
+
+	parallelFor(h, threads, [&](int begin, int end) {
+		for (int y = begin; y < end; y++)
+		{
+			const unsigned char* row0 = src + (size_t)std::min(2 * y, height - 1) * width * 4;
+			const unsigned char* row1 = src + (size_t)std::min(2 * y + 1, height - 1) * width * 4;
+			for (int x = 0; x < w; x++)
+			{
+				// The last row or column is repeated for odd sizes
+				int x0 = std::min(2 * x, width - 1) * 4, x1 = std::min(2 * x + 1, width - 1) * 4;
+				unsigned char* out = &dst[((size_t)y * w + x) * 4];
+				for (int c = 0; c < 4; c++)
+				{
+					if (srgb && c < 3)
+					{
+						// Averaged as light, not as encoded values
+						float sum = gamma.toLinear[row0[x0 + c]] + gamma.toLinear[row0[x1 + c]]
+							+ gamma.toLinear[row1[x0 + c]] + gamma.toLinear[row1[x1 + c]];
+						out[c] = gamma.toSRGB[(int)(sum * (LinearSteps / 4.0f) + 0.5f)];
+					}
+					else
+						out[c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+				}
+				if (normals)
+				{
+					// Averaged normals are shorter than 1
+					float v[3], length = 0.0f;
+					for (int c = 0; c < 3; c++)
+					{
+						v[c] = out[c] / 127.5f - 1.0f;
+						length += v[c] * v[c];
+					}
+					length = length > 0.0f ? 1.0f / std::sqrt(length) : 0.0f;
+					for (int c = 0; c < 3; c++)
+						out[c] = (unsigned char)std::min(255.0f, std::max(0.0f, (v[c] * length + 1.0f) * 127.5f + 0.5f));
+				}
+			}
+		}
+	});
+}
+
+size_t TextureImporter::uncompressedSize(int width, int height)
+{
+	size_t size = 0;
+	for (;;)
+	{
+		size += (size_t)width * height * 4;
+		if (width == 1 && height == 1)
+			return size;
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+}
+
+uint64_t TextureImporter::hashBytes(const unsigned char* data, size_t size, uint64_t hash)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+std::string TextureImporter::cacheName(const std::string& filename, TextureCompression compression, TextureUsage usage)
+{
+	static const char* const usageNames[] = { "color", "normal", "mask" };
+	return filename + "." + getCompressionName(compression) + "." + usageNames[usage] + ".dds";
+}
+
+const char* TextureImporter::getCompressionName(TextureCompression compression)
+{
+	switch (compression)
+	{
+	case TextureUncompressed: return "RGBA8";
+	case TextureBC1: return "BC1";
+	case TextureBC3: return "BC3";
+	case TextureBC4: return "BC4";
+	case TextureBC5: return "BC5";
+	default: return "Auto";
+	}
+}
+
+TextureCompression TextureImporter::chooseCompression(const unsigned char* rgba, int width, int height, int channels, TextureUsage usage)
+{
+	if (usage == TextureUsageNormalMap)
+		return TextureBC5;
+	if (usage == TextureUsageMask || channels == 1)
+		return TextureBC4;
+	if (channels == 2)
+		return TextureBC5;
+	for (size_t i = 3; i < (size_t)width * height * 4; i += 4)
+	{
+		if (rgba[i] != 255)
+			return TextureBC3;
+	}
+	return TextureBC1;
+}
+
+// BC4 / BC5 blocks of bands of block rows, image_DXT compressing each band as an image
+static unsigned char* compressRGTC(const unsigned char* pixels, int width, int height, int channels, bool bc5, int* size)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	size_t rowBytes = (size_t)blocksX * (bc5 ? 16 : 8);
+	int threads = std::max(1, std::min((int)std::thread::hardware_concurrency(), blocksY / 16));
+	*size = (int)(rowBytes * blocksY);
+	unsigned char* blocks = (unsigned char*)malloc(*size);
+	parallelFor(blocksY, threads, [&](int begin, int end) {
+		int bandHeight = std::min(height, 4 * end) - 4 * begin, bandSize;
+		const unsigned char* band = pixels + (size_t)4 * begin * width * channels;
+		unsigned char* out = bc5 ? convert_image_to_BC5(band, width, bandHeight, channels, &bandSize)
+			: convert_image_to_BC4(band, width, bandHeight, channels, &bandSize);
+		memcpy(blocks + rowBytes * begin, out, bandSize);
+		free(out);
+	});
+	return blocks;
+}
+
+// Blocks of one level (a copy of the pixels for RGBA8). Grey alpha images keep their grey and alpha in BC5.
+static unsigned char* compressLevel(const unsigned char* rgba, int width, int height, int channels, TextureCompression compression,
+	std::vector<unsigned char>& greyAlpha, int* size)
+{
+	switch (compression)
+	{
+	case TextureUncompressed:
+		*size = width * height * 4;
+		return (unsigned char*)memcpy(malloc(*size), rgba, *size);
+	case TextureBC3:
+		return compressDXT5(rgba, width, height, 4, size);
+	case TextureBC4:
+		return compressRGTC(rgba, width, height, 4, false, size);
+	case TextureBC5:
+		if (channels != 2)
+			return compressRGTC(rgba, width, height, 4, true, size);
+		greyAlpha.resize((size_t)width * height * 2);
+		for (size_t i = 0; i < (size_t)width * height; i++)
+		{
+			greyAlpha[2 * i] = rgba[4 * i];
+			greyAlpha[2 * i + 1] = rgba[4 * i + 3];
+		}
+		return compressRGTC(&greyAlpha[0], width, height, 2, true, size);
+	default:
+		return compressDXT1(rgba, width, height, 4, size);
+	}
+}
+
+double TextureImporter::computePSNR(const unsigned char* rgba, int channels, const unsigned char* blocks, int width, int height,
+	TextureCompression compression)
+{
+	if (compression == TextureUncompressed)
+		return 99.0;
+	std::vector<unsigned char> decoded((size_t)width * height * 4);
+	switch (compression)
+	{
+	case TextureBC3: decompressDXT5(blocks, width, height, &decoded[0]); break;
+	case TextureBC4: decompressBC4(blocks, width, height, &decoded[0]); break;
+	case TextureBC5: decompressBC5(blocks, width, height, &decoded[0]); break;
+	default: decompressDXT1(blocks, width, height, &decoded[0]); break;
+	}
+	// Source channel of each decoded channel
+	int sources[4] = { 0, 1, 2, 3 };
+	int count = compression == TextureBC1 ? 3 : (compression == TextureBC3 ? 4 : (compression == TextureBC4 ? 1 : 2));
+	if (compression == TextureBC5 && channels == 2)
+		sources[1] = 3;
+
+	double error = 0.0;
+	for (size_t p = 0; p < (size_t)width * height; p++)
+	{
+		for (int c = 0; c < count; c++)
+		{
+			double d = (double)rgba[p * 4 + sources[c]] - decoded[p * 4 + c];
+			error += d * d;
+		}
+	}
+	double mse = error / ((double)width * height * count);
+	return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+void TextureImporter::compress(const unsigned char* rgba, int width, int height, int channels, TextureCompression compression,
+	TextureUsage usage, CompressedImage& image)
+{
+	if (compression < TextureUncompressed || compression > TextureBC5)
+		compression = chooseCompression(rgba, width, height, channels, usage);
+	image.width = width;
+	image.height = height;
+	image.compression = compression;
+	image.channels = channels;
+	image.levelOffsets.clear();
+	image.levelSizes.clear();
+	image.data.clear();
+	image.data.reserve(levelSize(width, height, compression) * 4 / 3 + 16);
+
+	std::vector<unsigned char> level(rgba, rgba + (size_t)width * height * 4), next, greyAlpha;
+	for (;;)
+	{
+		int size = 0;
+		unsigned char* blocks = compressLevel(&level[0], width, height, channels, compression, greyAlpha, &size);
+		if (image.levelSizes.empty())
+			image.psnr = computePSNR(&level[0], channels, blocks, width, height, compression);
+		image.levelOffsets.push_back(image.data.size());
+		image.levelSizes.push_back(size);
+		image.data.insert(image.data.end(), blocks, blocks + size);
+		free(blocks);
+
+		if (width == 1 && height == 1)
+			return;
+		next.resize((size_t)std::max(1, width / 2) * std::max(1, height / 2) * 4);
+		generateMip(&level[0], width, height, &next[0], usage);
+		level.swap(next);
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+}
+
+bool TextureImporter::saveDDS(const std::string& filename, const CompressedImage& image, uint64_t sourceHash)
+{
+	DDS_header header;
+	memset(&header, 0, sizeof(DDS_header));
+	header.dwMagic = DDSMagic;
+	header.dwSize = 124;
+	header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT
+		| (image.compression == TextureUncompressed ? DDSD_PITCH : DDSD_LINEARSIZE);
+	header.dwWidth = image.width;
+	header.dwHeight = image.height;
+	header.dwPitchOrLinearSize = (unsigned int)(image.compression == TextureUncompressed ? image.width * 4 : image.levelSizes[0]);
+	header.dwMipMapCount = image.getLevelCount();
+	header.dwReserved1[0] = CacheTag;
+	header.dwReserved1[1] = (unsigned int)sourceHash;
+	header.dwReserved1[2] = (unsigned int)(sourceHash >> 32);
+	header.dwReserved1[3] = image.channels;
+	header.dwReserved1[4] = (unsigned int)(image.psnr * 100.0 + 0.5);
+	header.sPixelFormat.dwSize = 32;
+	if (image.compression == TextureUncompressed)
+	{
+		// R, G, B and A bytes
+		header.sPixelFormat.dwFlags = DDPF_RGB | DDPF_ALPHAPIXELS;
+		header.sPixelFormat.dwRGBBitCount = 32;
+		header.sPixelFormat.dwRBitMask = 0x000000ff;
+		header.sPixelFormat.dwGBitMask = 0x0000ff00;
+		header.sPixelFormat.dwBBitMask = 0x00ff0000;
+		header.sPixelFormat.dwAlphaBitMask = 0xff000000;
+	}
+	else
+	{
+		header.sPixelFormat.dwFlags = DDPF_FOURCC;
+		const unsigned int fourCC[] = { FourCCDXT1, FourCCDXT1, FourCCDXT5, FourCCATI1, FourCCATI2 };
+		header.sPixelFormat.dwFourCC = fourCC[image.compression];
+	}
+	header.sCaps.dwCaps1 = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+	std::ofstream out(filename, std::ios::binary);
+	out.write((const char*)&header, sizeof(DDS_header));
+	out.write((const char*)&image.data[0], image.data.size());
+	return (bool)out;
+}
+
+bool TextureImporter::loadDDS(const std::string& filename, CompressedImage& image, uint64_t& sourceHash)
+{
+	std::ifstream in(filename, std::ios::binary | std::ios::ate);
+	if (!in)
+		return false;
+	unsigned long long fileSize = (unsigned long long)in.tellg();
+	in.seekg(0);
+	DDS_header header;
+	// Bounded dimensions keep the level sizes below from overflowing
+	if (!in.read((char*)&header, sizeof(DDS_header)) || header.dwMagic != DDSMagic || header.dwSize != 124
+		|| header.dwWidth == 0 || header.dwHeight == 0 || header.dwWidth > 65536 || header.dwHeight > 65536)
+		return false;
+	if (!(header.sPixelFormat.dwFlags & DDPF_FOURCC))
+	{
+		if (header.sPixelFormat.dwRGBBitCount != 32 || header.sPixelFormat.dwRBitMask != 0x000000ff
+			|| header.sPixelFormat.dwGBitMask != 0x0000ff00 || header.sPixelFormat.dwBBitMask != 0x00ff0000)
+			return false;
+		image.compression = TextureUncompressed;
+	}
+	else if (header.sPixelFormat.dwFourCC == FourCCDXT1)
+		image.compression = TextureBC1;
+	else if (header.sPixelFormat.dwFourCC == FourCCDXT5)
+		image.compression = TextureBC3;
+	else if (header.sPixelFormat.dwFourCC == FourCCATI1)
+		image.compression = TextureBC4;
+	else if (header.sPixelFormat.dwFourCC == FourCCATI2)
+		image.compression = TextureBC5;
+	else
+		return false;
+
+	image.width = header.dwWidth;
+	image.height = header.dwHeight;
+	image.levelOffsets.clear();
+	image.levelSizes.clear();
+	int levels = (header.dwFlags & DDSD_MIPMAPCOUNT) && header.dwMipMapCount > 0 ? header.dwMipMapCount : 1;
+	int w = image.width, h = image.height;
+	size_t total = 0;
+	for (int l = 0; l < levels && l < 32; l++)
+	{
+		image.levelOffsets.push_back(total);
+		image.levelSizes.push_back(levelSize(w, h, image.compression));
+		total += image.levelSizes.back();
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+	}
+	// A truncated or edited file does not allocate what its header declares
+	if (total > fileSize - sizeof(DDS_header))
+		return false;
+	image.data.resize(total);
+	if (!in.read((char*)&image.data[0], total))
+		return false;
+
+	bool tagged = header.dwReserved1[0] == CacheTag;
+	sourceHash = tagged ? header.dwReserved1[1] | ((uint64_t)header.dwReserved1[2] << 32) : 0;
+	image.channels = tagged ? header.dwReserved1[3] : 4;
+	image.psnr = tagged ? header.dwReserved1[4] / 100.0 : 0.0;
+	return true;
+}
+
+bool TextureImporter::import(const std::string& filename, TextureCompression compression, CompressedImage& image,
+	TextureUsage usage)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	MappedFile source;
+	if (!source.open(filename))
+	{
+		LOG_ERROR << "TextureImporter : could not read " << filename << std::endl;
+		return false;
+	}
+	unsigned char mode[3] = { (unsigned char)compression, (unsigned char)usage, CacheVersion };
+	uint64_t hash = hashBytes(mode, 3, hashBytes(source.data(), source.size()));
+
+	uint64_t cachedHash = 0;
+	std::string cache = cacheName(filename, compression, usage);
+	bool fromCache = loadDDS(cache, image, cachedHash) && cachedHash == hash;
+	if (!fromCache)
+	{
+		int width, height, channels;
+		unsigned char* pixels = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 4);
+		if (pixels == NULL)
+		{
+			LOG_ERROR << "TextureImporter : could not decode " << filename << std::endl;
+			return false;
+		}
+		compress(pixels, width, height, channels, compression, usage, image);
+		stbi_image_free(pixels);
+		if (!saveDDS(cache, image, hash))
+			LOG_WARNING << "TextureImporter : could not write the cache " << cache << std::endl;
+	}
+
+	TextureMemoryRecord record;
+	record.filename = filename;
+	record.width = image.width;
+	record.height = image.height;
+	record.compression = image.compression;
+	record.uncompressedBytes = uncompressedSize(image.width, image.height);
+	record.compressedBytes = image.data.size();
+	record.psnr = image.psnr;
+	record.fromCache = fromCache;
+	record.importTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	size_t i = 0;
+	while (i < m_Records.size() && m_Records[i].filename != filename)
+		i++;
+	if (i == m_Records.size())
+		m_Records.push_back(record);
+	else
+		m_Records[i] = record;
+	return true;
+}
+
+std::vector<TextureMemoryRecord> TextureImporter::getRecords()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Records;
+}
+
+void TextureImporter::logReport()
+{
+	std::vector<TextureMemoryRecord> records = getRecords();
+	size_t uncompressed = 0, compressed = 0;
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		const TextureMemoryRecord& r = records[i];
+		LOG_INFO << r.filename << " : " << r.width << " x " << r.height << " " << getCompressionName(r.compression)
+			<< " (" << r.psnr << " dB) " << r.compressedBytes / 1024 << " KB instead of " << r.uncompressedBytes / 1024 << " KB, "
+			<< ((long long)r.uncompressedBytes - (long long)r.compressedBytes) / 1024 << " KB saved" << (r.fromCache ? " (cached)" : "") << std::endl;
+		uncompressed += r.uncompressedBytes;
+		compressed += r.compressedBytes;
+	}
+	LOG_INFO << records.size() << " imported textures : " << compressed / 1024 << " KB instead of " << uncompressed / 1024
+		<< " KB, " << ((long long)uncompressed - (long long)compressed) / 1024 << " KB saved" << std::endl;
+}
@@ -0,0 +1,310 @@
+#include "TexturePacker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stb/stb_image.h>
+
+#include "Logger/ImGuiLogger.h"
+
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/stb_rect_pack.h"
+
+// Layout of the swizzle of an image (see CompressedImage::getSwizzle): BC4 grey, BC5 grey alpha, or as stored
+static int channelClass(TextureCompression compression, int channels)
+{
+	if (compression == TextureBC4 && channels == 1)
+		return 1;
+	if (compression == TextureBC5 && channels == 2)
+		return 2;
+	return 4;
+}
+
+TexturePacker::TexturePacker(int atlasSize, int maxAtlasEntry, int padding) :
+	m_AtlasSize(atlasSize), m_MaxAtlasEntry(maxAtlasEntry), m_Padding(padding)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+TexturePacker::~TexturePacker()
+{
+	for (size_t g = 0; g < m_Groups.size(); g++)
+	{
+		if (m_Groups[g].id == 0)
+			continue;
+		glMakeTextureHandleNonResidentARB(m_Groups[g].handle);
+		glDeleteTextures(1, &m_Groups[g].id);
+	}
+}
+
+int TexturePacker::add(const std::string& filename, TextureCompression compression, TextureUsage usage, bool repeat)
+{
+	PackedTexture t;
+	t.filename = filename;
+	t.width = t.height = 0;
+	t.group = t.layer = -1;
+	t.uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+	t.atlased = false;
+	m_Textures.push_back(t);
+	Source s = { compression, usage, repeat };
+	m_Sources.push_back(s);
+	return (int)m_Textures.size() - 1;
+}
+
+bool TexturePacker::build()
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	memset(&m_Stats, 0, sizeof(m_Stats));
+	m_Groups.clear();
+	TextureImporter* importer = TextureImporter::getInstance();
+
+	// Atlas entries with their RGBA8 pixels, by format
+	struct AtlasBucket
+	{
+		TextureCompression compression;
+		TextureUsage usage;
+		int channels;
+		std::vector<int> entries;
+		std::vector<CompressedImage> pixels;
+	};
+	std::vector<AtlasBucket> buckets;
+
+	for (size_t i = 0; i < m_Textures.size(); i++)
+	{
+		PackedTexture& t = m_Textures[i];
+		const Source& s = m_Sources[i];
+		int width = 0, height = 0, channels = 0;
+		if (!s.repeat && stbi_info(t.filename.c_str(), &width, &height, &channels)
+			&& width <= m_MaxAtlasEntry && height <= m_MaxAtlasEntry)
+		{
+			CompressedImage pixels;
+			if (!importer->import(t.filename, TextureUncompressed, pixels, s.usage))
+				return false;
+			// Only the first level is packed
+			pixels.data.resize(pixels.levelSizes[0]);
+			pixels.levelSizes.resize(1);
+			pixels.levelOffsets.resize(1);
+			TextureCompression compression = s.compression;
+			if (compression == TextureAutoCompressed)
+				compression = TextureImporter::chooseCompression(&pixels.data[0], pixels.width, pixels.height, pixels.channels, s.usage);
+			int channelsKey = channelClass(compression, pixels.channels);
+
+			size_t b = 0;
+			while (b < buckets.size() && !(buckets[b].compression == compression && buckets[b].usage == s.usage && buckets[b].channels == channelsKey))
+				b++;
+			if (b == buckets.size())
+			{
+				AtlasBucket bucket;
+				bucket.compression = compression;
+				bucket.usage = s.usage;
+				bucket.channels = channelsKey;
+				buckets.push_back(bucket);
+			}
+			t.width = pixels.width;
+			t.height = pixels.height;
+			buckets[b].entries.push_back((int)i);
+			buckets[b].pixels.push_back(CompressedImage());
+			std::swap(buckets[b].pixels.back(), pixels);
+			continue;
+		}
+
+		// Whole texture, in the array of its size and format
+		CompressedImage image;
+		if (!importer->import(t.filename, s.compression, image, s.usage))
+			return false;
+		size_t g = 0;
+		while (g < m_Groups.size() && !(!m_Groups[g].atlas && m_Groups[g].width == image.width && m_Groups[g].height == image.height
+			&& m_Groups[g].compression == image.compression && m_Groups[g].levels == image.getLevelCount()
+			&& channelClass(image.compression, m_Groups[g].layers[0].channels) == channelClass(image.compression, image.channels)))
+			g++;
+		if (g == m_Groups.size())
+		{
+			TextureArrayGroup group;
+			group.width = image.width;
+			group.height = image.height;
+			group.levels = image.getLevelCount();
+			group.compression = image.compression;
+			group.atlas = false;
+			group.memorySize = 0;
+			group.id = 0;
+			group.handle = 0;
+			m_Groups.push_back(group);
+		}
+		t.width = image.width;
+		t.height = image.height;
+		t.group = (int)g;
+		t.layer = (int)m_Groups[g].layers.size();
+		m_Groups[g].memorySize += image.data.size();
+		m_Groups[g].layers.push_back(CompressedImage());
+		std::swap(m_Groups[g].layers.back(), image);
+		m_Stats.arrayLayers++;
+	}
+
+	for (size_t b = 0; b < buckets.size(); b++)
+		packAtlases(buckets[b].entries, buckets[b].pixels, buckets[b].compression, buckets[b].usage, buckets[b].channels);
+
+	double pageTexels = (double)m_Stats.atlasPages * m_AtlasSize * m_AtlasSize, entryTexels = 0.0;
+	for (size_t i = 0; i < m_Textures.size(); i++)
+	{
+		if (m_Textures[i].atlased)
+			entryTexels += (double)m_Textures[i].width * m_Textures[i].height;
+	}
+	for (size_t g = 0; g < m_Groups.size(); g++)
+		m_Stats.memorySize += m_Groups[g].memorySize;
+	m_Stats.textures = (int)m_Textures.size();
+	m_Stats.groups = (int)m_Groups.size();
+	m_Stats.atlasOccupancy = pageTexels > 0.0 ? entryTexels / pageTexels : 0.0;
+	m_Stats.buildTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
+
+void TexturePacker::packAtlases(std::vector<int>& entries, std::vector<CompressedImage>& pixels, TextureCompression compression,
+	TextureUsage usage, int channels)
+{
+	// Rectangles are packed in units of the padding, so that entries start on multiples of it
+	int pad = m_Padding, units = m_AtlasSize / pad;
+	// The gutter of level l is pad >> l texels, and 4 x 4 blocks must not straddle two entries: log2(pad) levels,
+	// down to log2(pad) - 2 for block compressed pages
+	int levels = 1;
+	while ((2 << levels) <= pad)
+		levels++;
+	if (compression != TextureUncompressed)
+		levels = std::max(1, levels - 1);
+
+	std::vector<stbrp_rect> remaining(entries.size());
+	for (size_t k = 0; k < entries.size(); k++)
+	{
+		remaining[k].id = (int)k;
+		remaining[k].w = (stbrp_coord)((pixels[k].width + 2 * pad + pad - 1) / pad);
+		remaining[k].h = (stbrp_coord)((pixels[k].height + 2 * pad + pad - 1) / pad);
+	}
+	std::vector<stbrp_node> nodes(units);
+
+	int group = (int)m_Groups.size();
+	TextureArrayGroup atlas;
+	atlas.width = atlas.height = m_AtlasSize;
+	atlas.levels = levels;
+	atlas.compression = compression;
+	atlas.atlas = true;
+	atlas.memorySize = 0;
+	atlas.id = 0;
+	atlas.handle = 0;
+	m_Groups.push_back(atlas);
+
+	std::vector<unsigned char> page;
+	while (!remaining.empty())
+	{
+		stbrp_context context;
+		stbrp_init_target(&context, units, units, &nodes[0], (int)nodes.size());
+		stbrp_pack_rects(&context, &remaining[0], (int)remaining.size());
+
+		page.assign((size_t)m_AtlasSize * m_AtlasSize * 4, 0);
+		int layer = (int)m_Groups[group].layers.size();
+		std::vector<stbrp_rect> next;
+		for (size_t r = 0; r < remaining.size(); r++)
+		{
+			if (!remaining[r].was_packed)
+			{
+				next.push_back(remaining[r]);
+				continue;
+			}
+			const CompressedImage& image = pixels[remaining[r].id];
+			int x0 = remaining[r].x * pad + pad, y0 = remaining[r].y * pad + pad;
+			// The gutter repeats the border texels
+			for (int y = -pad; y < image.height + pad; y++)
+			{
+				int sy = std::min(std::max(y, 0), image.height - 1);
+				for (int x = -pad; x < image.width + pad; x++)
+				{
+					int sx = std::min(std::max(x, 0), image.width - 1);
+					memcpy(&page[((size_t)(y0 + y) * m_AtlasSize + x0 + x) * 4], &image.data[((size_t)sy * image.width + sx) * 4], 4);
+				}
+			}
+			PackedTexture& t = m_Textures[entries[remaining[r].id]];
+			t.group = group;
+			t.layer = layer;
+			t.atlased = true;
+			t.uvTransform = glm::vec4((float)image.width / m_AtlasSize, (float)image.height / m_AtlasSize,
+				(float)x0 / m_AtlasSize, (float)y0 / m_AtlasSize);
+			m_Stats.atlasEntries++;
+		}
+		if (next.size() == remaining.size())
+		{
+			LOG_ERROR << "TexturePacker : an entry does not fit in a " << m_AtlasSize << " atlas" << std::endl;
+			return;
+		}
+		remaining.swap(next);
+
+		CompressedImage image;
+		TextureImporter::compress(&page[0], m_AtlasSize, m_AtlasSize, channels, compression, usage, image);
+		image.levelSizes.resize(levels);
+		image.levelOffsets.resize(levels);
+		image.data.resize(image.levelOffsets.back() + image.levelSizes.back());
+		m_Groups[group].memorySize += image.data.size();
+		m_Groups[group].layers.push_back(CompressedImage());
+		std::swap(m_Groups[group].layers.back(), image);
+		m_Stats.atlasPages++;
+	}
+}
+
+void TexturePacker::createGL()
+{
+	for (size_t g = 0; g < m_Groups.size(); g++)
+	{
+		TextureArrayGroup& group = m_Groups[g];
+		if (group.id != 0 || group.layers.empty())
+			continue;
+		const CompressedImage& first = group.layers[0];
+		GLenum format = first.getFormat();
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &group.id);
+		glTextureStorage3D(group.id, group.levels, format, group.width, group.height, (GLsizei)group.layers.size());
+		for (size_t layer = 0; layer < group.layers.size(); layer++)
+		{
+			const CompressedImage& image = group.layers[layer];
+			for (int level = 0; level < group.levels; level++)
+			{
+				int w = std::max(1, group.width >> level), h = std::max(1, group.height >> level);
+				const unsigned char* data = &image.data[image.levelOffsets[level]];
+				if (image.isCompressed())
+					glCompressedTextureSubImage3D(group.id, level, 0, 0, (GLint)layer, w, h, 1, format, (GLsizei)image.levelSizes[level], data);
+				else
+					glTextureSubImage3D(group.id, level, 0, 0, (GLint)layer, w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+			}
+		}
+		glTextureParameteri(group.id, GL_TEXTURE_MIN_FILTER, group.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(group.id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// Atlas entries are sampled within their rectangle
+		GLint wrap = group.atlas ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+		glTextureParameteri(group.id, GL_TEXTURE_WRAP_S, wrap);
+		glTextureParameteri(group.id, GL_TEXTURE_WRAP_T, wrap);
+		GLint swizzle[4];
+		if (first.getSwizzle(swizzle))
+			glTextureParameteriv(group.id, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+		group.handle = glGetTextureHandleARB(group.id);
+		glMakeTextureHandleResidentARB(group.handle);
+		std::vector<CompressedImage>().swap(group.layers);
+	}
+}
+
+void TexturePacker::remapCoords(const PackedTexture& t, std::vector<glm::vec3>& coords)
+{
+	for (size_t i = 0; i < coords.size(); i++)
+		coords[i] = glm::vec3(glm::vec2(coords[i]) * glm::vec2(t.uvTransform) + glm::vec2(t.uvTransform.z, t.uvTransform.w), (float)t.layer);
+}
+
+int TexturePacker::countBatches(const std::vector<int>& drawTextures, bool packed) const
+{
+	std::vector<bool> bound(packed ? m_Groups.size() : m_Textures.size(), false);
+	int batches = 0;
+	for (size_t d = 0; d < drawTextures.size(); d++)
+	{
+		int binding = packed ? m_Textures[drawTextures[d]].group : drawTextures[d];
+		if (!bound[binding])
+		{
+			bound[binding] = true;
+			batches++;
+		}
+	}
+	return batches;
+}
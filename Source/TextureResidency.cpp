@@ -0,0 +1,44 @@
+#include "TextureResidency.h"
+
+#include <cstring>
+
+#include "Texture2D.h"
+
+TextureResidency::TextureResidency() :
+	m_LRU(512 << 20, FramesInFlight), m_Frame(0), m_Restores(0)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+void TextureResidency::add(Texture2D* texture, size_t bytes)
+{
+	m_LRU.add(texture, bytes, m_Frame);
+}
+
+void TextureResidency::remove(Texture2D* texture)
+{
+	m_LRU.remove(texture);
+}
+
+void TextureResidency::use(Texture2D* texture)
+{
+	if (m_LRU.use(texture, m_Frame))
+	{
+		texture->setResident(true);
+		m_Restores++;
+		m_Stats.restores++;
+	}
+}
+
+void TextureResidency::update()
+{
+	m_Frame++;
+	m_Evicted.clear();
+	m_LRU.evict(m_Frame, m_Evicted);
+	for (size_t i = 0; i < m_Evicted.size(); i++)
+		m_Evicted[i]->setResident(false);
+	m_Stats.evictions += m_Evicted.size();
+	m_Stats.lastEvictions = (int)m_Evicted.size();
+	m_Stats.lastRestores = m_Restores;
+	m_Restores = 0;
+}
@@ -0,0 +1,470 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stb/stb_image.h>
+
+#include "Texture2D.h"
+#include "Logger/ImGuiLogger.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+UploadRing::UploadRing(size_t capacity, size_t alignment) : m_Alignment(alignment)
+{
+	reset(capacity);
+}
+
+void UploadRing::reset(size_t capacity)
+{
+	m_Capacity = capacity;
+	m_Head = m_Tail = m_Used = 0;
+	m_Ranges.clear();
+}
+
+size_t UploadRing::allocate(size_t size)
+{
+	size = (size + m_Alignment - 1) / m_Alignment * m_Alignment;
+	if (size == 0 || size > m_Capacity)
+		return NoOffset;
+	if (m_Used == 0)
+		m_Head = m_Tail = 0;
+
+	// Free space is [head, end) and [0, tail) when the head is after the tail, [head, tail) otherwise
+	Range r;
+	r.start = m_Head;
+	r.released = false;
+	if (m_Used == 0 || m_Head > m_Tail)
+	{
+		if (m_Capacity - m_Head >= size)
+			r.offset = m_Head;
+		else if (m_Tail >= size)
+			r.offset = 0;
+		else
+			return NoOffset;
+	}
+	else if (m_Tail - m_Head >= size)
+		r.offset = m_Head;
+	else
+		return NoOffset;
+
+	r.length = (r.offset >= r.start ? r.offset - r.start : m_Capacity - r.start) + size;
+	m_Head = r.offset + size;
+	if (m_Head == m_Capacity)
+		m_Head = 0;
+	m_Used += r.length;
+	m_Ranges.push_back(r);
+	return r.offset;
+}
+
+void UploadRing::release(size_t offset)
+{
+	for (size_t i = 0; i < m_Ranges.size(); i++)
+	{
+		if (m_Ranges[i].offset == offset && !m_Ranges[i].released)
+		{
+			m_Ranges[i].released = true;
+			break;
+		}
+	}
+	while (!m_Ranges.empty() && m_Ranges.front().released)
+	{
+		const Range& r = m_Ranges.front();
+		m_Tail = (r.start + r.length) % m_Capacity;
+		m_Used -= r.length;
+		m_Ranges.pop_front();
+	}
+}
+
+TextureStreamer::TextureStreamer() :
+	m_Stop(false), m_RingMemory(NULL), m_Buffer(0), m_Placeholder(0), m_PlaceholderHandle(0), m_MipBudget(4 << 20), m_Busy(false)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	stop();
+}
+
+void TextureStreamer::initGL(size_t ringSize, int threads)
+{
+	if (m_Buffer != 0)
+		return;
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &m_Buffer);
+	glNamedBufferStorage(m_Buffer, ringSize, NULL, flags);
+	unsigned char* ring = static_cast<unsigned char*>(glMapNamedBufferRange(m_Buffer, 0, ringSize, flags));
+	if (ring == NULL)
+	{
+		LOG_ERROR << "TextureStreamer : could not map the upload buffer" << std::endl;
+		glDeleteBuffers(1, &m_Buffer);
+		m_Buffer = 0;
+		return;
+	}
+	start(ring, ringSize, threads);
+}
+
+void TextureStreamer::start(unsigned char* ring, size_t ringSize, int threads)
+{
+	stop();
+	if (threads <= 0)
+		threads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_RingMemory = ring;
+	m_Ring.reset(ringSize);
+	for (int t = 0; t < threads; t++)
+		m_Workers.push_back(std::thread(&TextureStreamer::work, this));
+}
+
+void TextureStreamer::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_RequestAdded.notify_all();
+	m_RingReleased.notify_all();
+	for (size_t t = 0; t < m_Workers.size(); t++)
+		m_Workers[t].join();
+	m_Workers.clear();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (size_t i = 0; i < m_Decoded.size(); i++)
+		stbi_image_free(m_Decoded[i].pixels);
+	m_Requests.clear();
+	m_Decoded.clear();
+	m_Stop = false;
+}
+
+void TextureStreamer::request(const std::string& filename, Texture2D* texture)
+{
+	DecodedImage image;
+	image.texture = texture;
+	image.filename = filename;
+	image.width = image.height = 0;
+	image.offset = UploadRing::NoOffset;
+	image.pixels = NULL;
+	image.decodeTime = 0.0;
+	image.requestTime = Clock::now();
+	image.failed = false;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!m_Busy)
+		{
+			m_Busy = true;
+			m_BusyStart = image.requestTime;
+		}
+		m_Requests.push_back(image);
+		m_Stats.requested++;
+	}
+	m_RequestAdded.notify_one();
+}
+
+void TextureStreamer::cancel(Texture2D* texture)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (size_t i = 0; i < m_Requests.size(); i++)
+	{
+		if (m_Requests[i].texture == texture)
+			m_Requests[i].texture = NULL;
+	}
+	for (std::list<DecodedImage>::iterator it = m_Decoding.begin(); it != m_Decoding.end(); ++it)
+	{
+		if (it->texture == texture)
+			it->texture = NULL;
+	}
+	for (size_t i = 0; i < m_Decoded.size(); i++)
+	{
+		if (m_Decoded[i].texture == texture)
+			m_Decoded[i].texture = NULL;
+	}
+	// Uploads and mip streams are only touched by the GL thread, which destroys the textures
+	for (size_t i = 0; i < m_Uploads.size(); i++)
+	{
+		if (m_Uploads[i].image.texture == texture)
+			m_Uploads[i].image.texture = NULL;
+	}
+	for (std::list<MipStream>::iterator it = m_MipStreams.begin(); it != m_MipStreams.end();)
+	{
+		if (it->texture == texture)
+			it = m_MipStreams.erase(it);
+		else
+			++it;
+	}
+}
+
+void TextureStreamer::work()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	for (;;)
+	{
+		m_RequestAdded.wait(lock, [this]() { return m_Stop || !m_Requests.empty(); });
+		if (m_Stop)
+			return;
+		std::list<DecodedImage>::iterator job = m_Decoding.insert(m_Decoding.end(), m_Requests.front());
+		m_Requests.pop_front();
+		std::string filename = job->filename;
+		lock.unlock();
+
+		// The worker only writes the size and result fields, cancel only writes the texture
+		Clock::time_point start = Clock::now();
+		int width = 0, height = 0, channels;
+		unsigned char* pixels = stbi_load(filename.c_str(), &width, &height, &channels, 4);
+		double decodeTime = millisecondsSince(start);
+		size_t size = (size_t)width * height * 4;
+
+		lock.lock();
+		job->width = width;
+		job->height = height;
+		job->decodeTime = decodeTime;
+		job->failed = pixels == NULL;
+		if (pixels != NULL)
+		{
+			if (size > m_Ring.getCapacity())
+			{
+				// Uploaded from client memory
+				job->pixels = pixels;
+				pixels = NULL;
+			}
+			else
+			{
+				size_t offset = UploadRing::NoOffset;
+				m_RingReleased.wait(lock, [&]() { return m_Stop || (offset = m_Ring.allocate(size)) != UploadRing::NoOffset; });
+				if (m_Stop)
+				{
+					if (offset != UploadRing::NoOffset)
+						m_Ring.release(offset);
+					m_Decoding.erase(job);
+					lock.unlock();
+					stbi_image_free(pixels);
+					return;
+				}
+				job->offset = offset;
+				lock.unlock();
+				memcpy(m_RingMemory + offset, pixels, size);
+				stbi_image_free(pixels);
+				lock.lock();
+			}
+		}
+		m_Decoded.push_back(*job);
+		m_Decoding.erase(job);
+	}
+}
+
+bool TextureStreamer::popDecoded(DecodedImage& image)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Decoded.empty())
+		return false;
+	image = m_Decoded.front();
+	m_Decoded.pop_front();
+	return true;
+}
+
+void TextureStreamer::release(const DecodedImage& image)
+{
+	if (image.pixels != NULL)
+		stbi_image_free(image.pixels);
+	if (image.offset == UploadRing::NoOffset)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Ring.release(image.offset);
+	}
+	m_RingReleased.notify_all();
+}
+
+int TextureStreamer::getPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return (int)(m_Requests.size() + m_Decoding.size() + m_Decoded.size() + m_Uploads.size());
+}
+
+void TextureStreamer::update()
+{
+	updateMips();
+	if (m_Buffer == 0)
+		return;
+
+	// Fences are signaled in submission order
+	while (!m_Uploads.empty())
+	{
+		Upload& u = m_Uploads.front();
+		GLenum status = glClientWaitSync(u.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		glDeleteSync(u.fence);
+		if (u.image.texture != NULL)
+			u.image.texture->finishStreaming();
+		m_Stats.completed++;
+		release(u.image);
+		m_Uploads.pop_front();
+	}
+
+	DecodedImage image;
+	while (popDecoded(image))
+	{
+		if (image.failed)
+		{
+			LOG_WARNING << "TextureStreamer : could not load " << image.filename << std::endl;
+			m_Stats.failed++;
+		}
+		if (image.failed || image.texture == NULL)
+		{
+			release(image);
+			continue;
+		}
+
+		Clock::time_point start = Clock::now();
+		Texture2D* texture = image.texture;
+		texture->beginStreaming(image.width, image.height);
+		if (image.pixels == NULL)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Buffer);
+			glTextureSubImage2D(texture->getId(), 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)image.offset);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		else
+		{
+			// Client memory is copied by the call
+			glTextureSubImage2D(texture->getId(), 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+			stbi_image_free(image.pixels);
+			image.pixels = NULL;
+		}
+		glGenerateTextureMipmap(texture->getId());
+
+		Upload u = { glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), image };
+		m_Uploads.push_back(u);
+
+		double time = millisecondsSince(start);
+		m_Stats.submitted++;
+		m_Stats.uploadTime += time;
+		m_Stats.maxUploadTime = std::max(m_Stats.maxUploadTime, time);
+		m_Stats.decodeTime += image.decodeTime;
+		m_Stats.bytes += (long long)image.width * image.height * 4;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Busy && m_Requests.empty() && m_Decoding.empty() && m_Decoded.empty() && m_Uploads.empty())
+	{
+		m_Stats.streamingTime += millisecondsSince(m_BusyStart);
+		m_Busy = false;
+	}
+}
+
+GLuint64 TextureStreamer::getPlaceholderHandle()
+{
+	if (m_Placeholder == 0)
+	{
+		// 8 x 8 grey checker
+		unsigned char pixels[8 * 8 * 4];
+		for (int i = 0; i < 8 * 8; i++)
+		{
+			unsigned char v = ((i % 8) / 2 + (i / 8) / 2) % 2 ? 160 : 96;
+			pixels[4 * i] = pixels[4 * i + 1] = pixels[4 * i + 2] = v;
+			pixels[4 * i + 3] = 255;
+		}
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_Placeholder);
+		glTextureStorage2D(m_Placeholder, 1, GL_RGBA8, 8, 8);
+		glTextureSubImage2D(m_Placeholder, 0, 0, 0, 8, 8, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glTextureParameteri(m_Placeholder, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(m_Placeholder, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		m_PlaceholderHandle = glGetTextureHandleARB(m_Placeholder);
+		glMakeTextureHandleResidentARB(m_PlaceholderHandle);
+	}
+	return m_PlaceholderHandle;
+}
+
+void TextureStreamer::streamMips(Texture2D* texture, CompressedImage& image)
+{
+	m_MipStreams.push_back(MipStream());
+	MipStream& stream = m_MipStreams.back();
+	stream.texture = texture;
+	stream.nextLevel = texture->getBaseLevel() - 1;
+	std::swap(stream.image, image);
+}
+
+int TextureStreamer::getInitialLevel(const CompressedImage& image) const
+{
+	if (m_MipBudget == 0)
+		return 0;
+	return firstLevelWithin(image.levelSizes, InitialMipBytes);
+}
+
+void TextureStreamer::retireTexture(GLuint texture, GLuint64 handle)
+{
+	RetiredTexture r = { glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), texture, handle };
+	m_RetiredTextures.push_back(r);
+}
+
+int TextureStreamer::firstLevelWithin(const std::vector<size_t>& levelSizes, size_t bytes)
+{
+	int level = (int)levelSizes.size() - 1;
+	size_t total = level >= 0 ? levelSizes[level] : 0;
+	while (level > 0 && total + levelSizes[level - 1] <= bytes)
+		total += levelSizes[--level];
+	return std::max(0, level);
+}
+
+int TextureStreamer::countMipUploads(const std::vector<size_t>& levelSizes, int nextLevel, size_t budget, bool force)
+{
+	int count = 0;
+	for (int level = nextLevel; level >= 0; level--)
+	{
+		if (levelSizes[level] > budget && !(force && count == 0))
+			break;
+		budget -= std::min(budget, levelSizes[level]);
+		count++;
+	}
+	return count;
+}
+
+void TextureStreamer::updateMips()
+{
+	// Destroyed textures and views of former base levels, once no submitted frame samples them
+	while (!m_RetiredTextures.empty())
+	{
+		RetiredTexture& r = m_RetiredTextures.front();
+		GLenum status = glClientWaitSync(r.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		glDeleteSync(r.fence);
+		if (r.handle != 0)
+			glMakeTextureHandleNonResidentARB(r.handle);
+		glDeleteTextures(1, &r.texture);
+		m_RetiredTextures.pop_front();
+	}
+
+	// Streams are served in order: one waiting for a level larger than the rest of the budget holds the next ones
+	Clock::time_point start = Clock::now();
+	size_t budget = m_MipBudget;
+	bool first = true;
+	while (!m_MipStreams.empty())
+	{
+		MipStream& stream = m_MipStreams.front();
+		int count = countMipUploads(stream.image.levelSizes, stream.nextLevel, budget, first);
+		if (count == 0)
+			break;
+		for (int i = 0; i < count; i++, stream.nextLevel--)
+		{
+			size_t size = stream.image.levelSizes[stream.nextLevel];
+			stream.texture->uploadLevel(stream.image, stream.nextLevel);
+			budget -= std::min(budget, size);
+			m_Stats.mipLevels++;
+			m_Stats.mipBytes += size;
+		}
+		stream.texture->setBaseLevel(stream.nextLevel + 1);
+		first = false;
+		if (stream.nextLevel >= 0)
+			break;
+		m_MipStreams.pop_front();
+	}
+	if (!first)
+		m_Stats.mipUploadTime += millisecondsSince(start);
+}
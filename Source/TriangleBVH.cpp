@@ -0,0 +1,300 @@
+#include "TriangleBVH.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "ThreadPool.h"
+
+static const int BinCount = 16;
+static const int MaxLeafSize = 4;
+static const int MaxDepth = 64;				// Bounds the traversal stack
+static const int ParallelThreshold = 16384;	// Minimum triangle count to spawn a subtree task or split a loop
+
+TriangleBVH::TriangleBVH() : m_BuildTime(0.0)
+{
+}
+
+TriangleBVH::~TriangleBVH()
+{
+}
+
+AABB TriangleBVH::bounds() const
+{
+	if (m_Nodes.empty())
+		return AABB();
+	return AABB(m_Nodes[0].min, m_Nodes[0].max);
+}
+
+void TriangleBVH::build(const glm::vec3* vertices, const int* indices, int triangleCount, int threads)
+{
+	std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+
+	if (threads <= 0)
+		threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	m_Nodes.clear();
+	m_Triangles.clear();
+	m_Indices.resize(triangleCount);
+	m_TriangleBounds.resize(triangleCount);
+	m_Centroids.resize(triangleCount);
+
+	int loopThreads = triangleCount < ParallelThreshold ? 1 : threads;
+	parallelFor(triangleCount, loopThreads, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			AABB b;
+			b.expand(vertices[indices[3 * i]]);
+			b.expand(vertices[indices[3 * i + 1]]);
+			b.expand(vertices[indices[3 * i + 2]]);
+			m_TriangleBounds[i] = b;
+			m_Centroids[i] = b.center();
+			m_Indices[i] = i;
+		}
+	});
+
+	if (triangleCount > 0)
+	{
+		// Each level of parallel subdivision doubles the number of tasks
+		int parallelDepth = 0;
+		while ((1 << parallelDepth) < threads)
+			parallelDepth++;
+		m_Nodes.reserve(2 * triangleCount / MaxLeafSize + 1);
+		buildNode(0, triangleCount, m_Nodes, parallelDepth, 0);
+	}
+
+	// Reorder the triangles in leaf order for a cache friendly traversal
+	m_Triangles.resize(triangleCount);
+	parallelFor(triangleCount, loopThreads, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			int f = m_Indices[i];
+			glm::vec3 v0 = vertices[indices[3 * f]];
+			m_Triangles[i].v0 = v0;
+			m_Triangles[i].e1 = vertices[indices[3 * f + 1]] - v0;
+			m_Triangles[i].e2 = vertices[indices[3 * f + 2]] - v0;
+			m_Triangles[i].face = f;
+		}
+	});
+
+	std::vector<int>().swap(m_Indices);
+	std::vector<AABB>().swap(m_TriangleBounds);
+	std::vector<glm::vec3>().swap(m_Centroids);
+
+	m_BuildTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void TriangleBVH::buildNode(int begin, int end, std::vector<BVHNode>& out, int parallelDepth, int depth)
+{
+	AABB box, centroidBox;
+	for (int i = begin; i < end; i++)
+	{
+		box.expand(m_TriangleBounds[m_Indices[i]]);
+		centroidBox.expand(m_Centroids[m_Indices[i]]);
+	}
+
+	int nodeIndex = (int)out.size();
+	BVHNode node;
+	node.min = box.min;
+	node.max = box.max;
+	node.first = begin;
+	node.count = end - begin;
+	out.push_back(node);
+
+	int count = end - begin;
+	if (count <= MaxLeafSize || depth >= MaxDepth - 1)
+		return;
+
+	// Binned SAH along each axis
+	float bestCost = FLT_MAX;
+	int bestAxis = -1, bestSplit = -1;
+	glm::vec3 extent = centroidBox.extent();
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (extent[axis] <= 0.0f)
+			continue;
+
+		AABB binBox[BinCount];
+		int binCount[BinCount] = { 0 };
+		float scale = BinCount / extent[axis];
+		for (int i = begin; i < end; i++)
+		{
+			int t = m_Indices[i];
+			int b = std::min(BinCount - 1, (int)((m_Centroids[t][axis] - centroidBox.min[axis]) * scale));
+			binCount[b]++;
+			binBox[b].expand(m_TriangleBounds[t]);
+		}
+
+		// Sweep from the right to get the cost of every right partition
+		float rightArea[BinCount - 1];
+		int rightCount[BinCount - 1];
+		AABB acc;
+		int n = 0;
+		for (int b = BinCount - 1; b > 0; b--)
+		{
+			acc.expand(binBox[b]);
+			n += binCount[b];
+			rightArea[b - 1] = acc.isEmpty() ? 0.0f : acc.area();
+			rightCount[b - 1] = n;
+		}
+
+		acc = AABB();
+		n = 0;
+		for (int b = 0; b < BinCount - 1; b++)
+		{
+			acc.expand(binBox[b]);
+			n += binCount[b];
+			if (n == 0 || rightCount[b] == 0)
+				continue;
+			float cost = n * acc.area() + rightCount[b] * rightArea[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	int mid;
+	if (bestAxis == -1)
+	{
+		// All centroids are identical : split in the middle
+		mid = begin + count / 2;
+	}
+	else
+	{
+		float leafCost = count * box.area();
+		if (bestCost >= leafCost && count <= 4 * MaxLeafSize)
+			return;
+
+		float scale = BinCount / extent[bestAxis];
+		float origin = centroidBox.min[bestAxis];
+		int* p = std::partition(&m_Indices[0] + begin, &m_Indices[0] + end, [&](int t) {
+			return std::min(BinCount - 1, (int)((m_Centroids[t][bestAxis] - origin) * scale)) <= bestSplit;
+		});
+		mid = (int)(p - &m_Indices[0]);
+		if (mid == begin || mid == end)
+			mid = begin + count / 2;
+	}
+
+	out[nodeIndex].count = 0;
+
+	if (parallelDepth > 0 && count > ParallelThreshold)
+	{
+		// Build the right subtree in its own array on a worker while this thread builds the left one (waiting threads
+		// run the queued subtrees, so nested builds do not starve the pool)
+		std::vector<BVHNode> rightNodes;
+		parallelFor(2, 2, [&](int first, int) {
+			if (first == 0)
+				buildNode(begin, mid, out, parallelDepth - 1, depth + 1);
+			else
+				buildNode(mid, end, rightNodes, parallelDepth - 1, depth + 1);
+		});
+
+		int offset = (int)out.size();
+		out[nodeIndex].first = offset;
+		for (size_t i = 0; i < rightNodes.size(); i++)
+		{
+			if (rightNodes[i].count == 0)
+				rightNodes[i].first += offset;
+			out.push_back(rightNodes[i]);
+		}
+	}
+	else
+	{
+		buildNode(begin, mid, out, 0, depth + 1);
+		out[nodeIndex].first = (int)out.size();
+		buildNode(mid, end, out, 0, depth + 1);
+	}
+}
+
+bool TriangleBVH::intersect(const Ray& r, RayHit& hit, float tMax) const
+{
+	if (m_Nodes.empty())
+		return false;
+
+	bool found = false;
+	int stack[MaxDepth];
+	int stackSize = 0;
+	int current = 0;
+
+	while (true)
+	{
+		const BVHNode& node = m_Nodes[current];
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				const BVHTriangle& tri = m_Triangles[i];
+				glm::vec3 p = glm::cross(r.direction, tri.e2);
+				float det = glm::dot(tri.e1, p);
+				if (std::fabs(det) < 1e-12f)
+					continue;
+				float invDet = 1.0f / det;
+				glm::vec3 s = r.origin - tri.v0;
+				float u = glm::dot(s, p) * invDet;
+				if (u < 0.0f || u > 1.0f)
+					continue;
+				glm::vec3 q = glm::cross(s, tri.e1);
+				float v = glm::dot(r.direction, q) * invDet;
+				if (v < 0.0f || u + v > 1.0f)
+					continue;
+				float t = glm::dot(tri.e2, q) * invDet;
+				if (t > 0.0f && t < tMax)
+				{
+					tMax = t;
+					hit.t = t;
+					hit.face = tri.face;
+					hit.u = u;
+					hit.v = v;
+					found = true;
+				}
+			}
+		}
+		else
+		{
+			// Visit the closest child first and push the other one
+			int left = current + 1;
+			int right = node.first;
+			float tLeft, tRight;
+			bool hitLeft = r.intersect(AABB(m_Nodes[left].min, m_Nodes[left].max), tMax, tLeft);
+			bool hitRight = r.intersect(AABB(m_Nodes[right].min, m_Nodes[right].max), tMax, tRight);
+			if (hitLeft && hitRight)
+			{
+				if (tRight < tLeft)
+					std::swap(left, right);
+				stack[stackSize++] = right;
+				current = left;
+				continue;
+			}
+			if (hitLeft)
+			{
+				current = left;
+				continue;
+			}
+			if (hitRight)
+			{
+				current = right;
+				continue;
+			}
+		}
+
+		// Pop the next node, skipping the ones farther than the closest hit
+		bool next = false;
+		while (stackSize > 0)
+		{
+			current = stack[--stackSize];
+			float t;
+			if (r.intersect(AABB(m_Nodes[current].min, m_Nodes[current].max), tMax, t))
+			{
+				next = true;
+				break;
+			}
+		}
+		if (!next)
+			break;
+	}
+	return found;
+}